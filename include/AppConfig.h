@@ -5,6 +5,7 @@
 #include <QDate>
 #include <QTime>
 #include <QString>
+#include <QStringList>
 #include <QVector>
 
 /** User-configurable warning dialog preferences. */
@@ -22,12 +23,32 @@ struct WarningPreferences {
     int height {360};
 };
 
+/** A command the daemon runs after the RTC alarm of a weekly rule woke the machine. */
+struct MaintenanceJob {
+    QString name;
+    /** Passed to `/bin/sh -c`. */
+    QString command;
+    /** Niceness from -20 to 19. */
+    int nice {10};
+    /** I/O scheduling class as in ionice(1): 1 realtime, 2 best-effort, 3 idle. */
+    int ioClass {3};
+    /** Priority within the realtime and best-effort classes, 0 (highest) to 7. */
+    int ioLevel {4};
+    int timeoutSeconds {3600};
+};
+
 /** Entry representing a weekly schedule row. */
 struct WeeklyEntry {
     Qt::DayOfWeek day {Qt::Monday};
     bool enabled {false};
     QTime shutdownTime {QTime(23, 0)};
     QTime wakeTime {QTime(7, 30)};
+    /** Run after this rule's wake; an empty list keeps the machine up as before. */
+    QVector<MaintenanceJob> jobs;
+    /** Sleep again once every job finished. */
+    bool resuspendAfterJobs {true};
+    /** Wake from that sleep at this time if it comes before the next planned wake. */
+    QTime resuspendUntil;
 };
 
 /** Details about the user's graphical session so the daemon can show banners. */
@@ -40,6 +61,138 @@ struct SessionInfo {
     QString waylandDisplay;
 };
 
+/** Files and directories the daemon pulls into the page cache after an RTC wake. */
+struct PrefetchPreferences {
+    bool enabled {false};
+    QStringList paths;
+    int workers {4};
+    int budgetSeconds {60};
+};
+
+/**
+ * Limits of the pre-transition idleness check; a limit of zero or less is not checked.
+ * Pressure values are PSI `some avg10` percentages, throughputs are measured over
+ * sampleSeconds.
+ */
+struct DeferralPreferences {
+    bool enabled {false};
+    double maxLoadPerCpu {0.5};
+    double maxCpuPressure {20.0};
+    double maxIoPressure {10.0};
+    double maxMemoryPressure {10.0};
+    int maxDiskKiBps {2048};
+    int maxNetKiBps {512};
+    /** Process names (as in /proc/<pid>/comm) that keep the machine up while they run. */
+    QStringList blockingProcesses;
+    int sampleSeconds {5};
+    int stepMinutes {10};
+    int maxDelayMinutes {120};
+};
+
+/**
+ * Opportunistic suspend: when the machine stays idle for idleMinutes inside the
+ * [windowStart, windowEnd) range (which may wrap past midnight), the daemon performs
+ * actionId early and still wakes at the next scheduled wake time.
+ */
+struct IdleSuspendPreferences {
+    bool enabled {false};
+    int idleMinutes {30};
+    QTime windowStart {QTime(22, 0)};
+    QTime windowEnd {QTime(6, 0)};
+    int actionId {static_cast<int>(PowerAction::SuspendToRam)};
+    /** Share of a 10 s PSI window spent stalled that counts as activity. */
+    int pressurePercent {5};
+    /** Also require logind's IdleHint, i.e. no input in any session. */
+    bool requireSessionIdle {true};
+};
+
+/** Limits shared by all maintenance jobs. */
+struct MaintenancePreferences {
+    int maxParallel {2};
+    /** Stay up after the jobs while logind reports someone using a session. */
+    bool requireSessionIdle {true};
+};
+
+/** Go back to sleep when nobody uses the machine after a scheduled wake. */
+struct ReturnToSleepPreferences {
+    bool enabled {false};
+    int graceMinutes {20};
+    /** Input events on /dev/input count as activity. */
+    bool watchInputDevices {true};
+    /** logind's IdleHint turning false counts as activity. */
+    bool watchSession {true};
+};
+
+/**
+ * @brief Knobs applied right before the machine writes its hibernation image.
+ *
+ * Empty strings and a negative image size leave the kernel's current setting alone.
+ */
+struct HibernateTuningPreferences {
+    bool enabled {false};
+    /** Target image size as a share of RAM; 0 asks the kernel for the smallest image. */
+    int imageSizePercent {-1};
+    /** Drop clean page cache first so it is neither written nor read back. */
+    bool dropCaches {false};
+    bool compactMemory {false};
+    /** One of the modes listed in /sys/power/disk, e.g. "platform" or "shutdown". */
+    QString diskMode;
+    /** Image compressor, e.g. "lzo" or "lz4", where the kernel lets us choose. */
+    QString compressor;
+};
+
+/**
+ * @brief Arm the RTC early so the machine is ready at the wake time instead of starting then.
+ *
+ * The lead is a percentile of the readiness times measured for the same action.
+ */
+struct WakeLeadPreferences {
+    bool enabled {false};
+    int percentile {90};
+    /** Measured transitions needed before any lead is applied. */
+    int minSamples {5};
+    int maxLeadMinutes {10};
+};
+
+/** Which RTC to wake from and how far ahead its alarm reaches. */
+struct RtcPreferences {
+    /** e.g. "rtc1"; empty picks the RTC the system clock is set from. */
+    QString device;
+    /** Alarm range in hours for RTCs that misreport it; 0 probes the RTC instead. */
+    int maxAlarmHours {0};
+};
+
+/**
+ * @brief How hard to try before giving up on a night's sleep.
+ *
+ * Each mode is retried with a doubling pause; when it keeps failing the remaining modes
+ * of @c fallbackModes are tried, the ones that succeeded most often here first.
+ */
+struct SleepEntryPreferences {
+    /** Attempts per mode, including the first. */
+    int maxAttempts {3};
+    int backoffSeconds {2};
+    int maxBackoffSeconds {30};
+    /** rtcwake modes to fall back to; PowerOff never falls back. */
+    QStringList fallbackModes {QStringLiteral("mem"), QStringLiteral("freeze"), QStringLiteral("disk")};
+    /** Order the fallbacks by their recorded success rate instead of as listed. */
+    bool adaptiveOrder {true};
+};
+
+/** Measure the energy spent awake, asleep and in transitions from RAPL and battery counters. */
+struct EnergyPreferences {
+    bool enabled {false};
+    /** Awake sampling interval; 0 samples just often enough not to miss a RAPL counter wrap. */
+    int sampleMinutes {0};
+};
+
+/** Let systemd timers sleep and wake the machine instead of the resident daemon. */
+struct TimerBackendPreferences {
+    bool enabled {false};
+    /** Where the generated rtcwake-gui-*.timer and .service units are written. */
+    QString unitDir {QStringLiteral("/etc/systemd/system")};
+};
+
 /** Aggregate structure storing everything we persist between runs. */
 struct AppConfig {
     AppConfig();
@@ -49,7 +202,20 @@ struct AppConfig {
     QDate singleWakeDate {QDate::currentDate()};
     QTime singleWakeTime {QTime::currentTime()};
     int actionId {static_cast<int>(PowerAction::SuspendToRam)};
+    /** Minutes in RAM before PowerAction::SuspendThenHibernate moves to disk. */
+    int hibernateDelayMinutes {180};
     WarningPreferences warning;
     QVector<WeeklyEntry> weekly;
     SessionInfo session;
+    PrefetchPreferences prefetch;
+    DeferralPreferences deferral;
+    IdleSuspendPreferences idleSuspend;
+    MaintenancePreferences maintenance;
+    ReturnToSleepPreferences returnToSleep;
+    HibernateTuningPreferences hibernateTuning;
+    WakeLeadPreferences wakeLead;
+    RtcPreferences rtc;
+    SleepEntryPreferences sleepEntry;
+    EnergyPreferences energy;
+    TimerBackendPreferences timerBackend;
 };
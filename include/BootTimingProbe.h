@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QDateTime>
+#include <QObject>
+#include <QString>
+
+/**
+ * @brief Works out when this boot powered on and when it was ready for the user.
+ *
+ * /proc/uptime anchors the kernel start on the wall clock; systemd's Manager timestamps
+ * add the firmware and boot loader time before it and the moment the default target was
+ * reached after it. When systemd is still starting units, the probe waits for its
+ * StartupFinished signal instead of polling.
+ */
+class BootTimingProbe : public QObject {
+    Q_OBJECT
+
+public:
+    /** systemd's boot timestamps in microseconds relative to the kernel start; 0 when unknown. */
+    struct Timestamps {
+        /** Firmware plus boot loader, before the kernel. */
+        quint64 firmwareUs {0};
+        quint64 userspaceUs {0};
+        /** Default target reached; 0 while startup is still running. */
+        quint64 finishUs {0};
+    };
+
+    /** Wall-clock milestones of this boot; invalid where systemd did not report one. */
+    struct Timing {
+        QDateTime poweredOn;
+        QDateTime kernelStarted;
+        QDateTime userspaceStarted;
+        QDateTime ready;
+    };
+
+    explicit BootTimingProbe(QString procRoot = QStringLiteral("/proc"), QObject *parent = nullptr);
+
+    /** Asks systemd for its timestamps; finished() follows once startup has finished. */
+    void start();
+    bool isAvailable() const;
+
+    /** Seconds since the kernel started, or -1 when /proc/uptime is unreadable. */
+    double uptimeSeconds() const;
+
+    static Timing compute(const QDateTime &now, double uptimeSecs, const Timestamps &stamps);
+
+signals:
+    void finished(const BootTimingProbe::Timing &timing);
+
+private slots:
+    void handleStartupFinished(qulonglong firmwareUs, qulonglong loaderUs, qulonglong kernelUs, qulonglong initrdUs,
+                               qulonglong userspaceUs, qulonglong totalUs);
+
+private:
+    void fetch();
+    void report(const Timestamps &stamps);
+
+    QString m_procRoot;
+    bool m_available {false};
+    bool m_reported {false};
+};
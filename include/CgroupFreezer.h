@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QString>
+
+/**
+ * @brief Freezes and thaws cgroups through the cgroup v2 `cgroup.freeze` interface.
+ *
+ * Every process below a frozen cgroup is stopped until it is thawed again, without
+ * being told about it, so a whole user session can be put to rest while the rest of
+ * the system keeps running. Freezing completes asynchronously; `cgroup.events` reports
+ * `frozen 1` once every task has stopped.
+ */
+class CgroupFreezer {
+public:
+    /** @param cgroupRoot is replaced by a fake hierarchy in tests. */
+    explicit CgroupFreezer(QString cgroupRoot = QStringLiteral("/sys/fs/cgroup"));
+
+    /** The systemd slice holding every session and the user manager of @p uid, relative to the root. */
+    static QString userSlice(uint uid);
+
+    /** Whether the root is a cgroup v2 hierarchy whose user slices can be frozen. */
+    bool supported() const;
+
+    /** Ask the kernel to freeze @p cgroup (relative to the root); false when the write is refused. */
+    bool freeze(const QString &cgroup) const;
+    bool thaw(const QString &cgroup) const;
+    /** Whether @p cgroup is frozen right now (or, while freezing, has finished doing so). */
+    bool isFrozen(const QString &cgroup) const;
+
+private:
+    QString path(const QString &cgroup, const QString &file) const;
+
+    QString m_cgroupRoot;
+};
@@ -17,6 +17,9 @@ public:
     bool save(const AppConfig &config) const;
     QString configPath() const;
 
+    /** Stable digest of the persisted form of @p config, used to detect changes across restarts. */
+    QByteArray fingerprint(const AppConfig &config) const;
+
 private:
     QString resolvedPath() const;
     AppConfig parse(const QByteArray &json) const;
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <QDateTime>
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+#include <cstdint>
+
+/**
+ * @brief Bounded ring of fixed-size suspend/wake cycle records in a memory-mapped file.
+ *
+ * The daemon appends one record per cycle; the GUI and tools map the same file
+ * read-only and scan it without any parsing. Records are plain little-endian
+ * integers so the layout is stable across builds.
+ */
+class CycleHistoryStore {
+public:
+    static constexpr quint32 kDefaultCapacity = 4096;
+    static constexpr quint32 kFormatVersion = 1;
+
+    enum class Outcome : qint32 {
+        Completed = 0,
+        Failed,
+        Canceled,
+        Skipped
+    };
+
+    /** Bits stored in Record::flags. */
+    enum Flag : qint32 {
+        MissedWhileDown = 0x1,
+        /** The transition was postponed at least once because the machine was busy. */
+        DeferredForActivity = 0x2,
+        /** Started early by the idle trigger instead of at the planned shutdown time. */
+        IdleSuspend = 0x4,
+        /** Went back to sleep right after the wake rule's maintenance jobs. */
+        MaintenanceResuspend = 0x8,
+        /** Went back to sleep because nobody used the machine after the wake. */
+        NoActivityResuspend = 0x10,
+        /** Something other than the alarm woke the machine before it. */
+        EarlyWake = 0x20,
+        /** The machine resumed well after the alarm, or the alarm never woke it. */
+        LateWake = 0x40
+    };
+
+    /** Bits stored in Record::energySources. */
+    enum EnergySource : quint32 {
+        RaplEnergy = 0x1,
+        BatteryEnergy = 0x2
+    };
+
+    /** One cycle. Timestamps are seconds since the epoch, 0 when unknown. */
+    struct Record {
+        qint64 plannedShutdown {0};
+        qint64 actualShutdown {0};
+        qint64 plannedWake {0};
+        qint64 actualResume {0};
+        qint64 wakeLatencyMs {0};
+        qint64 suspendedMs {0};
+        qint32 action {0};
+        qint32 outcome {0};
+        qint32 snoozeCount {0};
+        qint32 flags {0};
+        /**
+         * Energy in millijoules of the awake period before the cycle, the sleep itself and
+         * the transitions around it, per counter. Only valid for the sources in energySources.
+         */
+        qint64 awakeRaplMj {0};
+        qint64 asleepRaplMj {0};
+        qint64 transitionRaplMj {0};
+        qint64 awakeBatteryMj {0};
+        qint64 asleepBatteryMj {0};
+        qint64 transitionBatteryMj {0};
+        /** EnergySource bits; records written before energy accounting have none. */
+        quint32 energySources {0};
+        quint8 reserved[12] {};
+    };
+    static_assert(sizeof(Record) == 128, "CycleHistoryStore::Record layout must stay fixed");
+
+    explicit CycleHistoryStore(QString path, quint32 capacity = kDefaultCapacity);
+    ~CycleHistoryStore();
+
+    CycleHistoryStore(const CycleHistoryStore &) = delete;
+    CycleHistoryStore &operator=(const CycleHistoryStore &) = delete;
+
+    /** Map the file, creating it first when @p writable is set. */
+    bool open(bool writable);
+    void close();
+    bool isOpen() const;
+
+    bool append(const Record &record);
+
+    /** Records still held in the ring, oldest first; optionally only those resumed after @p since. */
+    QVector<Record> records(const QDateTime &since = QDateTime()) const;
+    quint64 totalAppended() const;
+    quint32 capacity() const;
+    QString path() const;
+
+    /** Seconds spent asleep by completed cycles that resumed after @p since. */
+    static qint64 sleptSeconds(const QVector<Record> &records, const QDateTime &since = QDateTime());
+
+private:
+    struct Header {
+        char magic[8];
+        quint32 version;
+        quint32 recordSize;
+        quint32 capacity;
+        quint32 reserved0;
+        quint64 total;
+        quint8 reserved[32];
+    };
+    static_assert(sizeof(Header) == 64, "CycleHistoryStore::Header layout must stay fixed");
+
+    Header *header() const;
+    Record *slot(quint64 index) const;
+    bool initialize();
+
+    QString m_path;
+    quint32 m_requestedCapacity;
+    QFile m_file;
+    uchar *m_map {nullptr};
+    qint64 m_mapSize {0};
+    bool m_writable {false};
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <QDateTime>
+#include <QObject>
+
+#include <functional>
+
+/**
+ * @brief Timer handed out by a DaemonClock; emits timeout() like QTimer.
+ */
+class DaemonTimer : public QObject {
+    Q_OBJECT
+
+public:
+    using QObject::QObject;
+
+    /** Arm the timer @p msecs from now; values beyond QTimer's int range are allowed. */
+    virtual void start(qint64 msecs) = 0;
+    virtual void stop() = 0;
+    virtual bool isActive() const = 0;
+    virtual void setSingleShot(bool singleShot) = 0;
+    virtual void setInterval(qint64 msecs) = 0;
+    /** Re-arm with the interval set via setInterval(). */
+    void start() { start(interval()); }
+    virtual qint64 interval() const = 0;
+    /** Accuracy hint; the daemon uses Qt::VeryCoarseTimer so idle deadlines coalesce. */
+    virtual void setTimerType(Qt::TimerType type) { Q_UNUSED(type) }
+
+signals:
+    void timeout();
+};
+
+/**
+ * @brief Emits changed() when wall time jumps against monotonic time.
+ *
+ * Covers settimeofday(), NTP steps and resume from a suspend the daemon did not
+ * initiate, which replaces polling the clock.
+ */
+class ClockChangeWatcher : public QObject {
+    Q_OBJECT
+
+public:
+    using QObject::QObject;
+
+signals:
+    void changed();
+};
+
+/**
+ * @brief Source of time and timers for the daemon.
+ *
+ * The production implementation forwards to the system clocks and QTimer; tests
+ * substitute SimulatedClock to run months of schedules instantly.
+ */
+class DaemonClock {
+public:
+    virtual ~DaemonClock() = default;
+
+    virtual QDateTime now() const = 0;
+    /** Milliseconds that stop while suspended (CLOCK_MONOTONIC). */
+    virtual qint64 monotonicMs() const = 0;
+    /** Milliseconds that keep counting while suspended (CLOCK_BOOTTIME). */
+    virtual qint64 bootMs() const = 0;
+    /** Milliseconds of CLOCK_MONOTONIC_RAW: stops while suspended and is never slewed by NTP. */
+    virtual qint64 rawMonotonicMs() const = 0;
+    /** Whether NTP (or a similar service) currently disciplines the wall clock. */
+    virtual bool isSynchronized() const = 0;
+
+    virtual DaemonTimer *createTimer(QObject *parent) = 0;
+    virtual ClockChangeWatcher *createChangeWatcher(QObject *parent) = 0;
+    /** Block the caller for @p msecs; only for short waits inside a transition, which blocks the event loop anyway. */
+    virtual void pause(qint64 msecs) = 0;
+
+    /** Run @p callback once after @p msecs unless @p context is destroyed first. */
+    void singleShot(qint64 msecs, QObject *context, std::function<void()> callback);
+
+    /** Process-wide clock backed by the real system time. */
+    static DaemonClock &system();
+};
+
+/**
+ * @brief DaemonClock backed by clock_gettime() and QTimer.
+ */
+class SystemClock : public DaemonClock {
+public:
+    QDateTime now() const override;
+    qint64 monotonicMs() const override;
+    qint64 bootMs() const override;
+    qint64 rawMonotonicMs() const override;
+    /** adjtimex() reports no TIME_ERROR and STA_UNSYNC is clear. */
+    bool isSynchronized() const override;
+    DaemonTimer *createTimer(QObject *parent) override;
+    /** Backed by a CLOCK_REALTIME timerfd with TFD_TIMER_CANCEL_ON_SET. */
+    ClockChangeWatcher *createChangeWatcher(QObject *parent) override;
+    void pause(qint64 msecs) override;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "RtcWakeController.h"
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QString>
+
+/**
+ * @brief Small checksummed snapshot of the daemon's runtime plan.
+ *
+ * The journal is rewritten atomically after every state change so a restarted
+ * daemon can resume the exact plan (including snoozes) without reprogramming the
+ * RTC. The file holds one compact JSON line followed by its SHA-256 digest; a
+ * mismatch means the snapshot is ignored.
+ */
+class DaemonStateJournal {
+public:
+    struct State {
+        QDateTime nextShutdown;
+        QDateTime nextWake;
+        QDateTime cyclePlannedShutdown;
+        QDateTime armedAlarm;
+        /** Set while rtcwake runs, so a restart can tell an executed transition from a missed one. */
+        QDateTime transitionStarted;
+        PowerAction action {PowerAction::None};
+        /** How much earlier than nextWake the RTC was armed for the running transition. */
+        qint64 readyLeadMs {0};
+        bool snoozeActive {false};
+        int snoozeCount {0};
+        QByteArray configFingerprint;
+        QDateTime savedAt;
+        qint64 pid {0};
+    };
+
+    explicit DaemonStateJournal(QString path);
+
+    bool save(const State &state) const;
+    bool load(State &state) const;
+    bool clear() const;
+    QString path() const;
+
+private:
+    QString m_path;
+};
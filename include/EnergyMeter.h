@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QMap>
+#include <QString>
+
+/**
+ * @brief Running energy totals from RAPL and battery counters.
+ *
+ * RAPL (/sys/class/powercap/intel-rapl:N/energy_uj) counts what the CPU packages, or
+ * the whole platform where a `psys` zone exists, used while awake. The counters wrap at
+ * max_energy_range_uj, so they have to be read more often than that takes. Batteries
+ * (/sys/class/power_supply/ with type "Battery") report energy_now, or charge_now
+ * times voltage_now. That is coarse, but it is the only counter that keeps going while
+ * the machine sleeps. Each sample() folds the change since the previous one into the
+ * totals. Differences between two totals give the energy of the period in between.
+ */
+class EnergyMeter {
+public:
+    /** Package power no sampling interval has to allow for when guarding against wraps. */
+    static constexpr double kMaxWatts = 250.0;
+
+    /** Microjoules used since the first sample, by source. */
+    struct Energy {
+        qint64 raplUj {0};
+        /** Drained from the batteries; negative when they charged more than they drained. */
+        qint64 batteryUj {0};
+        bool hasRapl {false};
+        bool hasBattery {false};
+    };
+
+    explicit EnergyMeter(QString sysRoot = QStringLiteral("/sys"));
+
+    /**
+     * Read every counter and fold the changes into the totals. Across a sleep a RAPL
+     * counter that went backwards was reset rather than wrapped, so set @p acrossSleep
+     * for the first sample after a resume.
+     */
+    Energy sample(bool acrossSleep = false);
+    Energy totals() const;
+    /** Longest interval between samples that cannot miss a RAPL wrap; 0 without RAPL. */
+    qint64 wrapSafeIntervalMs() const;
+
+    /** Energy used between @p from and @p to; only sources both have are available. */
+    static Energy since(const Energy &from, const Energy &to);
+
+private:
+    struct RaplZone {
+        qint64 energyUj {0};
+        qint64 rangeUj {0};
+    };
+
+    QMap<QString, RaplZone> readRapl() const;
+    /** Energy left in each battery, in microjoules. */
+    QMap<QString, qint64> readBatteries() const;
+
+    QString m_sysRoot;
+    QMap<QString, qint64> m_raplLast;
+    QMap<QString, qint64> m_batteryLast;
+    qint64 m_raplRangeUj {0};
+    Energy m_totals;
+};
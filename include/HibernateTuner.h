@@ -0,0 +1,77 @@
+#pragma once
+
+#include "AppConfig.h"
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief Applies a hibernation image policy and keeps timings per policy.
+ *
+ * apply() runs right before `rtcwake -m disk`: it sizes the image, optionally drops
+ * clean caches and compacts memory, and selects the disk mode and compressor where the
+ * kernel offers a choice. The kernel logs how long writing and reading the image took;
+ * imageStats() picks those lines out of /dev/kmsg after resume so they can be recorded
+ * against the setting key that produced them.
+ */
+class HibernateTuner {
+public:
+    /** What apply() ended up with; @c key identifies the setting in the stats. */
+    struct Applied {
+        QString key;
+        qint64 imageBytes {-1};
+        QStringList errors;
+    };
+
+    /** Image write and read as reported by the kernel; seconds are -1 when not logged. */
+    struct ImageStats {
+        qint64 writtenKiB {0};
+        double writeSeconds {-1.0};
+        qint64 readKiB {0};
+        double readSeconds {-1.0};
+    };
+
+    /** Running totals for one setting key. */
+    struct SettingStats {
+        int count {0};
+        double resumeSecondsSum {0.0};
+        int writeCount {0};
+        double writeSecondsSum {0.0};
+        int readCount {0};
+        double readSecondsSum {0.0};
+        qint64 lastImageBytes {-1};
+
+        double meanResumeSeconds() const;
+        double meanWriteSeconds() const;
+        double meanReadSeconds() const;
+        /** Mean time the machine spends on hibernation itself: write plus resume. */
+        double costSeconds() const;
+    };
+
+    explicit HibernateTuner(QString sysRoot = QStringLiteral("/sys"), QString procRoot = QStringLiteral("/proc"),
+                            QString kmsgPath = QStringLiteral("/dev/kmsg"));
+
+    /** Setting key for @p prefs without touching the system. */
+    static QString settingKey(const HibernateTuningPreferences &prefs);
+    Applied apply(const HibernateTuningPreferences &prefs) const;
+
+    /** Sequence number of the newest kernel log record, 0 when the log cannot be read. */
+    quint64 kmsgSequence() const;
+    /** Newest image write/read lines logged after record @p afterSequence. */
+    ImageStats imageStats(quint64 afterSequence) const;
+
+    static QMap<QString, SettingStats> loadStats(const QString &path);
+    /** Adds one hibernation of @p key; @p resumeSeconds is the wake delay measured by the daemon. */
+    static bool recordSample(const QString &path, const QString &key, qint64 imageBytes, const ImageStats &image,
+                             double resumeSeconds);
+    /** Key with the lowest costSeconds() among settings with at least @p minSamples samples. */
+    static QString bestSetting(const QMap<QString, SettingStats> &stats, int minSamples = 3);
+
+private:
+    bool writeValue(const QString &path, const QByteArray &value, QStringList &errors) const;
+
+    QString m_sysRoot;
+    QString m_procRoot;
+    QString m_kmsgPath;
+};
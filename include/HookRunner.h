@@ -0,0 +1,73 @@
+#pragma once
+
+#include <QObject>
+#include <QProcessEnvironment>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * @brief Runs the executables of a hook directory (e.g. `pre-suspend.d/`) around a transition.
+ *
+ * Hooks start in name order, at most maxParallel() at a time, and a hook waits for every
+ * hook named in its `# rtcwake-after: a b` header line. Each hook has its own deadline
+ * (`# rtcwake-timeout: <seconds>` or the default) after which it is killed, so a pipeline
+ * takes about as long as its slowest dependency chain rather than the sum of all hooks.
+ * run() blocks in a local event loop until every hook finished.
+ */
+class HookRunner : public QObject {
+    Q_OBJECT
+
+public:
+    struct Hook {
+        QString name;
+        QString path;
+        QStringList after;
+        int timeoutMs {0};
+    };
+
+    struct Result {
+        QString name;
+        int exitCode {-1};
+        bool timedOut {false};
+        qint64 elapsedMs {0};
+        /** Last line of the hook's output, or why it never ran. */
+        QString message;
+
+        bool succeeded() const;
+    };
+
+    struct Report {
+        QVector<Result> results;
+        qint64 elapsedMs {0};
+
+        bool succeeded() const;
+        /** Result with the longest runtime, or nullptr when no hook ran. */
+        const Result *slowest() const;
+    };
+
+    static constexpr int kDefaultTimeoutMs = 30 * 1000;
+    static constexpr int kDefaultMaxParallel = 4;
+
+    explicit HookRunner(QObject *parent = nullptr);
+
+    void setMaxParallel(int count);
+    int maxParallel() const;
+    void setDefaultTimeout(int msecs);
+    void setEnvironment(const QProcessEnvironment &environment);
+
+    /** True while run() is executing; nested calls are refused. */
+    bool isRunning() const;
+
+    /** Executable regular files of @p directory in name order, with their headers parsed. */
+    static QVector<Hook> discover(const QString &directory, int defaultTimeoutMs = kDefaultTimeoutMs);
+
+    /** Run every hook of @p directory with @p arguments; a missing directory is an empty pipeline. */
+    Report run(const QString &directory, const QStringList &arguments);
+
+private:
+    int m_maxParallel {kDefaultMaxParallel};
+    int m_defaultTimeoutMs {kDefaultTimeoutMs};
+    QProcessEnvironment m_environment;
+    bool m_running {false};
+};
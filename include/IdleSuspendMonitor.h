@@ -0,0 +1,75 @@
+#pragma once
+
+#include "DaemonClock.h"
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class QSocketNotifier;
+
+/**
+ * @brief Detects "no pressure stall and no session activity for N minutes" without polling.
+ *
+ * Kernel PSI triggers (`some <stall> <window>` written to /proc/pressure/<resource>)
+ * wake the monitor only when a resource is under pressure. After such an event the
+ * triggers are muted and a single timer re-arms them one idle period later, so a busy
+ * machine costs one wakeup per idle period. idle() fires once a whole period passed
+ * with the triggers armed and silent while the session was idle; the monitor then
+ * stays quiet until start() is called again.
+ */
+class IdleSuspendMonitor : public QObject {
+    Q_OBJECT
+
+public:
+    struct Settings {
+        qint64 idleMs {30 * 60 * 1000};
+        /** Stall share of the PSI window that counts as activity. */
+        int pressurePercent {5};
+        QStringList resources {QStringLiteral("cpu"), QStringLiteral("io"), QStringLiteral("memory")};
+    };
+
+    IdleSuspendMonitor(DaemonClock *clock, QString procRoot, QObject *parent = nullptr);
+    ~IdleSuspendMonitor() override;
+
+    /** (Re)start a quiet period; PSI triggers are opened on first use. Stays stopped without PSI. */
+    void start(const Settings &settings);
+    void stop();
+    bool isActive() const;
+    /** Number of PSI triggers that could be armed. */
+    int triggerCount() const;
+
+public slots:
+    /** Something happened that should postpone idleness (pressure event, user input). */
+    void noteActivity();
+    /** Session idle hint from logind; while false the monitor sleeps entirely. */
+    void setSessionIdle(bool idle);
+
+signals:
+    void idle();
+
+private:
+    enum class State {
+        Stopped,
+        Watching,
+        Backoff,
+        SessionActive
+    };
+
+    void openTriggers();
+    void closeTriggers();
+    void setTriggersEnabled(bool enabled);
+    void drainTriggers();
+    void beginQuietPeriod();
+    void handleTimeout();
+
+    DaemonClock *m_clock;
+    QString m_procRoot;
+    Settings m_settings;
+    DaemonTimer *m_timer;
+    QVector<int> m_fds;
+    QVector<QSocketNotifier *> m_notifiers;
+    State m_state {State::Stopped};
+    bool m_sessionIdle {true};
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "AppConfig.h"
+
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief Reads the kernel's load, pressure and throughput counters to tell whether the
+ *        machine is busy enough to postpone a power transition.
+ *
+ * Throughput limits need two snapshots taken some seconds apart; load, pressure and
+ * blocking processes are judged on the later one. Everything is read below a
+ * configurable proc root so tests can feed in canned files.
+ */
+class IdlenessProbe {
+public:
+    struct Snapshot {
+        qint64 monotonicMs {0};
+        double load1 {-1.0};
+        /** PSI `some avg10` percentages, -1 when the kernel has no PSI support. */
+        double cpuPressure {-1.0};
+        double ioPressure {-1.0};
+        double memoryPressure {-1.0};
+        quint64 diskBytes {0};
+        quint64 netBytes {0};
+        /** Entries of the blocking list that were running. */
+        QStringList blockingProcesses;
+        bool valid {false};
+    };
+
+    explicit IdlenessProbe(QString procRoot = QStringLiteral("/proc"));
+
+    Snapshot sample(qint64 monotonicMs, const QStringList &blockingProcesses) const;
+
+    /** Human-readable reasons the machine counts as busy; empty means idle. */
+    static QStringList busyReasons(const Snapshot &before, const Snapshot &after, const DeferralPreferences &limits,
+                                   int cpuCount);
+
+private:
+    double readPressure(const QString &resource) const;
+    quint64 readDiskBytes() const;
+    quint64 readNetBytes() const;
+    QStringList findProcesses(const QStringList &names) const;
+
+    QString m_procRoot;
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief Reads and writes the small attribute files of sysfs, procfs and cgroupfs.
+ *
+ * The kernel answers a refused value from write(2) itself, so writes go out unbuffered
+ * and never create a file: a missing attribute is an error, not something to make up.
+ */
+namespace KernelFiles {
+
+/** Contents of @p path without surrounding whitespace; empty when it cannot be read. */
+QByteArray readValue(const QString &path);
+
+/** Whitespace-separated words of @p path, e.g. the choices listed in /sys/power/state. */
+QStringList readTokens(const QString &path);
+
+/** MemTotal of a /proc/meminfo file, in bytes; 0 when it is missing. */
+qint64 memTotalBytes(const QString &meminfoPath);
+
+/** Write @p value to the existing attribute @p path; on failure @p error gets the reason. */
+bool writeValue(const QString &path, const QByteArray &value, QString *error = nullptr);
+
+} // namespace KernelFiles
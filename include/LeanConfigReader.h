@@ -0,0 +1,49 @@
+#pragma once
+
+#include "PlannerCore.h"
+
+#include <string>
+
+/**
+ * @brief Qt-free reader for the JSON written by ConfigRepository.
+ *
+ * Only the fields rtcwake-daemon-lean needs are extracted; unknown keys are skipped.
+ * Defaults mirror AppConfig so both daemons plan identically from the same file.
+ */
+namespace LeanConfigReader {
+
+struct Warning {
+    bool enabled {true};
+    std::string message {"System will suspend soon. Save your work."};
+    int countdownSeconds {30};
+    int snoozeMinutes {5};
+    bool soundEnabled {false};
+    std::string soundFile;
+    int soundVolume {70};
+    std::string theme {"crimson"};
+    bool fullscreen {false};
+    int width {640};
+    int height {360};
+};
+
+struct Session {
+    std::string display;
+    std::string xdgRuntimeDir;
+    std::string dbusAddress;
+    std::string xauthority;
+    std::string waylandDisplay;
+};
+
+struct Config {
+    PlannerCore::Config plan;
+    Warning warning;
+    Session session;
+};
+
+/** Parse @p json; returns false (leaving defaults in @p config) when it is not a JSON object. */
+bool parse(const std::string &json, Config &config, std::string *error = nullptr);
+
+/** Read and parse @p path. */
+bool load(const std::string &path, Config &config, std::string *error = nullptr);
+
+} // namespace LeanConfigReader
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "LeanConfigReader.h"
+#include "PlannerCore.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Qt-free scheduler behind rtcwake-daemon-lean.
+ *
+ * One epoll loop multiplexes a CLOCK_REALTIME timerfd armed at the next shutdown
+ * (cancelled on clock changes), an inotify watch on the config directory and a
+ * signalfd for SIGTERM/SIGINT/SIGHUP. Planning goes through PlannerCore, so the
+ * schedule matches rtcwake-daemon exactly; metrics, traces, the cycle history and
+ * the state journal remain features of the Qt daemon.
+ */
+class LeanDaemon {
+public:
+    struct Options {
+        std::string configPath;
+        std::string targetUser;
+        std::string targetHome;
+        std::string warningApp;
+        /** Log the rtcwake commands instead of running them. */
+        bool dryRun {false};
+    };
+
+    explicit LeanDaemon(Options options);
+    ~LeanDaemon();
+
+    LeanDaemon(const LeanDaemon &) = delete;
+    LeanDaemon &operator=(const LeanDaemon &) = delete;
+
+    /** Run until SIGTERM/SIGINT; returns the process exit code. */
+    int run();
+
+private:
+    enum class WarningOutcome {
+        Apply,
+        Snooze,
+        Cancel
+    };
+
+    bool setup();
+    void watchConfig();
+    void reloadConfig(const char *reason);
+    void planNext(const char *reason);
+    void armTimer(std::int64_t deadlineMs);
+    void handleTimer();
+    void handleInotify();
+    bool handleSignal();
+    void executeAction();
+    /** Run `rtcwake -m mode -t wake` for the planned action and log it; returns the exit code. */
+    int sleepUntil(const char *mode, std::int64_t wakeMs);
+    /** RAM until the interim alarm, then disk (or RAM again if the wake is near) until the wake. */
+    void suspendThenHibernate();
+    WarningOutcome invokeWarning();
+    void programAlarm(std::int64_t wakeMs);
+    int runCommand(const std::vector<std::string> &argv);
+    void writeSummary() const;
+    void log(const char *category, const std::vector<std::pair<std::string, std::string>> &fields) const;
+    std::string statePath(const char *fileName) const;
+
+    Options m_options;
+    LeanConfigReader::Config m_config;
+    PlannerCore::Zone m_zone;
+    PlannerCore::Event m_next;
+    bool m_hasNext {false};
+    bool m_snoozed {false};
+    std::int64_t m_deadlineMs {0};
+    std::int64_t m_armedWakeMs {0};
+    std::string m_configDir;
+    std::string m_configName;
+    int m_epoll {-1};
+    int m_timer {-1};
+    int m_inotify {-1};
+    int m_watch {-1};
+    int m_signal {-1};
+};
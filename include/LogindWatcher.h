@@ -0,0 +1,46 @@
+#pragma once
+
+#include <QObject>
+#include <QStringList>
+#include <QVariantMap>
+
+/**
+ * @brief Follows logind's system-wide IdleHint (set by desktops after input inactivity).
+ *
+ * The hint is read once and then tracked through PropertiesChanged signals, so there is no
+ * polling. Without a system bus or logind the watcher is unavailable and reports "idle",
+ * leaving the decision to the pressure triggers alone.
+ *
+ * Sessions opening, closing or changing their active state are reported too, so callers
+ * can drop whatever they learned about a session without asking logind each time.
+ */
+class LogindWatcher : public QObject {
+    Q_OBJECT
+
+public:
+    explicit LogindWatcher(QObject *parent = nullptr);
+
+    bool isAvailable() const;
+    bool idleHint() const;
+    /**
+     * Ids of the local graphical sessions of @p uid that are still open, active ones first.
+     * Asks logind synchronously, waiting at most a second per call; empty without logind.
+     */
+    QStringList graphicalSessions(uint uid) const;
+
+signals:
+    void idleHintChanged(bool idle);
+    void sessionsChanged();
+
+private slots:
+    void handlePropertiesChanged(const QString &interface, const QVariantMap &changed, const QStringList &invalidated);
+    void handleSessionListChanged();
+    void handleSessionPropertiesChanged(const QString &interface, const QVariantMap &changed, const QStringList &invalidated);
+
+private:
+    void refresh();
+    void updateHint(bool idle);
+
+    bool m_available {false};
+    bool m_idleHint {true};
+};
@@ -16,6 +16,7 @@ class QDateEdit;
 class QLabel;
 class QLineEdit;
 class QPlainTextEdit;
+class QProcess;
 class QPushButton;
 class QSlider;
 class QSpinBox;
@@ -53,13 +54,21 @@ private:
     void connectSignals();
     void updateSoundControls();
     void updateBannerSizeControls();
+    void updateHibernateDelayControl();
 
     void loadSettings();
     void saveSettings(const QString &reason);
     void collectUiIntoConfig();
     void applyConfigToUi();
+    /** Regenerate the systemd timer units when the timer backend is on; returns a note for the summary. */
+    QString updateTimerUnits();
+    /** Run `systemctl daemon-reload` in the background for the rewritten @p changed unit files. */
+    void reloadTimerUnits(const QStringList &changed);
+    void finishTimerReload(QProcess *reload, const QStringList &changed, const QString &error);
     QString logFilePath() const;
     void refreshLogViewer();
+    void refreshLatencySummary();
+    void refreshHistorySummary();
     void appendUserLog(const QString &category, const QList<QPair<QString, QString>> &fields);
 
     PowerAction currentAction() const;
@@ -76,9 +85,12 @@ private:
     AnalogClockWidget *m_clockWidget {nullptr};
     QPlainTextEdit *m_logViewer {nullptr};
     QLabel *m_nextSummary {nullptr};
+    QLabel *m_latencySummary {nullptr};
+    QLabel *m_historySummary {nullptr};
 
     QButtonGroup *m_actionGroup {nullptr};
     QVector<PowerStateDetector::Option> m_actionOptions;
+    QSpinBox *m_hibernateDelay {nullptr};
 
     QCheckBox *m_warningEnabled {nullptr};
     QLineEdit *m_warningMessage {nullptr};
@@ -100,4 +112,7 @@ private:
 
     ConfigRepository m_configRepo;
     AppConfig m_config;
+    /** The daemon-reload in flight, and the note it left in the summary until it is done. */
+    QProcess *m_timerReload {nullptr};
+    QString m_timerReloadNote;
 };
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "AppConfig.h"
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QProcessEnvironment>
+#include <QString>
+#include <QVector>
+
+class QProcess;
+
+/**
+ * @brief Runs the maintenance jobs of a wake rule (backups, updates, fstrim) in the background.
+ *
+ * Jobs start in list order, at most maxParallel() at a time, each in its own session with
+ * the configured niceness and I/O class. A job that outlives its timeout is killed together
+ * with its children. finished() is emitted once the last job ended or cancel() was called.
+ */
+class MaintenanceRunner : public QObject {
+    Q_OBJECT
+
+public:
+    struct Result {
+        QString name;
+        int exitCode {-1};
+        bool timedOut {false};
+        /** Never started because the run was canceled first. */
+        bool skipped {false};
+        qint64 elapsedMs {0};
+        /** Last line of the job's output, or why it never ran. */
+        QString message;
+
+        bool succeeded() const;
+    };
+
+    struct Report {
+        QVector<Result> results;
+        qint64 elapsedMs {0};
+        bool canceled {false};
+
+        int failures() const;
+    };
+
+    explicit MaintenanceRunner(QObject *parent = nullptr);
+    ~MaintenanceRunner() override;
+
+    void setMaxParallel(int count);
+    void setEnvironment(const QProcessEnvironment &environment);
+
+    /** Start @p jobs; false when a run is already active or there is nothing to run. */
+    bool start(const QVector<MaintenanceJob> &jobs);
+    bool isRunning() const;
+    /** Kill running jobs and skip pending ones; finished() follows once the killed jobs exited. */
+    void cancel();
+    Report lastReport() const;
+
+signals:
+    void finished();
+
+private:
+    void startReady();
+    void finishJob(int index, int exitCode, const QString &message);
+    void complete();
+
+    QVector<MaintenanceJob> m_jobs;
+    QVector<QProcess *> m_processes;
+    QVector<QByteArray> m_output;
+    QVector<qint64> m_startOffsets;
+    Report m_report;
+    Report m_lastReport;
+    QProcessEnvironment m_environment;
+    int m_maxParallel {2};
+    int m_next {0};
+    int m_running {0};
+    int m_done {0};
+    QElapsedTimer m_total;
+    bool m_active {false};
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <QByteArray>
+#include <QMap>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <QVector>
+
+/**
+ * @brief Collects daemon counters, gauges and histograms and mirrors them into a
+ *        node_exporter textfile collector file (`*.prom`).
+ *
+ * Values are updated in memory on every event; the file is rewritten atomically
+ * at most once per flush interval, so bursts of events collapse into one write.
+ * An empty path disables the exporter entirely.
+ */
+class MetricsExporter : public QObject {
+    Q_OBJECT
+
+public:
+    explicit MetricsExporter(QString path, QObject *parent = nullptr);
+    ~MetricsExporter() override;
+
+    void defineCounter(const QString &name, const QString &help);
+    void defineGauge(const QString &name, const QString &help);
+    void defineHistogram(const QString &name, const QString &help, QVector<double> bounds);
+
+    /**
+     * @brief Update a metric. @p labels is an optional pre-rendered label set such as
+     *        `mode="mem"`; every distinct value becomes its own series.
+     */
+    void increment(const QString &name, const QString &labels = QString(), double delta = 1.0);
+    void setGauge(const QString &name, double value, const QString &labels = QString());
+    void observe(const QString &name, double value, const QString &labels = QString());
+
+    bool isEnabled() const;
+    QString path() const;
+    void setFlushInterval(int msecs);
+
+    /** Render the current state in the Prometheus text exposition format. */
+    QByteArray render() const;
+
+    /** Write pending changes immediately; returns false when the file could not be replaced. */
+    bool flush();
+
+private:
+    enum class Kind {
+        Counter,
+        Gauge,
+        Histogram
+    };
+
+    struct Series {
+        double value {0.0};
+        QVector<quint64> buckets;
+        double sum {0.0};
+        quint64 count {0};
+    };
+
+    struct Family {
+        Kind kind {Kind::Counter};
+        QString help;
+        QVector<double> bounds;
+        QMap<QString, Series> series;
+    };
+
+    void define(const QString &name, Kind kind, const QString &help, QVector<double> bounds);
+    Family *family(const QString &name, Kind kind);
+    void markDirty();
+
+    QString m_path;
+    QMap<QString, Family> m_families;
+    QTimer m_flushTimer;
+    bool m_dirty {false};
+};
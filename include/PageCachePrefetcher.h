@@ -0,0 +1,72 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <atomic>
+#include <thread>
+
+/**
+ * @brief Pulls a list of files and directory trees into the page cache after a wake.
+ *
+ * One thread walks the configured paths (without following symlinks) and hands regular
+ * files to a fixed pool of reader threads, which issue readahead(2) in chunks and fall
+ * back to posix_fadvise(POSIX_FADV_WILLNEED). Everything stops once the time budget is
+ * spent, so a long list only costs the budget.
+ */
+class PageCachePrefetcher : public QObject {
+    Q_OBJECT
+
+public:
+    struct Options {
+        QStringList paths;
+        int workers {4};
+        qint64 budgetMs {60 * 1000};
+    };
+
+    /** Totals for one configured path. */
+    struct RootTotals {
+        QString path;
+        qint64 files {0};
+        qint64 bytes {0};
+    };
+
+    struct Report {
+        QVector<RootTotals> roots;
+        qint64 files {0};
+        qint64 bytes {0};
+        /** Paths or files that could not be opened. */
+        qint64 errors {0};
+        qint64 elapsedMs {0};
+        bool budgetExhausted {false};
+        bool canceled {false};
+    };
+
+    explicit PageCachePrefetcher(QObject *parent = nullptr);
+    ~PageCachePrefetcher() override;
+
+    /** Prefetch synchronously on the calling thread plus the worker pool. */
+    static Report run(const Options &options, const std::atomic_bool *cancel = nullptr);
+
+    /** Run in the background and emit finished() on this object's thread; false if already running. */
+    bool start(const Options &options);
+    bool isRunning() const;
+    /** Stop a background run early and wait for its threads. */
+    void cancel();
+    Report lastReport() const;
+
+signals:
+    void finished();
+
+private:
+    void complete();
+
+    std::thread m_thread;
+    std::atomic_bool m_cancel {false};
+    quint64 m_generation {0};
+    /** Written by the background thread, read only after joining it. */
+    Report m_threadReport;
+    Report m_lastReport;
+};
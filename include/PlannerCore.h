@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief Qt-free schedule planning shared by SchedulePlanner and rtcwake-daemon-lean.
+ *
+ * Times are epoch milliseconds; wall-clock rules are resolved through a Zone so the
+ * Qt build can plan in any QTimeZone while the lean daemon uses the C library.
+ */
+namespace PlannerCore {
+
+/** PowerAction::SuspendThenHibernate, which this Qt-free code cannot name. */
+constexpr int kSuspendThenHibernate = 5;
+/** PowerAction::FreezeUserSession. */
+constexpr int kFreezeUserSession = 6;
+/** Below this much remaining sleep, writing and reading a hibernation image costs more than it saves. */
+constexpr std::int64_t kMinDiskSleepMs = 30 * 60 * 1000;
+
+/** Calendar date in the proleptic Gregorian calendar. */
+struct CivilDate {
+    int year {1970};
+    int month {1};
+    int day {1};
+};
+
+struct WeeklyRule {
+    /** 1 = Monday ... 7 = Sunday, matching Qt::DayOfWeek. */
+    int dayOfWeek {1};
+    bool enabled {false};
+    int shutdownMsecOfDay {0};
+    int wakeMsecOfDay {0};
+};
+
+struct Config {
+    bool hasSingle {false};
+    CivilDate singleShutdownDate;
+    int singleShutdownMsecOfDay {0};
+    CivilDate singleWakeDate;
+    int singleWakeMsecOfDay {0};
+    /** PowerAction value. */
+    int action {0};
+    /** How long a SuspendThenHibernate action stays in RAM before moving to disk. */
+    std::int64_t hibernateDelayMs {3 * 60 * 60 * 1000};
+    std::vector<WeeklyRule> weekly;
+};
+
+struct Event {
+    std::int64_t shutdownMs {0};
+    std::int64_t wakeMs {0};
+    int action {0};
+    /** Index into Config::weekly, -1 for the single event. */
+    int rule {-1};
+    /** Interim wake at which a SuspendThenHibernate event moves to disk, 0 if it stays in RAM. */
+    std::int64_t hibernateMs {0};
+};
+
+/** Conversion between local civil time and epoch milliseconds for one time zone. */
+struct Zone {
+    /** Epoch ms of @p msecOfDay on @p date; false when that local time does not exist. */
+    std::function<bool(const CivilDate &date, int msecOfDay, std::int64_t &epochMs)> toEpoch;
+    std::function<CivilDate(std::int64_t epochMs)> dateOf;
+};
+
+CivilDate addDays(const CivilDate &date, int days);
+int dayOfWeek(const CivilDate &date);
+
+/** Zone backed by mktime()/localtime_r() and the process TZ setting. */
+Zone systemZone();
+
+/**
+ * Interim alarm for @p action when sleeping from @p sleepMs until @p wakeMs: @p delayMs after
+ * going to sleep, or 0 when the action is not SuspendThenHibernate or the disk phase would be
+ * shorter than kMinDiskSleepMs.
+ */
+std::int64_t hibernateAt(int action, std::int64_t delayMs, std::int64_t sleepMs, std::int64_t wakeMs);
+
+/** Earliest shutdown strictly after @p nowMs; false when nothing is scheduled. */
+bool nextEvent(const Config &config, std::int64_t nowMs, const Zone &zone, Event &event);
+
+} // namespace PlannerCore
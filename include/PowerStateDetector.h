@@ -17,8 +17,33 @@ public:
         bool available;
     };
 
+    /** Whether a hibernation image can be written and found again on the next boot. */
+    struct HibernationSupport {
+        bool kernel {false};
+        /** /sys/power/resume names a device (not 0:0). */
+        bool resumeDevice {false};
+        qint64 swapBytes {0};
+        /** Size the kernel tries to shrink the image to (/sys/power/image_size). */
+        qint64 imageBytes {0};
+
+        bool usable() const;
+        /** Why usable() is false, empty otherwise. */
+        QString problem() const;
+    };
+
+    /** @param sysRoot, @param procRoot and @param cgroupRoot are replaced by fake trees in tests. */
+    explicit PowerStateDetector(QString sysRoot = QStringLiteral("/sys"), QString procRoot = QStringLiteral("/proc"),
+                                QString cgroupRoot = QStringLiteral("/sys/fs/cgroup"));
+
     /**
      * @brief Inspect the kernel capabilities and expose radio button metadata.
      */
     QVector<Option> detect() const;
+
+    HibernationSupport hibernation() const;
+
+private:
+    QString m_sysRoot;
+    QString m_procRoot;
+    QString m_cgroupRoot;
 };
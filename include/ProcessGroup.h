@@ -0,0 +1,25 @@
+#pragma once
+
+#include <QByteArray>
+#include <QProcess>
+#include <QString>
+
+/**
+ * @brief A QProcess whose child starts a session of its own.
+ *
+ * The child then leads a process group holding everything it spawns, so a timeout can
+ * kill a shell script together with its background children.
+ */
+class SessionProcess : public QProcess {
+public:
+    using QProcess::QProcess;
+
+protected:
+    void setupChildProcess() override;
+};
+
+/** SIGKILL the process group led by @p process, then @p process itself. */
+void killProcessGroup(QProcess *process);
+
+/** Last non-blank line of a child's @p output, cut to a length that fits a log line. */
+QString lastOutputLine(const QByteArray &output);
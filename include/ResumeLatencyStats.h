@@ -0,0 +1,65 @@
+#pragma once
+
+#include "RtcWakeController.h"
+
+#include <QDateTime>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief Per-PowerAction histograms of how late the daemon runs again after a planned wake.
+ *
+ * The latency of one transition is the distance between the planned RTC wake time and
+ * the moment rtcwake returned control to the daemon. Histograms use fixed buckets so the
+ * state file stays small no matter how many cycles are recorded.
+ */
+class ResumeLatencyStats {
+public:
+    /** Snapshot of the clocks needed to split a transition into sleep and resume time. */
+    struct ClockSample {
+        qint64 bootMs {0};
+        qint64 monotonicMs {0};
+        QDateTime realtime;
+
+        static ClockSample capture();
+    };
+
+    /** Derived numbers for one transition. */
+    struct Measurement {
+        qint64 suspendedMs {0};
+        qint64 wakeDelayMs {0};
+    };
+
+    struct Histogram {
+        QVector<quint32> buckets;
+        quint32 count {0};
+        double sumSeconds {0.0};
+        double maxSeconds {0.0};
+    };
+
+    /** Upper bounds in seconds; samples above the last bound land in an overflow bucket. */
+    static const QVector<double> &bucketBounds();
+
+    static Measurement measure(const ClockSample &before, const ClockSample &after, const QDateTime &plannedWake);
+
+    void record(PowerAction action, double seconds);
+    Histogram histogram(PowerAction action) const;
+    QList<PowerAction> actions() const;
+
+    /** Upper bucket bound that covers @p quantile of the samples, or -1 without samples. */
+    double percentile(PowerAction action, double quantile) const;
+    QString summary(PowerAction action) const;
+    /**
+     * How much earlier than the wake time to arm the RTC for @p action: the @p quantile
+     * readiness time capped at @p maxLeadMs, or 0 with fewer than @p minSamples samples.
+     */
+    qint64 leadMs(PowerAction action, double quantile, quint32 minSamples, qint64 maxLeadMs) const;
+
+    bool load(const QString &path);
+    bool save(const QString &path) const;
+
+private:
+    QMap<int, Histogram> m_histograms;
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief Lists the RTCs below /sys/class/rtc and what they can do as a wake source.
+ *
+ * Boards with several RTCs often have one that cannot raise an alarm (or cannot wake
+ * the system), so rtcwake's default is not always usable. Some alarm registers only hold
+ * a time of day or a day of the month; the kernel rejects alarms beyond that range,
+ * which probeAlarmRange() finds by trying a few distances.
+ */
+class RtcDeviceProbe {
+public:
+    struct Device {
+        QString name;
+        /** Driver name from the `name` attribute, e.g. "rtc_cmos". */
+        QString driver;
+        bool hasWakeAlarm {false};
+        /** The kernel sets the system clock from this RTC at boot. */
+        bool hctosys {false};
+        /** `device/power/wakeup` is "enabled", or absent (then the kernel did not say). */
+        bool canWake {true};
+    };
+
+    /** Alarm distances probeAlarmRange() tries, longest first. */
+    static const QVector<qint64> &rangeCandidates();
+
+    explicit RtcDeviceProbe(QString sysRoot = QStringLiteral("/sys"));
+
+    QVector<Device> devices() const;
+    /**
+     * The RTC to arm: @p preferred when it can raise a wake alarm, otherwise the one the
+     * system clock comes from, otherwise the first usable one; empty when none is.
+     */
+    QString select(const QString &preferred) const;
+    /**
+     * Longest candidate distance in seconds the RTC accepted as an alarm. Any alarm
+     * already armed in @p device is cleared. Returns 0 when even the shortest was refused
+     * or the alarm cannot be written at all.
+     */
+    qint64 probeAlarmRange(const QString &device) const;
+
+private:
+    QString deviceDir(const QString &device) const;
+
+    QString m_sysRoot;
+};
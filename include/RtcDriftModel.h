@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QDateTime>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * @brief Per-RTC drift estimate learned from suspend cycles.
+ *
+ * Each sample is how far an RTC ran ahead (positive) or behind over one sleep. The rate
+ * is a least-squares fit of gain against sleep length through the origin, so long sleeps
+ * weigh most and the RTC's one-second resolution averages out. Only the newest samples
+ * per device are kept, which lets the estimate follow ageing and temperature changes.
+ */
+class RtcDriftModel {
+public:
+    static constexpr int kMaxSamples = 32;
+    /** Samples needed before predictGainMs() compensates anything. */
+    static constexpr int kMinSamples = 3;
+    /** Shorter sleeps carry more rounding than drift and are ignored. */
+    static constexpr qint64 kMinSleepMs = 60 * 60 * 1000;
+    /** Anything faster is a clock change, not drift. */
+    static constexpr double kMaxPlausiblePpm = 2000.0;
+
+    struct Sample {
+        qint64 sleptMs {0};
+        qint64 gainMs {0};
+        QDateTime recorded;
+    };
+
+    struct Estimate {
+        double ppm {0.0};
+        /** Standard error of @c ppm, -1 until two samples exist. */
+        double stdErrorPpm {-1.0};
+        int samples {0};
+
+        bool usable() const { return samples >= kMinSamples; }
+    };
+
+    /** False when the sample is too short or implausible to learn from. */
+    bool addSample(const QString &device, qint64 sleptMs, qint64 gainMs, const QDateTime &recorded);
+    Estimate estimate(const QString &device) const;
+    /** Expected gain of @p device over @p sleepMs; 0 until the estimate is usable. */
+    qint64 predictGainMs(const QString &device, qint64 sleepMs) const;
+    QVector<Sample> samples(const QString &device) const;
+    QStringList devices() const;
+    QString summary(const QString &device) const;
+
+    bool load(const QString &path);
+    bool save(const QString &path) const;
+
+private:
+    QMap<QString, QVector<Sample>> m_samples;
+};
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "WakeupCountGate.h"
+
 #include <QObject>
 #include <QString>
 #include <QStringList>
@@ -12,7 +14,11 @@ enum class PowerAction {
     SuspendToIdle,
     SuspendToRam,
     Hibernate,
-    PowerOff
+    PowerOff,
+    /** Suspend to RAM, then hibernate at an interim alarm if the wake is still far away. */
+    SuspendThenHibernate,
+    /** Keep the system running but freeze the target user's session until the wake time. */
+    FreezeUserSession
 };
 
 /**
@@ -29,25 +35,67 @@ public:
         QString stdErr;
         QString commandLine;
         int exitCode {-1};
+        qint64 elapsedMs {0};
     };
 
     explicit RtcWakeController(QObject *parent = nullptr);
 
+    /** RTC to arm (passed to rtcwake as `-d`); empty keeps rtcwake's default. */
+    void setDevice(const QString &device);
+    /** The RTC alarms and sysfs reads refer to; rtc0 until setDevice() picks another. */
+    QString device() const;
+
     /**
      * @brief Program the RTC using rtcwake.
      * @param targetUtc Absolute wake time in UTC.
      * @param action Power transition to execute immediately.
      */
-    CommandResult scheduleWake(const QDateTime &targetUtc, PowerAction action) const;
+    virtual CommandResult scheduleWake(const QDateTime &targetUtc, PowerAction action) const;
 
     /**
      * @brief Only set the RTC alarm without leaving the current power state.
      */
-    CommandResult programAlarm(const QDateTime &targetUtc) const;
+    virtual CommandResult programAlarm(const QDateTime &targetUtc) const;
+
+    /**
+     * @brief Alarm currently armed in the RTC this controller drives.
+     * @return Same convention as armedAlarm(); overridden by simulated backends.
+     */
+    virtual qint64 currentAlarm() const;
+
+    /**
+     * @brief Read the alarm currently armed in the RTC.
+     * @return Seconds since the epoch, 0 when no alarm is armed, -1 when sysfs is unreadable.
+     */
+    static qint64 armedAlarm(const QString &device = QStringLiteral("rtc0"));
+
+    /**
+     * @brief Time the RTC currently shows, read from `since_epoch`.
+     * @return Seconds since the epoch, -1 when sysfs is unreadable.
+     */
+    static qint64 rtcTime(const QString &device = QStringLiteral("rtc0"));
+
+    /** rtcTime() of the RTC this controller drives; overridden by simulated backends. */
+    virtual qint64 currentRtcTime() const;
+
+    /**
+     * @brief Longest distance in seconds an alarm of this RTC may lie in the future.
+     * @return 0 when no limit could be established. Probing clears the armed alarm.
+     */
+    virtual qint64 alarmRangeSecs() const;
+
+    /**
+     * @brief Hand shake with /sys/power/wakeup_count right before scheduleWake().
+     * @return Pending when a wakeup event raced us and sleeping now would lose it.
+     */
+    virtual WakeupCountGate::Result armWakeupCount() const;
 
     static QString actionLabel(PowerAction action);
     static QString rtcwakeMode(PowerAction action);
 
 private:
     CommandResult runProcess(const QStringList &arguments) const;
+    QStringList deviceArguments() const;
+
+    QString m_device;
 };
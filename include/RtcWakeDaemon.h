@@ -1,8 +1,26 @@
 #pragma once
 
 #include "AppConfig.h"
+#include "BootTimingProbe.h"
 #include "ConfigRepository.h"
+#include "CycleHistoryStore.h"
+#include "DaemonClock.h"
+#include "DaemonStateJournal.h"
+#include "EnergyMeter.h"
+#include "HibernateTuner.h"
+#include "HookRunner.h"
+#include "IdleSuspendMonitor.h"
+#include "IdlenessProbe.h"
+#include "LogindWatcher.h"
+#include "MaintenanceRunner.h"
+#include "MetricsExporter.h"
+#include "PageCachePrefetcher.h"
+#include "ResumeLatencyStats.h"
+#include "RtcDriftModel.h"
 #include "RtcWakeController.h"
+#include "SessionLocator.h"
+#include "UserActivityMonitor.h"
+#include "WakeReasonProbe.h"
 
 #include <QDateTime>
 #include <QFileSystemWatcher>
@@ -10,7 +28,6 @@
 #include <QObject>
 #include <QPair>
 #include <QProcess>
-#include <QTimer>
 
 class RtcWakeDaemon : public QObject {
     Q_OBJECT
@@ -21,26 +38,141 @@ public:
         QString targetUser;
         QString targetHome;
         QString warningApp;
+        QString metricsPath;
+        QString tracePath;
+        /** Holds `pre-suspend.d/` and `post-resume.d/`; empty disables hooks. */
+        QString hooksDir;
+        /** Where the idleness check and the idle trigger read loadavg, pressure/, diskstats and net/dev. */
+        QString procRoot {QStringLiteral("/proc")};
+        /** Input devices watched for activity after a scheduled wake. */
+        QString inputDir {QStringLiteral("/dev/input")};
+        /**
+         * Where hibernation tuning writes power/image_size, power/disk and the compressor parameter,
+         * and where the RTC, wakeup source and energy counters are read.
+         */
+        QString sysRoot {QStringLiteral("/sys")};
+        /** cgroup v2 hierarchy holding the target user's slice for PowerAction::FreezeUserSession. */
+        QString cgroupRoot {QStringLiteral("/sys/fs/cgroup")};
     };
 
     explicit RtcWakeDaemon(Options options, QObject *parent = nullptr);
 
+    /**
+     * @brief Construct with an explicit time source and RTC backend.
+     * @param clock Clock and timer factory; nullptr selects the system clock.
+     * @param controller RTC backend; nullptr selects the built-in rtcwake wrapper. Not owned.
+     */
+    RtcWakeDaemon(Options options, DaemonClock *clock, RtcWakeController *controller, QObject *parent = nullptr);
+    /** Thaws a session frozen by this daemon; it must not stay frozen without a timer to wake it. */
+    ~RtcWakeDaemon() override;
+
     void start();
 
+    /** Write the in-memory trace ring as Chrome trace JSON; returns the file written or an empty string. */
+    QString dumpTrace();
+
 private slots:
     void handleConfigChanged();
-    void handlePeriodic();
+    void handleClockChanged();
     void handleEventTimeout();
+    void handlePrefetchFinished();
+    void handleSystemIdle();
+    void handleMaintenanceFinished();
+    void handleNoActivity();
+    void handleUserActivity(const QString &source);
 
 private:
+    /** Energy of one cycle, kept for appendCycleRecord(). */
+    struct CycleEnergy {
+        EnergyMeter::Energy awake;
+        EnergyMeter::Energy asleep;
+        EnergyMeter::Energy transition;
+    };
+
+    void defineMetrics();
     void watchConfig();
     void reloadConfig();
+    bool restoreState();
+    void persistState(const QDateTime &transitionStarted = QDateTime());
+    bool alarmArmedFor(const QDateTime &wake) const;
     void planNext(const QString &reason = QString());
     void scheduleEventTimer(const QDateTime &shutdown, PowerAction action);
     void cancelEventTimer();
+    /** Pre hooks, rtcwake, post hooks and bookkeeping for m_nextAction until m_nextWake. */
+    void executeTransition(qint32 flags = 0);
+    /** Two-stage sleep for PowerAction::SuspendThenHibernate until m_nextWake. */
+    RtcWakeController::CommandResult suspendThenHibernate();
+    /**
+     * Freeze the target user's slice until m_nextWake instead of sleeping; the cycle ends in
+     * thawUserSession(). False when nothing was frozen and the cycle is already recorded.
+     */
+    bool freezeUserSession();
+    void thawUserSession();
+    /** uid of Options::targetUser; -1 for an unknown user. */
+    qint64 targetUserId() const;
+    /** The target user's slice relative to Options::cgroupRoot; empty for an unknown user. */
+    QString targetUserSlice() const;
+    /** Apply the hibernation image policy right before a disk stage. */
+    void prepareHibernate();
+    /** Store the image and resume timings of the hibernation prepared last against its setting. */
+    void recordHibernate(const ResumeLatencyStats::Measurement &measurement);
+    /** Replan (or reload a config that changed meanwhile) once the event loop runs again. */
+    void finishTransition();
+    /** Start or stop the idle trigger for the configured window and arm the next window boundary. */
+    void configureIdleSuspend();
+    void ensureLogindWatcher();
     void programAlarm(const QDateTime &wake, PowerAction action);
+    /** Pick the RTC and learn how far ahead its alarm reaches, when the config asks for a change. */
+    void configureRtc();
+    /** Start or stop energy sampling for the current config. */
+    void configureEnergy();
+    /** Fold the energy counters into the meter; all -1 while energy accounting is off. */
+    EnergyMeter::Energy sampleEnergy(bool acrossSleep = false);
+    /** Split a transition's energy into awake, asleep and transition shares for the cycle record. */
+    void recordEnergy(const EnergyMeter::Energy &start, const EnergyMeter::Energy &beforeSleep,
+                      const EnergyMeter::Energy &afterSleep, const EnergyMeter::Energy &end);
+    /**
+     * Sleep in @p action until @p alarm. Beyond the RTC's alarm range this chains shorter
+     * sleeps, going straight back to sleep after each, unless someone woke the machine.
+     */
+    RtcWakeController::CommandResult sleepUntil(const QDateTime &alarm, PowerAction action);
+    /**
+     * One rtcwake sleep until @p alarmUtc behind the wakeup_count handshake, retried with
+     * backoff and walking the fallback modes when @p action keeps failing.
+     */
+    RtcWakeController::CommandResult enterSleep(const QDateTime &alarmUtc, PowerAction action);
+    /** Attribute the resume at @p resumed to a wakeup source; returns CycleHistoryStore flags. */
+    qint32 recordWakeReason(const QDateTime &resumed);
+    /** RTC alarm for @p wake, shifted by the drift the model expects until then. */
+    QDateTime rtcAlarmFor(const QDateTime &wake) const;
+    /** How long before the wake time @p action has to start to be ready by then; 0 when disabled. */
+    qint64 readyLeadMs(PowerAction action) const;
+    /** The wake time of the current transition, moved earlier by its readiness lead. */
+    QDateTime readyAlarm() const;
+    /** Time this boot against the alarm that powered the machine on for @p wake. */
+    void measureBoot(const QDateTime &alarm, const QDateTime &wake);
+    void recordBootTiming(const QDateTime &alarm, const QDateTime &wake, const BootTimingProbe::Timing &timing);
+    /** Wait for NTP to correct the wall clock after a resume; the correction is the RTC's error. */
+    void startDriftProbe(qint64 sleptMs, qint64 resumeWallOffsetMs);
+    void finishDriftProbe(quint64 probe, int attempt);
     void log(const QString &message) const;
     QString resolveLogPath() const;
+    QString statePath(const QString &fileName) const;
+    ResumeLatencyStats::Measurement recordResumeLatency(PowerAction action, const ResumeLatencyStats::ClockSample &before,
+                                                        const ResumeLatencyStats::ClockSample &after, const QDateTime &alarm);
+    void appendCycleRecord(CycleHistoryStore::Outcome outcome, const QDateTime &actualShutdown = QDateTime(),
+                           const QDateTime &actualResume = QDateTime(),
+                           const ResumeLatencyStats::Measurement &measurement = ResumeLatencyStats::Measurement(),
+                           qint32 flags = 0);
+    ResumeLatencyStats::ClockSample sampleClocks() const;
+    HookRunner::Report runHooks(const QString &phase, PowerAction action);
+    void startPrefetch();
+    /** Index into m_config.weekly of the rule behind the current plan, -1 if none. */
+    int plannedRule() const;
+    void startMaintenance(int rule, const ResumeLatencyStats::ClockSample &woke);
+    /** Give the user the grace period to show up before @p action is applied again. */
+    void startActivityWatch(PowerAction action);
+    bool deferForActivity();
     void appendPersistentLog(const QString &category, const QList<QPair<QString, QString>> &fields) const;
 
     enum class WarningOutcome {
@@ -50,20 +182,92 @@ private:
     };
 
     WarningOutcome invokeWarning(const QDateTime &shutdown, PowerAction action);
-    QProcessEnvironment buildUserEnvironment() const;
+    /**
+     * The target user's graphical session with a live display, found from logind and the
+     * session's processes and kept until logind reports a change; empty when there is none.
+     */
+    SessionLocator::Session userSession();
+    QProcessEnvironment buildUserEnvironment(const SessionLocator::Session &session) const;
 
     friend class RtcWakeLoggingTest;
+    friend class DaemonSimulationTest;
 
     ConfigRepository m_repo;
     AppConfig m_config;
     Options m_options;
+    DaemonClock *m_clock;
+    MetricsExporter m_metrics;
     QFileSystemWatcher m_watcher;
-    QTimer m_periodic;
-    QTimer m_eventTimer;
+    ClockChangeWatcher *m_clockWatcher;
+    DaemonTimer *m_eventTimer;
+    DaemonTimer *m_idleWindowTimer;
+    DaemonTimer *m_energyTimer;
+    DaemonTimer *m_thawTimer;
+    IdleSuspendMonitor *m_idleMonitor;
+    UserActivityMonitor *m_activityMonitor;
+    LogindWatcher *m_logind {nullptr};
+    BootTimingProbe *m_bootProbe {nullptr};
+    HookRunner m_hooks;
+    PageCachePrefetcher m_prefetcher;
+    MaintenanceRunner m_maintenance;
+    IdlenessProbe m_idleProbe;
+    IdlenessProbe::Snapshot m_idleBaseline;
+    HibernateTuner m_hibernateTuner;
+    HibernateTuner::Applied m_hibernateTuning;
+    quint64 m_kmsgSequence {0};
     QDateTime m_nextShutdown;
+    /** Monotonic time m_eventTimer fires at, which a wall-clock step does not move. */
+    qint64 m_eventDueMonoMs {0};
     QDateTime m_nextWake;
     PowerAction m_nextAction {PowerAction::None};
-    RtcWakeController m_controller;
+    /** How much earlier than m_nextWake the current transition armed the RTC. */
+    qint64 m_readyLeadMs {0};
+    RtcWakeController m_defaultController;
+    RtcWakeController *m_controller;
     QString m_rtcwakeLogPath;
+    ResumeLatencyStats m_resumeStats;
+    CycleHistoryStore m_history;
+    DaemonStateJournal m_journal;
+    QDateTime m_armedAlarm;
+    /** What the RTC was actually armed with for m_armedAlarm, drift compensation included. */
+    qint64 m_armedRtcSecs {0};
+    RtcDriftModel m_drift;
+    RtcPreferences m_rtcPreferences;
+    bool m_rtcConfigured {false};
+    /** Furthest an alarm may be armed ahead; 0 means no known limit. */
+    qint64 m_alarmRangeSecs {0};
+    WakeReasonProbe m_wakeProbe;
+    /** Wakeup source counters right before the last rtcwake call. */
+    WakeReasonProbe::Snapshot m_wakeBaseline;
+    EnergyMeter m_energy;
+    bool m_energyEnabled {false};
+    /** Meter totals when the machine last became awake. */
+    EnergyMeter::Energy m_awakeEnergy;
+    CycleEnergy m_cycleEnergy;
+    SessionLocator m_sessionLocator;
+    /** Where the last warning found the user's display; empty until looked up again. */
+    SessionLocator::Session m_userSession;
+    /** Bumped by every transition so a probe from an earlier resume is dropped. */
+    quint64 m_driftProbe {0};
+    qint64 m_driftSleptMs {0};
+    /** Wall clock minus raw monotonic time right after the last resume. */
+    qint64 m_driftResumeOffsetMs {0};
+    QDateTime m_cyclePlannedShutdown;
+    int m_snoozeCount {0};
     bool m_snoozeActive {false};
+    qint64 m_deferredMs {0};
+    bool m_idleProbePending {false};
+    bool m_transitionActive {false};
+    /** The slice frozen for the current cycle, empty while no session is frozen. */
+    QString m_frozenSlice;
+    QDateTime m_frozenSince;
+    bool m_reloadDeferred {false};
+    bool m_maintenanceResuspend {false};
+    QTime m_maintenanceResuspendUntil;
+    qint64 m_maintenanceWokeBootMs {0};
+    /** The event timer fired while jobs ran; apply the action once they are done. */
+    bool m_maintenanceHeldAction {false};
+    /** The action that brought the machine here, applied again if nobody shows up. */
+    PowerAction m_returnAction {PowerAction::None};
+    qint64 m_activityWokeBootMs {0};
 };
@@ -10,6 +10,10 @@ struct Event {
     QDateTime shutdown;
     QDateTime wake;
     PowerAction action {PowerAction::None};
+    /** Index into AppConfig::weekly of the rule behind this event, -1 for the single event. */
+    int weeklyIndex {-1};
+    /** When a SuspendThenHibernate event moves from RAM to disk; invalid if it stays in RAM. */
+    QDateTime hibernateAt;
 };
 
 bool nextEvent(const AppConfig &config, const QDateTime &now, Event &event);
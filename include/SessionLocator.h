@@ -0,0 +1,56 @@
+#pragma once
+
+#include "AppConfig.h"
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * @brief Finds the graphical sessions of a user right now, from the processes running in them.
+ *
+ * Session processes carry DISPLAY, WAYLAND_DISPLAY, XAUTHORITY and the bus address in
+ * `/proc/<pid>/environ`; the runtime directory and bus socket fill in what they leave out.
+ * A session only counts while its display socket accepts connections, so a display that
+ * went away with a logout is never handed to the warning helper.
+ */
+class SessionLocator {
+public:
+    struct Session {
+        /** logind session id (XDG_SESSION_ID), empty when the process did not carry one. */
+        QString id;
+        /** The process the environment was read from. */
+        qint64 pid {0};
+        QString display;
+        QString waylandDisplay;
+        QString xdgRuntimeDir;
+        QString dbusAddress;
+        QString xauthority;
+
+        bool graphical() const { return !display.isEmpty() || !waylandDisplay.isEmpty(); }
+    };
+
+    /** @param procRoot, @p runRoot and @p x11SocketDir are replaced by fake trees in tests. */
+    explicit SessionLocator(QString procRoot = QStringLiteral("/proc"), QString runRoot = QStringLiteral("/run"),
+                            QString x11SocketDir = QStringLiteral("/tmp/.X11-unix"));
+
+    /**
+     * Live graphical sessions of @p uid, one per session id. With @p sessionIds (from logind,
+     * active session first) only those sessions are returned, in that order; otherwise the
+     * most recently started process wins.
+     */
+    QVector<Session> discover(uint uid, const QStringList &sessionIds = {}) const;
+
+    /** Whether the display of @p session accepts connections; never blocks. */
+    bool alive(const Session &session) const;
+
+    /** @p info as a session, for the values the GUI saved when nothing better is found. */
+    static Session fromSessionInfo(const SessionInfo &info);
+
+private:
+    Session readProcess(qint64 pid, uint uid) const;
+
+    QString m_procRoot;
+    QString m_runRoot;
+    QString m_x11SocketDir;
+};
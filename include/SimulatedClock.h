@@ -0,0 +1,97 @@
+#pragma once
+
+#include "DaemonClock.h"
+
+#include <QList>
+#include <QPointer>
+
+class SimulatedTimer;
+
+/**
+ * @brief Manually driven DaemonClock for deterministic tests.
+ *
+ * Time only moves through advanceTo()/advanceBy(), which fire due timers in
+ * deadline order, or through suspend(), which models a system sleep: wall and
+ * boot time jump while monotonic time stands still. Timer deadlines are
+ * monotonic like QTimer's, so they do not catch up with a sleep; wall-clock
+ * jumps notify the change watchers on the next advance instead, like the
+ * kernel's timerfd cancellation.
+ */
+class SimulatedClock : public DaemonClock {
+public:
+    explicit SimulatedClock(const QDateTime &start);
+    ~SimulatedClock() override;
+
+    QDateTime now() const override;
+    qint64 monotonicMs() const override;
+    qint64 bootMs() const override;
+    /** Same as monotonicMs(): the simulation has no slewing, only setWallClock() steps. */
+    qint64 rawMonotonicMs() const override;
+    bool isSynchronized() const override;
+    DaemonTimer *createTimer(QObject *parent) override;
+    ClockChangeWatcher *createChangeWatcher(QObject *parent) override;
+    /** Let @p msecs pass without firing timers, as a blocked caller would; overdue ones fire on the next advance. */
+    void pause(qint64 msecs) override;
+
+    /** Move time forward to @p target, firing every timer that falls due on the way. */
+    void advanceTo(const QDateTime &target);
+    void advanceBy(qint64 msecs);
+
+    /** Jump to @p resume as if the machine slept; pending timers keep their monotonic deadlines. */
+    void suspend(const QDateTime &resume);
+    /** Step the wall clock (e.g. an NTP correction) without moving monotonic or boot time. */
+    void setWallClock(const QDateTime &wall);
+    /** What isSynchronized() reports; true by default. */
+    void setSynchronized(bool synchronized);
+
+    int activeTimers() const;
+    quint64 firedTimers() const;
+
+private:
+    friend class SimulatedTimer;
+
+    void registerTimer(SimulatedTimer *timer);
+    void unregisterTimer(SimulatedTimer *timer);
+    SimulatedTimer *nextDue(qint64 limitMonotonicMs) const;
+    bool deliverClockChange();
+
+    QDateTime m_now;
+    qint64 m_monotonicMs {0};
+    qint64 m_bootMs {0};
+    quint64 m_sequence {0};
+    quint64 m_fired {0};
+    bool m_clockChangePending {false};
+    bool m_synchronized {true};
+    QList<SimulatedTimer *> m_timers;
+    QList<QPointer<ClockChangeWatcher>> m_watchers;
+};
+
+/**
+ * @brief DaemonTimer whose deadline lives on a SimulatedClock.
+ */
+class SimulatedTimer : public DaemonTimer {
+    Q_OBJECT
+
+public:
+    SimulatedTimer(SimulatedClock *clock, QObject *parent);
+    ~SimulatedTimer() override;
+
+    void start(qint64 msecs) override;
+    void stop() override;
+    bool isActive() const override;
+    void setSingleShot(bool singleShot) override;
+    void setInterval(qint64 msecs) override;
+    qint64 interval() const override;
+
+private:
+    friend class SimulatedClock;
+
+    void fire();
+
+    SimulatedClock *m_clock;
+    qint64 m_deadlineMs {0};
+    quint64 m_sequence {0};
+    qint64 m_interval {0};
+    bool m_singleShot {false};
+    bool m_active {false};
+};
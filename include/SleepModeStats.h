@@ -0,0 +1,38 @@
+#pragma once
+
+#include <QDateTime>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief How often each rtcwake mode actually got the machine to sleep.
+ *
+ * Every attempt to enter a mode is counted, so a mode that keeps failing on this machine
+ * (a firmware that cannot do S3, a swap that is too small for the image) moves to the
+ * back of the fallback chain. Counts are halved once they grow large, which lets the
+ * order follow a kernel or firmware update instead of being stuck with old history.
+ */
+class SleepModeStats {
+public:
+    /** Attempts above which a mode's counts are halved. */
+    static constexpr int kMaxAttempts = 64;
+
+    struct Counts {
+        int attempts {0};
+        int successes {0};
+        QDateTime lastFailure;
+
+        /** Success rate with one success and one failure assumed, so an untried mode rates 0.5. */
+        double rate() const;
+    };
+
+    static QMap<QString, Counts> load(const QString &path);
+    static bool record(const QString &path, const QString &mode, bool success, const QDateTime &when);
+
+    /**
+     * Modes to fall back to after @p requested: @p chain without it, the most reliable
+     * first. Modes with the same rate keep their configured order.
+     */
+    static QStringList fallbackOrder(const QString &requested, const QStringList &chain, const QMap<QString, Counts> &stats);
+};
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <QJsonObject>
+#include <QString>
+
+/**
+ * Atomically replace the daemon state file @p path with @p object as one compact JSON line,
+ * creating the state directory first. Failures are logged; returns false on any of them.
+ */
+bool saveJsonState(const QString &path, const QJsonObject &object);
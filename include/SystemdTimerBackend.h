@@ -0,0 +1,47 @@
+#pragma once
+
+#include "AppConfig.h"
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief Compiles the schedule into systemd timer units for hosts without the resident daemon.
+ *
+ * `rtcwake-gui-sleep.timer` starts the power action at each shutdown time, and
+ * `rtcwake-gui-wake.timer` has WakeSystem=true, so systemd arms the RTC to resume the
+ * machine at each wake time. Weekly rules become weekly OnCalendar= expressions that keep
+ * firing without anything regenerating the units; the single event becomes an absolute one.
+ */
+class SystemdTimerBackend {
+public:
+    /** Unit file name to contents. */
+    using Units = QMap<QString, QByteArray>;
+
+    /** Every generated unit starts with this, so stale ones can be told from the admin's. */
+    static constexpr const char *kUnitPrefix = "rtcwake-gui-";
+    /** Two weeks of events see every weekly rule, even one a DST change skips once. */
+    static constexpr int kHorizonDays = 14;
+
+    explicit SystemdTimerBackend(QString unitDir = QStringLiteral("/etc/systemd/system"));
+
+    /** Units for what SchedulePlanner plans from @p now on; empty when nothing is scheduled. */
+    static Units compile(const AppConfig &config, const QDateTime &now);
+    /** The systemctl verb performing @p action; empty when no timer can (None, PowerOff, FreezeUserSession). */
+    static QString systemctlVerb(PowerAction action);
+
+    /**
+     * Write the units whose text differs from the files on disk and remove generated units
+     * @p units no longer has. @p changed receives the file names touched; empty means the
+     * plan did not change.
+     */
+    bool apply(const Units &units, QStringList *changed = nullptr) const;
+
+    QString unitDir() const;
+
+private:
+    QString m_unitDir;
+};
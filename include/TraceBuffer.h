@@ -0,0 +1,77 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+#include <atomic>
+#include <memory>
+
+/**
+ * @brief Fixed-size ring of trace events that can be dumped as Chrome trace-event JSON.
+ *
+ * Storage is allocated once up front; recording an event only reads the clock and
+ * fills one slot, so trace points can stay compiled in permanently. Names and
+ * categories must be string literals because only the pointers are stored.
+ */
+class TraceBuffer {
+public:
+    static constexpr int kDefaultCapacity = 4096;
+
+    /** Single recorded span or instant. */
+    struct Event {
+        const char *category {nullptr};
+        const char *name {nullptr};
+        qint64 startUs {0};
+        qint64 durationUs {0};
+        qint64 threadId {0};
+        char phase {'X'};
+    };
+
+    explicit TraceBuffer(int capacity = kDefaultCapacity);
+
+    /** Process-wide buffer used by the daemon and controller trace points. */
+    static TraceBuffer &instance();
+
+    /** Microseconds on CLOCK_BOOTTIME, so spans covering a suspend include the sleep. */
+    static qint64 nowUs();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    void complete(const char *category, const char *name, qint64 startUs, qint64 durationUs);
+    void instant(const char *category, const char *name);
+    void clear();
+
+    int capacity() const;
+    /** Events currently held, oldest first. */
+    int size() const;
+
+    QByteArray toChromeJson() const;
+    bool dump(const QString &path) const;
+
+private:
+    void record(const Event &event);
+
+    std::unique_ptr<Event[]> m_events;
+    int m_capacity {0};
+    std::atomic<quint64> m_next {0};
+    std::atomic<bool> m_enabled {true};
+};
+
+/**
+ * @brief RAII helper that records a complete ('X') event for the enclosing scope.
+ */
+class TraceScope {
+public:
+    TraceScope(const char *category, const char *name, TraceBuffer &buffer = TraceBuffer::instance());
+    ~TraceScope();
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    TraceBuffer &m_buffer;
+    const char *m_category;
+    const char *m_name;
+    qint64 m_startUs {-1};
+};
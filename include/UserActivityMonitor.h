@@ -0,0 +1,79 @@
+#pragma once
+
+#include "DaemonClock.h"
+
+#include <QBitArray>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <functional>
+
+class QSocketNotifier;
+
+/**
+ * @brief Waits a grace period after a scheduled wake for anyone to use the machine.
+ *
+ * Input devices (`event*` below the input directory) are watched with socket notifiers and
+ * logind's IdleHint is fed in through setSessionIdle(), so nothing is polled: the only timer
+ * is the grace period itself. Only keyboards, pointers and touch devices are opened, so an
+ * accelerometer or a hotkey device (power button, brightness keys) never counts as a person.
+ * Their key, button, pointer and touch events count; switch and scancode events do not.
+ * The first activity or the end of the grace period stops the monitor until start() is
+ * called again.
+ */
+class UserActivityMonitor : public QObject {
+    Q_OBJECT
+
+public:
+    /** What an input device can report, as EVIOCGBIT lists it. */
+    struct Capabilities {
+        QBitArray events;
+        QBitArray keys;
+        QBitArray relative;
+        QBitArray absolute;
+    };
+    /** Reads the capabilities of an open device; false when @p fd is not an evdev node. */
+    using CapabilityProbe = std::function<bool(int fd, Capabilities &capabilities)>;
+
+    UserActivityMonitor(DaemonClock *clock, QString inputDir, QObject *parent = nullptr);
+    ~UserActivityMonitor() override;
+
+    /** Begin a grace period of @p graceMs; @p watchInput also opens the input devices. */
+    void start(qint64 graceMs, bool watchInput);
+    void stop();
+    bool isActive() const;
+    /** Number of input devices opened by the last start(). */
+    int deviceCount() const;
+
+    /** Replaces the EVIOCGBIT query; tests use FIFOs, which have no capabilities. */
+    void setCapabilityProbe(CapabilityProbe probe);
+
+    /** Whether @p capabilities describe a keyboard, a pointer or a touch device. */
+    static bool isUserDevice(const Capabilities &capabilities);
+
+public slots:
+    /** Someone used the machine; @p source names the device or "session". */
+    void noteActivity(const QString &source);
+    /** logind's IdleHint; only a change to "not idle" counts, a stale hint from before the sleep does not. */
+    void setSessionIdle(bool idle);
+
+signals:
+    void activityDetected(const QString &source);
+    void graceExpired();
+
+private:
+    void openDevices();
+    void closeDevices();
+    void readDevice(int index);
+
+    DaemonClock *m_clock;
+    QString m_inputDir;
+    DaemonTimer *m_timer;
+    CapabilityProbe m_capabilityProbe;
+    QVector<int> m_fds;
+    QStringList m_names;
+    QVector<QSocketNotifier *> m_notifiers;
+    bool m_active {false};
+};
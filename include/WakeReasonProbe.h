@@ -0,0 +1,78 @@
+#pragma once
+
+#include <QDateTime>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief Works out what woke the machine by diffing the kernel's wakeup source counters.
+ *
+ * Each wakeup source (/sys/class/wakeup, or debugfs on older kernels) counts the wakeups
+ * it signalled. Comparing a snapshot taken right before sleeping with one taken after the
+ * resume names the source; /sys/power/pm_wakeup_irq adds the interrupt when the platform
+ * reports it. Comparing the resume time with the armed alarm tells an RTC wake from an
+ * early, late or missed one.
+ */
+class WakeReasonProbe {
+public:
+    /** Earlier than this before the alarm, something else woke the machine. */
+    static constexpr qint64 kEarlyToleranceMs = 60 * 1000;
+    /** Later than this after the alarm, the alarm did not wake the machine in time. */
+    static constexpr qint64 kLateToleranceMs = 5 * 60 * 1000;
+
+    struct Counters {
+        quint64 events {0};
+        quint64 wakeups {0};
+    };
+    using Snapshot = QMap<QString, Counters>;
+
+    struct Attribution {
+        /** Sources that signalled a wakeup (or, failing that, an event), busiest first. */
+        QStringList sources;
+        /** Interrupt the platform reported as the wake reason, e.g. "irq 8 (rtc0)". */
+        QString irq;
+        /** An RTC or alarm timer is among the sources. */
+        bool rtc {false};
+
+        QString primary() const;
+    };
+
+    enum class Verdict {
+        OnTime,
+        Early,
+        Late,
+        /** Late, and something other than the RTC did the waking. */
+        Missed
+    };
+
+    struct SourceCounts {
+        int wakes {0};
+        int early {0};
+        int late {0};
+        int missed {0};
+        QDateTime last;
+    };
+
+    explicit WakeReasonProbe(QString sysRoot = QStringLiteral("/sys"), QString procRoot = QStringLiteral("/proc"));
+
+    Snapshot snapshot() const;
+    /** The interrupt that ended the last sleep, empty when the kernel did not record one. */
+    QString wakeupIrq() const;
+    Attribution attribute(const Snapshot &before, const Snapshot &after) const;
+
+    static Verdict classify(const QDateTime &alarm, const QDateTime &resumed, const Attribution &attribution);
+    static QString verdictLabel(Verdict verdict);
+
+    static QMap<QString, SourceCounts> loadCounts(const QString &path);
+    /** Count one wake by @p source into the JSON file at @p path. */
+    static bool recordWake(const QString &path, const QString &source, Verdict verdict, const QDateTime &when);
+
+private:
+    Snapshot readClassWakeup() const;
+    Snapshot readDebugfs() const;
+    QString describeIrq(int irq) const;
+
+    QString m_sysRoot;
+    QString m_procRoot;
+};
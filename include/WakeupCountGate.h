@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QString>
+
+/**
+ * @brief The /sys/power/wakeup_count handshake that closes the race between a wakeup
+ * event and entering sleep.
+ *
+ * Reading the count waits for wakeup events in flight; writing the same value back tells
+ * the kernel to abort the next sleep if another event is registered before it. The write
+ * fails when one already was, in which case sleeping now would lose it and the caller
+ * should try again a little later.
+ */
+class WakeupCountGate {
+public:
+    enum class Result {
+        /** The kernel will abort the next sleep if a wakeup event arrives first. */
+        Armed,
+        /** No wakeup_count to hand shake with (or no permission to write it): sleep without. */
+        Unavailable,
+        /** A wakeup event arrived since the count was read. */
+        Pending
+    };
+
+    explicit WakeupCountGate(QString sysRoot = QStringLiteral("/sys"));
+
+    /** Perform the handshake; @p count receives the value read when there was one. */
+    Result arm(quint64 *count = nullptr) const;
+
+    static QString resultLabel(Result result);
+
+private:
+    QString m_sysRoot;
+};
@@ -0,0 +1,125 @@
+#include "BootTimingProbe.h"
+
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QDebug>
+#include <QFile>
+#include <QVariantMap>
+
+#include <cmath>
+#include <utility>
+
+namespace {
+const QString kService = QStringLiteral("org.freedesktop.systemd1");
+const QString kPath = QStringLiteral("/org/freedesktop/systemd1");
+const QString kManager = QStringLiteral("org.freedesktop.systemd1.Manager");
+const QString kProperties = QStringLiteral("org.freedesktop.DBus.Properties");
+
+QDateTime offsetUs(const QDateTime &base, qint64 us) {
+    return base.addMSecs(us / 1000);
+}
+}
+
+BootTimingProbe::BootTimingProbe(QString procRoot, QObject *parent)
+    : QObject(parent),
+      m_procRoot(std::move(procRoot)) {}
+
+void BootTimingProbe::start() {
+    auto bus = QDBusConnection::systemBus();
+    if (!bus.isConnected()) {
+        qWarning().noquote() << "System bus unavailable; boot readiness is not measured";
+        return;
+    }
+    // Connect before reading the properties so a startup finishing in between is not missed.
+    m_available = bus.connect(kService, kPath, kManager, QStringLiteral("StartupFinished"), this,
+                              SLOT(handleStartupFinished(qulonglong, qulonglong, qulonglong, qulonglong, qulonglong,
+                                                         qulonglong)));
+    if (!m_available) {
+        qWarning().noquote() << "Cannot subscribe to systemd startup signals:" << bus.lastError().message();
+        return;
+    }
+    // systemd only emits StartupFinished to subscribed clients.
+    bus.asyncCall(QDBusMessage::createMethodCall(kService, kPath, kManager, QStringLiteral("Subscribe")));
+    fetch();
+}
+
+bool BootTimingProbe::isAvailable() const {
+    return m_available;
+}
+
+double BootTimingProbe::uptimeSeconds() const {
+    QFile file(m_procRoot + QStringLiteral("/uptime"));
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return -1.0;
+    }
+    bool ok = false;
+    const double seconds = file.readLine().simplified().split(' ').value(0).toDouble(&ok);
+    return ok && seconds >= 0 ? seconds : -1.0;
+}
+
+BootTimingProbe::Timing BootTimingProbe::compute(const QDateTime &now, double uptimeSecs, const Timestamps &stamps) {
+    Timing timing;
+    if (!now.isValid() || uptimeSecs < 0) {
+        return timing;
+    }
+    timing.kernelStarted = now.addMSecs(-std::llround(uptimeSecs * 1000));
+    if (stamps.firmwareUs > 0) {
+        timing.poweredOn = offsetUs(timing.kernelStarted, -static_cast<qint64>(stamps.firmwareUs));
+    }
+    if (stamps.userspaceUs > 0) {
+        timing.userspaceStarted = offsetUs(timing.kernelStarted, static_cast<qint64>(stamps.userspaceUs));
+    }
+    if (stamps.finishUs > 0) {
+        timing.ready = offsetUs(timing.kernelStarted, static_cast<qint64>(stamps.finishUs));
+    }
+    return timing;
+}
+
+void BootTimingProbe::handleStartupFinished(qulonglong firmwareUs, qulonglong loaderUs, qulonglong kernelUs,
+                                            qulonglong initrdUs, qulonglong userspaceUs, qulonglong totalUs) {
+    Q_UNUSED(totalUs);
+    Timestamps stamps;
+    stamps.firmwareUs = firmwareUs + loaderUs;
+    stamps.userspaceUs = kernelUs + initrdUs;
+    stamps.finishUs = kernelUs + initrdUs + userspaceUs;
+    report(stamps);
+}
+
+void BootTimingProbe::fetch() {
+    auto message = QDBusMessage::createMethodCall(kService, kPath, kProperties, QStringLiteral("GetAll"));
+    message << kManager;
+    auto *watcher = new QDBusPendingCallWatcher(QDBusConnection::systemBus().asyncCall(message), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this](QDBusPendingCallWatcher *call) {
+        call->deleteLater();
+        const QDBusPendingReply<QVariantMap> reply = *call;
+        if (reply.isError()) {
+            qWarning().noquote() << "Cannot read systemd boot timestamps:" << reply.error().message();
+            return;
+        }
+        const QVariantMap properties = reply.value();
+        Timestamps stamps;
+        stamps.firmwareUs = properties.value(QStringLiteral("FirmwareTimestampMonotonic")).toULongLong();
+        stamps.userspaceUs = properties.value(QStringLiteral("UserspaceTimestampMonotonic")).toULongLong();
+        stamps.finishUs = properties.value(QStringLiteral("FinishTimestampMonotonic")).toULongLong();
+        if (stamps.finishUs == 0) {
+            // Still booting; StartupFinished carries the numbers later.
+            return;
+        }
+        report(stamps);
+    });
+}
+
+void BootTimingProbe::report(const Timestamps &stamps) {
+    if (m_reported) {
+        return;
+    }
+    const Timing timing = compute(QDateTime::currentDateTime(), uptimeSeconds(), stamps);
+    if (!timing.ready.isValid()) {
+        qWarning().noquote() << "Cannot anchor boot timestamps; is" << m_procRoot + QStringLiteral("/uptime") << "readable?";
+        return;
+    }
+    m_reported = true;
+    emit finished(timing);
+}
@@ -0,0 +1,59 @@
+#include "CgroupFreezer.h"
+
+#include "KernelFiles.h"
+
+#include <QDebug>
+#include <QFile>
+
+#include <utility>
+
+namespace {
+/** A missing file means the cgroup is gone; KernelFiles never creates it as a plain file. */
+bool writeAttribute(const QString &path, const QByteArray &value) {
+    QString error;
+    if (!KernelFiles::writeValue(path, value, &error)) {
+        qWarning().noquote() << "Failed to write" << path << error;
+        return false;
+    }
+    return true;
+}
+}
+
+CgroupFreezer::CgroupFreezer(QString cgroupRoot)
+    : m_cgroupRoot(std::move(cgroupRoot)) {}
+
+QString CgroupFreezer::userSlice(uint uid) {
+    return QStringLiteral("user.slice/user-%1.slice").arg(uid);
+}
+
+bool CgroupFreezer::supported() const {
+    // cgroup v1 has no cgroup.controllers, and the freezer file exists on every non-root cgroup since 5.2.
+    return QFile::exists(m_cgroupRoot + QStringLiteral("/cgroup.controllers"))
+        && QFile::exists(path(QStringLiteral("user.slice"), QStringLiteral("cgroup.freeze")));
+}
+
+bool CgroupFreezer::freeze(const QString &cgroup) const {
+    return writeAttribute(path(cgroup, QStringLiteral("cgroup.freeze")), "1");
+}
+
+bool CgroupFreezer::thaw(const QString &cgroup) const {
+    return writeAttribute(path(cgroup, QStringLiteral("cgroup.freeze")), "0");
+}
+
+bool CgroupFreezer::isFrozen(const QString &cgroup) const {
+    QFile file(path(cgroup, QStringLiteral("cgroup.events")));
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return false;
+    }
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine().simplified();
+        if (line.startsWith("frozen ")) {
+            return line.mid(7) == "1";
+        }
+    }
+    return false;
+}
+
+QString CgroupFreezer::path(const QString &cgroup, const QString &file) const {
+    return m_cgroupRoot + QLatin1Char('/') + cgroup + QLatin1Char('/') + file;
+}
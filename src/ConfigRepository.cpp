@@ -1,5 +1,6 @@
 #include "ConfigRepository.h"
 
+#include <QCryptographicHash>
 #include <QDate>
 #include <QDir>
 #include <QFile>
@@ -12,6 +13,8 @@
 #include <QDebug>
 #include <QTime>
 
+#include <algorithm>
+
 namespace {
 QString formatTime(const QTime &time) {
     return time.toString(QStringLiteral("HH:mm"));
@@ -73,6 +76,10 @@ QString ConfigRepository::configPath() const {
     return resolvedPath();
 }
 
+QByteArray ConfigRepository::fingerprint(const AppConfig &config) const {
+    return QCryptographicHash::hash(serialize(config), QCryptographicHash::Sha256).toHex();
+}
+
 AppConfig ConfigRepository::parse(const QByteArray &json) const {
     AppConfig config;
     QJsonParseError error;
@@ -100,6 +107,10 @@ AppConfig ConfigRepository::parse(const QByteArray &json) const {
     }
 
     config.actionId = root.value(QStringLiteral("actionId")).toInt(config.actionId);
+    const int hibernateDelay = root.value(QStringLiteral("hibernateDelayMinutes")).toInt(config.hibernateDelayMinutes);
+    if (hibernateDelay > 0) {
+        config.hibernateDelayMinutes = hibernateDelay;
+    }
 
     const auto warningObj = root.value(QStringLiteral("warning")).toObject();
     if (!warningObj.isEmpty()) {
@@ -154,6 +165,28 @@ AppConfig ConfigRepository::parse(const QByteArray &json) const {
         if (parsedWake.isValid()) {
             entry.wakeTime = parsedWake;
         }
+        for (const auto &jobValue : obj.value(QStringLiteral("jobs")).toArray()) {
+            const auto jobObj = jobValue.toObject();
+            MaintenanceJob job;
+            job.command = jobObj.value(QStringLiteral("command")).toString().trimmed();
+            if (job.command.isEmpty()) {
+                continue;
+            }
+            job.name = jobObj.value(QStringLiteral("name")).toString(job.command.section(QLatin1Char(' '), 0, 0));
+            job.nice = std::clamp(jobObj.value(QStringLiteral("nice")).toInt(job.nice), -20, 19);
+            const int ioClass = jobObj.value(QStringLiteral("ioClass")).toInt(job.ioClass);
+            if (ioClass >= 1 && ioClass <= 3) {
+                job.ioClass = ioClass;
+            }
+            job.ioLevel = std::clamp(jobObj.value(QStringLiteral("ioLevel")).toInt(job.ioLevel), 0, 7);
+            const int timeout = jobObj.value(QStringLiteral("timeoutSeconds")).toInt(job.timeoutSeconds);
+            if (timeout > 0) {
+                job.timeoutSeconds = timeout;
+            }
+            entry.jobs.append(job);
+        }
+        entry.resuspendAfterJobs = obj.value(QStringLiteral("resuspendAfterJobs")).toBool(entry.resuspendAfterJobs);
+        entry.resuspendUntil = QTime::fromString(obj.value(QStringLiteral("resuspendUntil")).toString(), QStringLiteral("HH:mm"));
         overrides.insert(day, entry);
     }
 
@@ -174,6 +207,178 @@ AppConfig ConfigRepository::parse(const QByteArray &json) const {
         config.session.waylandDisplay = sessionObj.value(QStringLiteral("waylandDisplay")).toString(config.session.waylandDisplay);
     }
 
+    const auto prefetchObj = root.value(QStringLiteral("prefetch")).toObject();
+    if (!prefetchObj.isEmpty()) {
+        config.prefetch.enabled = prefetchObj.value(QStringLiteral("enabled")).toBool(config.prefetch.enabled);
+        for (const auto &value : prefetchObj.value(QStringLiteral("paths")).toArray()) {
+            const QString path = value.toString().trimmed();
+            if (!path.isEmpty()) {
+                config.prefetch.paths << path;
+            }
+        }
+        const int workers = prefetchObj.value(QStringLiteral("workers")).toInt(config.prefetch.workers);
+        if (workers > 0) {
+            config.prefetch.workers = workers;
+        }
+        const int budget = prefetchObj.value(QStringLiteral("budgetSeconds")).toInt(config.prefetch.budgetSeconds);
+        if (budget > 0) {
+            config.prefetch.budgetSeconds = budget;
+        }
+    }
+
+    const auto deferralObj = root.value(QStringLiteral("deferral")).toObject();
+    if (!deferralObj.isEmpty()) {
+        auto &deferral = config.deferral;
+        deferral.enabled = deferralObj.value(QStringLiteral("enabled")).toBool(deferral.enabled);
+        deferral.maxLoadPerCpu = deferralObj.value(QStringLiteral("maxLoadPerCpu")).toDouble(deferral.maxLoadPerCpu);
+        deferral.maxCpuPressure = deferralObj.value(QStringLiteral("maxCpuPressure")).toDouble(deferral.maxCpuPressure);
+        deferral.maxIoPressure = deferralObj.value(QStringLiteral("maxIoPressure")).toDouble(deferral.maxIoPressure);
+        deferral.maxMemoryPressure = deferralObj.value(QStringLiteral("maxMemoryPressure")).toDouble(deferral.maxMemoryPressure);
+        deferral.maxDiskKiBps = deferralObj.value(QStringLiteral("maxDiskKiBps")).toInt(deferral.maxDiskKiBps);
+        deferral.maxNetKiBps = deferralObj.value(QStringLiteral("maxNetKiBps")).toInt(deferral.maxNetKiBps);
+        deferral.blockingProcesses.clear();
+        for (const auto &value : deferralObj.value(QStringLiteral("blockingProcesses")).toArray()) {
+            const QString name = value.toString().trimmed();
+            if (name.isEmpty()) {
+                continue;
+            }
+            // Processes are matched by the kernel's name for them, which never holds a directory.
+            if (name.contains(QLatin1Char('/'))) {
+                qWarning().noquote() << "Blocking process" << name << "can never match; use the program name without its directory";
+            }
+            deferral.blockingProcesses << name;
+        }
+        const int sample = deferralObj.value(QStringLiteral("sampleSeconds")).toInt(deferral.sampleSeconds);
+        if (sample > 0) {
+            deferral.sampleSeconds = sample;
+        }
+        const int step = deferralObj.value(QStringLiteral("stepMinutes")).toInt(deferral.stepMinutes);
+        if (step > 0) {
+            deferral.stepMinutes = step;
+        }
+        const int maxDelay = deferralObj.value(QStringLiteral("maxDelayMinutes")).toInt(deferral.maxDelayMinutes);
+        if (maxDelay >= 0) {
+            deferral.maxDelayMinutes = maxDelay;
+        }
+    }
+
+    const auto idleObj = root.value(QStringLiteral("idleSuspend")).toObject();
+    if (!idleObj.isEmpty()) {
+        auto &idle = config.idleSuspend;
+        idle.enabled = idleObj.value(QStringLiteral("enabled")).toBool(idle.enabled);
+        const int minutes = idleObj.value(QStringLiteral("idleMinutes")).toInt(idle.idleMinutes);
+        if (minutes > 0) {
+            idle.idleMinutes = minutes;
+        }
+        const auto windowStart = QTime::fromString(idleObj.value(QStringLiteral("windowStart")).toString(), QStringLiteral("HH:mm"));
+        if (windowStart.isValid()) {
+            idle.windowStart = windowStart;
+        }
+        const auto windowEnd = QTime::fromString(idleObj.value(QStringLiteral("windowEnd")).toString(), QStringLiteral("HH:mm"));
+        if (windowEnd.isValid()) {
+            idle.windowEnd = windowEnd;
+        }
+        idle.actionId = idleObj.value(QStringLiteral("actionId")).toInt(idle.actionId);
+        const int pressure = idleObj.value(QStringLiteral("pressurePercent")).toInt(idle.pressurePercent);
+        if (pressure > 0 && pressure <= 100) {
+            idle.pressurePercent = pressure;
+        }
+        idle.requireSessionIdle = idleObj.value(QStringLiteral("requireSessionIdle")).toBool(idle.requireSessionIdle);
+    }
+
+    const auto maintenanceObj = root.value(QStringLiteral("maintenance")).toObject();
+    const int maxParallel = maintenanceObj.value(QStringLiteral("maxParallel")).toInt(config.maintenance.maxParallel);
+    if (maxParallel > 0) {
+        config.maintenance.maxParallel = maxParallel;
+    }
+    config.maintenance.requireSessionIdle =
+        maintenanceObj.value(QStringLiteral("requireSessionIdle")).toBool(config.maintenance.requireSessionIdle);
+
+    const auto returnObj = root.value(QStringLiteral("returnToSleep")).toObject();
+    auto &returnToSleep = config.returnToSleep;
+    returnToSleep.enabled = returnObj.value(QStringLiteral("enabled")).toBool(returnToSleep.enabled);
+    const int graceMinutes = returnObj.value(QStringLiteral("graceMinutes")).toInt(returnToSleep.graceMinutes);
+    if (graceMinutes > 0) {
+        returnToSleep.graceMinutes = graceMinutes;
+    }
+    returnToSleep.watchInputDevices = returnObj.value(QStringLiteral("watchInputDevices")).toBool(returnToSleep.watchInputDevices);
+    returnToSleep.watchSession = returnObj.value(QStringLiteral("watchSession")).toBool(returnToSleep.watchSession);
+
+    const auto tuningObj = root.value(QStringLiteral("hibernateTuning")).toObject();
+    auto &tuning = config.hibernateTuning;
+    tuning.enabled = tuningObj.value(QStringLiteral("enabled")).toBool(tuning.enabled);
+    const int imageSizePercent = tuningObj.value(QStringLiteral("imageSizePercent")).toInt(tuning.imageSizePercent);
+    if (imageSizePercent <= 100) {
+        tuning.imageSizePercent = imageSizePercent;
+    }
+    tuning.dropCaches = tuningObj.value(QStringLiteral("dropCaches")).toBool(tuning.dropCaches);
+    tuning.compactMemory = tuningObj.value(QStringLiteral("compactMemory")).toBool(tuning.compactMemory);
+    tuning.diskMode = tuningObj.value(QStringLiteral("diskMode")).toString(tuning.diskMode);
+    tuning.compressor = tuningObj.value(QStringLiteral("compressor")).toString(tuning.compressor);
+
+    const auto leadObj = root.value(QStringLiteral("wakeLead")).toObject();
+    auto &lead = config.wakeLead;
+    lead.enabled = leadObj.value(QStringLiteral("enabled")).toBool(lead.enabled);
+    const int percentile = leadObj.value(QStringLiteral("percentile")).toInt(lead.percentile);
+    if (percentile > 0 && percentile <= 100) {
+        lead.percentile = percentile;
+    }
+    const int minSamples = leadObj.value(QStringLiteral("minSamples")).toInt(lead.minSamples);
+    if (minSamples > 0) {
+        lead.minSamples = minSamples;
+    }
+    const int maxLeadMinutes = leadObj.value(QStringLiteral("maxLeadMinutes")).toInt(lead.maxLeadMinutes);
+    if (maxLeadMinutes >= 0) {
+        lead.maxLeadMinutes = maxLeadMinutes;
+    }
+
+    const auto rtcObj = root.value(QStringLiteral("rtc")).toObject();
+    config.rtc.device = rtcObj.value(QStringLiteral("device")).toString(config.rtc.device);
+    const int maxAlarmHours = rtcObj.value(QStringLiteral("maxAlarmHours")).toInt(config.rtc.maxAlarmHours);
+    if (maxAlarmHours >= 0) {
+        config.rtc.maxAlarmHours = maxAlarmHours;
+    }
+
+    const auto entryObj = root.value(QStringLiteral("sleepEntry")).toObject();
+    auto &entry = config.sleepEntry;
+    const int maxAttempts = entryObj.value(QStringLiteral("maxAttempts")).toInt(entry.maxAttempts);
+    if (maxAttempts > 0) {
+        entry.maxAttempts = maxAttempts;
+    }
+    const int backoffSeconds = entryObj.value(QStringLiteral("backoffSeconds")).toInt(entry.backoffSeconds);
+    if (backoffSeconds >= 0) {
+        entry.backoffSeconds = backoffSeconds;
+    }
+    const int maxBackoffSeconds = entryObj.value(QStringLiteral("maxBackoffSeconds")).toInt(entry.maxBackoffSeconds);
+    if (maxBackoffSeconds >= entry.backoffSeconds) {
+        entry.maxBackoffSeconds = maxBackoffSeconds;
+    }
+    if (entryObj.contains(QStringLiteral("fallbackModes"))) {
+        static const QStringList known {QStringLiteral("mem"), QStringLiteral("freeze"), QStringLiteral("disk")};
+        entry.fallbackModes.clear();
+        for (const auto &value : entryObj.value(QStringLiteral("fallbackModes")).toArray()) {
+            const QString mode = value.toString().trimmed();
+            if (known.contains(mode) && !entry.fallbackModes.contains(mode)) {
+                entry.fallbackModes << mode;
+            }
+        }
+    }
+    entry.adaptiveOrder = entryObj.value(QStringLiteral("adaptiveOrder")).toBool(entry.adaptiveOrder);
+
+    const auto energyObj = root.value(QStringLiteral("energy")).toObject();
+    config.energy.enabled = energyObj.value(QStringLiteral("enabled")).toBool(config.energy.enabled);
+    const int sampleMinutes = energyObj.value(QStringLiteral("sampleMinutes")).toInt(config.energy.sampleMinutes);
+    if (sampleMinutes >= 0) {
+        config.energy.sampleMinutes = sampleMinutes;
+    }
+
+    const auto timerObj = root.value(QStringLiteral("timerBackend")).toObject();
+    config.timerBackend.enabled = timerObj.value(QStringLiteral("enabled")).toBool(config.timerBackend.enabled);
+    const QString unitDir = timerObj.value(QStringLiteral("unitDir")).toString().trimmed();
+    if (!unitDir.isEmpty()) {
+        config.timerBackend.unitDir = unitDir;
+    }
+
     return config;
 }
 
@@ -184,6 +389,7 @@ QByteArray ConfigRepository::serialize(const AppConfig &config) const {
     root.insert(QStringLiteral("singleDate"), config.singleWakeDate.toString(Qt::ISODate));
     root.insert(QStringLiteral("singleTime"), config.singleWakeTime.toString(Qt::ISODate));
     root.insert(QStringLiteral("actionId"), config.actionId);
+    root.insert(QStringLiteral("hibernateDelayMinutes"), config.hibernateDelayMinutes);
 
     QJsonObject warningObj;
     warningObj.insert(QStringLiteral("enabled"), config.warning.enabled);
@@ -206,6 +412,24 @@ QByteArray ConfigRepository::serialize(const AppConfig &config) const {
         obj.insert(QStringLiteral("enabled"), entry.enabled);
         obj.insert(QStringLiteral("shutdownTime"), formatTime(entry.shutdownTime));
         obj.insert(QStringLiteral("wakeTime"), formatTime(entry.wakeTime));
+        if (!entry.jobs.isEmpty()) {
+            QJsonArray jobsArray;
+            for (const auto &job : entry.jobs) {
+                QJsonObject jobObj;
+                jobObj.insert(QStringLiteral("name"), job.name);
+                jobObj.insert(QStringLiteral("command"), job.command);
+                jobObj.insert(QStringLiteral("nice"), job.nice);
+                jobObj.insert(QStringLiteral("ioClass"), job.ioClass);
+                jobObj.insert(QStringLiteral("ioLevel"), job.ioLevel);
+                jobObj.insert(QStringLiteral("timeoutSeconds"), job.timeoutSeconds);
+                jobsArray.append(jobObj);
+            }
+            obj.insert(QStringLiteral("jobs"), jobsArray);
+            obj.insert(QStringLiteral("resuspendAfterJobs"), entry.resuspendAfterJobs);
+            if (entry.resuspendUntil.isValid()) {
+                obj.insert(QStringLiteral("resuspendUntil"), formatTime(entry.resuspendUntil));
+            }
+        }
         weeklyArray.append(obj);
     }
     root.insert(QStringLiteral("weekly"), weeklyArray);
@@ -219,6 +443,88 @@ QByteArray ConfigRepository::serialize(const AppConfig &config) const {
     sessionObj.insert(QStringLiteral("waylandDisplay"), config.session.waylandDisplay);
     root.insert(QStringLiteral("session"), sessionObj);
 
+    QJsonObject prefetchObj;
+    prefetchObj.insert(QStringLiteral("enabled"), config.prefetch.enabled);
+    prefetchObj.insert(QStringLiteral("paths"), QJsonArray::fromStringList(config.prefetch.paths));
+    prefetchObj.insert(QStringLiteral("workers"), config.prefetch.workers);
+    prefetchObj.insert(QStringLiteral("budgetSeconds"), config.prefetch.budgetSeconds);
+    root.insert(QStringLiteral("prefetch"), prefetchObj);
+
+    QJsonObject deferralObj;
+    deferralObj.insert(QStringLiteral("enabled"), config.deferral.enabled);
+    deferralObj.insert(QStringLiteral("maxLoadPerCpu"), config.deferral.maxLoadPerCpu);
+    deferralObj.insert(QStringLiteral("maxCpuPressure"), config.deferral.maxCpuPressure);
+    deferralObj.insert(QStringLiteral("maxIoPressure"), config.deferral.maxIoPressure);
+    deferralObj.insert(QStringLiteral("maxMemoryPressure"), config.deferral.maxMemoryPressure);
+    deferralObj.insert(QStringLiteral("maxDiskKiBps"), config.deferral.maxDiskKiBps);
+    deferralObj.insert(QStringLiteral("maxNetKiBps"), config.deferral.maxNetKiBps);
+    deferralObj.insert(QStringLiteral("blockingProcesses"), QJsonArray::fromStringList(config.deferral.blockingProcesses));
+    deferralObj.insert(QStringLiteral("sampleSeconds"), config.deferral.sampleSeconds);
+    deferralObj.insert(QStringLiteral("stepMinutes"), config.deferral.stepMinutes);
+    deferralObj.insert(QStringLiteral("maxDelayMinutes"), config.deferral.maxDelayMinutes);
+    root.insert(QStringLiteral("deferral"), deferralObj);
+
+    QJsonObject idleObj;
+    idleObj.insert(QStringLiteral("enabled"), config.idleSuspend.enabled);
+    idleObj.insert(QStringLiteral("idleMinutes"), config.idleSuspend.idleMinutes);
+    idleObj.insert(QStringLiteral("windowStart"), formatTime(config.idleSuspend.windowStart));
+    idleObj.insert(QStringLiteral("windowEnd"), formatTime(config.idleSuspend.windowEnd));
+    idleObj.insert(QStringLiteral("actionId"), config.idleSuspend.actionId);
+    idleObj.insert(QStringLiteral("pressurePercent"), config.idleSuspend.pressurePercent);
+    idleObj.insert(QStringLiteral("requireSessionIdle"), config.idleSuspend.requireSessionIdle);
+    root.insert(QStringLiteral("idleSuspend"), idleObj);
+
+    QJsonObject maintenanceObj;
+    maintenanceObj.insert(QStringLiteral("maxParallel"), config.maintenance.maxParallel);
+    maintenanceObj.insert(QStringLiteral("requireSessionIdle"), config.maintenance.requireSessionIdle);
+    root.insert(QStringLiteral("maintenance"), maintenanceObj);
+
+    QJsonObject returnObj;
+    returnObj.insert(QStringLiteral("enabled"), config.returnToSleep.enabled);
+    returnObj.insert(QStringLiteral("graceMinutes"), config.returnToSleep.graceMinutes);
+    returnObj.insert(QStringLiteral("watchInputDevices"), config.returnToSleep.watchInputDevices);
+    returnObj.insert(QStringLiteral("watchSession"), config.returnToSleep.watchSession);
+    root.insert(QStringLiteral("returnToSleep"), returnObj);
+
+    QJsonObject tuningObj;
+    tuningObj.insert(QStringLiteral("enabled"), config.hibernateTuning.enabled);
+    tuningObj.insert(QStringLiteral("imageSizePercent"), config.hibernateTuning.imageSizePercent);
+    tuningObj.insert(QStringLiteral("dropCaches"), config.hibernateTuning.dropCaches);
+    tuningObj.insert(QStringLiteral("compactMemory"), config.hibernateTuning.compactMemory);
+    tuningObj.insert(QStringLiteral("diskMode"), config.hibernateTuning.diskMode);
+    tuningObj.insert(QStringLiteral("compressor"), config.hibernateTuning.compressor);
+    root.insert(QStringLiteral("hibernateTuning"), tuningObj);
+
+    QJsonObject leadObj;
+    leadObj.insert(QStringLiteral("enabled"), config.wakeLead.enabled);
+    leadObj.insert(QStringLiteral("percentile"), config.wakeLead.percentile);
+    leadObj.insert(QStringLiteral("minSamples"), config.wakeLead.minSamples);
+    leadObj.insert(QStringLiteral("maxLeadMinutes"), config.wakeLead.maxLeadMinutes);
+    root.insert(QStringLiteral("wakeLead"), leadObj);
+
+    QJsonObject rtcObj;
+    rtcObj.insert(QStringLiteral("device"), config.rtc.device);
+    rtcObj.insert(QStringLiteral("maxAlarmHours"), config.rtc.maxAlarmHours);
+    root.insert(QStringLiteral("rtc"), rtcObj);
+
+    QJsonObject entryObj;
+    entryObj.insert(QStringLiteral("maxAttempts"), config.sleepEntry.maxAttempts);
+    entryObj.insert(QStringLiteral("backoffSeconds"), config.sleepEntry.backoffSeconds);
+    entryObj.insert(QStringLiteral("maxBackoffSeconds"), config.sleepEntry.maxBackoffSeconds);
+    entryObj.insert(QStringLiteral("fallbackModes"), QJsonArray::fromStringList(config.sleepEntry.fallbackModes));
+    entryObj.insert(QStringLiteral("adaptiveOrder"), config.sleepEntry.adaptiveOrder);
+    root.insert(QStringLiteral("sleepEntry"), entryObj);
+
+    QJsonObject energyObj;
+    energyObj.insert(QStringLiteral("enabled"), config.energy.enabled);
+    energyObj.insert(QStringLiteral("sampleMinutes"), config.energy.sampleMinutes);
+    root.insert(QStringLiteral("energy"), energyObj);
+
+    QJsonObject timerObj;
+    timerObj.insert(QStringLiteral("enabled"), config.timerBackend.enabled);
+    timerObj.insert(QStringLiteral("unitDir"), config.timerBackend.unitDir);
+    root.insert(QStringLiteral("timerBackend"), timerObj);
+
     QJsonDocument doc(root);
     return doc.toJson(QJsonDocument::Compact);
 }
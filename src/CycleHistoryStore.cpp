@@ -0,0 +1,176 @@
+#include "CycleHistoryStore.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace {
+constexpr char kMagic[8] = {'R', 'T', 'C', 'W', 'H', 'I', 'S', 'T'};
+}
+
+CycleHistoryStore::CycleHistoryStore(QString path, quint32 capacity)
+    : m_path(std::move(path)),
+      m_requestedCapacity(std::max<quint32>(1, capacity)) {}
+
+CycleHistoryStore::~CycleHistoryStore() {
+    close();
+}
+
+bool CycleHistoryStore::open(bool writable) {
+    close();
+    if (m_path.isEmpty()) {
+        return false;
+    }
+    m_writable = writable;
+    m_file.setFileName(m_path);
+
+    if (writable) {
+        QDir dir = QFileInfo(m_path).absoluteDir();
+        if (!dir.exists() && !QDir().mkpath(dir.absolutePath())) {
+            qWarning().noquote() << "Failed to create history directory" << dir.absolutePath();
+            return false;
+        }
+        if (!m_file.open(QIODevice::ReadWrite)) {
+            qWarning().noquote() << "Failed to open history store" << m_path << m_file.errorString();
+            return false;
+        }
+        if (m_file.size() < static_cast<qint64>(sizeof(Header)) && !initialize()) {
+            close();
+            return false;
+        }
+    } else if (!m_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    Header probe {};
+    if (m_file.size() < static_cast<qint64>(sizeof(Header))
+        || m_file.read(reinterpret_cast<char *>(&probe), sizeof(probe)) != static_cast<qint64>(sizeof(probe))
+        || std::memcmp(probe.magic, kMagic, sizeof(kMagic)) != 0
+        || probe.version != kFormatVersion
+        || probe.recordSize != sizeof(Record)
+        || probe.capacity == 0) {
+        qWarning().noquote() << "History store has an unexpected layout" << m_path;
+        close();
+        return false;
+    }
+
+    // The capacity recorded in the file wins so existing history is never truncated.
+    const qint64 expected = static_cast<qint64>(sizeof(Header)) + static_cast<qint64>(probe.capacity) * sizeof(Record);
+    if (m_file.size() < expected && (!writable || !m_file.resize(expected))) {
+        close();
+        return false;
+    }
+
+    m_map = m_file.map(0, expected);
+    if (!m_map) {
+        qWarning().noquote() << "Failed to map history store" << m_path << m_file.errorString();
+        close();
+        return false;
+    }
+    m_mapSize = expected;
+    return true;
+}
+
+bool CycleHistoryStore::initialize() {
+    Header fresh {};
+    std::memcpy(fresh.magic, kMagic, sizeof(kMagic));
+    fresh.version = kFormatVersion;
+    fresh.recordSize = sizeof(Record);
+    fresh.capacity = m_requestedCapacity;
+    fresh.total = 0;
+
+    const qint64 size = static_cast<qint64>(sizeof(Header)) + static_cast<qint64>(m_requestedCapacity) * sizeof(Record);
+    if (!m_file.resize(size) || !m_file.seek(0)
+        || m_file.write(reinterpret_cast<const char *>(&fresh), sizeof(fresh)) != static_cast<qint64>(sizeof(fresh))) {
+        qWarning().noquote() << "Failed to initialize history store" << m_path << m_file.errorString();
+        return false;
+    }
+    m_file.flush();
+    return m_file.seek(0);
+}
+
+void CycleHistoryStore::close() {
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    m_mapSize = 0;
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+}
+
+bool CycleHistoryStore::isOpen() const {
+    return m_map != nullptr;
+}
+
+CycleHistoryStore::Header *CycleHistoryStore::header() const {
+    return reinterpret_cast<Header *>(m_map);
+}
+
+CycleHistoryStore::Record *CycleHistoryStore::slot(quint64 index) const {
+    const quint64 position = index % header()->capacity;
+    return reinterpret_cast<Record *>(m_map + sizeof(Header) + position * sizeof(Record));
+}
+
+bool CycleHistoryStore::append(const Record &record) {
+    if (!isOpen() || !m_writable) {
+        return false;
+    }
+    Header *head = header();
+    const quint64 index = head->total;
+    std::memcpy(slot(index), &record, sizeof(Record));
+    // Publish the record before bumping the counter readers rely on.
+    std::atomic_thread_fence(std::memory_order_release);
+    head->total = index + 1;
+    return true;
+}
+
+QVector<CycleHistoryStore::Record> CycleHistoryStore::records(const QDateTime &since) const {
+    QVector<Record> result;
+    if (!isOpen()) {
+        return result;
+    }
+    const quint64 total = header()->total;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const quint64 count = std::min<quint64>(total, header()->capacity);
+    const qint64 sinceSecs = since.isValid() ? since.toSecsSinceEpoch() : 0;
+
+    result.reserve(static_cast<int>(count));
+    for (quint64 i = total - count; i < total; ++i) {
+        const Record *record = slot(i);
+        if (sinceSecs > 0 && record->actualResume < sinceSecs && record->actualShutdown < sinceSecs) {
+            continue;
+        }
+        result.append(*record);
+    }
+    return result;
+}
+
+quint64 CycleHistoryStore::totalAppended() const {
+    return isOpen() ? header()->total : 0;
+}
+
+quint32 CycleHistoryStore::capacity() const {
+    return isOpen() ? header()->capacity : m_requestedCapacity;
+}
+
+QString CycleHistoryStore::path() const {
+    return m_path;
+}
+
+qint64 CycleHistoryStore::sleptSeconds(const QVector<Record> &records, const QDateTime &since) {
+    const qint64 sinceSecs = since.isValid() ? since.toSecsSinceEpoch() : 0;
+    qint64 total = 0;
+    for (const auto &record : records) {
+        if (record.outcome != static_cast<qint32>(Outcome::Completed) || record.actualResume < sinceSecs) {
+            continue;
+        }
+        total += record.suspendedMs / 1000;
+    }
+    return total;
+}
@@ -0,0 +1,186 @@
+#include "DaemonClock.h"
+
+#include <QDebug>
+#include <QSocketNotifier>
+#include <QThread>
+#include <QTimer>
+
+#include <cerrno>
+#include <sys/timerfd.h>
+#include <sys/timex.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+qint64 clockMs(clockid_t id) {
+    timespec ts {};
+    ::clock_gettime(id, &ts);
+    return static_cast<qint64>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * QTimer only accepts int milliseconds (~24.8 days); longer waits are split into
+ * chunks and timeout() is emitted once the whole duration has elapsed.
+ */
+class SystemTimer : public DaemonTimer {
+public:
+    explicit SystemTimer(QObject *parent)
+        : DaemonTimer(parent) {
+        m_timer.setSingleShot(true);
+        connect(&m_timer, &QTimer::timeout, this, [this]() { handleTimeout(); });
+    }
+
+    void start(qint64 msecs) override {
+        m_deadlineMs = clockMs(CLOCK_MONOTONIC) + std::max<qint64>(0, msecs);
+        m_active = true;
+        arm();
+    }
+
+    void stop() override {
+        m_active = false;
+        m_timer.stop();
+    }
+
+    bool isActive() const override {
+        return m_active;
+    }
+
+    void setSingleShot(bool singleShot) override {
+        m_singleShot = singleShot;
+    }
+
+    void setInterval(qint64 msecs) override {
+        m_interval = std::max<qint64>(0, msecs);
+    }
+
+    qint64 interval() const override {
+        return m_interval;
+    }
+
+    void setTimerType(Qt::TimerType type) override {
+        m_timer.setTimerType(type);
+    }
+
+private:
+    void arm() {
+        const qint64 remaining = std::max<qint64>(0, m_deadlineMs - clockMs(CLOCK_MONOTONIC));
+        m_timer.start(static_cast<int>(std::min<qint64>(remaining, std::numeric_limits<int>::max())));
+    }
+
+    void handleTimeout() {
+        if (!m_active) {
+            return;
+        }
+        if (clockMs(CLOCK_MONOTONIC) < m_deadlineMs) {
+            arm();
+            return;
+        }
+        if (m_singleShot) {
+            m_active = false;
+        } else {
+            start(m_interval);
+        }
+        emit timeout();
+    }
+
+    QTimer m_timer;
+    qint64 m_deadlineMs {0};
+    qint64 m_interval {0};
+    bool m_singleShot {false};
+    bool m_active {false};
+};
+
+class TimerfdChangeWatcher : public ClockChangeWatcher {
+public:
+    explicit TimerfdChangeWatcher(QObject *parent)
+        : ClockChangeWatcher(parent),
+          m_fd(::timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC)) {
+        if (m_fd < 0 || !arm()) {
+            qWarning().noquote() << "Clock change notifications unavailable:" << qt_error_string(errno);
+            return;
+        }
+        auto *notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+        connect(notifier, &QSocketNotifier::activated, this, [this]() { handleReadable(); });
+    }
+
+    ~TimerfdChangeWatcher() override {
+        if (m_fd >= 0) {
+            ::close(m_fd);
+        }
+    }
+
+private:
+    bool arm() {
+        // Never meant to expire; the absolute deadline only exists so CANCEL_ON_SET can fire.
+        constexpr time_t kFarFutureSecs = 10LL * 365 * 24 * 3600;
+        itimerspec spec {};
+        spec.it_value.tv_sec = ::time(nullptr) + kFarFutureSecs;
+        return ::timerfd_settime(m_fd, TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET, &spec, nullptr) == 0;
+    }
+
+    void handleReadable() {
+        quint64 expirations = 0;
+        const bool canceled = ::read(m_fd, &expirations, sizeof(expirations)) < 0 && errno == ECANCELED;
+        arm();
+        if (canceled) {
+            emit changed();
+        }
+    }
+
+    int m_fd;
+};
+}
+
+void DaemonClock::singleShot(qint64 msecs, QObject *context, std::function<void()> callback) {
+    DaemonTimer *timer = createTimer(context);
+    timer->setSingleShot(true);
+    QObject::connect(timer, &DaemonTimer::timeout, timer, [timer, callback = std::move(callback)]() {
+        timer->deleteLater();
+        callback();
+    });
+    timer->start(msecs);
+}
+
+DaemonClock &DaemonClock::system() {
+    static SystemClock clock;
+    return clock;
+}
+
+QDateTime SystemClock::now() const {
+    return QDateTime::currentDateTime();
+}
+
+qint64 SystemClock::monotonicMs() const {
+    return clockMs(CLOCK_MONOTONIC);
+}
+
+qint64 SystemClock::bootMs() const {
+    return clockMs(CLOCK_BOOTTIME);
+}
+
+qint64 SystemClock::rawMonotonicMs() const {
+    return clockMs(CLOCK_MONOTONIC_RAW);
+}
+
+bool SystemClock::isSynchronized() const {
+    timex tx {};
+    const int state = ::adjtimex(&tx);
+    return state != -1 && state != TIME_ERROR && !(tx.status & STA_UNSYNC);
+}
+
+DaemonTimer *SystemClock::createTimer(QObject *parent) {
+    return new SystemTimer(parent);
+}
+
+ClockChangeWatcher *SystemClock::createChangeWatcher(QObject *parent) {
+    return new TimerfdChangeWatcher(parent);
+}
+
+void SystemClock::pause(qint64 msecs) {
+    if (msecs > 0) {
+        QThread::msleep(static_cast<unsigned long>(msecs));
+    }
+}
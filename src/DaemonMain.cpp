@@ -1,10 +1,66 @@
+#include "CycleHistoryStore.h"
 #include "RtcWakeDaemon.h"
 
 #include <QCommandLineParser>
 #include <QCoreApplication>
+#include <QDir>
 #include <QFileInfo>
+#include <QSocketNotifier>
 #include <QTextStream>
 
+#include <csignal>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+// Deadlines are minutes to days away; let the kernel batch our few wakeups with others.
+constexpr unsigned long kTimerSlackNs = 100UL * 1000 * 1000;
+
+int g_signalPipe[2] {-1, -1};
+
+void forwardSignal(int signo) {
+    const char byte = static_cast<char>(signo);
+    // write(2) is async-signal-safe; the event loop picks the byte up via QSocketNotifier.
+    [[maybe_unused]] const auto written = ::write(g_signalPipe[0], &byte, sizeof(byte));
+}
+
+int dumpHistory(const QString &homeDir) {
+    CycleHistoryStore store(QDir(homeDir).filePath(QStringLiteral(".local/share/rtcwake-gui/history.bin")));
+    if (!store.open(false)) {
+        QTextStream(stderr) << QObject::tr("Cannot open %1\n").arg(store.path());
+        return 1;
+    }
+    QTextStream out(stdout);
+    out << "planned_shutdown,actual_shutdown,planned_wake,actual_resume,action,outcome,snoozes,wake_latency_ms,suspended_ms,"
+           "energy_sources,awake_rapl_mj,asleep_rapl_mj,transition_rapl_mj,awake_battery_mj,asleep_battery_mj,"
+           "transition_battery_mj\n";
+    for (const auto &record : store.records()) {
+        out << record.plannedShutdown << ',' << record.actualShutdown << ','
+            << record.plannedWake << ',' << record.actualResume << ','
+            << record.action << ',' << record.outcome << ',' << record.snoozeCount << ','
+            << record.wakeLatencyMs << ',' << record.suspendedMs << ','
+            << record.energySources << ',' << record.awakeRaplMj << ',' << record.asleepRaplMj << ','
+            << record.transitionRaplMj << ',' << record.awakeBatteryMj << ',' << record.asleepBatteryMj << ','
+            << record.transitionBatteryMj << '\n';
+    }
+    return 0;
+}
+
+/** SIGUSR1 dumps the trace; SIGTERM and SIGINT quit the event loop so the daemon can clean up. */
+bool installSignalHandlers() {
+    if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0, g_signalPipe) != 0) {
+        return false;
+    }
+    struct sigaction action {};
+    action.sa_handler = forwardSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    return ::sigaction(SIGUSR1, &action, nullptr) == 0 && ::sigaction(SIGTERM, &action, nullptr) == 0
+        && ::sigaction(SIGINT, &action, nullptr) == 0;
+}
+}
+
 int main(int argc, char *argv[]) {
     QCoreApplication app(argc, argv);
     app.setApplicationName(QStringLiteral("rtcwake-daemon"));
@@ -18,26 +74,80 @@ int main(int argc, char *argv[]) {
     QCommandLineOption userOpt(QStringLiteral("user"), QObject::tr("Target desktop user"), QObject::tr("name"));
     QCommandLineOption homeOpt(QStringLiteral("home"), QObject::tr("Target user home directory"), QObject::tr("dir"));
     QCommandLineOption warningOpt(QStringLiteral("warning-app"), QObject::tr("Path to the warning dialog executable"), QObject::tr("path"));
+    QCommandLineOption traceOpt(QStringLiteral("trace-file"), QObject::tr("Where SIGUSR1 dumps the Chrome trace JSON"), QObject::tr("path"));
+    QCommandLineOption metricsOpt(QStringLiteral("metrics-file"), QObject::tr("Optional node_exporter textfile (*.prom) to keep updated"), QObject::tr("path"));
+    QCommandLineOption hooksOpt(QStringLiteral("hooks-dir"), QObject::tr("Directory holding pre-suspend.d/ and post-resume.d/"),
+                                QObject::tr("dir"), QStringLiteral("/etc/rtcwake-gui"));
+    QCommandLineOption historyOpt(QStringLiteral("dump-history"), QObject::tr("Print the cycle history of --home as CSV and exit"));
 
     parser.addOption(configOpt);
     parser.addOption(userOpt);
     parser.addOption(homeOpt);
     parser.addOption(warningOpt);
+    parser.addOption(metricsOpt);
+    parser.addOption(traceOpt);
+    parser.addOption(hooksOpt);
+    parser.addOption(historyOpt);
 
     parser.process(app);
 
+    if (parser.isSet(historyOpt)) {
+        const QString home = parser.value(homeOpt);
+        if (home.isEmpty()) {
+            QTextStream(stderr) << QObject::tr("--dump-history needs --home.\n");
+            return 1;
+        }
+        return dumpHistory(home);
+    }
+
     RtcWakeDaemon::Options options;
     options.configPath = parser.value(configOpt);
     options.targetUser = parser.value(userOpt);
     options.targetHome = parser.value(homeOpt);
     options.warningApp = parser.value(warningOpt);
+    options.metricsPath = parser.value(metricsOpt);
+    options.tracePath = parser.value(traceOpt);
+    options.hooksDir = parser.value(hooksOpt);
 
     if (options.configPath.isEmpty() || options.targetUser.isEmpty() || options.targetHome.isEmpty() || options.warningApp.isEmpty()) {
         QTextStream(stderr) << QObject::tr("Missing required options. Use --help for details.\n");
         return 1;
     }
 
+    if (::prctl(PR_SET_TIMERSLACK, kTimerSlackNs, 0, 0, 0) != 0) {
+        QTextStream(stderr) << QObject::tr("Failed to raise timer slack\n");
+    }
+
     RtcWakeDaemon daemon(options);
+
+    if (installSignalHandlers()) {
+        auto *notifier = new QSocketNotifier(g_signalPipe[1], QSocketNotifier::Read, &app);
+        QObject::connect(notifier, &QSocketNotifier::activated, &daemon, [&daemon, &app]() {
+            char buffer[16];
+            bool dump = false;
+            bool quit = false;
+            qint64 count = 0;
+            while ((count = ::read(g_signalPipe[1], buffer, sizeof(buffer))) > 0) {
+                for (qint64 i = 0; i < count; ++i) {
+                    if (buffer[i] == SIGUSR1) {
+                        dump = true;
+                    } else {
+                        quit = true;
+                    }
+                }
+            }
+            if (dump) {
+                daemon.dumpTrace();
+            }
+            if (quit) {
+                // Leaving main() destroys the daemon, which thaws a frozen session.
+                app.quit();
+            }
+        });
+    } else {
+        QTextStream(stderr) << QObject::tr("Failed to install signal handlers\n");
+    }
+
     daemon.start();
 
     return app.exec();
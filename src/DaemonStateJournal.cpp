@@ -0,0 +1,118 @@
+#include "DaemonStateJournal.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+namespace {
+constexpr int kJournalVersion = 1;
+
+QString encodeDateTime(const QDateTime &dt) {
+    return dt.isValid() ? dt.toUTC().toString(Qt::ISODateWithMs) : QString();
+}
+
+QDateTime decodeDateTime(const QJsonValue &value) {
+    const QString text = value.toString();
+    if (text.isEmpty()) {
+        return QDateTime();
+    }
+    return QDateTime::fromString(text, Qt::ISODateWithMs).toLocalTime();
+}
+
+QByteArray digest(const QByteArray &payload) {
+    return QCryptographicHash::hash(payload, QCryptographicHash::Sha256).toHex();
+}
+}
+
+DaemonStateJournal::DaemonStateJournal(QString path)
+    : m_path(std::move(path)) {}
+
+QString DaemonStateJournal::path() const {
+    return m_path;
+}
+
+bool DaemonStateJournal::save(const State &state) const {
+    if (m_path.isEmpty()) {
+        return false;
+    }
+
+    QJsonObject obj;
+    obj.insert(QStringLiteral("version"), kJournalVersion);
+    obj.insert(QStringLiteral("nextShutdown"), encodeDateTime(state.nextShutdown));
+    obj.insert(QStringLiteral("nextWake"), encodeDateTime(state.nextWake));
+    obj.insert(QStringLiteral("cyclePlannedShutdown"), encodeDateTime(state.cyclePlannedShutdown));
+    obj.insert(QStringLiteral("armedAlarm"), encodeDateTime(state.armedAlarm));
+    obj.insert(QStringLiteral("transitionStarted"), encodeDateTime(state.transitionStarted));
+    obj.insert(QStringLiteral("actionId"), static_cast<int>(state.action));
+    obj.insert(QStringLiteral("readyLeadMs"), static_cast<double>(state.readyLeadMs));
+    obj.insert(QStringLiteral("snoozeActive"), state.snoozeActive);
+    obj.insert(QStringLiteral("snoozeCount"), state.snoozeCount);
+    obj.insert(QStringLiteral("configFingerprint"), QString::fromLatin1(state.configFingerprint));
+    obj.insert(QStringLiteral("savedAt"), encodeDateTime(state.savedAt));
+    obj.insert(QStringLiteral("pid"), static_cast<double>(state.pid));
+
+    const QByteArray payload = QJsonDocument(obj).toJson(QJsonDocument::Compact);
+
+    QDir dir = QFileInfo(m_path).absoluteDir();
+    if (!dir.exists() && !QDir().mkpath(dir.absolutePath())) {
+        qWarning().noquote() << "Failed to create journal directory" << dir.absolutePath();
+        return false;
+    }
+    QSaveFile file(m_path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qWarning().noquote() << "Failed to open state journal" << m_path << file.errorString();
+        return false;
+    }
+    file.write(payload);
+    file.write("\n");
+    file.write(digest(payload));
+    file.write("\n");
+    return file.commit();
+}
+
+bool DaemonStateJournal::load(State &state) const {
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return false;
+    }
+    const QByteArray payload = file.readLine().trimmed();
+    const QByteArray checksum = file.readLine().trimmed();
+    if (payload.isEmpty() || checksum != digest(payload)) {
+        qWarning().noquote() << "Ignoring state journal with bad checksum" << m_path;
+        return false;
+    }
+
+    const auto doc = QJsonDocument::fromJson(payload);
+    if (!doc.isObject()) {
+        return false;
+    }
+    const QJsonObject obj = doc.object();
+    if (obj.value(QStringLiteral("version")).toInt() != kJournalVersion) {
+        return false;
+    }
+
+    State loaded;
+    loaded.nextShutdown = decodeDateTime(obj.value(QStringLiteral("nextShutdown")));
+    loaded.nextWake = decodeDateTime(obj.value(QStringLiteral("nextWake")));
+    loaded.cyclePlannedShutdown = decodeDateTime(obj.value(QStringLiteral("cyclePlannedShutdown")));
+    loaded.armedAlarm = decodeDateTime(obj.value(QStringLiteral("armedAlarm")));
+    loaded.transitionStarted = decodeDateTime(obj.value(QStringLiteral("transitionStarted")));
+    loaded.action = static_cast<PowerAction>(obj.value(QStringLiteral("actionId")).toInt());
+    loaded.readyLeadMs = static_cast<qint64>(obj.value(QStringLiteral("readyLeadMs")).toDouble());
+    loaded.snoozeActive = obj.value(QStringLiteral("snoozeActive")).toBool();
+    loaded.snoozeCount = obj.value(QStringLiteral("snoozeCount")).toInt();
+    loaded.configFingerprint = obj.value(QStringLiteral("configFingerprint")).toString().toLatin1();
+    loaded.savedAt = decodeDateTime(obj.value(QStringLiteral("savedAt")));
+    loaded.pid = static_cast<qint64>(obj.value(QStringLiteral("pid")).toDouble());
+    state = loaded;
+    return true;
+}
+
+bool DaemonStateJournal::clear() const {
+    return !QFile::exists(m_path) || QFile::remove(m_path);
+}
@@ -0,0 +1,139 @@
+#include "EnergyMeter.h"
+
+#include <QDir>
+#include <QFile>
+#include <QRegularExpression>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace {
+qint64 readNumber(const QString &path, bool *ok = nullptr) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (ok) {
+            *ok = false;
+        }
+        return 0;
+    }
+    return file.readAll().trimmed().toLongLong(ok);
+}
+
+QString readText(const QString &path) {
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly | QIODevice::Text) ? QString::fromUtf8(file.readAll().trimmed()) : QString();
+}
+}
+
+EnergyMeter::EnergyMeter(QString sysRoot)
+    : m_sysRoot(std::move(sysRoot)) {}
+
+EnergyMeter::Energy EnergyMeter::sample(bool acrossSleep) {
+    const auto zones = readRapl();
+    m_raplRangeUj = 0;
+    for (auto it = zones.cbegin(); it != zones.cend(); ++it) {
+        if (it->rangeUj > 0) {
+            m_raplRangeUj = m_raplRangeUj > 0 ? std::min(m_raplRangeUj, it->rangeUj) : it->rangeUj;
+        }
+        const auto last = m_raplLast.constFind(it.key());
+        qint64 delta = 0;
+        if (last != m_raplLast.cend()) {
+            delta = it->energyUj - *last;
+            if (delta < 0) {
+                delta = acrossSleep || it->rangeUj <= 0 ? it->energyUj : delta + it->rangeUj;
+            }
+        }
+        m_totals.raplUj += delta;
+        m_totals.hasRapl = true;
+        m_raplLast.insert(it.key(), it->energyUj);
+    }
+
+    const auto batteries = readBatteries();
+    for (auto it = batteries.cbegin(); it != batteries.cend(); ++it) {
+        const qint64 drained = m_batteryLast.contains(it.key()) ? m_batteryLast.value(it.key()) - *it : 0;
+        m_totals.batteryUj += drained;
+        m_totals.hasBattery = true;
+        m_batteryLast.insert(it.key(), *it);
+    }
+    return m_totals;
+}
+
+EnergyMeter::Energy EnergyMeter::totals() const {
+    return m_totals;
+}
+
+qint64 EnergyMeter::wrapSafeIntervalMs() const {
+    if (m_raplRangeUj <= 0) {
+        return 0;
+    }
+    // Half the time the counter needs to wrap at full power.
+    return static_cast<qint64>(m_raplRangeUj / kMaxWatts / 1000.0 / 2.0);
+}
+
+EnergyMeter::Energy EnergyMeter::since(const Energy &from, const Energy &to) {
+    Energy result;
+    result.hasRapl = from.hasRapl && to.hasRapl;
+    if (result.hasRapl) {
+        result.raplUj = to.raplUj - from.raplUj;
+    }
+    result.hasBattery = from.hasBattery && to.hasBattery;
+    if (result.hasBattery) {
+        result.batteryUj = to.batteryUj - from.batteryUj;
+    }
+    return result;
+}
+
+QMap<QString, EnergyMeter::RaplZone> EnergyMeter::readRapl() const {
+    static const QRegularExpression topLevel(QStringLiteral("^intel-rapl:\\d+$"));
+    const QDir dir(m_sysRoot + QStringLiteral("/class/powercap"));
+    QMap<QString, RaplZone> packages;
+    QMap<QString, RaplZone> platform;
+    for (const auto &name : dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        // Sub-zones (cores, uncore, DRAM) are part of their package's count.
+        if (!topLevel.match(name).hasMatch()) {
+            continue;
+        }
+        const QString path = dir.filePath(name);
+        bool ok = false;
+        RaplZone zone;
+        zone.energyUj = readNumber(path + QStringLiteral("/energy_uj"), &ok);
+        if (!ok) {
+            continue;
+        }
+        zone.rangeUj = readNumber(path + QStringLiteral("/max_energy_range_uj"));
+        (readText(path + QStringLiteral("/name")) == QStringLiteral("psys") ? platform : packages).insert(name, zone);
+    }
+    // psys already includes the packages.
+    return platform.isEmpty() ? packages : platform;
+}
+
+QMap<QString, qint64> EnergyMeter::readBatteries() const {
+    const QDir dir(m_sysRoot + QStringLiteral("/class/power_supply"));
+    QMap<QString, qint64> result;
+    for (const auto &name : dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        const QString path = dir.filePath(name);
+        if (readText(path + QStringLiteral("/type")) != QStringLiteral("Battery")) {
+            continue;
+        }
+        bool ok = false;
+        // µWh, or µAh times µV (10^-12 Wh); either way scaled to µJ.
+        const qint64 energyUwh = readNumber(path + QStringLiteral("/energy_now"), &ok);
+        if (ok) {
+            result.insert(name, energyUwh * 3600);
+            continue;
+        }
+        const qint64 chargeUah = readNumber(path + QStringLiteral("/charge_now"), &ok);
+        if (!ok) {
+            continue;
+        }
+        qint64 voltageUv = readNumber(path + QStringLiteral("/voltage_now"), &ok);
+        if (!ok || voltageUv <= 0) {
+            voltageUv = readNumber(path + QStringLiteral("/voltage_min_design"), &ok);
+        }
+        if (ok && voltageUv > 0) {
+            result.insert(name, std::llround(static_cast<double>(chargeUah) * voltageUv * 3.6e-3));
+        }
+    }
+    return result;
+}
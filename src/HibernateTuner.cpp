@@ -0,0 +1,277 @@
+#include "HibernateTuner.h"
+
+#include "KernelFiles.h"
+#include "StateFile.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QObject>
+#include <QRegularExpression>
+
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <functional>
+
+namespace {
+/**
+ * Calls @p record for every "prio,seq,usec,flags;message" record of a kmsg device.
+ * /dev/kmsg hands out one record per read() and EAGAIN at the end; a plain file (tests)
+ * hands out arbitrary chunks, so lines are reassembled either way.
+ */
+void forEachKmsgRecord(const QString &path, const std::function<void(quint64, const QByteArray &)> &record) {
+    const QByteArray name = QFile::encodeName(path);
+    const int fd = ::open(name.constData(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        qWarning().noquote() << "Cannot read the kernel log" << path << qt_error_string(errno);
+        return;
+    }
+    QByteArray pending;
+    char buffer[8192];
+    for (;;) {
+        const ssize_t bytes = ::read(fd, buffer, sizeof(buffer));
+        if (bytes < 0 && errno == EPIPE) {
+            // Records were overwritten while reading; the next read continues after them.
+            continue;
+        }
+        if (bytes <= 0) {
+            break;
+        }
+        pending.append(buffer, static_cast<int>(bytes));
+        int newline = -1;
+        while ((newline = pending.indexOf('\n')) >= 0) {
+            const QByteArray line = pending.left(newline);
+            pending.remove(0, newline + 1);
+            // Continuation lines (" SUBSYSTEM=...") start with a space.
+            const int semicolon = line.indexOf(';');
+            if (line.startsWith(' ') || semicolon < 0) {
+                continue;
+            }
+            const QList<QByteArray> prefix = line.left(semicolon).split(',');
+            if (prefix.size() >= 2) {
+                record(prefix.at(1).toULongLong(), line.mid(semicolon + 1));
+            }
+        }
+    }
+    ::close(fd);
+}
+
+double mean(double sum, int count) {
+    return count > 0 ? sum / count : -1.0;
+}
+}
+
+double HibernateTuner::SettingStats::meanResumeSeconds() const {
+    return mean(resumeSecondsSum, count);
+}
+
+double HibernateTuner::SettingStats::meanWriteSeconds() const {
+    return mean(writeSecondsSum, writeCount);
+}
+
+double HibernateTuner::SettingStats::meanReadSeconds() const {
+    return mean(readSecondsSum, readCount);
+}
+
+double HibernateTuner::SettingStats::costSeconds() const {
+    return meanResumeSeconds() + std::max(0.0, meanWriteSeconds());
+}
+
+HibernateTuner::HibernateTuner(QString sysRoot, QString procRoot, QString kmsgPath)
+    : m_sysRoot(std::move(sysRoot)),
+      m_procRoot(std::move(procRoot)),
+      m_kmsgPath(std::move(kmsgPath)) {}
+
+QString HibernateTuner::settingKey(const HibernateTuningPreferences &prefs) {
+    QStringList parts;
+    if (prefs.imageSizePercent < 0) {
+        parts << QStringLiteral("image=kernel");
+    } else if (prefs.imageSizePercent == 0) {
+        parts << QStringLiteral("image=min");
+    } else {
+        parts << QStringLiteral("image=%1%").arg(prefs.imageSizePercent);
+    }
+    parts << QStringLiteral("disk=%1").arg(prefs.diskMode.isEmpty() ? QStringLiteral("kernel") : prefs.diskMode);
+    parts << QStringLiteral("compressor=%1").arg(prefs.compressor.isEmpty() ? QStringLiteral("kernel") : prefs.compressor);
+    if (prefs.dropCaches) {
+        parts << QStringLiteral("drop_caches");
+    }
+    if (prefs.compactMemory) {
+        parts << QStringLiteral("compact");
+    }
+    return parts.join(QLatin1Char(','));
+}
+
+HibernateTuner::Applied HibernateTuner::apply(const HibernateTuningPreferences &prefs) const {
+    Applied applied;
+    applied.key = settingKey(prefs);
+
+    // Dropping the page cache first shrinks what the image has to hold; only clean pages
+    // go, so flush dirty ones to disk before asking.
+    if (prefs.dropCaches) {
+        ::sync();
+        writeValue(m_procRoot + QStringLiteral("/sys/vm/drop_caches"), "1", applied.errors);
+    }
+    if (prefs.compactMemory) {
+        writeValue(m_procRoot + QStringLiteral("/sys/vm/compact_memory"), "1", applied.errors);
+    }
+
+    const QString imageSizePath = m_sysRoot + QStringLiteral("/power/image_size");
+    if (prefs.imageSizePercent >= 0) {
+        const qint64 memTotal = KernelFiles::memTotalBytes(m_procRoot + QStringLiteral("/meminfo"));
+        if (memTotal <= 0) {
+            applied.errors << QObject::tr("Cannot size the image: MemTotal is unknown");
+        } else {
+            const qint64 bytes = memTotal * prefs.imageSizePercent / 100;
+            if (writeValue(imageSizePath, QByteArray::number(bytes), applied.errors)) {
+                applied.imageBytes = bytes;
+            }
+        }
+    }
+    if (applied.imageBytes < 0) {
+        applied.imageBytes = KernelFiles::readTokens(imageSizePath).value(0, QStringLiteral("-1")).toLongLong();
+    }
+
+    if (!prefs.diskMode.isEmpty()) {
+        // "[platform] shutdown reboot suspend test_resume": brackets mark the current mode.
+        QStringList modes = KernelFiles::readTokens(m_sysRoot + QStringLiteral("/power/disk"));
+        for (auto &mode : modes) {
+            mode.remove(QLatin1Char('[')).remove(QLatin1Char(']'));
+        }
+        if (modes.contains(prefs.diskMode)) {
+            writeValue(m_sysRoot + QStringLiteral("/power/disk"), prefs.diskMode.toUtf8(), applied.errors);
+        } else {
+            applied.errors << QObject::tr("Disk mode %1 is not offered (%2)")
+                                  .arg(prefs.diskMode, modes.join(QLatin1Char(' ')));
+        }
+    }
+
+    if (!prefs.compressor.isEmpty()) {
+        const QString compressorPath = m_sysRoot + QStringLiteral("/module/hibernate/parameters/compressor");
+        if (QFile::exists(compressorPath)) {
+            writeValue(compressorPath, prefs.compressor.toUtf8(), applied.errors);
+        } else {
+            applied.errors << QObject::tr("This kernel does not let us choose the image compressor");
+        }
+    }
+    return applied;
+}
+
+quint64 HibernateTuner::kmsgSequence() const {
+    quint64 newest = 0;
+    forEachKmsgRecord(m_kmsgPath, [&newest](quint64 sequence, const QByteArray &) {
+        newest = std::max(newest, sequence);
+    });
+    return newest;
+}
+
+HibernateTuner::ImageStats HibernateTuner::imageStats(quint64 afterSequence) const {
+    // swsusp_show_speed(): "PM: hibernation: Wrote 2048000 kbytes in 4.10 seconds (499.51 MB/s)"
+    static const QRegularExpression pattern(QStringLiteral("\\b(Wrote|Read) (\\d+) kbytes in (\\d+\\.\\d+) seconds"));
+    ImageStats stats;
+    forEachKmsgRecord(m_kmsgPath, [&stats, afterSequence](quint64 sequence, const QByteArray &message) {
+        if (sequence <= afterSequence) {
+            return;
+        }
+        const auto match = pattern.match(QString::fromUtf8(message));
+        if (!match.hasMatch()) {
+            return;
+        }
+        const qint64 kib = match.captured(2).toLongLong();
+        const double seconds = match.captured(3).toDouble();
+        if (match.captured(1) == QStringLiteral("Wrote")) {
+            stats.writtenKiB = kib;
+            stats.writeSeconds = seconds;
+        } else {
+            stats.readKiB = kib;
+            stats.readSeconds = seconds;
+        }
+    });
+    return stats;
+}
+
+QMap<QString, HibernateTuner::SettingStats> HibernateTuner::loadStats(const QString &path) {
+    QMap<QString, SettingStats> result;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return result;
+    }
+    const QJsonObject settings = QJsonDocument::fromJson(file.readAll()).object().value(QStringLiteral("settings")).toObject();
+    for (auto it = settings.begin(); it != settings.end(); ++it) {
+        const QJsonObject obj = it.value().toObject();
+        SettingStats stats;
+        stats.count = obj.value(QStringLiteral("count")).toInt();
+        stats.resumeSecondsSum = obj.value(QStringLiteral("resumeSecondsSum")).toDouble();
+        stats.writeCount = obj.value(QStringLiteral("writeCount")).toInt();
+        stats.writeSecondsSum = obj.value(QStringLiteral("writeSecondsSum")).toDouble();
+        stats.readCount = obj.value(QStringLiteral("readCount")).toInt();
+        stats.readSecondsSum = obj.value(QStringLiteral("readSecondsSum")).toDouble();
+        stats.lastImageBytes = static_cast<qint64>(obj.value(QStringLiteral("lastImageBytes")).toDouble(-1));
+        if (stats.count > 0) {
+            result.insert(it.key(), stats);
+        }
+    }
+    return result;
+}
+
+bool HibernateTuner::recordSample(const QString &path, const QString &key, qint64 imageBytes, const ImageStats &image,
+                                  double resumeSeconds) {
+    QMap<QString, SettingStats> all = loadStats(path);
+    SettingStats &stats = all[key];
+    ++stats.count;
+    stats.resumeSecondsSum += std::max(0.0, resumeSeconds);
+    if (image.writeSeconds >= 0) {
+        ++stats.writeCount;
+        stats.writeSecondsSum += image.writeSeconds;
+    }
+    if (image.readSeconds >= 0) {
+        ++stats.readCount;
+        stats.readSecondsSum += image.readSeconds;
+    }
+    stats.lastImageBytes = imageBytes;
+
+    QJsonObject settings;
+    for (auto it = all.cbegin(); it != all.cend(); ++it) {
+        QJsonObject obj;
+        obj.insert(QStringLiteral("count"), it->count);
+        obj.insert(QStringLiteral("resumeSecondsSum"), it->resumeSecondsSum);
+        obj.insert(QStringLiteral("writeCount"), it->writeCount);
+        obj.insert(QStringLiteral("writeSecondsSum"), it->writeSecondsSum);
+        obj.insert(QStringLiteral("readCount"), it->readCount);
+        obj.insert(QStringLiteral("readSecondsSum"), it->readSecondsSum);
+        obj.insert(QStringLiteral("lastImageBytes"), static_cast<double>(it->lastImageBytes));
+        settings.insert(it.key(), obj);
+    }
+    QJsonObject root;
+    root.insert(QStringLiteral("settings"), settings);
+
+    return saveJsonState(path, root);
+}
+
+QString HibernateTuner::bestSetting(const QMap<QString, SettingStats> &stats, int minSamples) {
+    QString best;
+    double bestCost = 0.0;
+    for (auto it = stats.cbegin(); it != stats.cend(); ++it) {
+        if (it->count < minSamples) {
+            continue;
+        }
+        if (best.isEmpty() || it->costSeconds() < bestCost) {
+            best = it.key();
+            bestCost = it->costSeconds();
+        }
+    }
+    return best;
+}
+
+bool HibernateTuner::writeValue(const QString &path, const QByteArray &value, QStringList &errors) const {
+    QString error;
+    if (!KernelFiles::writeValue(path, value, &error)) {
+        errors << QObject::tr("Cannot write %1 to %2: %3").arg(QString::fromUtf8(value), path, error);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,237 @@
+#include "HookRunner.h"
+
+#include "ProcessGroup.h"
+#include "TraceBuffer.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QHash>
+#include <QProcess>
+#include <QRegularExpression>
+#include <QTimer>
+
+#include <algorithm>
+#include <functional>
+
+namespace {
+constexpr int kMaxHeaderLines = 40;
+
+bool isBackupName(const QString &name) {
+    return name.endsWith(QLatin1Char('~')) || name.contains(QStringLiteral(".dpkg-"))
+           || name.endsWith(QStringLiteral(".rpmnew")) || name.endsWith(QStringLiteral(".rpmsave"));
+}
+
+/** Read the `# rtcwake-*:` lines of the leading comment block. */
+void parseHeader(HookRunner::Hook &hook) {
+    QFile file(hook.path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    for (int line = 0; line < kMaxHeaderLines && !file.atEnd(); ++line) {
+        const QString text = QString::fromUtf8(file.readLine(512)).trimmed();
+        if (text.isEmpty()) {
+            continue;
+        }
+        if (!text.startsWith(QLatin1Char('#'))) {
+            break;
+        }
+        const QString body = text.mid(1).trimmed();
+        if (body.startsWith(QStringLiteral("rtcwake-after:"))) {
+            hook.after += body.mid(14).split(QRegularExpression(QStringLiteral("[\\s,]+")), Qt::SkipEmptyParts);
+        } else if (body.startsWith(QStringLiteral("rtcwake-timeout:"))) {
+            bool ok = false;
+            const double seconds = body.mid(16).trimmed().toDouble(&ok);
+            if (ok && seconds > 0) {
+                hook.timeoutMs = static_cast<int>(std::min(seconds * 1000.0, 24.0 * 3600 * 1000));
+            } else {
+                qWarning().noquote() << "Ignoring invalid rtcwake-timeout in" << hook.path;
+            }
+        }
+    }
+}
+}
+
+bool HookRunner::Result::succeeded() const {
+    return !timedOut && exitCode == 0;
+}
+
+bool HookRunner::Report::succeeded() const {
+    return std::all_of(results.cbegin(), results.cend(), [](const Result &result) { return result.succeeded(); });
+}
+
+const HookRunner::Result *HookRunner::Report::slowest() const {
+    const auto it = std::max_element(results.cbegin(), results.cend(), [](const Result &a, const Result &b) {
+        return a.elapsedMs < b.elapsedMs;
+    });
+    return it == results.cend() ? nullptr : &*it;
+}
+
+HookRunner::HookRunner(QObject *parent)
+    : QObject(parent) {}
+
+void HookRunner::setMaxParallel(int count) {
+    m_maxParallel = std::max(1, count);
+}
+
+int HookRunner::maxParallel() const {
+    return m_maxParallel;
+}
+
+void HookRunner::setDefaultTimeout(int msecs) {
+    m_defaultTimeoutMs = std::max(1, msecs);
+}
+
+void HookRunner::setEnvironment(const QProcessEnvironment &environment) {
+    m_environment = environment;
+}
+
+bool HookRunner::isRunning() const {
+    return m_running;
+}
+
+QVector<HookRunner::Hook> HookRunner::discover(const QString &directory, int defaultTimeoutMs) {
+    QVector<Hook> hooks;
+    if (directory.isEmpty()) {
+        return hooks;
+    }
+    const auto entries = QDir(directory).entryInfoList(QDir::Files | QDir::Executable, QDir::Name);
+    for (const auto &entry : entries) {
+        if (isBackupName(entry.fileName())) {
+            continue;
+        }
+        Hook hook;
+        hook.name = entry.fileName();
+        hook.path = entry.absoluteFilePath();
+        hook.timeoutMs = defaultTimeoutMs;
+        parseHeader(hook);
+        hooks.append(hook);
+    }
+    return hooks;
+}
+
+HookRunner::Report HookRunner::run(const QString &directory, const QStringList &arguments) {
+    Report report;
+    if (m_running) {
+        qWarning().noquote() << "Hook pipeline already running; not starting" << directory;
+        return report;
+    }
+    const QVector<Hook> hooks = discover(directory, m_defaultTimeoutMs);
+    if (hooks.isEmpty()) {
+        return report;
+    }
+
+    TraceScope trace("hooks", "run");
+    m_running = true;
+    QElapsedTimer total;
+    total.start();
+
+    enum class State {
+        Pending,
+        Running,
+        Done
+    };
+    QHash<QString, int> indexByName;
+    for (int i = 0; i < hooks.size(); ++i) {
+        indexByName.insert(hooks.at(i).name, i);
+    }
+    QVector<State> states(hooks.size(), State::Pending);
+    QVector<QElapsedTimer> clocks(hooks.size());
+    report.results.resize(hooks.size());
+    for (int i = 0; i < hooks.size(); ++i) {
+        report.results[i].name = hooks.at(i).name;
+    }
+
+    QEventLoop loop;
+    QObject scope;
+    int running = 0;
+    int done = 0;
+    std::function<void()> startReady;
+
+    const auto finish = [&](int index, int exitCode, const QString &message) {
+        if (states.at(index) == State::Done) {
+            return;
+        }
+        if (states.at(index) == State::Running) {
+            --running;
+            report.results[index].elapsedMs = clocks[index].elapsed();
+        }
+        states[index] = State::Done;
+        ++done;
+        report.results[index].exitCode = exitCode;
+        report.results[index].message = message;
+        if (done == hooks.size()) {
+            loop.quit();
+        } else {
+            startReady();
+        }
+    };
+
+    const auto ready = [&](int index) {
+        return std::all_of(hooks.at(index).after.cbegin(), hooks.at(index).after.cend(), [&](const QString &name) {
+            // Ordering only: hooks that are not installed do not hold anyone back.
+            const auto it = indexByName.constFind(name);
+            return it == indexByName.cend() || states.at(it.value()) == State::Done;
+        });
+    };
+
+    startReady = [&]() {
+        for (int i = 0; i < hooks.size() && running < m_maxParallel; ++i) {
+            if (states.at(i) != State::Pending || !ready(i)) {
+                continue;
+            }
+            const Hook &hook = hooks.at(i);
+            states[i] = State::Running;
+            ++running;
+            clocks[i].start();
+
+            auto *process = new SessionProcess(&scope);
+            process->setProcessChannelMode(QProcess::MergedChannels);
+            if (!m_environment.isEmpty()) {
+                process->setProcessEnvironment(m_environment);
+            }
+            auto *deadline = new QTimer(process);
+            deadline->setSingleShot(true);
+            connect(deadline, &QTimer::timeout, process, [&, i, process]() {
+                report.results[i].timedOut = true;
+                killProcessGroup(process);
+            });
+            connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), &scope,
+                    [&, i, process, deadline](int exitCode, QProcess::ExitStatus status) {
+                        deadline->stop();
+                        QString message = lastOutputLine(process->readAll());
+                        if (report.results.at(i).timedOut) {
+                            message = tr("killed after %1 ms").arg(hooks.at(i).timeoutMs);
+                        }
+                        finish(i, status == QProcess::NormalExit ? exitCode : -1, message);
+                    });
+            connect(process, &QProcess::errorOccurred, &scope, [&, i, process, deadline](QProcess::ProcessError error) {
+                if (error == QProcess::FailedToStart) {
+                    deadline->stop();
+                    finish(i, -1, process->errorString());
+                }
+            });
+            deadline->start(hook.timeoutMs);
+            process->start(hook.path, arguments);
+        }
+
+        if (running == 0 && done < hooks.size()) {
+            // Nothing runs and nothing can start: skip the first blocked hook to break the cycle.
+            const auto blocked = std::find(states.cbegin(), states.cend(), State::Pending);
+            const int index = static_cast<int>(blocked - states.cbegin());
+            qWarning().noquote() << "Hook" << hooks.at(index).path << "is part of an rtcwake-after cycle; skipped";
+            finish(index, -1, tr("skipped to break an rtcwake-after cycle"));
+        }
+    };
+
+    startReady();
+    if (done < hooks.size()) {
+        loop.exec();
+    }
+
+    report.elapsedMs = total.elapsed();
+    m_running = false;
+    return report;
+}
@@ -0,0 +1,167 @@
+#include "IdleSuspendMonitor.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QSocketNotifier>
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+namespace {
+// The longest window the kernel accepts; fewer events while busy.
+constexpr qint64 kPsiWindowUs = 10 * 1000 * 1000;
+}
+
+IdleSuspendMonitor::IdleSuspendMonitor(DaemonClock *clock, QString procRoot, QObject *parent)
+    : QObject(parent),
+      m_clock(clock),
+      m_procRoot(std::move(procRoot)),
+      m_timer(m_clock->createTimer(this)) {
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::VeryCoarseTimer);
+    connect(m_timer, &DaemonTimer::timeout, this, &IdleSuspendMonitor::handleTimeout);
+}
+
+IdleSuspendMonitor::~IdleSuspendMonitor() {
+    closeTriggers();
+}
+
+void IdleSuspendMonitor::start(const Settings &settings) {
+    if (m_fds.isEmpty() || settings.pressurePercent != m_settings.pressurePercent
+        || settings.resources != m_settings.resources) {
+        closeTriggers();
+        m_settings = settings;
+        openTriggers();
+    }
+    m_settings = settings;
+    if (m_fds.isEmpty()) {
+        // Without PSI a busy machine is indistinguishable from an idle one.
+        qWarning().noquote() << "No PSI trigger could be armed below" << m_procRoot << "; idle suspend stays off";
+        stop();
+        return;
+    }
+    if (!m_sessionIdle) {
+        m_state = State::SessionActive;
+        m_timer->stop();
+        setTriggersEnabled(false);
+        return;
+    }
+    beginQuietPeriod();
+}
+
+void IdleSuspendMonitor::stop() {
+    m_state = State::Stopped;
+    m_timer->stop();
+    setTriggersEnabled(false);
+}
+
+bool IdleSuspendMonitor::isActive() const {
+    return m_state != State::Stopped;
+}
+
+int IdleSuspendMonitor::triggerCount() const {
+    return m_fds.size();
+}
+
+void IdleSuspendMonitor::noteActivity() {
+    if (m_state != State::Watching) {
+        return;
+    }
+    // Mute the triggers and look again one idle period later instead of on every event.
+    m_state = State::Backoff;
+    setTriggersEnabled(false);
+    m_timer->start(m_settings.idleMs);
+}
+
+void IdleSuspendMonitor::setSessionIdle(bool idle) {
+    if (m_sessionIdle == idle) {
+        return;
+    }
+    m_sessionIdle = idle;
+    if (m_state == State::Stopped) {
+        return;
+    }
+    if (!idle) {
+        m_state = State::SessionActive;
+        m_timer->stop();
+        setTriggersEnabled(false);
+        return;
+    }
+    beginQuietPeriod();
+}
+
+void IdleSuspendMonitor::openTriggers() {
+    const qint64 stallUs = kPsiWindowUs * std::clamp(m_settings.pressurePercent, 1, 100) / 100;
+    const QByteArray trigger = "some " + QByteArray::number(stallUs) + ' ' + QByteArray::number(kPsiWindowUs);
+    for (const auto &resource : m_settings.resources) {
+        const QByteArray path = QFile::encodeName(m_procRoot + QStringLiteral("/pressure/") + resource);
+        const int fd = ::open(path.constData(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) {
+            qWarning().noquote() << "Cannot open PSI trigger" << path << qt_error_string(errno);
+            continue;
+        }
+        if (::write(fd, trigger.constData(), static_cast<size_t>(trigger.size() + 1)) < 0) {
+            qWarning().noquote() << "Cannot arm PSI trigger" << path << qt_error_string(errno);
+            ::close(fd);
+            continue;
+        }
+        // PSI reports a crossed threshold as POLLPRI, which QSocketNotifier calls Exception.
+        auto *notifier = new QSocketNotifier(fd, QSocketNotifier::Exception, this);
+        notifier->setEnabled(false);
+        connect(notifier, &QSocketNotifier::activated, this, &IdleSuspendMonitor::noteActivity);
+        m_fds.append(fd);
+        m_notifiers.append(notifier);
+    }
+}
+
+void IdleSuspendMonitor::closeTriggers() {
+    qDeleteAll(m_notifiers);
+    m_notifiers.clear();
+    for (const int fd : m_fds) {
+        ::close(fd);
+    }
+    m_fds.clear();
+}
+
+void IdleSuspendMonitor::setTriggersEnabled(bool enabled) {
+    for (auto *notifier : m_notifiers) {
+        notifier->setEnabled(enabled);
+    }
+}
+
+void IdleSuspendMonitor::drainTriggers() {
+    // An event that fired while muted is stale; polling the trigger consumes it.
+    QVector<pollfd> fds;
+    for (const int fd : m_fds) {
+        fds.append({fd, POLLPRI, 0});
+    }
+    if (!fds.isEmpty()) {
+        ::poll(fds.data(), static_cast<nfds_t>(fds.size()), 0);
+    }
+}
+
+void IdleSuspendMonitor::beginQuietPeriod() {
+    drainTriggers();
+    setTriggersEnabled(true);
+    m_state = State::Watching;
+    m_timer->start(m_settings.idleMs);
+}
+
+void IdleSuspendMonitor::handleTimeout() {
+    switch (m_state) {
+    case State::Backoff:
+        beginQuietPeriod();
+        break;
+    case State::Watching:
+        m_state = State::Stopped;
+        setTriggersEnabled(false);
+        emit idle();
+        break;
+    case State::SessionActive:
+    case State::Stopped:
+        break;
+    }
+}
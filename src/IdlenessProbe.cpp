@@ -0,0 +1,176 @@
+#include "IdlenessProbe.h"
+
+#include <QDir>
+#include <QFile>
+#include <QMultiHash>
+#include <QRegularExpression>
+#include <QSet>
+
+#include <algorithm>
+
+namespace {
+constexpr quint64 kSectorBytes = 512;
+/** The kernel keeps TASK_COMM_LEN (16) bytes of a process name, including the NUL. */
+constexpr int kCommLength = 15;
+
+QByteArray readSmallFile(const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    // procfs files report a size of 0, so read until EOF instead of trusting size().
+    return file.readAll();
+}
+
+/** Partitions, loop/ram devices and stacked devices would count the same I/O twice. */
+bool isPhysicalDisk(const QString &name) {
+    static const QRegularExpression skip(QStringLiteral(
+        "^(loop\\d+|ram\\d+|zram\\d+|dm-\\d+|md\\d+|sr\\d+|fd\\d+"
+        "|(sd|vd|xvd|hd)[a-z]+\\d+|nvme\\d+n\\d+p\\d+|mmcblk\\d+p\\d+|mmcblk\\d+boot\\d+)$"));
+    return !skip.match(name).hasMatch();
+}
+
+QString formatDouble(double value) {
+    return QString::number(value, 'f', 2);
+}
+}
+
+IdlenessProbe::IdlenessProbe(QString procRoot)
+    : m_procRoot(std::move(procRoot)) {}
+
+IdlenessProbe::Snapshot IdlenessProbe::sample(qint64 monotonicMs, const QStringList &blockingProcesses) const {
+    Snapshot snapshot;
+    snapshot.monotonicMs = monotonicMs;
+
+    const QByteArray loadavg = readSmallFile(m_procRoot + QStringLiteral("/loadavg"));
+    bool ok = false;
+    const double load1 = loadavg.split(' ').value(0).toDouble(&ok);
+    if (ok) {
+        snapshot.load1 = load1;
+        snapshot.valid = true;
+    }
+    snapshot.cpuPressure = readPressure(QStringLiteral("cpu"));
+    snapshot.ioPressure = readPressure(QStringLiteral("io"));
+    snapshot.memoryPressure = readPressure(QStringLiteral("memory"));
+    snapshot.diskBytes = readDiskBytes();
+    snapshot.netBytes = readNetBytes();
+    snapshot.blockingProcesses = findProcesses(blockingProcesses);
+    return snapshot;
+}
+
+QStringList IdlenessProbe::busyReasons(const Snapshot &before, const Snapshot &after, const DeferralPreferences &limits,
+                                       int cpuCount) {
+    QStringList reasons;
+    const double perCpu = after.load1 / std::max(1, cpuCount);
+    if (limits.maxLoadPerCpu > 0 && after.load1 >= 0 && perCpu > limits.maxLoadPerCpu) {
+        reasons << QStringLiteral("load %1 per cpu > %2").arg(formatDouble(perCpu), formatDouble(limits.maxLoadPerCpu));
+    }
+
+    const auto checkPressure = [&reasons](const char *resource, double value, double limit) {
+        if (limit > 0 && value >= 0 && value > limit) {
+            reasons << QStringLiteral("%1 pressure %2% > %3%")
+                           .arg(QLatin1String(resource), formatDouble(value), formatDouble(limit));
+        }
+    };
+    checkPressure("cpu", after.cpuPressure, limits.maxCpuPressure);
+    checkPressure("io", after.ioPressure, limits.maxIoPressure);
+    checkPressure("memory", after.memoryPressure, limits.maxMemoryPressure);
+
+    const qint64 spanMs = after.monotonicMs - before.monotonicMs;
+    if (before.valid && spanMs > 0) {
+        const auto kibPerSecond = [spanMs](quint64 from, quint64 to) {
+            return to > from ? (to - from) / 1024.0 / (spanMs / 1000.0) : 0.0;
+        };
+        const double disk = kibPerSecond(before.diskBytes, after.diskBytes);
+        if (limits.maxDiskKiBps > 0 && disk > limits.maxDiskKiBps) {
+            reasons << QStringLiteral("disk %1 KiB/s > %2 KiB/s").arg(QString::number(disk, 'f', 0)).arg(limits.maxDiskKiBps);
+        }
+        const double net = kibPerSecond(before.netBytes, after.netBytes);
+        if (limits.maxNetKiBps > 0 && net > limits.maxNetKiBps) {
+            reasons << QStringLiteral("network %1 KiB/s > %2 KiB/s").arg(QString::number(net, 'f', 0)).arg(limits.maxNetKiBps);
+        }
+    }
+
+    if (!after.blockingProcesses.isEmpty()) {
+        reasons << QStringLiteral("running %1").arg(after.blockingProcesses.join(QStringLiteral(", ")));
+    }
+    return reasons;
+}
+
+double IdlenessProbe::readPressure(const QString &resource) const {
+    const QByteArray text = readSmallFile(m_procRoot + QStringLiteral("/pressure/") + resource);
+    for (const QByteArray &line : text.split('\n')) {
+        if (!line.startsWith("some ")) {
+            continue;
+        }
+        for (const QByteArray &field : line.split(' ')) {
+            if (field.startsWith("avg10=")) {
+                bool ok = false;
+                const double value = field.mid(6).toDouble(&ok);
+                return ok ? value : -1.0;
+            }
+        }
+    }
+    return -1.0;
+}
+
+quint64 IdlenessProbe::readDiskBytes() const {
+    quint64 sectors = 0;
+    const QByteArray text = readSmallFile(m_procRoot + QStringLiteral("/diskstats"));
+    for (const QByteArray &line : text.split('\n')) {
+        const QList<QByteArray> fields = line.simplified().split(' ');
+        // major minor name reads merged sectors_read ms writes merged sectors_written ...
+        if (fields.size() < 10 || !isPhysicalDisk(QString::fromLatin1(fields.at(2)))) {
+            continue;
+        }
+        sectors += fields.at(5).toULongLong() + fields.at(9).toULongLong();
+    }
+    return sectors * kSectorBytes;
+}
+
+quint64 IdlenessProbe::readNetBytes() const {
+    quint64 bytes = 0;
+    const QByteArray text = readSmallFile(m_procRoot + QStringLiteral("/net/dev"));
+    for (const QByteArray &line : text.split('\n')) {
+        const int colon = line.indexOf(':');
+        if (colon < 0) {
+            continue;
+        }
+        const QByteArray name = line.left(colon).trimmed();
+        if (name == "lo") {
+            continue;
+        }
+        const QList<QByteArray> fields = line.mid(colon + 1).simplified().split(' ');
+        // rx bytes packets errs drop fifo frame compressed multicast, then tx bytes ...
+        if (fields.size() < 9) {
+            continue;
+        }
+        bytes += fields.at(0).toULongLong() + fields.at(8).toULongLong();
+    }
+    return bytes;
+}
+
+QStringList IdlenessProbe::findProcesses(const QStringList &names) const {
+    if (names.isEmpty()) {
+        return {};
+    }
+    // /proc/<pid>/comm holds only the first 15 characters, so longer names match on those.
+    QMultiHash<QString, QString> wanted;
+    for (const auto &name : names) {
+        wanted.insert(name.left(kCommLength), name);
+    }
+    QSet<QString> found;
+    const auto pids = QDir(m_procRoot).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const auto &pid : pids) {
+        if (pid.isEmpty() || !pid.at(0).isDigit()) {
+            continue;
+        }
+        const QString comm = QString::fromLocal8Bit(readSmallFile(m_procRoot + QLatin1Char('/') + pid + QStringLiteral("/comm"))).trimmed();
+        for (auto it = wanted.constFind(comm); it != wanted.cend() && it.key() == comm; ++it) {
+            found.insert(it.value());
+        }
+    }
+    QStringList result = found.values();
+    result.sort();
+    return result;
+}
@@ -0,0 +1,48 @@
+#include "KernelFiles.h"
+
+#include <QFile>
+
+namespace KernelFiles {
+
+QByteArray readValue(const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return QByteArray();
+    }
+    return file.readAll().trimmed();
+}
+
+QStringList readTokens(const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return {};
+    }
+    return QString::fromUtf8(file.readAll()).simplified().split(QLatin1Char(' '), Qt::SkipEmptyParts);
+}
+
+qint64 memTotalBytes(const QString &meminfoPath) {
+    QFile file(meminfoPath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return 0;
+    }
+    while (!file.atEnd()) {
+        const QString line = QString::fromUtf8(file.readLine());
+        if (line.startsWith(QStringLiteral("MemTotal:"))) {
+            return line.simplified().split(QLatin1Char(' ')).value(1).toLongLong() * 1024;
+        }
+    }
+    return 0;
+}
+
+bool writeValue(const QString &path, const QByteArray &value, QString *error) {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Unbuffered | QIODevice::ExistingOnly) || file.write(value) != value.size()) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+} // namespace KernelFiles
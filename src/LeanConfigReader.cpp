@@ -0,0 +1,457 @@
+#include "LeanConfigReader.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+namespace LeanConfigReader {
+
+namespace {
+struct Value {
+    enum Type { Null, Bool, Number, String, Array, Object };
+
+    Type type {Null};
+    bool boolean {false};
+    double number {0};
+    std::string string;
+    std::vector<Value> items;
+    std::vector<std::pair<std::string, Value>> members;
+
+    const Value *find(const char *key) const {
+        for (const auto &member : members) {
+            if (member.first == key) {
+                return &member.second;
+            }
+        }
+        return nullptr;
+    }
+};
+
+/** Recursive-descent parser for RFC 8259 JSON, enough for ConfigRepository's output. */
+class Parser {
+public:
+    explicit Parser(const std::string &text)
+        : m_text(text) {}
+
+    bool parseDocument(Value &value) {
+        if (!parseValue(value, 0)) {
+            return false;
+        }
+        skipSpace();
+        return m_pos == m_text.size() || fail("trailing characters");
+    }
+
+    std::string error() const {
+        return m_error;
+    }
+
+private:
+    static constexpr int kMaxDepth = 32;
+
+    bool fail(const char *what) {
+        if (m_error.empty()) {
+            m_error = std::string(what) + " at offset " + std::to_string(m_pos);
+        }
+        return false;
+    }
+
+    void skipSpace() {
+        while (m_pos < m_text.size()
+               && (m_text[m_pos] == ' ' || m_text[m_pos] == '\t' || m_text[m_pos] == '\n' || m_text[m_pos] == '\r')) {
+            ++m_pos;
+        }
+    }
+
+    bool consume(const char *literal) {
+        size_t i = 0;
+        while (literal[i] != '\0') {
+            if (m_pos + i >= m_text.size() || m_text[m_pos + i] != literal[i]) {
+                return false;
+            }
+            ++i;
+        }
+        m_pos += i;
+        return true;
+    }
+
+    bool parseValue(Value &value, int depth) {
+        if (depth > kMaxDepth) {
+            return fail("nesting too deep");
+        }
+        skipSpace();
+        if (m_pos >= m_text.size()) {
+            return fail("unexpected end");
+        }
+        const char c = m_text[m_pos];
+        if (c == '{') {
+            return parseObject(value, depth);
+        }
+        if (c == '[') {
+            return parseArray(value, depth);
+        }
+        if (c == '"') {
+            value.type = Value::String;
+            return parseString(value.string);
+        }
+        if (consume("true")) {
+            value.type = Value::Bool;
+            value.boolean = true;
+            return true;
+        }
+        if (consume("false")) {
+            value.type = Value::Bool;
+            value.boolean = false;
+            return true;
+        }
+        if (consume("null")) {
+            value.type = Value::Null;
+            return true;
+        }
+        return parseNumber(value);
+    }
+
+    bool parseObject(Value &value, int depth) {
+        value.type = Value::Object;
+        ++m_pos; // '{'
+        skipSpace();
+        if (m_pos < m_text.size() && m_text[m_pos] == '}') {
+            ++m_pos;
+            return true;
+        }
+        while (true) {
+            skipSpace();
+            std::string key;
+            if (m_pos >= m_text.size() || m_text[m_pos] != '"' || !parseString(key)) {
+                return fail("expected object key");
+            }
+            skipSpace();
+            if (m_pos >= m_text.size() || m_text[m_pos] != ':') {
+                return fail("expected ':'");
+            }
+            ++m_pos;
+            Value member;
+            if (!parseValue(member, depth + 1)) {
+                return false;
+            }
+            value.members.emplace_back(std::move(key), std::move(member));
+            skipSpace();
+            if (m_pos < m_text.size() && m_text[m_pos] == ',') {
+                ++m_pos;
+                continue;
+            }
+            if (m_pos < m_text.size() && m_text[m_pos] == '}') {
+                ++m_pos;
+                return true;
+            }
+            return fail("expected ',' or '}'");
+        }
+    }
+
+    bool parseArray(Value &value, int depth) {
+        value.type = Value::Array;
+        ++m_pos; // '['
+        skipSpace();
+        if (m_pos < m_text.size() && m_text[m_pos] == ']') {
+            ++m_pos;
+            return true;
+        }
+        while (true) {
+            Value item;
+            if (!parseValue(item, depth + 1)) {
+                return false;
+            }
+            value.items.push_back(std::move(item));
+            skipSpace();
+            if (m_pos < m_text.size() && m_text[m_pos] == ',') {
+                ++m_pos;
+                continue;
+            }
+            if (m_pos < m_text.size() && m_text[m_pos] == ']') {
+                ++m_pos;
+                return true;
+            }
+            return fail("expected ',' or ']'");
+        }
+    }
+
+    bool parseHex4(unsigned &code) {
+        if (m_pos + 4 > m_text.size()) {
+            return fail("short \\u escape");
+        }
+        code = 0;
+        for (int i = 0; i < 4; ++i) {
+            const char c = m_text[m_pos++];
+            code <<= 4;
+            if (c >= '0' && c <= '9') {
+                code |= static_cast<unsigned>(c - '0');
+            } else if (c >= 'a' && c <= 'f') {
+                code |= static_cast<unsigned>(c - 'a' + 10);
+            } else if (c >= 'A' && c <= 'F') {
+                code |= static_cast<unsigned>(c - 'A' + 10);
+            } else {
+                return fail("bad \\u escape");
+            }
+        }
+        return true;
+    }
+
+    static void appendUtf8(std::string &out, unsigned code) {
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    bool parseString(std::string &out) {
+        ++m_pos; // opening quote
+        while (m_pos < m_text.size()) {
+            const char c = m_text[m_pos++];
+            if (c == '"') {
+                return true;
+            }
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (m_pos >= m_text.size()) {
+                break;
+            }
+            const char escape = m_text[m_pos++];
+            switch (escape) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                unsigned code = 0;
+                if (!parseHex4(code)) {
+                    return false;
+                }
+                if (code >= 0xD800 && code <= 0xDBFF && consume("\\u")) {
+                    unsigned low = 0;
+                    if (!parseHex4(low)) {
+                        return false;
+                    }
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                }
+                appendUtf8(out, code);
+                break;
+            }
+            default:
+                return fail("bad escape");
+            }
+        }
+        return fail("unterminated string");
+    }
+
+    bool parseNumber(Value &value) {
+        const char *begin = m_text.c_str() + m_pos;
+        char *end = nullptr;
+        const double number = std::strtod(begin, &end);
+        if (end == begin) {
+            return fail("unexpected character");
+        }
+        m_pos += static_cast<size_t>(end - begin);
+        value.type = Value::Number;
+        value.number = number;
+        return true;
+    }
+
+    const std::string &m_text;
+    size_t m_pos {0};
+    std::string m_error;
+};
+
+bool readBool(const Value &object, const char *key, bool fallback) {
+    const Value *value = object.find(key);
+    return value && value->type == Value::Bool ? value->boolean : fallback;
+}
+
+int readInt(const Value &object, const char *key, int fallback) {
+    const Value *value = object.find(key);
+    if (!value || value->type != Value::Number || std::floor(value->number) != value->number) {
+        return fallback;
+    }
+    return static_cast<int>(value->number);
+}
+
+std::string readString(const Value &object, const char *key, const std::string &fallback = std::string()) {
+    const Value *value = object.find(key);
+    return value && value->type == Value::String ? value->string : fallback;
+}
+
+bool parseDate(const std::string &text, PlannerCore::CivilDate &date) {
+    int year = 0;
+    int month = 0;
+    int day = 0;
+    char tail = 0;
+    if (std::sscanf(text.c_str(), "%4d-%2d-%2d%c", &year, &month, &day, &tail) != 3) {
+        return false;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > 31) {
+        return false;
+    }
+    // Reject dates such as 2021-02-30 that would silently roll over.
+    const PlannerCore::CivilDate parsed {year, month, day};
+    const PlannerCore::CivilDate roundTrip = PlannerCore::addDays(parsed, 0);
+    if (roundTrip.month != month || roundTrip.day != day) {
+        return false;
+    }
+    date = parsed;
+    return true;
+}
+
+/** "HH:mm", optionally followed by ":ss" and ".zzz" when @p allowSeconds is set. */
+bool parseTime(const std::string &text, bool allowSeconds, int &msecOfDay) {
+    int hour = 0;
+    int minute = 0;
+    int second = 0;
+    int millis = 0;
+    int consumed = 0;
+    if (std::sscanf(text.c_str(), "%2d:%2d%n", &hour, &minute, &consumed) != 2 || consumed != 5) {
+        return false;
+    }
+    size_t pos = static_cast<size_t>(consumed);
+    if (allowSeconds && pos < text.size()) {
+        if (std::sscanf(text.c_str() + pos, ":%2d%n", &second, &consumed) != 1 || consumed != 3) {
+            return false;
+        }
+        pos += static_cast<size_t>(consumed);
+        if (pos < text.size()) {
+            if (std::sscanf(text.c_str() + pos, ".%3d%n", &millis, &consumed) != 1 || consumed != 4) {
+                return false;
+            }
+            pos += static_cast<size_t>(consumed);
+        }
+    }
+    if (pos != text.size() || hour > 23 || minute > 59 || second > 59 || hour < 0 || minute < 0 || second < 0) {
+        return false;
+    }
+    msecOfDay = ((hour * 60 + minute) * 60 + second) * 1000 + millis;
+    return true;
+}
+
+void applyDefaults(Config &config) {
+    config = Config();
+    config.plan.action = 2; // PowerAction::SuspendToRam
+    for (int day = 1; day <= 7; ++day) {
+        config.plan.weekly.push_back({day, false, 23 * 3600 * 1000, (7 * 60 + 30) * 60 * 1000});
+    }
+}
+}
+
+bool parse(const std::string &json, Config &config, std::string *error) {
+    applyDefaults(config);
+
+    Value root;
+    Parser parser(json);
+    if (!parser.parseDocument(root) || root.type != Value::Object) {
+        if (error) {
+            *error = parser.error().empty() ? std::string("document is not an object") : parser.error();
+        }
+        return false;
+    }
+
+    PlannerCore::Config &plan = config.plan;
+    plan.hasSingle = parseDate(readString(root, "singleShutdownDate"), plan.singleShutdownDate)
+        && parseTime(readString(root, "singleShutdownTime"), true, plan.singleShutdownMsecOfDay)
+        && parseDate(readString(root, "singleDate"), plan.singleWakeDate)
+        && parseTime(readString(root, "singleTime"), true, plan.singleWakeMsecOfDay);
+    plan.action = readInt(root, "actionId", plan.action);
+    const int hibernateDelay = readInt(root, "hibernateDelayMinutes", 0);
+    if (hibernateDelay > 0) {
+        plan.hibernateDelayMs = static_cast<std::int64_t>(hibernateDelay) * 60 * 1000;
+    }
+
+    if (const Value *warning = root.find("warning"); warning && warning->type == Value::Object) {
+        Warning &w = config.warning;
+        w.enabled = readBool(*warning, "enabled", w.enabled);
+        w.message = readString(*warning, "message", w.message);
+        w.countdownSeconds = readInt(*warning, "countdownSeconds", w.countdownSeconds);
+        w.snoozeMinutes = readInt(*warning, "snoozeMinutes", w.snoozeMinutes);
+        w.soundEnabled = readBool(*warning, "soundEnabled", w.soundEnabled);
+        w.soundFile = readString(*warning, "soundFile", w.soundFile);
+        w.soundVolume = readInt(*warning, "soundVolume", w.soundVolume);
+        const std::string theme = readString(*warning, "theme");
+        if (!theme.empty()) {
+            w.theme = theme;
+        }
+        w.fullscreen = readBool(*warning, "fullscreen", w.fullscreen);
+        const int width = readInt(*warning, "width", w.width);
+        if (width > 0) {
+            w.width = width;
+        }
+        const int height = readInt(*warning, "height", w.height);
+        if (height > 0) {
+            w.height = height;
+        }
+    }
+
+    if (const Value *weekly = root.find("weekly"); weekly && weekly->type == Value::Array) {
+        for (const auto &item : weekly->items) {
+            if (item.type != Value::Object) {
+                continue;
+            }
+            const int day = readInt(item, "day", -1);
+            if (day < 1 || day > 7) {
+                continue;
+            }
+            PlannerCore::WeeklyRule rule {day, readBool(item, "enabled", false), 23 * 3600 * 1000,
+                                          (7 * 60 + 30) * 60 * 1000};
+            parseTime(readString(item, "shutdownTime"), false, rule.shutdownMsecOfDay);
+            std::string wake = readString(item, "wakeTime");
+            if (wake.empty()) {
+                wake = readString(item, "time");
+            }
+            parseTime(wake, false, rule.wakeMsecOfDay);
+            plan.weekly[static_cast<size_t>(day - 1)] = rule;
+        }
+    }
+
+    if (const Value *session = root.find("session"); session && session->type == Value::Object) {
+        config.session.display = readString(*session, "display");
+        config.session.xdgRuntimeDir = readString(*session, "xdgRuntimeDir");
+        config.session.dbusAddress = readString(*session, "dbusAddress");
+        config.session.xauthority = readString(*session, "xauthority");
+        config.session.waylandDisplay = readString(*session, "waylandDisplay");
+    }
+    return true;
+}
+
+bool load(const std::string &path, Config &config, std::string *error) {
+    std::FILE *file = std::fopen(path.c_str(), "rbe");
+    if (!file) {
+        applyDefaults(config);
+        if (error) {
+            *error = "cannot open " + path;
+        }
+        return false;
+    }
+    std::string json;
+    char buffer[4096];
+    size_t read = 0;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        json.append(buffer, read);
+    }
+    std::fclose(file);
+    return parse(json, config, error);
+}
+
+} // namespace LeanConfigReader
@@ -0,0 +1,500 @@
+#include "LeanDaemon.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <sys/signalfd.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+namespace {
+constexpr std::int64_t kIdleDeadlineMs = 10LL * 365 * 24 * 3600 * 1000; // re-armed far ahead when idle
+// A resume earlier than this before the interim alarm was not caused by it.
+constexpr std::int64_t kEarlyFireToleranceMs = 60 * 1000;
+
+std::int64_t nowMs() {
+    timespec ts {};
+    ::clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<std::int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+std::string formatLocal(std::int64_t epochMs, const char *format) {
+    const std::time_t secs = static_cast<std::time_t>(epochMs / 1000);
+    std::tm tm {};
+    localtime_r(&secs, &tm);
+    char buffer[64];
+    const size_t length = std::strftime(buffer, sizeof(buffer), format, &tm);
+    return std::string(buffer, length);
+}
+
+std::string sanitizeSingleLine(std::string text) {
+    std::replace(text.begin(), text.end(), '\n', ' ');
+    std::replace(text.begin(), text.end(), '\r', ' ');
+    return text;
+}
+
+std::string jsonString(const std::string &text) {
+    std::string out = "\"";
+    for (const char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    out += '"';
+    return out;
+}
+
+bool makePath(const std::string &path) {
+    for (size_t pos = 1; pos <= path.size(); ++pos) {
+        if (pos == path.size() || path[pos] == '/') {
+            const std::string prefix = path.substr(0, pos);
+            if (::mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+const char *rtcwakeMode(int action) {
+    switch (action) {
+    case 1: return "freeze";
+    case 2: return "mem";
+    case 3: return "disk";
+    case 4: return "off";
+    case PlannerCore::kSuspendThenHibernate: return "mem";
+    default: return "no";
+    }
+}
+
+const char *actionLabel(int action) {
+    switch (action) {
+    case 1: return "Suspend to idle";
+    case 2: return "Suspend to RAM";
+    case 3: return "Hibernate";
+    case 4: return "Power off";
+    case PlannerCore::kSuspendThenHibernate: return "Suspend, then hibernate";
+    default: return "No action";
+    }
+}
+}
+
+LeanDaemon::LeanDaemon(Options options)
+    : m_options(std::move(options)),
+      m_zone(PlannerCore::systemZone()) {
+    const size_t slash = m_options.configPath.rfind('/');
+    m_configDir = slash == std::string::npos ? std::string(".") : m_options.configPath.substr(0, std::max<size_t>(slash, 1));
+    m_configName = slash == std::string::npos ? m_options.configPath : m_options.configPath.substr(slash + 1);
+}
+
+LeanDaemon::~LeanDaemon() {
+    for (const int fd : {m_signal, m_inotify, m_timer, m_epoll}) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+}
+
+int LeanDaemon::run() {
+    if (!setup()) {
+        return 1;
+    }
+    log("daemon_start", {{"pid", std::to_string(::getpid())}, {"variant", "lean"}});
+    reloadConfig("Daemon started");
+
+    epoll_event events[4];
+    while (true) {
+        const int count = ::epoll_wait(m_epoll, events, 4, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::perror("epoll_wait");
+            return 1;
+        }
+        for (int i = 0; i < count; ++i) {
+            const int fd = events[i].data.fd;
+            if (fd == m_signal) {
+                if (!handleSignal()) {
+                    log("daemon_stop", {{"pid", std::to_string(::getpid())}});
+                    return 0;
+                }
+            } else if (fd == m_timer) {
+                handleTimer();
+            } else if (fd == m_inotify) {
+                handleInotify();
+            }
+        }
+    }
+}
+
+bool LeanDaemon::setup() {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGHUP);
+    sigaddset(&mask, SIGUSR1);
+    if (::sigprocmask(SIG_BLOCK, &mask, nullptr) != 0) {
+        std::perror("sigprocmask");
+        return false;
+    }
+
+    m_epoll = ::epoll_create1(EPOLL_CLOEXEC);
+    m_signal = ::signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    m_timer = ::timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC);
+    m_inotify = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_epoll < 0 || m_signal < 0 || m_timer < 0 || m_inotify < 0) {
+        std::perror("rtcwake-daemon-lean: setup");
+        return false;
+    }
+
+    for (const int fd : {m_signal, m_timer, m_inotify}) {
+        epoll_event event {};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (::epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+            std::perror("epoll_ctl");
+            return false;
+        }
+    }
+    watchConfig();
+    return true;
+}
+
+void LeanDaemon::watchConfig() {
+    m_watch = ::inotify_add_watch(m_inotify, m_configDir.c_str(),
+                                  IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE);
+    if (m_watch < 0) {
+        log("config_watch", {{"event", "failed"}, {"path", m_configDir}, {"error", std::strerror(errno)}});
+    }
+}
+
+void LeanDaemon::reloadConfig(const char *reason) {
+    std::string error;
+    if (!LeanConfigReader::load(m_options.configPath, m_config, &error)) {
+        log("config_reload", {{"path", m_options.configPath}, {"error", error}});
+    } else {
+        log("config_reload", {{"path", m_options.configPath}});
+    }
+    m_snoozed = false;
+    planNext(reason);
+}
+
+void LeanDaemon::planNext(const char *reason) {
+    ::tzset();
+    PlannerCore::Event next;
+    if (!PlannerCore::nextEvent(m_config.plan, nowMs(), m_zone, next)) {
+        m_hasNext = false;
+        armTimer(0);
+        log("schedule", {{"status", "empty"}, {"reason", reason}});
+        return;
+    }
+
+    m_next = next;
+    m_hasNext = true;
+    if (m_armedWakeMs != next.wakeMs) {
+        programAlarm(next.wakeMs);
+    }
+    armTimer(next.shutdownMs);
+    writeSummary();
+    log("schedule", {{"status", "planned"},
+                     {"reason", reason},
+                     {"shutdown", formatLocal(next.shutdownMs, "%Y-%m-%d %H:%M:%S")},
+                     {"wake", formatLocal(next.wakeMs, "%Y-%m-%d %H:%M:%S")},
+                     {"action", actionLabel(next.action)},
+                     {"shutdown_epoch", std::to_string(next.shutdownMs / 1000)},
+                     {"wake_epoch", std::to_string(next.wakeMs / 1000)}});
+}
+
+void LeanDaemon::armTimer(std::int64_t deadlineMs) {
+    m_deadlineMs = deadlineMs;
+    const std::int64_t armAt = deadlineMs > 0 ? deadlineMs : nowMs() + kIdleDeadlineMs;
+    itimerspec spec {};
+    spec.it_value.tv_sec = static_cast<time_t>(armAt / 1000);
+    spec.it_value.tv_nsec = static_cast<long>((armAt % 1000) * 1000000);
+    // Absolute CLOCK_REALTIME deadline; a settimeofday()/NTP step cancels the read so we replan.
+    if (::timerfd_settime(m_timer, TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET, &spec, nullptr) != 0) {
+        std::perror("timerfd_settime");
+    }
+}
+
+void LeanDaemon::handleTimer() {
+    std::uint64_t expirations = 0;
+    if (::read(m_timer, &expirations, sizeof(expirations)) < 0) {
+        if (errno == ECANCELED) {
+            log("clock", {{"event", "changed"}});
+            if (m_snoozed) {
+                armTimer(m_deadlineMs);
+            } else {
+                planNext("Clock changed");
+            }
+        }
+        return;
+    }
+    if (!m_hasNext || m_deadlineMs <= 0) {
+        armTimer(0);
+        return;
+    }
+    if (nowMs() < m_deadlineMs) {
+        armTimer(m_deadlineMs);
+        return;
+    }
+    executeAction();
+}
+
+void LeanDaemon::handleInotify() {
+    alignas(inotify_event) char buffer[4096];
+    bool relevant = false;
+    ssize_t length = 0;
+    while ((length = ::read(m_inotify, buffer, sizeof(buffer))) > 0) {
+        for (char *ptr = buffer; ptr < buffer + length;) {
+            const auto *event = reinterpret_cast<const inotify_event *>(ptr);
+            if (event->len > 0 && m_configName == event->name) {
+                relevant = true;
+            }
+            ptr += sizeof(inotify_event) + event->len;
+        }
+    }
+    if (relevant) {
+        reloadConfig("Config reloaded");
+    }
+}
+
+bool LeanDaemon::handleSignal() {
+    signalfd_siginfo info {};
+    while (::read(m_signal, &info, sizeof(info)) == static_cast<ssize_t>(sizeof(info))) {
+        switch (info.ssi_signo) {
+        case SIGTERM:
+        case SIGINT:
+            return false;
+        case SIGHUP:
+            reloadConfig("SIGHUP");
+            break;
+        default:
+            log("signal", {{"signal", std::to_string(info.ssi_signo)}, {"status", "ignored"}});
+            break;
+        }
+    }
+    return true;
+}
+
+void LeanDaemon::executeAction() {
+    const WarningOutcome outcome = invokeWarning();
+    if (outcome == WarningOutcome::Snooze) {
+        m_snoozed = true;
+        armTimer(nowMs() + static_cast<std::int64_t>(m_config.warning.snoozeMinutes) * 60 * 1000);
+        log("warning", {{"outcome", "snooze"}, {"minutes", std::to_string(m_config.warning.snoozeMinutes)}});
+        return;
+    }
+    m_snoozed = false;
+    if (outcome == WarningOutcome::Cancel) {
+        log("warning", {{"outcome", "cancel"}});
+        planNext("User canceled");
+        return;
+    }
+
+    if (m_next.action == 0) {
+        log("action", {{"status", "skipped"}, {"reason", "no_action"}});
+    } else if (m_next.action == PlannerCore::kFreezeUserSession) {
+        // Freezing the session needs the full daemon's cgroup handling.
+        log("action", {{"status", "skipped"}, {"reason", "unsupported_action"}});
+    } else if (m_next.action == PlannerCore::kSuspendThenHibernate) {
+        suspendThenHibernate();
+    } else {
+        sleepUntil(rtcwakeMode(m_next.action), m_next.wakeMs);
+    }
+    planNext("Action completed");
+}
+
+int LeanDaemon::sleepUntil(const char *mode, std::int64_t wakeMs) {
+    const std::vector<std::string> argv {"rtcwake", "-m", mode, "-t", std::to_string(wakeMs / 1000)};
+    const int exitCode = runCommand(argv);
+    log("rtcwake", {{"action", actionLabel(m_next.action)},
+                    {"wake", formatLocal(wakeMs, "%Y-%m-%d %H:%M:%S")},
+                    {"command", "rtcwake -m " + argv[2] + " -t " + argv[4]},
+                    {"exit", std::to_string(exitCode)},
+                    {"success", exitCode == 0 ? "true" : "false"}});
+    m_armedWakeMs = 0;
+    return exitCode;
+}
+
+void LeanDaemon::suspendThenHibernate() {
+    const std::int64_t interimMs = PlannerCore::hibernateAt(m_next.action, m_config.plan.hibernateDelayMs, nowMs(), m_next.wakeMs);
+    if (interimMs == 0) {
+        sleepUntil("mem", m_next.wakeMs);
+        return;
+    }
+    if (sleepUntil("mem", interimMs) != 0 || nowMs() < interimMs - kEarlyFireToleranceMs) {
+        // Failed, or someone woke the machine before the interim alarm.
+        return;
+    }
+    const std::int64_t remainingMs = m_next.wakeMs - nowMs();
+    if (remainingMs <= 0) {
+        return;
+    }
+    if (remainingMs < PlannerCore::kMinDiskSleepMs || sleepUntil("disk", m_next.wakeMs) != 0) {
+        // A failed hibernation (no swap, no resume device) must not leave the machine up all night.
+        sleepUntil("mem", m_next.wakeMs);
+    }
+}
+
+LeanDaemon::WarningOutcome LeanDaemon::invokeWarning() {
+    const auto &warning = m_config.warning;
+    if (!warning.enabled || m_options.warningApp.empty() || m_options.targetUser.empty()) {
+        return WarningOutcome::Apply;
+    }
+
+    std::vector<std::string> argv {"runuser", "-u", m_options.targetUser, "--", "env"};
+    const auto addEnv = [&argv](const char *name, const std::string &configured) {
+        const char *inherited = std::getenv(name);
+        const std::string value = !configured.empty() ? configured : (inherited ? inherited : "");
+        if (!value.empty()) {
+            argv.push_back(std::string(name) + "=" + value);
+        }
+    };
+    addEnv("DISPLAY", m_config.session.display);
+    addEnv("XDG_RUNTIME_DIR", m_config.session.xdgRuntimeDir);
+    addEnv("DBUS_SESSION_BUS_ADDRESS", m_config.session.dbusAddress);
+    addEnv("XAUTHORITY", m_config.session.xauthority);
+    addEnv("WAYLAND_DISPLAY", m_config.session.waylandDisplay);
+    if (!m_options.targetHome.empty()) {
+        argv.push_back("HOME=" + m_options.targetHome);
+    }
+
+    argv.insert(argv.end(), {m_options.warningApp, "--message", warning.message, "--countdown",
+                             std::to_string(warning.countdownSeconds), "--snooze", std::to_string(warning.snoozeMinutes),
+                             "--theme", warning.theme});
+    if (warning.fullscreen) {
+        argv.push_back("--fullscreen");
+    }
+    argv.insert(argv.end(), {"--width", std::to_string(std::clamp(warning.width, 320, 3840)), "--height",
+                             std::to_string(std::clamp(warning.height, 200, 2160))});
+    if (warning.soundEnabled) {
+        argv.push_back("--sound-enabled");
+        if (!warning.soundFile.empty()) {
+            argv.insert(argv.end(), {"--sound-file", warning.soundFile});
+        }
+        argv.insert(argv.end(), {"--volume", std::to_string(std::clamp(warning.soundVolume, 0, 100))});
+    }
+    argv.insert(argv.end(), {"--action", actionLabel(m_next.action)});
+
+    const int exitCode = runCommand(argv);
+    if (exitCode < 0) {
+        log("warning", {{"outcome", "apply"}, {"error", "failed to start warning dialog"}});
+        return WarningOutcome::Apply;
+    }
+    if (exitCode == 0) {
+        return WarningOutcome::Apply;
+    }
+    return exitCode == 1 ? WarningOutcome::Snooze : WarningOutcome::Cancel;
+}
+
+void LeanDaemon::programAlarm(std::int64_t wakeMs) {
+    const std::vector<std::string> argv {"rtcwake", "-m", "no", "-t", std::to_string(wakeMs / 1000)};
+    const int exitCode = runCommand(argv);
+    m_armedWakeMs = exitCode == 0 ? wakeMs : 0;
+    log("rtcwake", {{"action", "Program alarm"},
+                    {"wake", formatLocal(wakeMs, "%Y-%m-%d %H:%M:%S")},
+                    {"command", "rtcwake -m no -t " + argv[4]},
+                    {"exit", std::to_string(exitCode)},
+                    {"success", exitCode == 0 ? "true" : "false"}});
+}
+
+int LeanDaemon::runCommand(const std::vector<std::string> &argv) {
+    if (m_options.dryRun && argv.front() == "rtcwake") {
+        return 0;
+    }
+
+    std::vector<char *> args;
+    args.reserve(argv.size() + 1);
+    for (const auto &arg : argv) {
+        args.push_back(const_cast<char *>(arg.c_str()));
+    }
+    args.push_back(nullptr);
+
+    // Children must not inherit the signals we route through signalfd.
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t empty;
+    sigemptyset(&empty);
+    posix_spawnattr_setsigmask(&attr, &empty);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK);
+
+    pid_t pid = -1;
+    const int spawnError = ::posix_spawnp(&pid, args.front(), nullptr, &attr, args.data(), environ);
+    posix_spawnattr_destroy(&attr);
+    if (spawnError != 0) {
+        return -1;
+    }
+
+    int status = 0;
+    while (::waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+void LeanDaemon::writeSummary() const {
+    const std::string path = statePath("next-wake.json");
+    if (path.empty() || !makePath(path.substr(0, path.rfind('/')))) {
+        return;
+    }
+    std::FILE *file = std::fopen(path.c_str(), "we");
+    if (!file) {
+        return;
+    }
+    const std::string payload = "{\"timestamp\":" + std::to_string(m_next.wakeMs / 1000)
+        + ",\"localTime\":" + jsonString(formatLocal(m_next.wakeMs, "%Y-%m-%dT%H:%M:%S"))
+        + ",\"friendly\":" + jsonString(formatLocal(m_next.wakeMs, "%c"))
+        + ",\"mode\":" + jsonString(rtcwakeMode(m_next.action))
+        + ",\"action\":" + jsonString(actionLabel(m_next.action)) + "}\n";
+    std::fputs(payload.c_str(), file);
+    std::fclose(file);
+}
+
+void LeanDaemon::log(const char *category, const std::vector<std::pair<std::string, std::string>> &fields) const {
+    std::string line = "[" + formatLocal(nowMs(), "%Y-%m-%d %H:%M:%S") + "] category=\"" + category + "\"";
+    for (const auto &field : fields) {
+        line += " " + field.first + "=\"" + sanitizeSingleLine(field.second) + "\"";
+    }
+    line += "\n";
+    std::fputs(line.c_str(), stderr);
+
+    const std::string path = statePath("log.txt");
+    if (path.empty() || !makePath(path.substr(0, path.rfind('/')))) {
+        return;
+    }
+    if (std::FILE *file = std::fopen(path.c_str(), "ae")) {
+        std::fputs(line.c_str(), file);
+        std::fclose(file);
+    }
+}
+
+std::string LeanDaemon::statePath(const char *fileName) const {
+    std::string base = m_options.targetHome;
+    if (base.empty()) {
+        const char *home = std::getenv("HOME");
+        base = home ? home : "";
+    }
+    if (base.empty()) {
+        return std::string();
+    }
+    return base + "/.local/share/rtcwake-gui/" + fileName;
+}
@@ -0,0 +1,52 @@
+#include "LeanDaemon.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace {
+void printUsage(const char *program) {
+    std::printf("Usage: %s --config <path> [--user <name>] [--home <dir>] [--warning-app <path>] [--dry-run]\n"
+                "\n"
+                "Lean rtcwake background scheduler without Qt.\n"
+                "\n"
+                "  --config <path>       Path to the user config file\n"
+                "  --user <name>         Target desktop user (needed for the warning dialog)\n"
+                "  --home <dir>          Target user home directory (log.txt, next-wake.json)\n"
+                "  --warning-app <path>  Path to the warning dialog executable\n"
+                "  --dry-run             Plan and log, but never invoke rtcwake\n",
+                program);
+}
+}
+
+int main(int argc, char *argv[]) {
+    LeanDaemon::Options options;
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--config") == 0 && hasValue) {
+            options.configPath = argv[++i];
+        } else if (std::strcmp(arg, "--user") == 0 && hasValue) {
+            options.targetUser = argv[++i];
+        } else if (std::strcmp(arg, "--home") == 0 && hasValue) {
+            options.targetHome = argv[++i];
+        } else if (std::strcmp(arg, "--warning-app") == 0 && hasValue) {
+            options.warningApp = argv[++i];
+        } else if (std::strcmp(arg, "--dry-run") == 0) {
+            options.dryRun = true;
+        } else if (std::strcmp(arg, "--help") == 0 || std::strcmp(arg, "-h") == 0) {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            std::fprintf(stderr, "Unknown or incomplete option %s. Use --help for details.\n", arg);
+            return 1;
+        }
+    }
+
+    if (options.configPath.empty()) {
+        std::fprintf(stderr, "Missing required option --config. Use --help for details.\n");
+        return 1;
+    }
+
+    LeanDaemon daemon(options);
+    return daemon.run();
+}
@@ -0,0 +1,158 @@
+#include "LogindWatcher.h"
+
+#include <QDBusArgument>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusObjectPath>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QDBusVariant>
+#include <QDebug>
+
+namespace {
+const QString kService = QStringLiteral("org.freedesktop.login1");
+const QString kPath = QStringLiteral("/org/freedesktop/login1");
+const QString kManager = QStringLiteral("org.freedesktop.login1.Manager");
+const QString kSession = QStringLiteral("org.freedesktop.login1.Session");
+const QString kProperties = QStringLiteral("org.freedesktop.DBus.Properties");
+const QString kIdleHint = QStringLiteral("IdleHint");
+constexpr int kCallTimeoutMs = 1000;
+}
+
+LogindWatcher::LogindWatcher(QObject *parent)
+    : QObject(parent) {
+    auto bus = QDBusConnection::systemBus();
+    if (!bus.isConnected()) {
+        qWarning().noquote() << "System bus unavailable; session idleness is not checked";
+        return;
+    }
+    m_available = bus.connect(kService, kPath, kProperties, QStringLiteral("PropertiesChanged"), this,
+                              SLOT(handlePropertiesChanged(QString, QVariantMap, QStringList)));
+    if (!m_available) {
+        qWarning().noquote() << "Cannot subscribe to logind property changes:" << bus.lastError().message();
+        return;
+    }
+    // An empty path matches every session object; only their own interface is of interest.
+    bus.connect(kService, QString(), kProperties, QStringLiteral("PropertiesChanged"), this,
+                SLOT(handleSessionPropertiesChanged(QString, QVariantMap, QStringList)));
+    bus.connect(kService, kPath, kManager, QStringLiteral("SessionNew"), this, SLOT(handleSessionListChanged()));
+    bus.connect(kService, kPath, kManager, QStringLiteral("SessionRemoved"), this, SLOT(handleSessionListChanged()));
+    refresh();
+}
+
+bool LogindWatcher::isAvailable() const {
+    return m_available;
+}
+
+bool LogindWatcher::idleHint() const {
+    return m_idleHint;
+}
+
+void LogindWatcher::handlePropertiesChanged(const QString &interface, const QVariantMap &changed,
+                                            const QStringList &invalidated) {
+    if (interface != kManager) {
+        return;
+    }
+    if (changed.contains(kIdleHint)) {
+        updateHint(changed.value(kIdleHint).toBool());
+    } else if (invalidated.contains(kIdleHint)) {
+        // logind announces IdleHint without its value; fetch it.
+        refresh();
+    }
+}
+
+QStringList LogindWatcher::graphicalSessions(uint uid) const {
+    if (!m_available) {
+        return {};
+    }
+    auto bus = QDBusConnection::systemBus();
+    const auto reply = bus.call(QDBusMessage::createMethodCall(kService, kPath, kManager, QStringLiteral("ListSessions")),
+                                QDBus::Block, kCallTimeoutMs);
+    if (reply.type() != QDBusMessage::ReplyMessage) {
+        qWarning().noquote() << "Cannot list logind sessions:" << reply.errorMessage();
+        return {};
+    }
+    QList<QDBusObjectPath> paths;
+    // a(susso): id, uid, user name, seat, object path.
+    const auto sessions = reply.arguments().value(0).value<QDBusArgument>();
+    sessions.beginArray();
+    while (!sessions.atEnd()) {
+        QString id;
+        uint sessionUid = 0;
+        QString user;
+        QString seat;
+        QDBusObjectPath path;
+        sessions.beginStructure();
+        sessions >> id >> sessionUid >> user >> seat >> path;
+        sessions.endStructure();
+        if (sessionUid == uid) {
+            paths.append(path);
+        }
+    }
+    sessions.endArray();
+
+    QStringList active;
+    QStringList inactive;
+    for (const auto &path : paths) {
+        auto message = QDBusMessage::createMethodCall(kService, path.path(), kProperties, QStringLiteral("GetAll"));
+        message << kSession;
+        const auto properties = bus.call(message, QDBus::Block, kCallTimeoutMs);
+        if (properties.type() != QDBusMessage::ReplyMessage) {
+            continue;
+        }
+        const auto values = qdbus_cast<QVariantMap>(properties.arguments().value(0));
+        const QString type = values.value(QStringLiteral("Type")).toString();
+        if ((type != QStringLiteral("x11") && type != QStringLiteral("wayland"))
+            || values.value(QStringLiteral("Remote")).toBool()
+            || values.value(QStringLiteral("State")).toString() == QStringLiteral("closing")) {
+            continue;
+        }
+        const QString id = values.value(QStringLiteral("Id")).toString();
+        if (values.value(QStringLiteral("Active")).toBool()) {
+            active.append(id);
+        } else {
+            inactive.append(id);
+        }
+    }
+    return active + inactive;
+}
+
+void LogindWatcher::handleSessionListChanged() {
+    emit sessionsChanged();
+}
+
+void LogindWatcher::handleSessionPropertiesChanged(const QString &interface, const QVariantMap &changed,
+                                                   const QStringList &invalidated) {
+    if (interface != kSession) {
+        return;
+    }
+    for (const auto &property : {QStringLiteral("Active"), QStringLiteral("State")}) {
+        if (changed.contains(property) || invalidated.contains(property)) {
+            emit sessionsChanged();
+            return;
+        }
+    }
+}
+
+void LogindWatcher::refresh() {
+    auto message = QDBusMessage::createMethodCall(kService, kPath, kProperties, QStringLiteral("Get"));
+    message << kManager << kIdleHint;
+    auto *watcher = new QDBusPendingCallWatcher(QDBusConnection::systemBus().asyncCall(message), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this](QDBusPendingCallWatcher *call) {
+        call->deleteLater();
+        const QDBusPendingReply<QDBusVariant> reply = *call;
+        if (reply.isError()) {
+            qWarning().noquote() << "Cannot read logind IdleHint:" << reply.error().message();
+            return;
+        }
+        updateHint(reply.value().variant().toBool());
+    });
+}
+
+void LogindWatcher::updateHint(bool idle) {
+    if (idle == m_idleHint) {
+        return;
+    }
+    m_idleHint = idle;
+    emit idleHintChanged(idle);
+}
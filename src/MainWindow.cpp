@@ -1,7 +1,10 @@
 #include "MainWindow.h"
 
 #include "AnalogClockWidget.h"
+#include "CycleHistoryStore.h"
+#include "ResumeLatencyStats.h"
 #include "RtcWakeController.h"
+#include "SystemdTimerBackend.h"
 
 #include <QButtonGroup>
 #include <QCheckBox>
@@ -23,6 +26,7 @@
 #include <QLineEdit>
 #include <QMessageBox>
 #include <QPlainTextEdit>
+#include <QProcess>
 #include <QPushButton>
 #include <QRadioButton>
 #include <QSlider>
@@ -30,12 +34,16 @@
 #include <QTabWidget>
 #include <QTableWidget>
 #include <QTimeEdit>
+#include <QTimer>
 #include <QTextCursor>
 #include <QTextStream>
 #include <QVBoxLayout>
 #include <algorithm>
 
 namespace {
+// daemon-reload takes well under a second; a polkit prompt left unanswered this long counts as a failure.
+constexpr int kDaemonReloadTimeoutMs = 15000;
+
 QString formatDateTime(const QDateTime &dt) {
     QLocale locale;
     return locale.toString(dt, QLocale::LongFormat);
@@ -190,6 +198,20 @@ QWidget *MainWindow::buildSettingsTab() {
     auto *actionsBox = new QGroupBox(tr("Power action"), tab);
     auto *actionsLayout = new QVBoxLayout(actionsBox);
     populateActionGroup(actionsLayout);
+    auto *hibernateRow = new QHBoxLayout();
+    hibernateRow->addWidget(new QLabel(tr("Hibernate after"), actionsBox));
+    m_hibernateDelay = new QSpinBox(actionsBox);
+    m_hibernateDelay->setRange(5, 24 * 60);
+    m_hibernateDelay->setValue(180);
+    m_hibernateDelay->setSuffix(tr(" min"));
+    m_hibernateDelay->setToolTip(tr("Time in RAM before \"Suspend, then hibernate\" moves to disk"));
+    hibernateRow->addWidget(m_hibernateDelay);
+    hibernateRow->addStretch();
+    actionsLayout->addLayout(hibernateRow);
+    m_latencySummary = new QLabel(actionsBox);
+    m_latencySummary->setWordWrap(true);
+    m_latencySummary->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    actionsLayout->addWidget(m_latencySummary);
     layout->addWidget(actionsBox);
 
     auto *warningBox = new QGroupBox(tr("Warning banner"), tab);
@@ -285,6 +307,10 @@ QWidget *MainWindow::buildLogsTab() {
     m_logViewer->setPlaceholderText(tr("No log entries yet."));
     layout->addWidget(m_logViewer, 1);
 
+    m_historySummary = new QLabel(tab);
+    m_historySummary->setWordWrap(true);
+    layout->addWidget(m_historySummary);
+
     auto *buttonRow = new QHBoxLayout();
     buttonRow->addStretch();
     auto *refreshButton = new QPushButton(tr("Refresh logs"), tab);
@@ -292,6 +318,8 @@ QWidget *MainWindow::buildLogsTab() {
     layout->addLayout(buttonRow);
 
     connect(refreshButton, &QPushButton::clicked, this, &MainWindow::refreshLogViewer);
+    connect(refreshButton, &QPushButton::clicked, this, &MainWindow::refreshLatencySummary);
+    connect(refreshButton, &QPushButton::clicked, this, &MainWindow::refreshHistorySummary);
     refreshLogViewer();
 
     return tab;
@@ -356,6 +384,8 @@ void MainWindow::connectSignals() {
     if (m_fullscreenBanner) {
         connect(m_fullscreenBanner, &QCheckBox::toggled, this, [this](bool) { updateBannerSizeControls(); });
     }
+    connect(m_actionGroup, QOverload<QAbstractButton *, bool>::of(&QButtonGroup::buttonToggled), this,
+            [this](QAbstractButton *, bool) { updateHibernateDelayControl(); });
 }
 
 void MainWindow::updateSoundControls() {
@@ -378,6 +408,12 @@ void MainWindow::updateSoundControls() {
     }
 }
 
+void MainWindow::updateHibernateDelayControl() {
+    if (m_hibernateDelay) {
+        m_hibernateDelay->setEnabled(currentAction() == PowerAction::SuspendThenHibernate);
+    }
+}
+
 void MainWindow::updateBannerSizeControls() {
     const bool enableSize = !(m_fullscreenBanner && m_fullscreenBanner->isChecked());
     if (m_bannerWidth) {
@@ -393,6 +429,8 @@ void MainWindow::loadSettings() {
     applyConfigToUi();
     m_nextSummary->setText(tr("Config loaded for %1").arg(currentUser()));
     refreshLogViewer();
+    refreshLatencySummary();
+    refreshHistorySummary();
 }
 
 QString MainWindow::logFilePath() const {
@@ -421,6 +459,60 @@ void MainWindow::refreshLogViewer() {
     m_logViewer->moveCursor(QTextCursor::End);
 }
 
+void MainWindow::refreshLatencySummary() {
+    if (!m_latencySummary) {
+        return;
+    }
+
+    const QString path = QFileInfo(logFilePath()).dir().filePath(QStringLiteral("resume-latency.json"));
+    ResumeLatencyStats stats;
+    const bool loaded = stats.load(path);
+    QStringList lines;
+    for (const auto &option : m_actionOptions) {
+        if (option.action == PowerAction::None || stats.histogram(option.action).count == 0) {
+            continue;
+        }
+        lines << stats.summary(option.action);
+        if (auto *button = m_actionGroup->button(static_cast<int>(option.action))) {
+            button->setToolTip(option.description + QLatin1Char('\n') + stats.summary(option.action));
+        }
+    }
+    if (!loaded || lines.isEmpty()) {
+        m_latencySummary->setText(tr("Measured resume latency: no samples yet. The daemon records one after every scheduled wake."));
+        return;
+    }
+    m_latencySummary->setText(tr("Measured resume latency (planned wake → daemon running):\n%1").arg(lines.join(QLatin1Char('\n'))));
+}
+
+void MainWindow::refreshHistorySummary() {
+    if (!m_historySummary) {
+        return;
+    }
+
+    CycleHistoryStore store(QFileInfo(logFilePath()).dir().filePath(QStringLiteral("history.bin")));
+    if (!store.open(false)) {
+        m_historySummary->setText(tr("Cycle history: none recorded yet."));
+        return;
+    }
+
+    const QDateTime since = QDateTime::currentDateTime().addDays(-30);
+    const auto records = store.records(since);
+    int completed = 0;
+    int snoozes = 0;
+    for (const auto &record : records) {
+        if (record.outcome == static_cast<qint32>(CycleHistoryStore::Outcome::Completed)) {
+            ++completed;
+        }
+        snoozes += record.snoozeCount;
+    }
+    const double hours = CycleHistoryStore::sleptSeconds(records, since) / 3600.0;
+    m_historySummary->setText(tr("Last 30 days: %1 cycles (%2 completed), %3 h asleep, %4 snoozes.")
+                                  .arg(records.size())
+                                  .arg(completed)
+                                  .arg(hours, 0, 'f', 1)
+                                  .arg(snoozes));
+}
+
 void MainWindow::appendUserLog(const QString &category, const QList<QPair<QString, QString>> &fields) {
     const QString path = logFilePath();
     QFileInfo info(path);
@@ -455,6 +547,8 @@ void MainWindow::applyConfigToUi() {
     if (auto *button = m_actionGroup->button(m_config.actionId)) {
         button->setChecked(true);
     }
+    m_hibernateDelay->setValue(m_config.hibernateDelayMinutes);
+    updateHibernateDelayControl();
 
     m_warningEnabled->setChecked(m_config.warning.enabled);
     m_warningMessage->setText(m_config.warning.message);
@@ -504,6 +598,7 @@ void MainWindow::collectUiIntoConfig() {
     m_config.singleWakeDate = m_dateEdit->date();
     m_config.singleWakeTime = m_timeEdit->time();
     m_config.actionId = static_cast<int>(currentAction());
+    m_config.hibernateDelayMinutes = m_hibernateDelay->value();
 
     m_config.warning.enabled = m_warningEnabled->isChecked();
     m_config.warning.message = m_warningMessage->text();
@@ -563,6 +658,10 @@ void MainWindow::saveSettings(const QString &reason) {
     } else {
         m_nextSummary->setText(tr("%1 — %2").arg(stamp, reason));
     }
+    const QString timerStatus = updateTimerUnits();
+    if (!timerStatus.isEmpty()) {
+        m_nextSummary->setText(m_nextSummary->text() + QLatin1Char(' ') + timerStatus);
+    }
     const QDateTime shutdown(m_config.singleShutdownDate, m_config.singleShutdownTime);
     const QDateTime wake(m_config.singleWakeDate, m_config.singleWakeTime);
     appendUserLog(QStringLiteral("config_save"),
@@ -573,6 +672,107 @@ void MainWindow::saveSettings(const QString &reason) {
     refreshLogViewer();
 }
 
+QString MainWindow::updateTimerUnits() {
+    const auto &prefs = m_config.timerBackend;
+    if (!prefs.enabled) {
+        return QString();
+    }
+    const auto units = SystemdTimerBackend::compile(m_config, QDateTime::currentDateTime());
+    QStringList changed;
+    const bool written = SystemdTimerBackend(prefs.unitDir).apply(units, &changed);
+    if (written && !changed.isEmpty()) {
+        // Timers only pick up the new OnCalendar= lines once the manager reloads the files.
+        reloadTimerUnits(changed);
+        return m_timerReloadNote;
+    }
+    appendUserLog(QStringLiteral("timer_units"),
+                  {{QStringLiteral("status"), written ? QStringLiteral("unchanged") : QStringLiteral("failed")},
+                   {QStringLiteral("dir"), prefs.unitDir},
+                   {QStringLiteral("files"), changed.isEmpty() ? tr("<none>") : changed.join(QLatin1Char(','))}});
+    if (!written) {
+        return tr("Failed to write the timer units to %1.").arg(prefs.unitDir);
+    }
+    return QString();
+}
+
+void MainWindow::reloadTimerUnits(const QStringList &changed) {
+    if (m_timerReload) {
+        // The files were rewritten again; only the newest reload gets reported.
+        m_timerReload->disconnect(this);
+        m_timerReload->kill();
+        m_timerReload->deleteLater();
+    }
+    auto *reload = new QProcess(this);
+    m_timerReload = reload;
+    m_timerReloadNote = tr("Timer units written to %1; waiting for systemd to reload them.").arg(m_config.timerBackend.unitDir);
+
+    auto *deadline = new QTimer(reload);
+    deadline->setSingleShot(true);
+    connect(deadline, &QTimer::timeout, reload, [reload]() { reload->kill(); });
+    connect(reload, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+            [this, reload, deadline, changed](int exitCode, QProcess::ExitStatus status) {
+                QString error;
+                if (!deadline->isActive()) {
+                    error = tr("systemctl did not finish within %1 s").arg(kDaemonReloadTimeoutMs / 1000);
+                } else if (status != QProcess::NormalExit || exitCode != 0) {
+                    error = QString::fromLocal8Bit(reload->readAllStandardError()).trimmed();
+                    if (error.isEmpty()) {
+                        error = tr("systemctl exited with %1").arg(exitCode);
+                    }
+                }
+                deadline->stop();
+                finishTimerReload(reload, changed, error);
+            });
+    connect(reload, &QProcess::errorOccurred, this, [this, reload, deadline, changed](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            deadline->stop();
+            finishTimerReload(reload, changed, tr("systemctl could not be started"));
+        }
+    });
+    deadline->start(kDaemonReloadTimeoutMs);
+    reload->start(QStringLiteral("systemctl"), {QStringLiteral("daemon-reload")});
+}
+
+void MainWindow::finishTimerReload(QProcess *reload, const QStringList &changed, const QString &error) {
+    if (reload != m_timerReload) {
+        return;
+    }
+    m_timerReload = nullptr;
+    reload->deleteLater();
+
+    const auto &prefs = m_config.timerBackend;
+    QList<QPair<QString, QString>> fields {{QStringLiteral("status"), error.isEmpty() ? QStringLiteral("updated") : QStringLiteral("reload_failed")},
+                                           {QStringLiteral("dir"), prefs.unitDir},
+                                           {QStringLiteral("files"), changed.join(QLatin1Char(','))}};
+    if (!error.isEmpty()) {
+        fields.append({QStringLiteral("error"), error});
+    }
+    appendUserLog(QStringLiteral("timer_units"), fields);
+    refreshLogViewer();
+
+    QString status;
+    if (!error.isEmpty()) {
+        status = tr("Timer units written to %1, but systemd did not reload them (%2); the previous timers stay active.")
+                     .arg(prefs.unitDir, error);
+    } else {
+        status = tr("Timer units updated in %1.").arg(prefs.unitDir);
+        const PowerAction action = currentAction();
+        if (action != PowerAction::None && SystemdTimerBackend::systemctlVerb(action).isEmpty()) {
+            status += QLatin1Char(' ')
+                + tr("Timers cannot apply \"%1\", so they only wake the machine.").arg(RtcWakeController::actionLabel(action));
+        }
+    }
+    // Replace the "waiting" note unless the summary moved on in the meantime.
+    QString summary = m_nextSummary->text();
+    if (summary.endsWith(m_timerReloadNote)) {
+        summary.chop(m_timerReloadNote.size());
+        m_nextSummary->setText(summary + status);
+    } else {
+        m_nextSummary->setText(summary + QLatin1Char(' ') + status);
+    }
+    m_timerReloadNote.clear();
+}
+
 void MainWindow::scheduleSingleWake() {
     const QDateTime shutdown(m_shutdownDateEdit->date(), m_shutdownTimeEdit->time());
     const QDateTime wake(m_dateEdit->date(), m_timeEdit->time());
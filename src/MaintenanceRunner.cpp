@@ -0,0 +1,203 @@
+#include "MaintenanceRunner.h"
+
+#include "ProcessGroup.h"
+#include "TraceBuffer.h"
+
+#include <QDebug>
+#include <QProcess>
+#include <QTimer>
+
+#include <algorithm>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+constexpr int kOutputTailBytes = 4096;
+// From linux/ioprio.h, which is not installed everywhere.
+constexpr int kIoprioWhoProcess = 1;
+constexpr int kIoprioClassShift = 13;
+
+/** Applies the job's scheduling settings between fork and exec. */
+class JobProcess : public SessionProcess {
+public:
+    JobProcess(const MaintenanceJob &job, QObject *parent)
+        : SessionProcess(parent),
+          m_nice(job.nice),
+          m_ioprio((job.ioClass << kIoprioClassShift) | (job.ioClass == 3 ? 0 : job.ioLevel)) {}
+
+protected:
+    void setupChildProcess() override {
+        SessionProcess::setupChildProcess();
+        ::setpriority(PRIO_PROCESS, 0, m_nice);
+        ::syscall(SYS_ioprio_set, kIoprioWhoProcess, 0, m_ioprio);
+    }
+
+private:
+    int m_nice;
+    int m_ioprio;
+};
+}
+
+bool MaintenanceRunner::Result::succeeded() const {
+    return !timedOut && !skipped && exitCode == 0;
+}
+
+int MaintenanceRunner::Report::failures() const {
+    return static_cast<int>(std::count_if(results.cbegin(), results.cend(), [](const Result &result) {
+        return !result.succeeded();
+    }));
+}
+
+MaintenanceRunner::MaintenanceRunner(QObject *parent)
+    : QObject(parent) {}
+
+MaintenanceRunner::~MaintenanceRunner() {
+    for (auto *process : m_processes) {
+        if (process && process->state() != QProcess::NotRunning) {
+            process->disconnect(this);
+            killProcessGroup(process);
+            process->waitForFinished(1000);
+        }
+    }
+}
+
+void MaintenanceRunner::setMaxParallel(int count) {
+    m_maxParallel = std::max(1, count);
+}
+
+void MaintenanceRunner::setEnvironment(const QProcessEnvironment &environment) {
+    m_environment = environment;
+}
+
+bool MaintenanceRunner::start(const QVector<MaintenanceJob> &jobs) {
+    if (m_active || jobs.isEmpty()) {
+        return false;
+    }
+    m_jobs = jobs;
+    m_processes = QVector<QProcess *>(jobs.size(), nullptr);
+    m_output = QVector<QByteArray>(jobs.size());
+    m_startOffsets = QVector<qint64>(jobs.size(), 0);
+    m_report = Report();
+    m_report.results.resize(jobs.size());
+    for (int i = 0; i < jobs.size(); ++i) {
+        m_report.results[i].name = jobs.at(i).name;
+    }
+    m_next = 0;
+    m_running = 0;
+    m_done = 0;
+    m_active = true;
+    m_total.start();
+    TraceBuffer::instance().instant("maintenance", "start");
+    startReady();
+    return true;
+}
+
+bool MaintenanceRunner::isRunning() const {
+    return m_active;
+}
+
+void MaintenanceRunner::cancel() {
+    if (!m_active) {
+        return;
+    }
+    m_report.canceled = true;
+    for (; m_next < m_jobs.size(); ++m_next) {
+        m_report.results[m_next].skipped = true;
+        m_report.results[m_next].message = tr("canceled before it started");
+        ++m_done;
+    }
+    for (auto *process : m_processes) {
+        if (process && process->state() != QProcess::NotRunning) {
+            killProcessGroup(process);
+        }
+    }
+    if (m_running == 0) {
+        complete();
+    }
+}
+
+MaintenanceRunner::Report MaintenanceRunner::lastReport() const {
+    return m_lastReport;
+}
+
+void MaintenanceRunner::startReady() {
+    while (m_running < m_maxParallel && m_next < m_jobs.size()) {
+        const int index = m_next++;
+        const MaintenanceJob &job = m_jobs.at(index);
+        ++m_running;
+        m_startOffsets[index] = m_total.elapsed();
+
+        auto *process = new JobProcess(job, this);
+        m_processes[index] = process;
+        process->setProcessChannelMode(QProcess::MergedChannels);
+        QProcessEnvironment environment = m_environment.isEmpty() ? QProcessEnvironment::systemEnvironment() : m_environment;
+        environment.insert(QStringLiteral("RTCWAKE_JOB"), job.name);
+        process->setProcessEnvironment(environment);
+        // Keep only the tail: a chatty backup must not grow the daemon.
+        connect(process, &QProcess::readyRead, this, [this, index, process]() {
+            QByteArray &output = m_output[index];
+            output += process->readAll();
+            if (output.size() > kOutputTailBytes) {
+                output.remove(0, output.size() - kOutputTailBytes);
+            }
+        });
+        auto *deadline = new QTimer(process);
+        deadline->setSingleShot(true);
+        connect(deadline, &QTimer::timeout, this, [this, index, process]() {
+            m_report.results[index].timedOut = true;
+            killProcessGroup(process);
+        });
+        connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+                [this, index, process, deadline](int exitCode, QProcess::ExitStatus status) {
+                    deadline->stop();
+                    m_output[index] += process->readAll();
+                    QString message = lastOutputLine(m_output.at(index));
+                    if (m_report.results.at(index).timedOut) {
+                        message = tr("killed after %1 s").arg(m_jobs.at(index).timeoutSeconds);
+                    } else if (m_report.canceled && status != QProcess::NormalExit) {
+                        message = tr("canceled");
+                    }
+                    finishJob(index, status == QProcess::NormalExit ? exitCode : -1, message);
+                });
+        connect(process, &QProcess::errorOccurred, this, [this, index, process, deadline](QProcess::ProcessError error) {
+            if (error == QProcess::FailedToStart) {
+                deadline->stop();
+                finishJob(index, -1, process->errorString());
+            }
+        });
+        deadline->start(std::min(job.timeoutSeconds, 24 * 3600) * 1000);
+        process->start(QStringLiteral("/bin/sh"), {QStringLiteral("-c"), job.command});
+    }
+}
+
+void MaintenanceRunner::finishJob(int index, int exitCode, const QString &message) {
+    QProcess *process = m_processes.at(index);
+    if (!process) {
+        return;
+    }
+    m_processes[index] = nullptr;
+    process->deleteLater();
+    --m_running;
+    ++m_done;
+    Result &result = m_report.results[index];
+    result.exitCode = exitCode;
+    result.message = message;
+    result.elapsedMs = m_total.elapsed() - m_startOffsets.at(index);
+    if (!result.succeeded()) {
+        qWarning().noquote() << "Maintenance job" << result.name << "failed:" << message;
+    }
+    if (m_done == m_jobs.size()) {
+        complete();
+    } else if (!m_report.canceled) {
+        startReady();
+    }
+}
+
+void MaintenanceRunner::complete() {
+    m_report.elapsedMs = m_total.elapsed();
+    m_lastReport = m_report;
+    m_active = false;
+    TraceBuffer::instance().instant("maintenance", "finished");
+    emit finished();
+}
@@ -0,0 +1,196 @@
+#include "MetricsExporter.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr int kDefaultFlushIntervalMs = 2000;
+
+QByteArray formatValue(double value) {
+    if (std::isinf(value)) {
+        return value > 0 ? QByteArrayLiteral("+Inf") : QByteArrayLiteral("-Inf");
+    }
+    return QByteArray::number(value, 'g', 15);
+}
+
+QByteArray seriesName(const QString &name, const QString &suffix, const QString &labels, const QString &extraLabel = QString()) {
+    QString joined = labels;
+    if (!extraLabel.isEmpty()) {
+        joined = joined.isEmpty() ? extraLabel : joined + QLatin1Char(',') + extraLabel;
+    }
+    QString result = name + suffix;
+    if (!joined.isEmpty()) {
+        result += QLatin1Char('{') + joined + QLatin1Char('}');
+    }
+    return result.toUtf8();
+}
+}
+
+MetricsExporter::MetricsExporter(QString path, QObject *parent)
+    : QObject(parent),
+      m_path(std::move(path)) {
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(kDefaultFlushIntervalMs);
+    connect(&m_flushTimer, &QTimer::timeout, this, [this]() { flush(); });
+}
+
+MetricsExporter::~MetricsExporter() {
+    if (m_dirty) {
+        flush();
+    }
+}
+
+void MetricsExporter::defineCounter(const QString &name, const QString &help) {
+    define(name, Kind::Counter, help, {});
+}
+
+void MetricsExporter::defineGauge(const QString &name, const QString &help) {
+    define(name, Kind::Gauge, help, {});
+}
+
+void MetricsExporter::defineHistogram(const QString &name, const QString &help, QVector<double> bounds) {
+    std::sort(bounds.begin(), bounds.end());
+    define(name, Kind::Histogram, help, std::move(bounds));
+}
+
+void MetricsExporter::define(const QString &name, Kind kind, const QString &help, QVector<double> bounds) {
+    Family entry;
+    entry.kind = kind;
+    entry.help = help;
+    entry.bounds = std::move(bounds);
+    m_families.insert(name, entry);
+}
+
+MetricsExporter::Family *MetricsExporter::family(const QString &name, Kind kind) {
+    if (!isEnabled()) {
+        return nullptr;
+    }
+    auto it = m_families.find(name);
+    if (it == m_families.end() || it->kind != kind) {
+        qWarning().noquote() << "Unknown metric" << name;
+        return nullptr;
+    }
+    return &it.value();
+}
+
+void MetricsExporter::increment(const QString &name, const QString &labels, double delta) {
+    if (auto *entry = family(name, Kind::Counter)) {
+        entry->series[labels].value += delta;
+        markDirty();
+    }
+}
+
+void MetricsExporter::setGauge(const QString &name, double value, const QString &labels) {
+    if (auto *entry = family(name, Kind::Gauge)) {
+        Series &series = entry->series[labels];
+        if (series.count > 0 && series.value == value) {
+            return;
+        }
+        series.value = value;
+        series.count = 1;
+        markDirty();
+    }
+}
+
+void MetricsExporter::observe(const QString &name, double value, const QString &labels) {
+    if (auto *entry = family(name, Kind::Histogram)) {
+        Series &series = entry->series[labels];
+        if (series.buckets.size() != entry->bounds.size()) {
+            series.buckets.fill(0, entry->bounds.size());
+        }
+        for (int i = 0; i < entry->bounds.size(); ++i) {
+            if (value <= entry->bounds.at(i)) {
+                ++series.buckets[i];
+            }
+        }
+        series.sum += value;
+        ++series.count;
+        markDirty();
+    }
+}
+
+bool MetricsExporter::isEnabled() const {
+    return !m_path.isEmpty();
+}
+
+QString MetricsExporter::path() const {
+    return m_path;
+}
+
+void MetricsExporter::setFlushInterval(int msecs) {
+    m_flushTimer.setInterval(std::max(0, msecs));
+}
+
+void MetricsExporter::markDirty() {
+    m_dirty = true;
+    if (!m_flushTimer.isActive()) {
+        m_flushTimer.start();
+    }
+}
+
+QByteArray MetricsExporter::render() const {
+    QByteArray out;
+    for (auto it = m_families.cbegin(); it != m_families.cend(); ++it) {
+        const QString &name = it.key();
+        const Family &entry = it.value();
+        if (entry.series.isEmpty()) {
+            continue;
+        }
+
+        const char *type = entry.kind == Kind::Counter ? "counter"
+                           : entry.kind == Kind::Gauge ? "gauge"
+                                                       : "histogram";
+        out += "# HELP " + name.toUtf8() + ' ' + entry.help.toUtf8() + '\n';
+        out += "# TYPE " + name.toUtf8() + ' ' + type + '\n';
+
+        for (auto series = entry.series.cbegin(); series != entry.series.cend(); ++series) {
+            const QString &labels = series.key();
+            const Series &data = series.value();
+            if (entry.kind != Kind::Histogram) {
+                out += seriesName(name, QString(), labels) + ' ' + formatValue(data.value) + '\n';
+                continue;
+            }
+            for (int i = 0; i < entry.bounds.size(); ++i) {
+                const QString le = QStringLiteral("le=\"%1\"").arg(QString::fromLatin1(formatValue(entry.bounds.at(i))));
+                const quint64 bucket = i < data.buckets.size() ? data.buckets.at(i) : 0;
+                out += seriesName(name, QStringLiteral("_bucket"), labels, le) + ' ' + QByteArray::number(bucket) + '\n';
+            }
+            out += seriesName(name, QStringLiteral("_bucket"), labels, QStringLiteral("le=\"+Inf\"")) + ' '
+                   + QByteArray::number(data.count) + '\n';
+            out += seriesName(name, QStringLiteral("_sum"), labels) + ' ' + formatValue(data.sum) + '\n';
+            out += seriesName(name, QStringLiteral("_count"), labels) + ' ' + QByteArray::number(data.count) + '\n';
+        }
+    }
+    return out;
+}
+
+bool MetricsExporter::flush() {
+    m_flushTimer.stop();
+    if (!isEnabled()) {
+        return false;
+    }
+    m_dirty = false;
+
+    QDir dir = QFileInfo(m_path).absoluteDir();
+    if (!dir.exists() && !QDir().mkpath(dir.absolutePath())) {
+        qWarning().noquote() << "Failed to create metrics directory" << dir.absolutePath();
+        return false;
+    }
+
+    // QSaveFile writes next to the target and renames, so the collector never sees a torn file.
+    QSaveFile file(m_path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning().noquote() << "Failed to open metrics file" << m_path << file.errorString();
+        return false;
+    }
+    file.write(render());
+    if (!file.commit()) {
+        qWarning().noquote() << "Failed to replace metrics file" << m_path << file.errorString();
+        return false;
+    }
+    return true;
+}
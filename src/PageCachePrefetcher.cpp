@@ -0,0 +1,252 @@
+#include "PageCachePrefetcher.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QMetaObject>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+// Big files (VM images) are read in slices so the budget is checked between them.
+constexpr qint64 kChunkBytes = 8LL * 1024 * 1024;
+constexpr int kMaxWorkers = 32;
+constexpr std::size_t kQueuePerWorker = 64;
+
+using Clock = std::chrono::steady_clock;
+
+struct WorkItem {
+    QByteArray path;
+    int root {0};
+};
+
+/** Bounded hand-off between the directory walker and the readers. */
+class WorkQueue {
+public:
+    explicit WorkQueue(std::size_t capacity)
+        : m_capacity(capacity) {}
+
+    bool push(WorkItem item, const Clock::time_point &deadline) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_notFull.wait_until(lock, deadline, [this]() { return m_items.size() < m_capacity; })) {
+            return false;
+        }
+        m_items.push_back(std::move(item));
+        m_notEmpty.notify_one();
+        return true;
+    }
+
+    bool pop(WorkItem &item) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notEmpty.wait(lock, [this]() { return !m_items.empty() || m_closed; });
+        if (m_items.empty()) {
+            return false;
+        }
+        item = std::move(m_items.front());
+        m_items.pop_front();
+        m_notFull.notify_one();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_notEmpty.notify_all();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_notEmpty;
+    std::condition_variable m_notFull;
+    std::deque<WorkItem> m_items;
+    std::size_t m_capacity;
+    bool m_closed {false};
+};
+
+struct Totals {
+    qint64 files {0};
+    qint64 bytes {0};
+};
+
+/** Ask the kernel to cache @p path; no data is copied to user space. Returns the bytes covered or -1. */
+qint64 prefetchFile(const QByteArray &path, const Clock::time_point &deadline, const std::atomic_bool &stop) {
+    int fd = ::open(path.constData(), O_RDONLY | O_CLOEXEC | O_NOATIME | O_NONBLOCK);
+    if (fd < 0 && errno == EPERM) {
+        // O_NOATIME is only allowed for the file owner (or root).
+        fd = ::open(path.constData(), O_RDONLY | O_CLOEXEC | O_NONBLOCK);
+    }
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        ::close(fd);
+        return -1;
+    }
+    qint64 done = 0;
+    const qint64 size = info.st_size;
+    while (done < size && !stop && Clock::now() < deadline) {
+        const qint64 length = std::min(kChunkBytes, size - done);
+        if (::readahead(fd, done, static_cast<size_t>(length)) != 0
+            && ::posix_fadvise(fd, done, length, POSIX_FADV_WILLNEED) != 0) {
+            break;
+        }
+        done += length;
+    }
+    ::close(fd);
+    return done;
+}
+}
+
+PageCachePrefetcher::PageCachePrefetcher(QObject *parent)
+    : QObject(parent) {}
+
+PageCachePrefetcher::~PageCachePrefetcher() {
+    m_cancel = true;
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+PageCachePrefetcher::Report PageCachePrefetcher::run(const Options &options, const std::atomic_bool *cancel) {
+    const auto started = Clock::now();
+    const auto deadline = started + std::chrono::milliseconds(std::max<qint64>(0, options.budgetMs));
+    const int workerCount = std::clamp(options.workers, 1, kMaxWorkers);
+
+    Report report;
+    for (const auto &path : options.paths) {
+        report.roots.append({QDir::cleanPath(path), 0, 0});
+    }
+
+    std::atomic_bool stop {false};
+    const auto shouldStop = [&]() {
+        if (cancel && *cancel) {
+            report.canceled = true;
+            stop = true;
+        }
+        if (Clock::now() >= deadline) {
+            report.budgetExhausted = true;
+            stop = true;
+        }
+        return stop.load();
+    };
+
+    WorkQueue queue(kQueuePerWorker * static_cast<std::size_t>(workerCount));
+    std::mutex resultMutex;
+    std::vector<std::thread> workers;
+    workers.reserve(static_cast<std::size_t>(workerCount));
+    for (int i = 0; i < workerCount; ++i) {
+        workers.emplace_back([&]() {
+            std::vector<Totals> local(static_cast<std::size_t>(report.roots.size()));
+            qint64 errors = 0;
+            WorkItem item;
+            while (queue.pop(item)) {
+                if (stop) {
+                    continue;
+                }
+                const qint64 bytes = prefetchFile(item.path, deadline, stop);
+                if (bytes < 0) {
+                    ++errors;
+                    continue;
+                }
+                auto &totals = local[static_cast<std::size_t>(item.root)];
+                ++totals.files;
+                totals.bytes += bytes;
+            }
+            std::lock_guard<std::mutex> lock(resultMutex);
+            for (int root = 0; root < report.roots.size(); ++root) {
+                report.roots[root].files += local[static_cast<std::size_t>(root)].files;
+                report.roots[root].bytes += local[static_cast<std::size_t>(root)].bytes;
+            }
+            report.errors += errors;
+        });
+    }
+
+    // The walker only stats directory entries; the readers do the actual I/O.
+    for (int root = 0; root < report.roots.size() && !shouldStop(); ++root) {
+        const QString &path = report.roots.at(root).path;
+        const QFileInfo info(path);
+        if (info.isFile()) {
+            if (!queue.push({QFile::encodeName(info.absoluteFilePath()), root}, deadline)) {
+                shouldStop();
+            }
+            continue;
+        }
+        if (!info.isDir()) {
+            std::lock_guard<std::mutex> lock(resultMutex);
+            ++report.errors;
+            continue;
+        }
+        QDirIterator it(path, QDir::Files | QDir::Hidden | QDir::NoSymLinks, QDirIterator::Subdirectories);
+        while (it.hasNext() && !shouldStop()) {
+            if (!queue.push({QFile::encodeName(it.next()), root}, deadline)) {
+                shouldStop();
+                break;
+            }
+        }
+    }
+
+    queue.close();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    shouldStop();
+
+    for (const auto &root : report.roots) {
+        report.files += root.files;
+        report.bytes += root.bytes;
+    }
+    report.elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - started).count();
+    return report;
+}
+
+bool PageCachePrefetcher::start(const Options &options) {
+    if (m_thread.joinable()) {
+        return false;
+    }
+    m_cancel = false;
+    const quint64 generation = ++m_generation;
+    m_thread = std::thread([this, options, generation]() {
+        m_threadReport = run(options, &m_cancel);
+        QMetaObject::invokeMethod(this, [this, generation]() {
+            if (generation == m_generation && m_thread.joinable()) {
+                m_thread.join();
+                complete();
+            }
+        }, Qt::QueuedConnection);
+    });
+    return true;
+}
+
+bool PageCachePrefetcher::isRunning() const {
+    return m_thread.joinable();
+}
+
+void PageCachePrefetcher::cancel() {
+    if (!m_thread.joinable()) {
+        return;
+    }
+    m_cancel = true;
+    m_thread.join();
+    complete();
+}
+
+PageCachePrefetcher::Report PageCachePrefetcher::lastReport() const {
+    return m_lastReport;
+}
+
+void PageCachePrefetcher::complete() {
+    m_lastReport = m_threadReport;
+    emit finished();
+}
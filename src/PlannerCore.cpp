@@ -0,0 +1,145 @@
+#include "PlannerCore.h"
+
+#include <ctime>
+
+namespace PlannerCore {
+
+namespace {
+// Howard Hinnant's days_from_civil / civil_from_days.
+std::int64_t daysFromCivil(const CivilDate &date) {
+    const int y = date.year - (date.month <= 2 ? 1 : 0);
+    const int era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned mp = static_cast<unsigned>(date.month + (date.month > 2 ? -3 : 9));
+    const unsigned doy = (153 * mp + 2) / 5 + static_cast<unsigned>(date.day) - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return static_cast<std::int64_t>(era) * 146097 + static_cast<std::int64_t>(doe) - 719468;
+}
+
+CivilDate civilFromDays(std::int64_t days) {
+    days += 719468;
+    const std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(days - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    CivilDate date;
+    date.day = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+    date.month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+    date.year = static_cast<int>(yoe + era * 400 + (date.month <= 2 ? 1 : 0));
+    return date;
+}
+
+void considerCandidate(bool valid, std::int64_t shutdown, std::int64_t wake, int action, int rule, std::int64_t now,
+                       bool &hasCandidate, Event &best) {
+    if (!valid || shutdown <= now) {
+        return;
+    }
+    if (!hasCandidate || shutdown < best.shutdownMs) {
+        best.shutdownMs = shutdown;
+        best.wakeMs = wake;
+        best.action = action;
+        best.rule = rule;
+        hasCandidate = true;
+    }
+}
+}
+
+CivilDate addDays(const CivilDate &date, int days) {
+    return civilFromDays(daysFromCivil(date) + days);
+}
+
+int dayOfWeek(const CivilDate &date) {
+    // 1970-01-01 was a Thursday.
+    const std::int64_t days = daysFromCivil(date);
+    const int weekday = static_cast<int>(((days % 7) + 7 + 3) % 7); // 0 = Monday
+    return weekday + 1;
+}
+
+Zone systemZone() {
+    Zone zone;
+    zone.toEpoch = [](const CivilDate &date, int msecOfDay, std::int64_t &epochMs) {
+        std::tm tm {};
+        tm.tm_year = date.year - 1900;
+        tm.tm_mon = date.month - 1;
+        tm.tm_mday = date.day;
+        tm.tm_hour = msecOfDay / 3600000;
+        tm.tm_min = (msecOfDay / 60000) % 60;
+        tm.tm_sec = (msecOfDay / 1000) % 60;
+        tm.tm_isdst = -1;
+        const std::tm requested = tm;
+        const std::time_t secs = std::mktime(&tm);
+        if (secs == static_cast<std::time_t>(-1)) {
+            return false;
+        }
+        // mktime() silently shifts times inside a DST gap; treat those as nonexistent.
+        if (tm.tm_hour != requested.tm_hour || tm.tm_min != requested.tm_min || tm.tm_mday != requested.tm_mday) {
+            return false;
+        }
+        epochMs = static_cast<std::int64_t>(secs) * 1000 + msecOfDay % 1000;
+        return true;
+    };
+    zone.dateOf = [](std::int64_t epochMs) {
+        const std::time_t secs = static_cast<std::time_t>(epochMs / 1000);
+        std::tm tm {};
+        localtime_r(&secs, &tm);
+        return CivilDate {tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday};
+    };
+    return zone;
+}
+
+std::int64_t hibernateAt(int action, std::int64_t delayMs, std::int64_t sleepMs, std::int64_t wakeMs) {
+    if (action != kSuspendThenHibernate || delayMs < 0) {
+        return 0;
+    }
+    const std::int64_t interim = sleepMs + delayMs;
+    return wakeMs - interim >= kMinDiskSleepMs ? interim : 0;
+}
+
+bool nextEvent(const Config &config, std::int64_t nowMs, const Zone &zone, Event &event) {
+    bool hasCandidate = false;
+
+    if (config.hasSingle) {
+        std::int64_t shutdown = 0;
+        std::int64_t wake = 0;
+        const bool valid = zone.toEpoch(config.singleShutdownDate, config.singleShutdownMsecOfDay, shutdown)
+            && zone.toEpoch(config.singleWakeDate, config.singleWakeMsecOfDay, wake);
+        considerCandidate(valid && shutdown < wake, shutdown, wake, config.action, -1, nowMs, hasCandidate, event);
+    }
+
+    const CivilDate today = zone.dateOf(nowMs);
+    const int todayWeekday = dayOfWeek(today);
+    for (std::size_t index = 0; index < config.weekly.size(); ++index) {
+        const WeeklyRule &rule = config.weekly[index];
+        if (!rule.enabled) {
+            continue;
+        }
+
+        int offset = rule.dayOfWeek - todayWeekday;
+        if (offset < 0) {
+            offset += 7;
+        }
+        CivilDate shutdownDate = addDays(today, offset);
+        std::int64_t shutdown = 0;
+        bool valid = zone.toEpoch(shutdownDate, rule.shutdownMsecOfDay, shutdown);
+        if (valid && shutdown <= nowMs) {
+            shutdownDate = addDays(shutdownDate, 7);
+            valid = zone.toEpoch(shutdownDate, rule.shutdownMsecOfDay, shutdown);
+        }
+
+        std::int64_t wake = 0;
+        valid = valid && zone.toEpoch(shutdownDate, rule.wakeMsecOfDay, wake);
+        if (valid && wake <= shutdown) {
+            valid = zone.toEpoch(addDays(shutdownDate, 1), rule.wakeMsecOfDay, wake);
+        }
+
+        considerCandidate(valid, shutdown, wake, config.action, static_cast<int>(index), nowMs, hasCandidate, event);
+    }
+
+    if (hasCandidate) {
+        event.hibernateMs = hibernateAt(event.action, config.hibernateDelayMs, event.shutdownMs, event.wakeMs);
+    }
+    return hasCandidate;
+}
+
+} // namespace PlannerCore
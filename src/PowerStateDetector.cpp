@@ -1,29 +1,78 @@
 #include "PowerStateDetector.h"
 
+#include "CgroupFreezer.h"
+#include "KernelFiles.h"
+
 #include <QFile>
 #include <QStringList>
 
 namespace {
-QStringList readTokens(const QString &path) {
+/** Sum of the Size column (KiB) of /proc/swaps. */
+qint64 swapBytes(const QString &path) {
     QFile file(path);
     if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        return {};
+        return 0;
+    }
+    qint64 total = 0;
+    file.readLine(); // header
+    while (!file.atEnd()) {
+        // Columns are separated by a mix of spaces and tabs.
+        const auto fields = QString::fromUtf8(file.readLine()).simplified().split(QLatin1Char(' '), Qt::SkipEmptyParts);
+        if (fields.size() >= 3) {
+            total += fields.at(2).toLongLong() * 1024;
+        }
+    }
+    return total;
+}
+}
+
+bool PowerStateDetector::HibernationSupport::usable() const {
+    return problem().isEmpty();
+}
+
+QString PowerStateDetector::HibernationSupport::problem() const {
+    if (!kernel) {
+        return QObject::tr("The kernel does not offer hibernation");
+    }
+    if (!resumeDevice) {
+        return QObject::tr("No resume device is configured");
     }
-    const QString data = QString::fromUtf8(file.readAll());
-    QString normalized = data;
-    normalized.replace('\n', ' ');
-    return normalized.split(' ', Qt::SkipEmptyParts);
+    if (swapBytes < imageBytes) {
+        return QObject::tr("Swap (%1 MiB) is smaller than the hibernation image (%2 MiB)")
+            .arg(swapBytes / (1024 * 1024))
+            .arg(imageBytes / (1024 * 1024));
+    }
+    return QString();
 }
+
+PowerStateDetector::PowerStateDetector(QString sysRoot, QString procRoot, QString cgroupRoot)
+    : m_sysRoot(std::move(sysRoot)),
+      m_procRoot(std::move(procRoot)),
+      m_cgroupRoot(std::move(cgroupRoot)) {}
+
+PowerStateDetector::HibernationSupport PowerStateDetector::hibernation() const {
+    HibernationSupport support;
+    support.kernel = KernelFiles::readTokens(m_sysRoot + QStringLiteral("/power/state")).contains(QStringLiteral("disk"));
+    const QStringList resume = KernelFiles::readTokens(m_sysRoot + QStringLiteral("/power/resume"));
+    support.resumeDevice = !resume.isEmpty() && resume.first() != QStringLiteral("0:0");
+    support.swapBytes = swapBytes(m_procRoot + QStringLiteral("/swaps"));
+    const QStringList imageSize = KernelFiles::readTokens(m_sysRoot + QStringLiteral("/power/image_size"));
+    // The kernel default is 2/5 of RAM; an image that does not shrink that far needs more.
+    support.imageBytes = imageSize.isEmpty() ? KernelFiles::memTotalBytes(m_procRoot + QStringLiteral("/meminfo")) * 2 / 5
+                                             : imageSize.first().toLongLong();
+    return support;
 }
 
 QVector<PowerStateDetector::Option> PowerStateDetector::detect() const {
-    const QStringList tokens = readTokens(QStringLiteral("/sys/power/state"));
+    const QStringList tokens = KernelFiles::readTokens(m_sysRoot + QStringLiteral("/power/state"));
     const bool freeze = tokens.contains(QStringLiteral("freeze"));
     const bool mem = tokens.contains(QStringLiteral("mem"));
-    const bool disk = tokens.contains(QStringLiteral("disk"));
+    const auto hibernate = hibernation();
+    const bool disk = hibernate.usable();
+    const QString diskProblem = disk ? QString() : QStringLiteral(" (%1)").arg(hibernate.problem());
 
     QVector<Option> options;
-    options.reserve(5);
+    options.reserve(7);
 
     options.push_back({PowerAction::None,
                        QObject::tr("Keep running"),
@@ -42,9 +91,19 @@ QVector<PowerStateDetector::Option> PowerStateDetector::detect() const {
 
     options.push_back({PowerAction::Hibernate,
                        QObject::tr("Hibernate"),
-                       QObject::tr("Save memory to disk and power off"),
+                       QObject::tr("Save memory to disk and power off") + diskProblem,
                        disk});
 
+    options.push_back({PowerAction::SuspendThenHibernate,
+                       QObject::tr("Suspend, then hibernate"),
+                       QObject::tr("Sleep in RAM for a while, then move to disk if the wake is still far away") + diskProblem,
+                       mem && disk});
+
+    options.push_back({PowerAction::FreezeUserSession,
+                       QObject::tr("Freeze user session"),
+                       QObject::tr("Stop every program of the user while the system keeps running"),
+                       CgroupFreezer(m_cgroupRoot).supported()});
+
     options.push_back({PowerAction::PowerOff,
                        QObject::tr("Power off"),
                        QObject::tr("Shut down immediately"),
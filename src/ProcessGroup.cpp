@@ -0,0 +1,31 @@
+#include "ProcessGroup.h"
+
+#include <csignal>
+#include <unistd.h>
+
+namespace {
+constexpr int kMaxMessageLength = 200;
+}
+
+void SessionProcess::setupChildProcess() {
+    ::setsid();
+}
+
+void killProcessGroup(QProcess *process) {
+    const qint64 pid = process->processId();
+    if (pid > 0) {
+        ::kill(static_cast<pid_t>(-pid), SIGKILL);
+    }
+    process->kill();
+}
+
+QString lastOutputLine(const QByteArray &output) {
+    const auto lines = QString::fromLocal8Bit(output).split(QLatin1Char('\n'), Qt::SkipEmptyParts);
+    for (auto it = lines.crbegin(); it != lines.crend(); ++it) {
+        const QString line = it->trimmed();
+        if (!line.isEmpty()) {
+            return line.left(kMaxMessageLength);
+        }
+    }
+    return QString();
+}
@@ -0,0 +1,178 @@
+#include "ResumeLatencyStats.h"
+
+#include "StateFile.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <time.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+qint64 clockMs(clockid_t id) {
+    timespec ts {};
+    ::clock_gettime(id, &ts);
+    return static_cast<qint64>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+QString actionKey(PowerAction action) {
+    return RtcWakeController::rtcwakeMode(action) + QLatin1Char('-') + QString::number(static_cast<int>(action));
+}
+}
+
+ResumeLatencyStats::ClockSample ResumeLatencyStats::ClockSample::capture() {
+    ClockSample sample;
+    sample.bootMs = clockMs(CLOCK_BOOTTIME);
+    sample.monotonicMs = clockMs(CLOCK_MONOTONIC);
+    sample.realtime = QDateTime::currentDateTime();
+    return sample;
+}
+
+const QVector<double> &ResumeLatencyStats::bucketBounds() {
+    static const QVector<double> bounds {1, 2, 5, 10, 20, 30, 60, 120, 300, 600};
+    return bounds;
+}
+
+ResumeLatencyStats::Measurement ResumeLatencyStats::measure(const ClockSample &before, const ClockSample &after,
+                                                           const QDateTime &plannedWake) {
+    Measurement result;
+    // CLOCK_BOOTTIME keeps counting while suspended, CLOCK_MONOTONIC does not.
+    result.suspendedMs = std::max<qint64>(0, (after.bootMs - before.bootMs) - (after.monotonicMs - before.monotonicMs));
+    if (plannedWake.isValid() && after.realtime.isValid()) {
+        result.wakeDelayMs = plannedWake.msecsTo(after.realtime);
+    }
+    return result;
+}
+
+void ResumeLatencyStats::record(PowerAction action, double seconds) {
+    const auto &bounds = bucketBounds();
+    Histogram &histogram = m_histograms[static_cast<int>(action)];
+    if (histogram.buckets.size() != bounds.size() + 1) {
+        histogram.buckets.fill(0, bounds.size() + 1);
+    }
+    const double value = std::max(0.0, seconds);
+    const auto it = std::lower_bound(bounds.begin(), bounds.end(), value);
+    ++histogram.buckets[static_cast<int>(it - bounds.begin())];
+    ++histogram.count;
+    histogram.sumSeconds += value;
+    histogram.maxSeconds = std::max(histogram.maxSeconds, value);
+}
+
+ResumeLatencyStats::Histogram ResumeLatencyStats::histogram(PowerAction action) const {
+    return m_histograms.value(static_cast<int>(action));
+}
+
+QList<PowerAction> ResumeLatencyStats::actions() const {
+    QList<PowerAction> result;
+    for (auto it = m_histograms.cbegin(); it != m_histograms.cend(); ++it) {
+        if (it->count > 0) {
+            result.append(static_cast<PowerAction>(it.key()));
+        }
+    }
+    return result;
+}
+
+double ResumeLatencyStats::percentile(PowerAction action, double quantile) const {
+    const Histogram histogram = m_histograms.value(static_cast<int>(action));
+    if (histogram.count == 0) {
+        return -1.0;
+    }
+    const auto &bounds = bucketBounds();
+    const double target = std::clamp(quantile, 0.0, 1.0) * histogram.count;
+    quint64 cumulative = 0;
+    for (int i = 0; i < histogram.buckets.size(); ++i) {
+        cumulative += histogram.buckets.at(i);
+        if (cumulative >= target && cumulative > 0) {
+            return i < bounds.size() ? std::min(bounds.at(i), histogram.maxSeconds) : histogram.maxSeconds;
+        }
+    }
+    return histogram.maxSeconds;
+}
+
+QString ResumeLatencyStats::summary(PowerAction action) const {
+    const Histogram histogram = m_histograms.value(static_cast<int>(action));
+    if (histogram.count == 0) {
+        return QObject::tr("%1: no samples").arg(RtcWakeController::actionLabel(action));
+    }
+    return QObject::tr("%1: p50 ≤ %2 s, p90 ≤ %3 s, max %4 s, mean %5 s (%6 samples)")
+        .arg(RtcWakeController::actionLabel(action))
+        .arg(percentile(action, 0.5), 0, 'f', 1)
+        .arg(percentile(action, 0.9), 0, 'f', 1)
+        .arg(histogram.maxSeconds, 0, 'f', 1)
+        .arg(histogram.sumSeconds / histogram.count, 0, 'f', 1)
+        .arg(histogram.count);
+}
+
+qint64 ResumeLatencyStats::leadMs(PowerAction action, double quantile, quint32 minSamples, qint64 maxLeadMs) const {
+    if (histogram(action).count < std::max<quint32>(1, minSamples)) {
+        return 0;
+    }
+    const double seconds = percentile(action, quantile);
+    return std::clamp<qint64>(std::llround(seconds * 1000), 0, std::max<qint64>(0, maxLeadMs));
+}
+
+bool ResumeLatencyStats::load(const QString &path) {
+    m_histograms.clear();
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return false;
+    }
+    const auto doc = QJsonDocument::fromJson(file.readAll());
+    if (!doc.isObject()) {
+        return false;
+    }
+
+    const int bucketCount = bucketBounds().size() + 1;
+    const QJsonObject actions = doc.object().value(QStringLiteral("actions")).toObject();
+    for (auto it = actions.begin(); it != actions.end(); ++it) {
+        const QJsonObject obj = it.value().toObject();
+        const int actionId = obj.value(QStringLiteral("actionId")).toInt(-1);
+        const QJsonArray buckets = obj.value(QStringLiteral("buckets")).toArray();
+        if (actionId < 0 || buckets.size() != bucketCount) {
+            continue;
+        }
+        Histogram histogram;
+        histogram.buckets.reserve(bucketCount);
+        for (const auto &value : buckets) {
+            const quint32 bucket = static_cast<quint32>(std::max(0, value.toInt()));
+            histogram.buckets.append(bucket);
+            histogram.count += bucket;
+        }
+        histogram.sumSeconds = obj.value(QStringLiteral("sumSeconds")).toDouble();
+        histogram.maxSeconds = obj.value(QStringLiteral("maxSeconds")).toDouble();
+        m_histograms.insert(actionId, histogram);
+    }
+    return true;
+}
+
+bool ResumeLatencyStats::save(const QString &path) const {
+    QJsonObject actions;
+    for (auto it = m_histograms.cbegin(); it != m_histograms.cend(); ++it) {
+        const PowerAction action = static_cast<PowerAction>(it.key());
+        QJsonArray buckets;
+        for (const auto bucket : it->buckets) {
+            buckets.append(static_cast<int>(bucket));
+        }
+        QJsonObject obj;
+        obj.insert(QStringLiteral("actionId"), it.key());
+        obj.insert(QStringLiteral("label"), RtcWakeController::actionLabel(action));
+        obj.insert(QStringLiteral("buckets"), buckets);
+        obj.insert(QStringLiteral("sumSeconds"), it->sumSeconds);
+        obj.insert(QStringLiteral("maxSeconds"), it->maxSeconds);
+        actions.insert(actionKey(action), obj);
+    }
+
+    QJsonArray bounds;
+    for (const double bound : bucketBounds()) {
+        bounds.append(bound);
+    }
+    QJsonObject root;
+    root.insert(QStringLiteral("bucketBounds"), bounds);
+    root.insert(QStringLiteral("actions"), actions);
+
+    return saveJsonState(path, root);
+}
@@ -0,0 +1,82 @@
+#include "RtcDeviceProbe.h"
+
+#include "KernelFiles.h"
+
+#include <QDir>
+#include <QFile>
+
+#include <algorithm>
+#include <utility>
+
+const QVector<qint64> &RtcDeviceProbe::rangeCandidates() {
+    // A year, a month-of-days register, a week and a time-of-day-only register.
+    static const QVector<qint64> candidates {365LL * 86400, 28LL * 86400, 7LL * 86400, 23LL * 3600};
+    return candidates;
+}
+
+RtcDeviceProbe::RtcDeviceProbe(QString sysRoot)
+    : m_sysRoot(std::move(sysRoot)) {}
+
+QVector<RtcDeviceProbe::Device> RtcDeviceProbe::devices() const {
+    QVector<Device> result;
+    const QDir dir(m_sysRoot + QStringLiteral("/class/rtc"));
+    auto names = dir.entryList({QStringLiteral("rtc*")}, QDir::Dirs | QDir::NoDotAndDotDot);
+    // rtc10 after rtc9, not after rtc1.
+    std::sort(names.begin(), names.end(), [](const QString &a, const QString &b) {
+        return a.size() != b.size() ? a.size() < b.size() : a < b;
+    });
+    for (const auto &name : names) {
+        Device device;
+        device.name = name;
+        const QString path = deviceDir(name);
+        device.driver = QString::fromUtf8(KernelFiles::readValue(path + QStringLiteral("/name")));
+        device.hasWakeAlarm = QFile::exists(path + QStringLiteral("/wakealarm"));
+        device.hctosys = KernelFiles::readValue(path + QStringLiteral("/hctosys")) == "1";
+        const QByteArray wakeup = KernelFiles::readValue(path + QStringLiteral("/device/power/wakeup"));
+        device.canWake = wakeup.isEmpty() || wakeup == "enabled";
+        result.append(device);
+    }
+    return result;
+}
+
+QString RtcDeviceProbe::select(const QString &preferred) const {
+    const auto all = devices();
+    QString first;
+    QString systemClock;
+    for (const auto &device : all) {
+        if (!device.hasWakeAlarm || !device.canWake) {
+            continue;
+        }
+        if (device.name == preferred) {
+            return preferred;
+        }
+        if (first.isEmpty()) {
+            first = device.name;
+        }
+        if (device.hctosys && systemClock.isEmpty()) {
+            systemClock = device.name;
+        }
+    }
+    return systemClock.isEmpty() ? first : systemClock;
+}
+
+qint64 RtcDeviceProbe::probeAlarmRange(const QString &device) const {
+    const QString path = deviceDir(device) + QStringLiteral("/wakealarm");
+    // The kernel refuses a new absolute alarm while one is pending; "0" clears it.
+    if (!KernelFiles::writeValue(path, "0")) {
+        return 0;
+    }
+    qint64 accepted = 0;
+    for (const qint64 secs : rangeCandidates()) {
+        if (KernelFiles::writeValue(path, QByteArray("+") + QByteArray::number(secs))) {
+            accepted = secs;
+            break;
+        }
+    }
+    KernelFiles::writeValue(path, "0");
+    return accepted;
+}
+
+QString RtcDeviceProbe::deviceDir(const QString &device) const {
+    return m_sysRoot + QStringLiteral("/class/rtc/") + device;
+}
@@ -0,0 +1,133 @@
+#include "RtcDriftModel.h"
+
+#include "StateFile.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QObject>
+
+#include <cmath>
+
+bool RtcDriftModel::addSample(const QString &device, qint64 sleptMs, qint64 gainMs, const QDateTime &recorded) {
+    if (sleptMs < kMinSleepMs) {
+        return false;
+    }
+    const double ppm = static_cast<double>(gainMs) / sleptMs * 1e6;
+    if (std::abs(ppm) > kMaxPlausiblePpm) {
+        return false;
+    }
+    auto &samples = m_samples[device];
+    samples.append({sleptMs, gainMs, recorded});
+    if (samples.size() > kMaxSamples) {
+        samples.remove(0, samples.size() - kMaxSamples);
+    }
+    return true;
+}
+
+RtcDriftModel::Estimate RtcDriftModel::estimate(const QString &device) const {
+    Estimate result;
+    const auto samples = m_samples.value(device);
+    result.samples = samples.size();
+    if (samples.isEmpty()) {
+        return result;
+    }
+    // gain = rate * slept, fitted through the origin.
+    double sumXY = 0.0;
+    double sumXX = 0.0;
+    for (const auto &sample : samples) {
+        sumXY += static_cast<double>(sample.gainMs) * sample.sleptMs;
+        sumXX += static_cast<double>(sample.sleptMs) * sample.sleptMs;
+    }
+    const double rate = sumXY / sumXX;
+    result.ppm = rate * 1e6;
+    if (samples.size() >= 2) {
+        double residuals = 0.0;
+        for (const auto &sample : samples) {
+            const double residual = sample.gainMs - rate * sample.sleptMs;
+            residuals += residual * residual;
+        }
+        result.stdErrorPpm = std::sqrt(residuals / (samples.size() - 1) / sumXX) * 1e6;
+    }
+    return result;
+}
+
+qint64 RtcDriftModel::predictGainMs(const QString &device, qint64 sleepMs) const {
+    const Estimate current = estimate(device);
+    if (!current.usable() || sleepMs <= 0) {
+        return 0;
+    }
+    return std::llround(current.ppm * 1e-6 * sleepMs);
+}
+
+QVector<RtcDriftModel::Sample> RtcDriftModel::samples(const QString &device) const {
+    return m_samples.value(device);
+}
+
+QStringList RtcDriftModel::devices() const {
+    return m_samples.keys();
+}
+
+QString RtcDriftModel::summary(const QString &device) const {
+    const Estimate current = estimate(device);
+    if (current.samples == 0) {
+        return QObject::tr("%1: no drift samples").arg(device);
+    }
+    const QString error = current.stdErrorPpm < 0 ? QObject::tr("unknown") : QString::number(current.stdErrorPpm, 'f', 1);
+    return QObject::tr("%1: %2 ppm ± %3 (%4 s/day) from %5 samples%6")
+        .arg(device)
+        .arg(current.ppm, 0, 'f', 1)
+        .arg(error)
+        .arg(current.ppm * 86400 / 1e6, 0, 'f', 1)
+        .arg(current.samples)
+        .arg(current.usable() ? QString() : QObject::tr(", not compensating yet"));
+}
+
+bool RtcDriftModel::load(const QString &path) {
+    m_samples.clear();
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return false;
+    }
+    const auto doc = QJsonDocument::fromJson(file.readAll());
+    if (!doc.isObject()) {
+        return false;
+    }
+    const QJsonObject devices = doc.object().value(QStringLiteral("devices")).toObject();
+    for (auto it = devices.begin(); it != devices.end(); ++it) {
+        const QJsonArray samples = it.value().toObject().value(QStringLiteral("samples")).toArray();
+        for (const auto &value : samples) {
+            const QJsonObject obj = value.toObject();
+            addSample(it.key(),
+                      static_cast<qint64>(obj.value(QStringLiteral("sleptMs")).toDouble()),
+                      static_cast<qint64>(obj.value(QStringLiteral("gainMs")).toDouble()),
+                      QDateTime::fromString(obj.value(QStringLiteral("recorded")).toString(), Qt::ISODate));
+        }
+    }
+    return true;
+}
+
+bool RtcDriftModel::save(const QString &path) const {
+    QJsonObject devices;
+    for (auto it = m_samples.cbegin(); it != m_samples.cend(); ++it) {
+        QJsonArray samples;
+        for (const auto &sample : *it) {
+            QJsonObject obj;
+            obj.insert(QStringLiteral("sleptMs"), static_cast<double>(sample.sleptMs));
+            obj.insert(QStringLiteral("gainMs"), static_cast<double>(sample.gainMs));
+            obj.insert(QStringLiteral("recorded"), sample.recorded.toUTC().toString(Qt::ISODate));
+            samples.append(obj);
+        }
+        const Estimate current = estimate(it.key());
+        QJsonObject device;
+        device.insert(QStringLiteral("ppm"), current.ppm);
+        device.insert(QStringLiteral("stdErrorPpm"), current.stdErrorPpm);
+        device.insert(QStringLiteral("samples"), samples);
+        devices.insert(it.key(), device);
+    }
+    QJsonObject root;
+    root.insert(QStringLiteral("devices"), devices);
+
+    return saveJsonState(path, root);
+}
@@ -1,24 +1,82 @@
 #include "RtcWakeController.h"
 
+#include "RtcDeviceProbe.h"
+#include "TraceBuffer.h"
+#include "WakeupCountGate.h"
+
+#include <QElapsedTimer>
+#include <QFile>
 #include <QProcess>
 
 RtcWakeController::RtcWakeController(QObject *parent)
     : QObject(parent) {}
 
+void RtcWakeController::setDevice(const QString &device) {
+    m_device = device;
+}
+
+QString RtcWakeController::device() const {
+    return m_device.isEmpty() ? QStringLiteral("rtc0") : m_device;
+}
+
 RtcWakeController::CommandResult RtcWakeController::scheduleWake(const QDateTime &targetUtc, PowerAction action) const {
+    TraceScope trace("controller", "scheduleWake");
     const QString epoch = QString::number(targetUtc.toSecsSinceEpoch());
     const QString mode = rtcwakeMode(action);
 
     QStringList args {QStringLiteral("rtcwake"), QStringLiteral("-m"), mode, QStringLiteral("-t"), epoch};
+    args << deviceArguments();
     return runProcess(args);
 }
 
 RtcWakeController::CommandResult RtcWakeController::programAlarm(const QDateTime &targetUtc) const {
+    TraceScope trace("controller", "programAlarm");
     const QString epoch = QString::number(targetUtc.toSecsSinceEpoch());
     QStringList args {QStringLiteral("rtcwake"), QStringLiteral("-m"), QStringLiteral("no"), QStringLiteral("-t"), epoch};
+    args << deviceArguments();
     return runProcess(args);
 }
 
+qint64 RtcWakeController::armedAlarm(const QString &device) {
+    QFile file(QStringLiteral("/sys/class/rtc/%1/wakealarm").arg(device));
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return -1;
+    }
+    const QByteArray text = file.readAll().trimmed();
+    if (text.isEmpty()) {
+        return 0;
+    }
+    bool ok = false;
+    const qint64 epoch = text.toLongLong(&ok);
+    return ok ? epoch : -1;
+}
+
+qint64 RtcWakeController::currentAlarm() const {
+    return armedAlarm(device());
+}
+
+qint64 RtcWakeController::rtcTime(const QString &device) {
+    QFile file(QStringLiteral("/sys/class/rtc/%1/since_epoch").arg(device));
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return -1;
+    }
+    bool ok = false;
+    const qint64 epoch = file.readAll().trimmed().toLongLong(&ok);
+    return ok ? epoch : -1;
+}
+
+qint64 RtcWakeController::currentRtcTime() const {
+    return rtcTime(device());
+}
+
+qint64 RtcWakeController::alarmRangeSecs() const {
+    return RtcDeviceProbe().probeAlarmRange(device());
+}
+
+WakeupCountGate::Result RtcWakeController::armWakeupCount() const {
+    return WakeupCountGate().arm();
+}
+
 QString RtcWakeController::actionLabel(PowerAction action) {
     switch (action) {
     case PowerAction::SuspendToIdle:
@@ -29,6 +87,10 @@ QString RtcWakeController::actionLabel(PowerAction action) {
         return QObject::tr("Hibernate");
     case PowerAction::PowerOff:
         return QObject::tr("Power off");
+    case PowerAction::SuspendThenHibernate:
+        return QObject::tr("Suspend, then hibernate");
+    case PowerAction::FreezeUserSession:
+        return QObject::tr("Freeze user session");
     case PowerAction::None:
     default:
         return QObject::tr("Do nothing");
@@ -45,6 +107,11 @@ QString RtcWakeController::rtcwakeMode(PowerAction action) {
         return QStringLiteral("disk");
     case PowerAction::PowerOff:
         return QStringLiteral("off");
+    case PowerAction::SuspendThenHibernate:
+        // The first stage; the daemon runs the disk stage itself.
+        return QStringLiteral("mem");
+    case PowerAction::FreezeUserSession:
+        // The machine stays up; the daemon thaws the session itself.
     case PowerAction::None:
     default:
         return QStringLiteral("no");
@@ -66,17 +133,35 @@ RtcWakeController::CommandResult RtcWakeController::runProcess(const QStringList
 
     result.commandLine = arguments.join(' ');
 
-    process.start(program, args);
-    bool started = process.waitForStarted();
+    QElapsedTimer timer;
+    timer.start();
+    bool started = false;
+    {
+        TraceScope spawnTrace("controller", "processStart");
+        process.start(program, args);
+        started = process.waitForStarted();
+    }
     if (!started) {
         result.stdErr = QObject::tr("Failed to start %1").arg(program);
+        result.elapsedMs = timer.elapsed();
         return result;
     }
 
-    process.waitForFinished(-1);
+    {
+        TraceScope waitTrace("controller", "processWait");
+        process.waitForFinished(-1);
+    }
+    result.elapsedMs = timer.elapsed();
     result.stdOut = QString::fromLocal8Bit(process.readAllStandardOutput());
     result.stdErr = QString::fromLocal8Bit(process.readAllStandardError());
     result.exitCode = process.exitCode();
     result.success = (process.exitStatus() == QProcess::NormalExit && process.exitCode() == 0);
     return result;
 }
+
+QStringList RtcWakeController::deviceArguments() const {
+    if (m_device.isEmpty()) {
+        return {};
+    }
+    return {QStringLiteral("-d"), m_device};
+}
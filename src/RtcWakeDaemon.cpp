@@ -1,27 +1,87 @@
 #include "RtcWakeDaemon.h"
 
+#include "CgroupFreezer.h"
+#include "PlannerCore.h"
+#include "RtcDeviceProbe.h"
 #include "SchedulePlanner.h"
+#include "SleepModeStats.h"
 #include "SummaryWriter.h"
+#include "TraceBuffer.h"
 
 #include <QCoreApplication>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileInfo>
 #include <QLoggingCategory>
 #include <QProcessEnvironment>
 #include <QProcess>
 #include <QLocale>
+#include <QThread>
+#include <QTimeZone>
 #include <QTextStream>
-#include <limits>
 #include <algorithm>
+#include <cmath>
+#include <pwd.h>
+#include <utility>
 
 namespace {
-constexpr int kPeriodicIntervalMs = 5 * 60 * 1000; // 5 minutes
+// Qt::VeryCoarseTimer may fire up to half a second early; anything earlier is re-armed.
+constexpr qint64 kEarlyFireToleranceMs = 1000;
+// A deferral that would leave less sleep than this skips the cycle instead.
+constexpr qint64 kMinSleepSecs = 5 * 60;
+// A boot this soon after a planned power-off wake was caused by our alarm.
+constexpr qint64 kBootWakeWindowSecs = 15 * 60;
+// A resume earlier than this before the suspend-then-hibernate alarm was not caused by it.
+constexpr qint64 kInterimWakeToleranceMs = 60 * 1000;
+// Time NTP gets after a resume to correct the wall clock before the RTC's error is read off.
+constexpr qint64 kDriftSettleMs = 15 * 60 * 1000;
+constexpr int kDriftProbeAttempts = 8;
+
+// Chained alarms stay this far inside the RTC's range so drift compensation cannot push them out.
+constexpr qint64 kChainMarginSecs = 60;
+
+// Time the warning helper gets beyond its countdown to start up and exit.
+constexpr int kWarningGraceSeconds = 30;
 
 QString formatDateTime(const QDateTime &dt) {
     return QLocale().toString(dt, QLocale::LongFormat);
 }
 
+QString modeLabel(const QString &mode) {
+    return QStringLiteral("mode=\"%1\"").arg(mode);
+}
+
+/** The sleeping action rtcwake runs for @p mode; None for modes the daemon does not fall back to. */
+PowerAction actionForMode(const QString &mode) {
+    for (const PowerAction action : {PowerAction::SuspendToIdle, PowerAction::SuspendToRam, PowerAction::Hibernate}) {
+        if (RtcWakeController::rtcwakeMode(action) == mode) {
+            return action;
+        }
+    }
+    return PowerAction::None;
+}
+
+/**
+ * Whether @p now lies in [start, end) (wrapping past midnight when end < start) and the
+ * next time that changes; start == end means the whole day and no boundary.
+ */
+bool idleWindowContains(const IdleSuspendPreferences &prefs, const QDateTime &now, QDateTime &boundary) {
+    boundary = QDateTime();
+    if (prefs.windowStart == prefs.windowEnd) {
+        return true;
+    }
+    const QTime time = now.time();
+    const bool inside = prefs.windowEnd > prefs.windowStart
+        ? time >= prefs.windowStart && time < prefs.windowEnd
+        : time >= prefs.windowStart || time < prefs.windowEnd;
+    boundary = QDateTime(now.date(), inside ? prefs.windowEnd : prefs.windowStart, now.timeZone());
+    if (boundary <= now) {
+        boundary = boundary.addDays(1);
+    }
+    return inside;
+}
+
 QString sanitizeSingleLine(QString text) {
     text.replace(QLatin1Char('\r'), QLatin1Char(' '));
     text.replace(QLatin1Char('\n'), QLatin1Char(' '));
@@ -30,24 +90,278 @@ QString sanitizeSingleLine(QString text) {
 }
 
 RtcWakeDaemon::RtcWakeDaemon(Options options, QObject *parent)
+    : RtcWakeDaemon(std::move(options), nullptr, nullptr, parent) {}
+
+RtcWakeDaemon::RtcWakeDaemon(Options options, DaemonClock *clock, RtcWakeController *controller, QObject *parent)
     : QObject(parent),
       m_repo(options.configPath),
       m_options(std::move(options)),
-      m_rtcwakeLogPath(resolveLogPath()) {
-    connect(&m_periodic, &QTimer::timeout, this, &RtcWakeDaemon::handlePeriodic);
-    connect(&m_eventTimer, &QTimer::timeout, this, &RtcWakeDaemon::handleEventTimeout);
-    m_periodic.setInterval(kPeriodicIntervalMs);
-    m_periodic.setSingleShot(false);
-    m_eventTimer.setSingleShot(true);
+      m_clock(clock ? clock : &DaemonClock::system()),
+      m_metrics(m_options.metricsPath),
+      m_clockWatcher(m_clock->createChangeWatcher(this)),
+      m_eventTimer(m_clock->createTimer(this)),
+      m_idleWindowTimer(m_clock->createTimer(this)),
+      m_energyTimer(m_clock->createTimer(this)),
+      m_thawTimer(m_clock->createTimer(this)),
+      m_idleMonitor(new IdleSuspendMonitor(m_clock, m_options.procRoot, this)),
+      m_activityMonitor(new UserActivityMonitor(m_clock, m_options.inputDir, this)),
+      m_idleProbe(m_options.procRoot),
+      m_hibernateTuner(m_options.sysRoot, m_options.procRoot),
+      m_controller(controller ? controller : &m_defaultController),
+      m_rtcwakeLogPath(resolveLogPath()),
+      m_history(statePath(QStringLiteral("history.bin"))),
+      m_journal(statePath(QStringLiteral("daemon-state.journal"))),
+      m_wakeProbe(m_options.sysRoot, m_options.procRoot),
+      m_energy(m_options.sysRoot),
+      m_sessionLocator(m_options.procRoot) {
+    defineMetrics();
+    // No polling: the daemon sleeps until the next deadline, a config change or a wall-clock jump.
+    connect(m_clockWatcher, &ClockChangeWatcher::changed, this, &RtcWakeDaemon::handleClockChanged);
+    connect(m_eventTimer, &DaemonTimer::timeout, this, &RtcWakeDaemon::handleEventTimeout);
+    connect(&m_prefetcher, &PageCachePrefetcher::finished, this, &RtcWakeDaemon::handlePrefetchFinished);
+    m_eventTimer->setSingleShot(true);
+    m_eventTimer->setTimerType(Qt::VeryCoarseTimer);
+    connect(m_idleWindowTimer, &DaemonTimer::timeout, this, &RtcWakeDaemon::configureIdleSuspend);
+    connect(m_idleMonitor, &IdleSuspendMonitor::idle, this, &RtcWakeDaemon::handleSystemIdle);
+    connect(&m_maintenance, &MaintenanceRunner::finished, this, &RtcWakeDaemon::handleMaintenanceFinished);
+    connect(m_activityMonitor, &UserActivityMonitor::graceExpired, this, &RtcWakeDaemon::handleNoActivity);
+    connect(m_activityMonitor, &UserActivityMonitor::activityDetected, this, &RtcWakeDaemon::handleUserActivity);
+    m_idleWindowTimer->setSingleShot(true);
+    m_idleWindowTimer->setTimerType(Qt::VeryCoarseTimer);
+    connect(m_energyTimer, &DaemonTimer::timeout, this, [this]() { sampleEnergy(); });
+    m_energyTimer->setTimerType(Qt::VeryCoarseTimer);
+    connect(m_thawTimer, &DaemonTimer::timeout, this, &RtcWakeDaemon::thawUserSession);
+    m_thawTimer->setSingleShot(true);
+    m_thawTimer->setTimerType(Qt::VeryCoarseTimer);
+}
+
+RtcWakeDaemon::~RtcWakeDaemon() {
+    if (m_frozenSlice.isEmpty()) {
+        return;
+    }
+    const bool thawed = CgroupFreezer(m_options.cgroupRoot).thaw(m_frozenSlice);
+    log(tr("Daemon exiting; %1 %2").arg(thawed ? tr("thawed") : tr("failed to thaw"), m_frozenSlice));
+    appendPersistentLog(QStringLiteral("session_freeze"),
+                        {{QStringLiteral("status"), thawed ? QStringLiteral("thawed_on_exit") : QStringLiteral("thaw_failed")},
+                         {QStringLiteral("cgroup"), m_frozenSlice}});
 }
 
 void RtcWakeDaemon::start() {
     log(tr("Daemon starting (PID %1)").arg(QCoreApplication::applicationPid()));
     appendPersistentLog(QStringLiteral("daemon_start"),
                         {{QStringLiteral("pid"), QString::number(QCoreApplication::applicationPid())}});
+    m_resumeStats.load(statePath(QStringLiteral("resume-latency.json")));
+    if (!m_history.open(true)) {
+        log(tr("Cycle history disabled: cannot open %1").arg(m_history.path()));
+    }
+    for (const auto action : m_resumeStats.actions()) {
+        log(tr("Resume latency %1").arg(m_resumeStats.summary(action)));
+    }
+    m_drift.load(statePath(QStringLiteral("rtc-drift.json")));
+    for (const auto &device : m_drift.devices()) {
+        log(tr("RTC drift %1").arg(m_drift.summary(device)));
+    }
+    const CgroupFreezer freezer(m_options.cgroupRoot);
+    const QString slice = targetUserSlice();
+    if (!slice.isEmpty() && freezer.isFrozen(slice)) {
+        // A previous daemon died with the session frozen and nothing left to thaw it.
+        const bool thawed = freezer.thaw(slice);
+        log(tr("%1 %2 left frozen by a previous daemon").arg(thawed ? tr("Thawed") : tr("Failed to thaw"), slice));
+        appendPersistentLog(QStringLiteral("recovery"),
+                            {{QStringLiteral("status"), thawed ? QStringLiteral("thawed_session") : QStringLiteral("thaw_failed")},
+                             {QStringLiteral("cgroup"), slice}});
+    }
     watchConfig();
-    reloadConfig();
-    m_periodic.start();
+    if (!restoreState()) {
+        reloadConfig();
+    } else {
+        configureIdleSuspend();
+        configureEnergy();
+    }
+}
+
+bool RtcWakeDaemon::restoreState() {
+    DaemonStateJournal::State state;
+    if (!m_journal.load(state)) {
+        return false;
+    }
+
+    m_config = m_repo.load();
+    if (state.configFingerprint != m_repo.fingerprint(m_config)) {
+        log(tr("Configuration changed while the daemon was down; replanning"));
+        return false;
+    }
+    configureRtc();
+
+    const QDateTime now = m_clock->now();
+    if (state.transitionStarted.isValid()) {
+        log(tr("Previous daemon exited during a %1 transition started at %2")
+                .arg(RtcWakeController::actionLabel(state.action), formatDateTime(state.transitionStarted)));
+        appendPersistentLog(QStringLiteral("recovery"),
+                            {{QStringLiteral("status"), QStringLiteral("after_transition")},
+                             {QStringLiteral("action"), RtcWakeController::actionLabel(state.action)},
+                             {QStringLiteral("started"), formatDateTime(state.transitionStarted)}});
+        const QDateTime bootAlarm = state.nextWake.isValid() ? state.nextWake.addMSecs(-state.readyLeadMs) : QDateTime();
+        if (state.action == PowerAction::PowerOff && bootAlarm.isValid() && bootAlarm <= now
+            && bootAlarm.secsTo(now) < kBootWakeWindowSecs) {
+            // Booted by our own alarm: this is the wake the maintenance jobs were planned for.
+            m_nextWake = state.nextWake;
+            m_nextAction = state.action;
+            m_readyLeadMs = state.readyLeadMs;
+            m_cyclePlannedShutdown = state.cyclePlannedShutdown;
+            measureBoot(bootAlarm, state.nextWake);
+            startMaintenance(plannedRule(), sampleClocks());
+            startActivityWatch(state.action);
+        }
+        return false;
+    }
+    if (!state.nextShutdown.isValid()) {
+        return false;
+    }
+
+    m_nextShutdown = state.nextShutdown;
+    m_nextWake = state.nextWake;
+    m_nextAction = state.action;
+    m_cyclePlannedShutdown = state.cyclePlannedShutdown;
+    m_snoozeCount = state.snoozeCount;
+    m_armedAlarm = state.armedAlarm;
+    m_armedRtcSecs = state.armedAlarm.isValid() ? state.armedAlarm.toSecsSinceEpoch() : 0;
+
+    if (state.nextShutdown <= now) {
+        const qint64 lateSecs = state.nextShutdown.secsTo(now);
+        const bool windowOpen = state.nextWake.isValid() && now < state.nextWake;
+        log(tr("Missed the %1 deadline at %2 by %3 s while the daemon was down")
+                .arg(RtcWakeController::actionLabel(state.action), formatDateTime(state.nextShutdown))
+                .arg(lateSecs));
+        appendPersistentLog(QStringLiteral("recovery"),
+                            {{QStringLiteral("status"), QStringLiteral("missed_deadline")},
+                             {QStringLiteral("shutdown"), formatDateTime(state.nextShutdown)},
+                             {QStringLiteral("late_s"), QString::number(lateSecs)},
+                             {QStringLiteral("resolution"), windowOpen ? QStringLiteral("apply_now") : QStringLiteral("replan")}});
+        if (!windowOpen) {
+            // The whole sleep window passed; record it and fall back to a fresh plan.
+            appendCycleRecord(CycleHistoryStore::Outcome::Skipped, QDateTime(), QDateTime(), {},
+                              CycleHistoryStore::MissedWhileDown);
+            return false;
+        }
+        m_snoozeActive = state.snoozeActive;
+        scheduleEventTimer(now, m_nextAction);
+        persistState();
+        return true;
+    }
+
+    m_snoozeActive = state.snoozeActive;
+    if (!alarmArmedFor(m_nextWake)) {
+        programAlarm(m_nextWake, m_nextAction);
+    }
+    scheduleEventTimer(m_nextShutdown, m_nextAction);
+    m_metrics.setGauge(QStringLiteral("rtcwake_daemon_next_wake_timestamp_seconds"), m_nextWake.toSecsSinceEpoch());
+    m_metrics.setGauge(QStringLiteral("rtcwake_daemon_next_shutdown_timestamp_seconds"), m_nextShutdown.toSecsSinceEpoch());
+    log(tr("Restored plan from journal: shutdown at %1, wake at %2 (%3)%4")
+            .arg(formatDateTime(m_nextShutdown), formatDateTime(m_nextWake), RtcWakeController::actionLabel(m_nextAction),
+                 m_snoozeActive ? tr(", snoozed") : QString()));
+    appendPersistentLog(QStringLiteral("recovery"),
+                        {{QStringLiteral("status"), QStringLiteral("restored")},
+                         {QStringLiteral("shutdown"), formatDateTime(m_nextShutdown)},
+                         {QStringLiteral("wake"), formatDateTime(m_nextWake)},
+                         {QStringLiteral("snoozed"), m_snoozeActive ? QStringLiteral("true") : QStringLiteral("false")}});
+    persistState();
+    return true;
+}
+
+void RtcWakeDaemon::persistState(const QDateTime &transitionStarted) {
+    DaemonStateJournal::State state;
+    state.nextShutdown = m_nextShutdown;
+    state.nextWake = m_nextWake;
+    state.cyclePlannedShutdown = m_cyclePlannedShutdown;
+    state.armedAlarm = m_armedAlarm;
+    state.transitionStarted = transitionStarted;
+    state.action = m_nextAction;
+    state.readyLeadMs = m_readyLeadMs;
+    state.snoozeActive = m_snoozeActive;
+    state.snoozeCount = m_snoozeCount;
+    state.configFingerprint = m_repo.fingerprint(m_config);
+    state.savedAt = m_clock->now();
+    state.pid = QCoreApplication::applicationPid();
+    if (!m_journal.save(state)) {
+        log(tr("Failed to write state journal %1").arg(m_journal.path()));
+    }
+}
+
+bool RtcWakeDaemon::alarmArmedFor(const QDateTime &wake) const {
+    if (!m_armedAlarm.isValid() || !wake.isValid() || m_armedAlarm != wake) {
+        return false;
+    }
+    // Trust our own bookkeeping only while the RTC agrees (or cannot be inspected).
+    const qint64 rtcAlarm = m_controller->currentAlarm();
+    return rtcAlarm < 0 || rtcAlarm == m_armedRtcSecs;
+}
+
+QString RtcWakeDaemon::dumpTrace() {
+    QString path = m_options.tracePath;
+    if (path.isEmpty() && !m_rtcwakeLogPath.isEmpty()) {
+        path = QFileInfo(m_rtcwakeLogPath).dir().filePath(QStringLiteral("trace.json"));
+    }
+    if (!TraceBuffer::instance().dump(path)) {
+        log(tr("Failed to write trace dump to %1").arg(path.isEmpty() ? tr("<unset>") : path));
+        return QString();
+    }
+    log(tr("Trace dump written to %1").arg(path));
+    appendPersistentLog(QStringLiteral("trace"),
+                        {{QStringLiteral("path"), path},
+                         {QStringLiteral("events"), QString::number(TraceBuffer::instance().size())}});
+    return path;
+}
+
+void RtcWakeDaemon::defineMetrics() {
+    m_metrics.defineCounter(QStringLiteral("rtcwake_daemon_plans_total"), QStringLiteral("Successful schedule plans."));
+    m_metrics.defineCounter(QStringLiteral("rtcwake_daemon_config_reloads_total"), QStringLiteral("Configuration reloads."));
+    m_metrics.defineCounter(QStringLiteral("rtcwake_daemon_alarm_programs_total"), QStringLiteral("RTC alarm programming attempts."));
+    m_metrics.defineCounter(QStringLiteral("rtcwake_daemon_rtcwake_failures_total"), QStringLiteral("Failed rtcwake invocations."));
+    m_metrics.defineCounter(QStringLiteral("rtcwake_daemon_snoozes_total"), QStringLiteral("Power actions snoozed from the warning dialog."));
+    m_metrics.defineCounter(QStringLiteral("rtcwake_daemon_cancels_total"), QStringLiteral("Power actions canceled from the warning dialog."));
+    m_metrics.defineGauge(QStringLiteral("rtcwake_daemon_next_wake_timestamp_seconds"), QStringLiteral("Planned wake time, 0 when idle."));
+    m_metrics.defineGauge(QStringLiteral("rtcwake_daemon_next_shutdown_timestamp_seconds"), QStringLiteral("Planned shutdown time, 0 when idle."));
+    m_metrics.defineHistogram(QStringLiteral("rtcwake_daemon_rtcwake_duration_seconds"),
+                              QStringLiteral("Wall time spent inside rtcwake, including any sleep."),
+                              {0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 60, 600, 3600, 28800, 86400});
+    m_metrics.defineHistogram(QStringLiteral("rtcwake_daemon_resume_latency_seconds"),
+                              QStringLiteral("Delay between the planned wake time and the daemon running again."),
+                              ResumeLatencyStats::bucketBounds());
+    m_metrics.defineHistogram(QStringLiteral("rtcwake_daemon_warning_response_seconds"),
+                              QStringLiteral("Time until the warning dialog returned a decision."),
+                              {1, 5, 10, 30, 60, 120, 300, 600});
+    m_metrics.defineGauge(QStringLiteral("rtcwake_daemon_prefetch_bytes"), QStringLiteral("Bytes queued into the page cache by the last post-wake prefetch."));
+    m_metrics.defineHistogram(QStringLiteral("rtcwake_daemon_prefetch_seconds"),
+                              QStringLiteral("Duration of the post-wake page-cache prefetch."),
+                              {0.5, 1, 2.5, 5, 10, 30, 60, 120, 300});
+    m_metrics.defineCounter(QStringLiteral("rtcwake_daemon_deferrals_total"), QStringLiteral("Transitions postponed because the machine was busy."));
+    m_metrics.defineCounter(QStringLiteral("rtcwake_daemon_idle_suspends_total"), QStringLiteral("Transitions started early because the machine was idle."));
+    m_metrics.defineCounter(QStringLiteral("rtcwake_daemon_return_to_sleep_total"), QStringLiteral("Scheduled wakes nobody used, slept through again."));
+    m_metrics.defineCounter(QStringLiteral("rtcwake_daemon_maintenance_job_failures_total"), QStringLiteral("Maintenance jobs that failed or timed out."));
+    m_metrics.defineHistogram(QStringLiteral("rtcwake_daemon_maintenance_job_duration_seconds"),
+                              QStringLiteral("Runtime of a single post-wake maintenance job."),
+                              {1, 10, 30, 60, 300, 600, 1800, 3600, 7200});
+    m_metrics.defineHistogram(QStringLiteral("rtcwake_daemon_maintenance_awake_seconds"),
+                              QStringLiteral("Time awake after a maintenance wake until sleeping again or giving up."),
+                              {60, 300, 600, 1800, 3600, 7200, 14400});
+    m_metrics.defineCounter(QStringLiteral("rtcwake_daemon_hook_failures_total"), QStringLiteral("Hooks that failed or timed out."));
+    m_metrics.defineCounter(QStringLiteral("rtcwake_daemon_wakeups_total"), QStringLiteral("Resumes by wakeup source and timing against the alarm."));
+    m_metrics.defineCounter(QStringLiteral("rtcwake_daemon_sleep_attempts_total"), QStringLiteral("Attempts to enter a sleep mode by outcome."));
+    m_metrics.defineCounter(QStringLiteral("rtcwake_daemon_session_freezes_total"), QStringLiteral("User session freezes by outcome."));
+    m_metrics.defineCounter(QStringLiteral("rtcwake_daemon_energy_joules_total"), QStringLiteral("Energy spent awake, asleep and in transitions by counter."));
+    m_metrics.defineHistogram(QStringLiteral("rtcwake_daemon_hook_duration_seconds"),
+                              QStringLiteral("Runtime of a single pre-suspend or post-resume hook."),
+                              {0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60});
+    m_metrics.defineHistogram(QStringLiteral("rtcwake_daemon_hook_pipeline_seconds"),
+                              QStringLiteral("Time from the first hook starting to the last one finishing."),
+                              {0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60});
+    m_metrics.defineHistogram(QStringLiteral("rtcwake_daemon_hibernate_image_write_seconds"),
+                              QStringLiteral("Time the kernel took to write the hibernation image."),
+                              {1, 2.5, 5, 10, 20, 30, 60, 120, 300});
+    m_metrics.defineHistogram(QStringLiteral("rtcwake_daemon_hibernate_image_read_seconds"),
+                              QStringLiteral("Time the kernel took to read the hibernation image back."),
+                              {1, 2.5, 5, 10, 20, 30, 60, 120, 300});
 }
 
 void RtcWakeDaemon::watchConfig() {
@@ -68,46 +382,118 @@ void RtcWakeDaemon::watchConfig() {
 }
 
 void RtcWakeDaemon::handleConfigChanged() {
-    QTimer::singleShot(500, this, [this]() { reloadConfig(); });
+    TraceBuffer::instance().instant("daemon", "configChanged");
+    m_clock->singleShot(500, this, [this]() {
+        if (m_transitionActive || !m_frozenSlice.isEmpty()) {
+            // Hooks spin a local event loop, and a frozen session ends its cycle at the thaw;
+            // reload once the transition is over.
+            m_reloadDeferred = true;
+            return;
+        }
+        reloadConfig();
+    });
     appendPersistentLog(QStringLiteral("config_watch"), {{QStringLiteral("event"), QStringLiteral("changed")}});
 }
 
-void RtcWakeDaemon::handlePeriodic() {
-    if (m_snoozeActive && m_eventTimer.isActive() && m_nextShutdown.isValid()
-        && QDateTime::currentDateTime() < m_nextShutdown) {
-        log(tr("Snoozed event pending; skipping periodic replanning"));
+void RtcWakeDaemon::handleClockChanged() {
+    TraceScope trace("daemon", "handleClockChanged");
+    const QDateTime now = m_clock->now();
+    appendPersistentLog(QStringLiteral("clock"), {{QStringLiteral("event"), QStringLiteral("changed")}});
+    if (!m_frozenSlice.isEmpty()) {
+        // The thaw timer counts monotonic time; the plan is rebuilt after the thaw.
+        m_thawTimer->start(std::max<qint64>(0, now.msecsTo(m_nextWake)));
+        return;
+    }
+    if (m_transitionActive || m_maintenanceHeldAction) {
+        // Resuming steps the clock while post-resume hooks run; the post-action plan covers it.
+        // A held action is applied when the maintenance jobs finish.
         return;
     }
-    planNext(tr("Periodic refresh"));
+    // The window boundary timer counts monotonic time as well.
+    configureIdleSuspend();
+    if (m_eventTimer->isActive() && m_nextShutdown.isValid()) {
+        if ((m_snoozeActive || m_deferredMs > 0 || m_idleProbePending) && m_nextWake.isValid() && now < m_nextWake) {
+            // Snooze, deferral and sample steps are durations: the step keeps its monotonic
+            // end and only its wall-clock label moves with the clock.
+            const qint64 remainingMs = std::max<qint64>(0, m_eventDueMonoMs - m_clock->monotonicMs());
+            scheduleEventTimer(now.addMSecs(remainingMs), m_nextAction);
+            persistState();
+            return;
+        }
+        // The event timer counts monotonic time; convert the wall deadline again.
+        if (m_nextShutdown <= now && m_nextWake.isValid() && now < m_nextWake) {
+            log(tr("Wall clock moved past the %1 deadline at %2; applying it now")
+                    .arg(RtcWakeController::actionLabel(m_nextAction), formatDateTime(m_nextShutdown)));
+            scheduleEventTimer(now, m_nextAction);
+            return;
+        }
+        SchedulePlanner::Event next;
+        if (m_nextShutdown > now && SchedulePlanner::nextEvent(m_config, now, next) && next.shutdown == m_nextShutdown
+            && next.wake == m_nextWake && next.action == m_nextAction && alarmArmedFor(next.wake)) {
+            scheduleEventTimer(m_nextShutdown, m_nextAction);
+            return;
+        }
+        if (m_nextShutdown <= now) {
+            log(tr("Missed the %1 deadline at %2 while the clock jumped")
+                    .arg(RtcWakeController::actionLabel(m_nextAction), formatDateTime(m_nextShutdown)));
+            appendCycleRecord(CycleHistoryStore::Outcome::Skipped);
+        }
+    }
+    planNext(tr("Wall clock changed"));
 }
 
 void RtcWakeDaemon::reloadConfig() {
+    TraceScope trace("daemon", "reloadConfig");
     m_snoozeActive = false;
     m_config = m_repo.load();
+    if (!m_config.returnToSleep.enabled) {
+        m_activityMonitor->stop();
+    }
+    configureRtc();
+    configureEnergy();
+    m_metrics.increment(QStringLiteral("rtcwake_daemon_config_reloads_total"));
     planNext(tr("Config reloaded"));
     appendPersistentLog(QStringLiteral("config_reload"),
                         {{QStringLiteral("path"), m_options.configPath.isEmpty() ? tr("<default>") : m_options.configPath}});
 }
 
 void RtcWakeDaemon::planNext(const QString &reason) {
+    TraceScope trace("daemon", "planNext");
     SchedulePlanner::Event next;
-    const QDateTime now = QDateTime::currentDateTime();
+    const QDateTime now = m_clock->now();
     if (!SchedulePlanner::nextEvent(m_config, now, next)) {
         cancelEventTimer();
+        m_metrics.setGauge(QStringLiteral("rtcwake_daemon_next_wake_timestamp_seconds"), 0);
+        m_metrics.setGauge(QStringLiteral("rtcwake_daemon_next_shutdown_timestamp_seconds"), 0);
         log(tr("No upcoming events. %1").arg(reason));
         appendPersistentLog(QStringLiteral("schedule"),
                             {{QStringLiteral("status"), QStringLiteral("empty")},
                              {QStringLiteral("reason"), reason.isEmpty() ? tr("<unspecified>") : reason}});
+        persistState();
+        configureIdleSuspend();
         return;
     }
 
     m_nextShutdown = next.shutdown;
     m_nextWake = next.wake;
     m_nextAction = next.action;
+    m_cyclePlannedShutdown = next.shutdown;
+    m_snoozeCount = 0;
+    m_deferredMs = 0;
+    m_idleProbePending = false;
+    m_maintenanceHeldAction = false;
 
-    programAlarm(next.wake, next.action);
+    if (alarmArmedFor(next.wake)) {
+        log(tr("RTC alarm already armed for %1").arg(formatDateTime(next.wake)));
+    } else {
+        programAlarm(next.wake, next.action);
+    }
     scheduleEventTimer(next.shutdown, next.action);
+    persistState();
     SummaryWriter::write(m_options.targetHome, next.wake, next.action);
+    m_metrics.increment(QStringLiteral("rtcwake_daemon_plans_total"));
+    m_metrics.setGauge(QStringLiteral("rtcwake_daemon_next_wake_timestamp_seconds"), next.wake.toSecsSinceEpoch());
+    m_metrics.setGauge(QStringLiteral("rtcwake_daemon_next_shutdown_timestamp_seconds"), next.shutdown.toSecsSinceEpoch());
 
     const QString shutdownLabel = formatDateTime(next.shutdown);
     const QString wakeLabel = formatDateTime(next.wake);
@@ -120,37 +506,56 @@ void RtcWakeDaemon::planNext(const QString &reason) {
                          {QStringLiteral("shutdown"), shutdownLabel},
                          {QStringLiteral("wake"), wakeLabel},
                          {QStringLiteral("action"), actionLabel}});
+    configureIdleSuspend();
 }
 
 void RtcWakeDaemon::scheduleEventTimer(const QDateTime &shutdown, PowerAction action) {
-    m_eventTimer.stop();
+    m_eventTimer->stop();
     m_nextShutdown = shutdown;
     m_nextAction = action;
-
-    const qint64 msecs = QDateTime::currentDateTime().msecsTo(shutdown);
-    if (msecs <= 0) {
-        QTimer::singleShot(0, this, &RtcWakeDaemon::handleEventTimeout);
-        return;
-    }
-    m_eventTimer.start(static_cast<int>(qMin(msecs, static_cast<qint64>(std::numeric_limits<int>::max()))));
+    const qint64 delayMs = std::max<qint64>(0, m_clock->now().msecsTo(shutdown));
+    m_eventDueMonoMs = m_clock->monotonicMs() + delayMs;
+    m_eventTimer->start(delayMs);
 }
 
 void RtcWakeDaemon::cancelEventTimer() {
-    m_eventTimer.stop();
+    m_eventTimer->stop();
     m_nextShutdown = QDateTime();
+    m_snoozeActive = false;
 }
 
 void RtcWakeDaemon::handleEventTimeout() {
+    TraceScope trace("daemon", "handleEventTimeout");
     if (!m_nextShutdown.isValid()) {
         return;
     }
+    const qint64 remainingMs = m_clock->now().msecsTo(m_nextShutdown);
+    if (remainingMs > kEarlyFireToleranceMs) {
+        // The wall clock moved back without a change notification; wait for the real deadline.
+        scheduleEventTimer(m_nextShutdown, m_nextAction);
+        return;
+    }
+    if (m_maintenance.isRunning()) {
+        // Do not pull the machine away from a backup; every job has its own timeout.
+        m_maintenanceHeldAction = true;
+        log(tr("Maintenance jobs still running; holding the %1").arg(RtcWakeController::actionLabel(m_nextAction)));
+        appendPersistentLog(QStringLiteral("maintenance"), {{QStringLiteral("status"), QStringLiteral("holding")}});
+        return;
+    }
+    if (deferForActivity()) {
+        return;
+    }
 
     const auto outcome = invokeWarning(m_nextShutdown, m_nextAction);
     if (outcome == WarningOutcome::Snooze) {
         m_snoozeActive = true;
+        ++m_snoozeCount;
         const int snoozeMs = m_config.warning.snoozeMinutes * 60 * 1000;
-        m_nextShutdown = QDateTime::currentDateTime().addMSecs(snoozeMs);
+        m_nextShutdown = m_clock->now().addMSecs(snoozeMs);
         scheduleEventTimer(m_nextShutdown, m_nextAction);
+        persistState();
+        m_metrics.increment(QStringLiteral("rtcwake_daemon_snoozes_total"));
+        m_metrics.setGauge(QStringLiteral("rtcwake_daemon_next_shutdown_timestamp_seconds"), m_nextShutdown.toSecsSinceEpoch());
         log(tr("Power action snoozed for %1 minutes").arg(m_config.warning.snoozeMinutes));
         appendPersistentLog(QStringLiteral("warning"),
                             {{QStringLiteral("outcome"), QStringLiteral("snooze")},
@@ -160,9 +565,11 @@ void RtcWakeDaemon::handleEventTimeout() {
 
     if (outcome == WarningOutcome::Cancel) {
         m_snoozeActive = false;
+        m_metrics.increment(QStringLiteral("rtcwake_daemon_cancels_total"));
         log(tr("Power action canceled by user"));
         appendPersistentLog(QStringLiteral("warning"),
                             {{QStringLiteral("outcome"), QStringLiteral("cancel")}});
+        appendCycleRecord(CycleHistoryStore::Outcome::Canceled);
         planNext(tr("User canceled"));
         return;
     }
@@ -173,46 +580,413 @@ void RtcWakeDaemon::handleEventTimeout() {
         appendPersistentLog(QStringLiteral("action"),
                             {{QStringLiteral("status"), QStringLiteral("skipped")},
                              {QStringLiteral("reason"), QStringLiteral("no_action")}});
+        appendCycleRecord(CycleHistoryStore::Outcome::Skipped);
     } else if (!m_nextWake.isValid()) {
         log(tr("Cannot arm rtcwake: next wake time is invalid"));
         appendPersistentLog(QStringLiteral("action"),
                             {{QStringLiteral("status"), QStringLiteral("skipped")},
                              {QStringLiteral("reason"), QStringLiteral("invalid_wake")}});
+        appendCycleRecord(CycleHistoryStore::Outcome::Skipped);
+    } else if (m_nextAction == PowerAction::FreezeUserSession) {
+        if (freezeUserSession()) {
+            return;
+        }
     } else {
-        const QString actionLabel = RtcWakeController::actionLabel(m_nextAction);
-        const QString wakeLabel = formatDateTime(m_nextWake);
-        auto result = m_controller.scheduleWake(m_nextWake.toUTC(), m_nextAction);
-        if (!result.success) {
-            log(tr("Failed to arm rtcwake for %1 via %2: %3")
-                    .arg(actionLabel,
-                         result.commandLine.isEmpty() ? tr("<unknown command>") : result.commandLine,
-                         result.stdErr.isEmpty() ? tr("<no stderr>") : result.stdErr));
-        } else {
-            log(tr("Invoked rtcwake for %1 at %2 via: %3")
-                    .arg(actionLabel,
-                         wakeLabel,
-                         result.commandLine.isEmpty() ? tr("<unknown command>") : result.commandLine));
-        }
-        appendPersistentLog(QStringLiteral("rtcwake"),
-                            {{QStringLiteral("action"), actionLabel},
-                             {QStringLiteral("wake"), wakeLabel},
-                             {QStringLiteral("command"), result.commandLine.isEmpty() ? tr("<unknown>") : result.commandLine},
-                             {QStringLiteral("exit"), QString::number(result.exitCode)},
-                             {QStringLiteral("success"), result.success ? QStringLiteral("true") : QStringLiteral("false")},
-                             {QStringLiteral("stderr"), result.stdErr.isEmpty() ? tr("<empty>") : result.stdErr}});
+        executeTransition();
+    }
+
+    finishTransition();
+}
+
+void RtcWakeDaemon::executeTransition(qint32 flags) {
+    TraceScope trace("daemon", "executeTransition");
+    const int rule = plannedRule();
+    const QString actionLabel = RtcWakeController::actionLabel(m_nextAction);
+    const QString wakeLabel = formatDateTime(m_nextWake);
+    // Publish the pre-sleep state; the event loop is blocked until rtcwake returns.
+    m_transitionActive = true;
+    ++m_driftProbe;
+    m_idleMonitor->stop();
+    m_activityMonitor->stop();
+    m_prefetcher.cancel();
+    const auto energyStart = sampleEnergy();
+    runHooks(QStringLiteral("pre"), m_nextAction);
+    m_metrics.flush();
+    m_readyLeadMs = readyLeadMs(m_nextAction);
+    if (m_readyLeadMs > 0) {
+        log(tr("Waking %1 s early so the machine is ready at %2")
+                .arg(m_readyLeadMs / 1000.0, 0, 'f', 1)
+                .arg(wakeLabel));
+    }
+    const auto beforeSleep = sampleClocks();
+    const bool syncedBeforeSleep = m_clock->isSynchronized();
+    persistState(beforeSleep.realtime);
+    if (m_nextAction == PowerAction::Hibernate) {
+        prepareHibernate();
+    }
+    const auto energyBeforeSleep = sampleEnergy();
+    auto result = m_nextAction == PowerAction::SuspendThenHibernate ? suspendThenHibernate()
+                                                                    : sleepUntil(readyAlarm(), m_nextAction);
+    const auto afterSleep = sampleClocks();
+    const auto energyAfterSleep = sampleEnergy(true);
+    const qint64 resumeWallOffsetMs = afterSleep.realtime.toMSecsSinceEpoch() - m_clock->rawMonotonicMs();
+    if (!result.success || m_nextAction != PowerAction::PowerOff) {
+        // Also after a failed rtcwake: the pre-suspend hooks stopped things that must come back.
+        runHooks(QStringLiteral("post"), m_nextAction);
+    }
+    recordEnergy(energyStart, energyBeforeSleep, energyAfterSleep, sampleEnergy());
+    m_transitionActive = false;
+    const QString mode = modeLabel(RtcWakeController::rtcwakeMode(m_nextAction));
+    m_metrics.observe(QStringLiteral("rtcwake_daemon_rtcwake_duration_seconds"), result.elapsedMs / 1000.0, mode);
+    if (!result.success) {
+        m_metrics.increment(QStringLiteral("rtcwake_daemon_rtcwake_failures_total"), mode);
+        log(tr("Failed to arm rtcwake for %1 via %2: %3")
+                .arg(actionLabel,
+                     result.commandLine.isEmpty() ? tr("<unknown command>") : result.commandLine,
+                     result.stdErr.isEmpty() ? tr("<no stderr>") : result.stdErr));
+    } else {
+        log(tr("Invoked rtcwake for %1 at %2 via: %3")
+                .arg(actionLabel,
+                     wakeLabel,
+                     result.commandLine.isEmpty() ? tr("<unknown command>") : result.commandLine));
+    }
+    appendPersistentLog(QStringLiteral("rtcwake"),
+                        {{QStringLiteral("action"), actionLabel},
+                         {QStringLiteral("wake"), wakeLabel},
+                         {QStringLiteral("command"), result.commandLine.isEmpty() ? tr("<unknown>") : result.commandLine},
+                         {QStringLiteral("exit"), QString::number(result.exitCode)},
+                         {QStringLiteral("success"), result.success ? QStringLiteral("true") : QStringLiteral("false")},
+                         {QStringLiteral("stderr"), result.stdErr.isEmpty() ? tr("<empty>") : result.stdErr}});
+    // The RTC alarm has fired (or been consumed by the failed run); nothing is armed any more.
+    m_armedAlarm = QDateTime();
+    m_armedRtcSecs = 0;
+    persistState();
+    ResumeLatencyStats::Measurement measurement;
+    if (result.success) {
+        measurement = recordResumeLatency(m_nextAction, beforeSleep, afterSleep, readyAlarm());
+    }
+    recordHibernate(measurement);
+    if (syncedBeforeSleep && measurement.suspendedMs > 0) {
+        startDriftProbe(measurement.suspendedMs, resumeWallOffsetMs);
+    }
+    if (measurement.suspendedMs > 0) {
+        flags |= recordWakeReason(afterSleep.realtime);
+    }
+    appendCycleRecord(result.success ? CycleHistoryStore::Outcome::Completed : CycleHistoryStore::Outcome::Failed,
+                      beforeSleep.realtime, afterSleep.realtime, measurement, flags);
+    if (measurement.suspendedMs > 0 && measurement.wakeDelayMs >= 0) {
+        // Woken by our alarm rather than by the user: warm the caches before the first login.
+        startPrefetch();
+        startMaintenance(rule, afterSleep);
+        startActivityWatch(m_nextAction);
+    }
+}
+
+RtcWakeController::CommandResult RtcWakeDaemon::suspendThenHibernate() {
+    const qint64 interimMs = PlannerCore::hibernateAt(static_cast<int>(m_nextAction), m_config.hibernateDelayMinutes * 60000LL,
+                                                      m_clock->now().toMSecsSinceEpoch(), m_nextWake.toMSecsSinceEpoch());
+    if (interimMs == 0) {
+        return sleepUntil(readyAlarm(), PowerAction::SuspendToRam);
+    }
+    const QDateTime interim = QDateTime::fromMSecsSinceEpoch(interimMs, m_nextWake.timeZone());
+    auto first = sleepUntil(interim, PowerAction::SuspendToRam);
+    const QDateTime resumed = m_clock->now();
+    const qint64 remainingMs = resumed.msecsTo(m_nextWake);
+    QString stage;
+    if (!first.success) {
+        stage = QStringLiteral("failed");
+    } else if (resumed.msecsTo(interim) > kInterimWakeToleranceMs) {
+        // Someone woke the machine before the interim alarm: they want it now.
+        stage = QStringLiteral("woken_early");
+    } else if (remainingMs <= 0) {
+        stage = QStringLiteral("overslept");
+    }
+    if (!stage.isEmpty()) {
+        appendPersistentLog(QStringLiteral("hybrid_sleep"),
+                            {{QStringLiteral("stage"), stage}, {QStringLiteral("interim"), formatDateTime(interim)}});
+        return first;
+    }
+
+    PowerAction second = remainingMs >= PlannerCore::kMinDiskSleepMs ? PowerAction::Hibernate : PowerAction::SuspendToRam;
+    log(tr("Interim wake at %1; %2 until %3")
+            .arg(formatDateTime(resumed), RtcWakeController::actionLabel(second), formatDateTime(m_nextWake)));
+    if (second == PowerAction::Hibernate) {
+        prepareHibernate();
+    }
+    auto result = sleepUntil(readyAlarm(), second);
+    if (!result.success && second == PowerAction::Hibernate) {
+        // No usable swap or resume device after all: RAM still beats staying up all night.
+        log(tr("Hibernation failed (%1); suspending to RAM instead")
+                .arg(result.stdErr.isEmpty() ? tr("<no stderr>") : result.stdErr));
+        second = PowerAction::SuspendToRam;
+        m_hibernateTuning = HibernateTuner::Applied();
+        result = sleepUntil(readyAlarm(), second);
+    }
+    appendPersistentLog(QStringLiteral("hybrid_sleep"),
+                        {{QStringLiteral("stage"), RtcWakeController::rtcwakeMode(second)},
+                         {QStringLiteral("interim"), formatDateTime(interim)},
+                         {QStringLiteral("wake"), formatDateTime(m_nextWake)}});
+    result.commandLine = first.commandLine + QStringLiteral(" && ") + result.commandLine;
+    result.elapsedMs += first.elapsedMs;
+    return result;
+}
+
+bool RtcWakeDaemon::freezeUserSession() {
+    TraceScope trace("daemon", "freezeUserSession");
+    const QDateTime now = m_clock->now();
+    const QString slice = targetUserSlice();
+    const QString wakeLabel = formatDateTime(m_nextWake);
+    if (slice.isEmpty() || !CgroupFreezer(m_options.cgroupRoot).freeze(slice)) {
+        log(tr("Failed to freeze the session of %1")
+                .arg(m_options.targetUser.isEmpty() ? tr("<no user>") : m_options.targetUser));
+        m_metrics.increment(QStringLiteral("rtcwake_daemon_session_freezes_total"), QStringLiteral("result=\"failed\""));
+        appendPersistentLog(QStringLiteral("session_freeze"),
+                            {{QStringLiteral("status"), QStringLiteral("failed")},
+                             {QStringLiteral("user"), m_options.targetUser},
+                             {QStringLiteral("cgroup"), slice.isEmpty() ? tr("<unknown>") : slice}});
+        appendCycleRecord(CycleHistoryStore::Outcome::Failed, now);
+        return false;
+    }
+    // The system keeps running: no hooks, no RTC sleep, just a timer to thaw at the wake time.
+    m_frozenSlice = slice;
+    m_frozenSince = now;
+    m_idleMonitor->stop();
+    m_activityMonitor->stop();
+    m_prefetcher.cancel();
+    m_thawTimer->start(std::max<qint64>(0, now.msecsTo(m_nextWake)));
+    log(tr("Froze %1 until %2").arg(slice, wakeLabel));
+    appendPersistentLog(QStringLiteral("session_freeze"),
+                        {{QStringLiteral("status"), QStringLiteral("frozen")},
+                         {QStringLiteral("cgroup"), slice},
+                         {QStringLiteral("wake"), wakeLabel}});
+    return true;
+}
+
+void RtcWakeDaemon::thawUserSession() {
+    TraceScope trace("daemon", "thawUserSession");
+    if (m_frozenSlice.isEmpty()) {
+        return;
+    }
+    const QDateTime now = m_clock->now();
+    const bool thawed = CgroupFreezer(m_options.cgroupRoot).thaw(m_frozenSlice);
+    const QString frozenMinutes = QString::number(m_frozenSince.msecsTo(now) / 60000.0, 'f', 1);
+    if (thawed) {
+        log(tr("Thawed %1 after %2 minutes").arg(m_frozenSlice, frozenMinutes));
+    } else {
+        log(tr("Failed to thaw %1; the session stays frozen").arg(m_frozenSlice));
+    }
+    m_metrics.increment(QStringLiteral("rtcwake_daemon_session_freezes_total"),
+                        thawed ? QStringLiteral("result=\"thawed\"") : QStringLiteral("result=\"thaw_failed\""));
+    appendPersistentLog(QStringLiteral("session_freeze"),
+                        {{QStringLiteral("status"), thawed ? QStringLiteral("thawed") : QStringLiteral("thaw_failed")},
+                         {QStringLiteral("cgroup"), m_frozenSlice},
+                         {QStringLiteral("frozen_min"), frozenMinutes}});
+    appendCycleRecord(thawed ? CycleHistoryStore::Outcome::Completed : CycleHistoryStore::Outcome::Failed,
+                      m_frozenSince, now);
+    m_frozenSlice.clear();
+    m_frozenSince = QDateTime();
+    finishTransition();
+}
+
+qint64 RtcWakeDaemon::targetUserId() const {
+    const QByteArray user = m_options.targetUser.toLocal8Bit();
+    const struct passwd *entry = user.isEmpty() ? nullptr : ::getpwnam(user.constData());
+    return entry ? static_cast<qint64>(entry->pw_uid) : -1;
+}
+
+QString RtcWakeDaemon::targetUserSlice() const {
+    const qint64 uid = targetUserId();
+    return uid < 0 ? QString() : CgroupFreezer::userSlice(static_cast<uint>(uid));
+}
+
+void RtcWakeDaemon::prepareHibernate() {
+    m_hibernateTuning = HibernateTuner::Applied();
+    const auto &prefs = m_config.hibernateTuning;
+    if (!prefs.enabled) {
+        return;
+    }
+    // Remember where the kernel log stands so only this hibernation's timings are picked up.
+    m_kmsgSequence = m_hibernateTuner.kmsgSequence();
+    m_hibernateTuning = m_hibernateTuner.apply(prefs);
+    for (const auto &error : m_hibernateTuning.errors) {
+        log(tr("Hibernate tuning: %1").arg(error));
+    }
+    appendPersistentLog(QStringLiteral("hibernate_tuning"),
+                        {{QStringLiteral("status"), QStringLiteral("applied")},
+                         {QStringLiteral("setting"), m_hibernateTuning.key},
+                         {QStringLiteral("image_bytes"), QString::number(m_hibernateTuning.imageBytes)},
+                         {QStringLiteral("errors"), QString::number(m_hibernateTuning.errors.size())}});
+}
+
+void RtcWakeDaemon::recordHibernate(const ResumeLatencyStats::Measurement &measurement) {
+    const HibernateTuner::Applied tuning = std::exchange(m_hibernateTuning, HibernateTuner::Applied());
+    // An early or foreign wake says nothing about how fast this setting resumes.
+    if (tuning.key.isEmpty() || measurement.suspendedMs <= 0 || measurement.wakeDelayMs < 0) {
+        return;
+    }
+    const auto image = m_hibernateTuner.imageStats(m_kmsgSequence);
+    const double resumeSeconds = measurement.wakeDelayMs / 1000.0;
+    const QString path = statePath(QStringLiteral("hibernate-tuning.json"));
+    HibernateTuner::recordSample(path, tuning.key, tuning.imageBytes, image, resumeSeconds);
+    if (image.writeSeconds >= 0) {
+        m_metrics.observe(QStringLiteral("rtcwake_daemon_hibernate_image_write_seconds"), image.writeSeconds);
+    }
+    if (image.readSeconds >= 0) {
+        m_metrics.observe(QStringLiteral("rtcwake_daemon_hibernate_image_read_seconds"), image.readSeconds);
+    }
+
+    const auto stats = HibernateTuner::loadStats(path);
+    const QString best = HibernateTuner::bestSetting(stats);
+    const auto seconds = [](double value) {
+        return value < 0 ? QStringLiteral("unknown") : QString::number(value, 'f', 2);
+    };
+    log(tr("Hibernated with %1: image written in %2 s, read in %3 s, resumed %4 s after the planned wake")
+            .arg(tuning.key, seconds(image.writeSeconds), seconds(image.readSeconds), seconds(resumeSeconds)));
+    appendPersistentLog(QStringLiteral("hibernate_tuning"),
+                        {{QStringLiteral("status"), QStringLiteral("measured")},
+                         {QStringLiteral("setting"), tuning.key},
+                         {QStringLiteral("image_kib"), QString::number(image.writtenKiB)},
+                         {QStringLiteral("write_s"), seconds(image.writeSeconds)},
+                         {QStringLiteral("read_s"), seconds(image.readSeconds)},
+                         {QStringLiteral("resume_s"), seconds(resumeSeconds)},
+                         {QStringLiteral("samples"), QString::number(stats.value(tuning.key).count)},
+                         {QStringLiteral("best"), best.isEmpty() ? tr("<undecided>") : best}});
+}
+
+void RtcWakeDaemon::finishTransition() {
+    m_clock->singleShot(0, this, [this]() {
+        if (m_reloadDeferred) {
+            m_reloadDeferred = false;
+            reloadConfig();
+            return;
+        }
+        planNext(tr("Action completed"));
+    });
+}
+
+void RtcWakeDaemon::configureIdleSuspend() {
+    const auto &prefs = m_config.idleSuspend;
+    m_idleWindowTimer->stop();
+    if (!prefs.enabled) {
+        m_idleMonitor->stop();
+        return;
+    }
+    if (prefs.requireSessionIdle) {
+        ensureLogindWatcher();
     }
+    m_idleMonitor->setSessionIdle(!prefs.requireSessionIdle || !m_logind || m_logind->idleHint());
 
-    QTimer::singleShot(0, this, [this]() { planNext(tr("Action completed")); });
+    const QDateTime now = m_clock->now();
+    QDateTime boundary;
+    const bool inside = idleWindowContains(prefs, now, boundary);
+    if (boundary.isValid()) {
+        m_idleWindowTimer->start(now.msecsTo(boundary));
+    }
+    if (!inside || m_transitionActive || !m_frozenSlice.isEmpty()) {
+        m_idleMonitor->stop();
+        return;
+    }
+    IdleSuspendMonitor::Settings settings;
+    settings.idleMs = qint64(prefs.idleMinutes) * 60 * 1000;
+    settings.pressurePercent = prefs.pressurePercent;
+    m_idleMonitor->start(settings);
+}
+
+void RtcWakeDaemon::ensureLogindWatcher() {
+    if (m_logind) {
+        return;
+    }
+    m_logind = new LogindWatcher(this);
+    connect(m_logind, &LogindWatcher::sessionsChanged, this, [this]() { m_userSession = SessionLocator::Session(); });
+    connect(m_logind, &LogindWatcher::idleHintChanged, this, [this](bool idle) {
+        if (m_config.idleSuspend.enabled && m_config.idleSuspend.requireSessionIdle) {
+            m_idleMonitor->setSessionIdle(idle);
+        }
+        if (m_config.returnToSleep.watchSession) {
+            m_activityMonitor->setSessionIdle(idle);
+        }
+    });
+}
+
+void RtcWakeDaemon::handleSystemIdle() {
+    TraceScope trace("daemon", "handleSystemIdle");
+    const QDateTime now = m_clock->now();
+    const auto action = static_cast<PowerAction>(m_config.idleSuspend.actionId);
+    QString skipReason;
+    if (m_transitionActive) {
+        skipReason = QStringLiteral("transition_active");
+    } else if (!m_frozenSlice.isEmpty()) {
+        skipReason = QStringLiteral("session_frozen");
+    } else if (m_maintenance.isRunning()) {
+        skipReason = QStringLiteral("maintenance_running");
+    } else if (action == PowerAction::None || action == PowerAction::PowerOff
+               || action == PowerAction::FreezeUserSession) {
+        skipReason = QStringLiteral("unsupported_action");
+    } else if (!m_nextWake.isValid() || now.secsTo(m_nextWake) < kMinSleepSecs) {
+        // Without a planned wake the machine would sleep until someone presses a key.
+        skipReason = QStringLiteral("no_wake");
+    }
+    if (!skipReason.isEmpty()) {
+        log(tr("System idle but not suspending (%1)").arg(skipReason));
+        appendPersistentLog(QStringLiteral("idle_suspend"),
+                            {{QStringLiteral("status"), QStringLiteral("skipped")},
+                             {QStringLiteral("reason"), skipReason}});
+        return;
+    }
+
+    const auto outcome = invokeWarning(now, action);
+    if (outcome != WarningOutcome::Apply) {
+        // Someone is there after all; measure a fresh idle period.
+        log(tr("Idle suspend declined from the warning dialog"));
+        appendPersistentLog(QStringLiteral("idle_suspend"),
+                            {{QStringLiteral("status"), QStringLiteral("declined")},
+                             {QStringLiteral("outcome"), outcome == WarningOutcome::Snooze ? QStringLiteral("snooze")
+                                                                                            : QStringLiteral("cancel")}});
+        configureIdleSuspend();
+        return;
+    }
+
+    const QString plannedLabel = m_nextShutdown.isValid() ? formatDateTime(m_nextShutdown) : tr("<none>");
+    m_eventTimer->stop();
+    m_snoozeActive = false;
+    m_nextShutdown = now;
+    m_nextAction = action;
+    m_metrics.increment(QStringLiteral("rtcwake_daemon_idle_suspends_total"));
+    log(tr("System idle for %1 minutes; %2 until %3 instead of waiting for %4")
+            .arg(m_config.idleSuspend.idleMinutes)
+            .arg(RtcWakeController::actionLabel(action), formatDateTime(m_nextWake), plannedLabel));
+    appendPersistentLog(QStringLiteral("idle_suspend"),
+                        {{QStringLiteral("status"), QStringLiteral("applied")},
+                         {QStringLiteral("action"), RtcWakeController::actionLabel(action)},
+                         {QStringLiteral("idle_minutes"), QString::number(m_config.idleSuspend.idleMinutes)},
+                         {QStringLiteral("planned_shutdown"), plannedLabel},
+                         {QStringLiteral("wake"), formatDateTime(m_nextWake)}});
+    executeTransition(CycleHistoryStore::IdleSuspend);
+    finishTransition();
 }
 
 void RtcWakeDaemon::programAlarm(const QDateTime &wake, PowerAction action) {
+    TraceScope trace("daemon", "programAlarm");
     const QString wakeLabel = wake.isValid() ? formatDateTime(wake) : tr("<invalid wake time>");
-    auto result = m_controller.programAlarm(wake.toUTC());
+    QDateTime rtcAlarm = rtcAlarmFor(wake.isValid() ? wake.addMSecs(-readyLeadMs(action)) : wake);
+    const QDateTime reach = m_clock->now().addSecs(m_alarmRangeSecs - kChainMarginSecs);
+    if (m_alarmRangeSecs > 0 && rtcAlarm > reach) {
+        // A safety net only; the sleep itself chains alarms up to the real wake.
+        rtcAlarm = reach;
+    }
+    auto result = m_controller->programAlarm(rtcAlarm.toUTC());
+    const QString mode = modeLabel(QStringLiteral("no"));
+    m_metrics.increment(QStringLiteral("rtcwake_daemon_alarm_programs_total"));
+    m_metrics.observe(QStringLiteral("rtcwake_daemon_rtcwake_duration_seconds"), result.elapsedMs / 1000.0, mode);
     if (result.success) {
+        m_armedAlarm = wake;
+        m_armedRtcSecs = rtcAlarm.toSecsSinceEpoch();
         log(tr("Programmed rtcwake for %1 via: %2")
                 .arg(wakeLabel,
                      result.commandLine.isEmpty() ? tr("<unknown command>") : result.commandLine));
     } else {
+        m_armedAlarm = QDateTime();
+        m_metrics.increment(QStringLiteral("rtcwake_daemon_rtcwake_failures_total"), mode);
         log(tr("Failed to program rtcwake for %1 via %2: %3")
                 .arg(wakeLabel,
                      result.commandLine.isEmpty() ? tr("<unknown command>") : result.commandLine,
@@ -227,17 +1001,449 @@ void RtcWakeDaemon::programAlarm(const QDateTime &wake, PowerAction action) {
                          {QStringLiteral("stderr"), result.stdErr.isEmpty() ? tr("<empty>") : result.stdErr}});
 }
 
+void RtcWakeDaemon::configureRtc() {
+    const auto &prefs = m_config.rtc;
+    if (m_rtcConfigured && prefs.device == m_rtcPreferences.device && prefs.maxAlarmHours == m_rtcPreferences.maxAlarmHours) {
+        return;
+    }
+    m_rtcConfigured = true;
+    m_rtcPreferences = prefs;
+
+    const QString selected = RtcDeviceProbe(m_options.sysRoot).select(prefs.device);
+    if (!prefs.device.isEmpty() && selected != prefs.device) {
+        log(tr("RTC %1 cannot wake the system; using %2 instead")
+                .arg(prefs.device, selected.isEmpty() ? tr("rtcwake's default") : selected));
+    }
+    m_controller->setDevice(selected);
+
+    QString source;
+    if (prefs.maxAlarmHours > 0) {
+        m_alarmRangeSecs = prefs.maxAlarmHours * 3600LL;
+        source = QStringLiteral("config");
+    } else {
+        const qint64 probed = m_controller->alarmRangeSecs();
+        // Whatever takes the longest candidate reaches further than any plan looks ahead.
+        m_alarmRangeSecs = probed >= RtcDeviceProbe::rangeCandidates().first() ? 0 : probed;
+        source = QStringLiteral("probe");
+    }
+    // The probe may have cleared the armed alarm; make sure the next plan re-arms it.
+    m_armedAlarm = QDateTime();
+    m_armedRtcSecs = 0;
+    log(tr("Waking from %1; alarm range %2")
+            .arg(m_controller->device(),
+                 m_alarmRangeSecs > 0 ? tr("%1 h").arg(m_alarmRangeSecs / 3600.0, 0, 'f', 1) : tr("unlimited")));
+    appendPersistentLog(QStringLiteral("rtc"),
+                        {{QStringLiteral("device"), m_controller->device()},
+                         {QStringLiteral("range_s"), QString::number(m_alarmRangeSecs)},
+                         {QStringLiteral("source"), source}});
+}
+
+void RtcWakeDaemon::configureEnergy() {
+    const auto &prefs = m_config.energy;
+    if (!prefs.enabled) {
+        m_energyEnabled = false;
+        m_energyTimer->stop();
+        return;
+    }
+    if (!m_energyEnabled) {
+        m_energyEnabled = true;
+        m_awakeEnergy = m_energy.sample();
+        log(tr("Energy accounting: RAPL %1, battery %2")
+                .arg(m_awakeEnergy.hasRapl ? tr("available") : tr("unavailable"),
+                     m_awakeEnergy.hasBattery ? tr("available") : tr("unavailable")));
+    }
+    // Only RAPL wraps; batteries are read around transitions alone.
+    const qint64 intervalMs = prefs.sampleMinutes > 0 ? prefs.sampleMinutes * 60000LL : m_energy.wrapSafeIntervalMs();
+    if (intervalMs <= 0) {
+        m_energyTimer->stop();
+        return;
+    }
+    if (!m_energyTimer->isActive() || m_energyTimer->interval() != intervalMs) {
+        m_energyTimer->setSingleShot(false);
+        m_energyTimer->setInterval(intervalMs);
+        m_energyTimer->start(intervalMs);
+    }
+}
+
+EnergyMeter::Energy RtcWakeDaemon::sampleEnergy(bool acrossSleep) {
+    return m_energyEnabled ? m_energy.sample(acrossSleep) : EnergyMeter::Energy();
+}
+
+void RtcWakeDaemon::recordEnergy(const EnergyMeter::Energy &start, const EnergyMeter::Energy &beforeSleep,
+                                 const EnergyMeter::Energy &afterSleep, const EnergyMeter::Energy &end) {
+    m_cycleEnergy = CycleEnergy();
+    if (!m_energyEnabled) {
+        return;
+    }
+    const auto entering = EnergyMeter::since(start, beforeSleep);
+    const auto resuming = EnergyMeter::since(afterSleep, end);
+    m_cycleEnergy.awake = EnergyMeter::since(m_awakeEnergy, start);
+    m_cycleEnergy.asleep = EnergyMeter::since(beforeSleep, afterSleep);
+    m_cycleEnergy.transition.hasRapl = entering.hasRapl && resuming.hasRapl;
+    m_cycleEnergy.transition.raplUj = entering.raplUj + resuming.raplUj;
+    m_cycleEnergy.transition.hasBattery = entering.hasBattery && resuming.hasBattery;
+    m_cycleEnergy.transition.batteryUj = entering.batteryUj + resuming.batteryUj;
+    m_awakeEnergy = end;
+
+    using Energy = EnergyMeter::Energy;
+    const auto report = [this](const QString &source, bool Energy::*available, qint64 Energy::*uj) {
+        const QList<QPair<QString, const Energy *>> phases {{QStringLiteral("awake"), &m_cycleEnergy.awake},
+                                                             {QStringLiteral("asleep"), &m_cycleEnergy.asleep},
+                                                             {QStringLiteral("transition"), &m_cycleEnergy.transition}};
+        if (!(m_cycleEnergy.asleep.*available) && !(m_cycleEnergy.transition.*available)) {
+            return;
+        }
+        QList<QPair<QString, QString>> fields {{QStringLiteral("source"), source}};
+        for (const auto &phase : phases) {
+            const Energy &energy = *phase.second;
+            if (energy.*available && energy.*uj > 0) {
+                m_metrics.increment(QStringLiteral("rtcwake_daemon_energy_joules_total"),
+                                    QStringLiteral("phase=\"%1\",source=\"%2\"").arg(phase.first, source), energy.*uj / 1e6);
+            }
+            fields.append({phase.first + QStringLiteral("_j"),
+                           energy.*available ? QString::number(energy.*uj / 1e6, 'f', 3) : QStringLiteral("unknown")});
+        }
+        appendPersistentLog(QStringLiteral("energy"), fields);
+    };
+    report(QStringLiteral("rapl"), &Energy::hasRapl, &Energy::raplUj);
+    report(QStringLiteral("battery"), &Energy::hasBattery, &Energy::batteryUj);
+}
+
+RtcWakeController::CommandResult RtcWakeDaemon::sleepUntil(const QDateTime &alarm, PowerAction action) {
+    QStringList commands;
+    qint64 elapsedMs = 0;
+    const auto finish = [&](RtcWakeController::CommandResult result) {
+        commands << result.commandLine;
+        result.commandLine = commands.join(QStringLiteral(" && "));
+        result.elapsedMs += elapsedMs;
+        return result;
+    };
+
+    QDateTime target = alarm;
+    const qint64 reachSecs = m_alarmRangeSecs - kChainMarginSecs;
+    if (m_alarmRangeSecs > 0 && action == PowerAction::PowerOff && m_clock->now().secsTo(target) > reachSecs) {
+        // Nothing runs while the machine is off to re-arm the next link: boot early instead of never.
+        target = m_clock->now().addSecs(reachSecs);
+        log(tr("%1 is beyond the RTC's alarm range; powering on at %2 instead")
+                .arg(formatDateTime(alarm), formatDateTime(target)));
+        appendPersistentLog(QStringLiteral("rtc_chain"),
+                            {{QStringLiteral("status"), QStringLiteral("clamped")},
+                             {QStringLiteral("target"), formatDateTime(alarm)},
+                             {QStringLiteral("alarm"), formatDateTime(target)}});
+    }
+    for (int link = 1; m_alarmRangeSecs > 0 && m_clock->now().secsTo(target) > reachSecs; ++link) {
+        const QDateTime hop = m_clock->now().addSecs(reachSecs);
+        auto result = enterSleep(rtcAlarmFor(hop).toUTC(), action);
+        const QDateTime resumed = m_clock->now();
+        QString status = QStringLiteral("relinked");
+        if (!result.success) {
+            status = QStringLiteral("failed");
+        } else if (resumed.msecsTo(hop) > kInterimWakeToleranceMs) {
+            status = QStringLiteral("woken_early");
+        }
+        log(tr("Chained alarm %1 at %2 for %3: %4")
+                .arg(link)
+                .arg(formatDateTime(hop), formatDateTime(target), status));
+        appendPersistentLog(QStringLiteral("rtc_chain"),
+                            {{QStringLiteral("status"), status},
+                             {QStringLiteral("link"), QString::number(link)},
+                             {QStringLiteral("alarm"), formatDateTime(hop)},
+                             {QStringLiteral("target"), formatDateTime(target)}});
+        if (status != QStringLiteral("relinked")) {
+            return finish(result);
+        }
+        commands << result.commandLine;
+        elapsedMs += result.elapsedMs;
+    }
+    return finish(enterSleep(rtcAlarmFor(target).toUTC(), action));
+}
+
+RtcWakeController::CommandResult RtcWakeDaemon::enterSleep(const QDateTime &alarmUtc, PowerAction action) {
+    const auto &prefs = m_config.sleepEntry;
+    const QString statsPath = statePath(QStringLiteral("sleep-modes.json"));
+    const QString requested = RtcWakeController::rtcwakeMode(action);
+    QList<PowerAction> modes {action};
+    if (action != PowerAction::PowerOff) {
+        // Nothing is left running to notice a failed power-off, so only sleeps fall back.
+        const auto stats = prefs.adaptiveOrder ? SleepModeStats::load(statsPath) : QMap<QString, SleepModeStats::Counts>();
+        for (const auto &mode : SleepModeStats::fallbackOrder(requested, prefs.fallbackModes, stats)) {
+            const PowerAction fallback = actionForMode(mode);
+            if (fallback != PowerAction::None) {
+                modes << fallback;
+            }
+        }
+    }
+
+    RtcWakeController::CommandResult result;
+    QStringList commands;
+    qint64 elapsedMs = 0;
+    const auto finish = [&]() {
+        result.commandLine = commands.join(QStringLiteral(" || "));
+        result.elapsedMs = elapsedMs;
+        return result;
+    };
+    const int attempts = std::max(1, prefs.maxAttempts);
+    for (const PowerAction mode : modes) {
+        const QString modeName = RtcWakeController::rtcwakeMode(mode);
+        if (mode != action) {
+            log(tr("Could not sleep in %1; trying %2 instead").arg(requested, modeName));
+            appendPersistentLog(QStringLiteral("sleep_entry"),
+                                {{QStringLiteral("status"), QStringLiteral("fallback")},
+                                 {QStringLiteral("mode"), modeName},
+                                 {QStringLiteral("requested"), requested}});
+            if (mode == PowerAction::Hibernate) {
+                prepareHibernate();
+            } else {
+                m_hibernateTuning = HibernateTuner::Applied();
+            }
+        }
+        qint64 backoffMs = prefs.backoffSeconds * 1000LL;
+        for (int attempt = 1; attempt <= attempts; ++attempt) {
+            if (attempt > 1) {
+                if (m_clock->now().msecsTo(alarmUtc) <= backoffMs + kInterimWakeToleranceMs) {
+                    log(tr("Not retrying: the alarm at %1 is too close").arg(formatDateTime(alarmUtc)));
+                    return finish();
+                }
+                // Let whatever raced the last attempt settle before trying again.
+                m_clock->pause(backoffMs);
+                backoffMs = std::min(backoffMs * 2, prefs.maxBackoffSeconds * 1000LL);
+            }
+            QString status;
+            if (mode != PowerAction::PowerOff
+                && m_controller->armWakeupCount() == WakeupCountGate::Result::Pending) {
+                result = RtcWakeController::CommandResult();
+                result.stdErr = tr("a wakeup event arrived while preparing to sleep");
+                status = QStringLiteral("wakeup_pending");
+            } else {
+                m_wakeBaseline = m_wakeProbe.snapshot();
+                const qint64 sleptBeforeMs = m_clock->bootMs() - m_clock->monotonicMs();
+                result = m_controller->scheduleWake(alarmUtc, mode);
+                commands << result.commandLine;
+                elapsedMs += result.elapsedMs;
+                const bool slept = m_clock->bootMs() - m_clock->monotonicMs() > sleptBeforeMs;
+                if (result.success && !slept && mode != PowerAction::PowerOff
+                    && m_clock->now().msecsTo(alarmUtc) > kInterimWakeToleranceMs) {
+                    // An aborted suspend can still exit 0: the machine never left this state.
+                    result.success = false;
+                    result.stdErr = tr("rtcwake returned without sleeping");
+                }
+                SleepModeStats::record(statsPath, modeName, result.success, m_clock->now());
+                status = result.success ? QStringLiteral("entered") : QStringLiteral("failed");
+            }
+            m_metrics.increment(QStringLiteral("rtcwake_daemon_sleep_attempts_total"),
+                                QStringLiteral("mode=\"%1\",result=\"%2\"").arg(modeName, status));
+            if (result.success) {
+                if (attempt > 1 || mode != action) {
+                    appendPersistentLog(QStringLiteral("sleep_entry"),
+                                        {{QStringLiteral("status"), status},
+                                         {QStringLiteral("mode"), modeName},
+                                         {QStringLiteral("attempt"), QString::number(attempt)}});
+                }
+                return finish();
+            }
+            log(tr("Attempt %1 of %2 to sleep in %3 failed: %4")
+                    .arg(attempt)
+                    .arg(attempts)
+                    .arg(modeName, result.stdErr.isEmpty() ? tr("<no stderr>") : result.stdErr));
+            appendPersistentLog(QStringLiteral("sleep_entry"),
+                                {{QStringLiteral("status"), status},
+                                 {QStringLiteral("mode"), modeName},
+                                 {QStringLiteral("attempt"), QString::number(attempt)},
+                                 {QStringLiteral("exit"), QString::number(result.exitCode)}});
+        }
+    }
+    return finish();
+}
+
+qint32 RtcWakeDaemon::recordWakeReason(const QDateTime &resumed) {
+    const QDateTime alarm = readyAlarm();
+    const auto attribution = m_wakeProbe.attribute(m_wakeBaseline, m_wakeProbe.snapshot());
+    const auto verdict = WakeReasonProbe::classify(alarm, resumed, attribution);
+    const QString source = attribution.primary();
+    const QString label = WakeReasonProbe::verdictLabel(verdict);
+    const double offsetSeconds = alarm.msecsTo(resumed) / 1000.0;
+
+    WakeReasonProbe::recordWake(statePath(QStringLiteral("wake-sources.json")), source, verdict, resumed);
+    m_metrics.increment(QStringLiteral("rtcwake_daemon_wakeups_total"),
+                        QStringLiteral("source=\"%1\",verdict=\"%2\"").arg(sanitizeSingleLine(source).remove(QLatin1Char('"')), label));
+    if (verdict != WakeReasonProbe::Verdict::OnTime) {
+        log(tr("Woke %1 s %2 the alarm at %3 (%4); source %5")
+                .arg(std::abs(offsetSeconds), 0, 'f', 1)
+                .arg(offsetSeconds < 0 ? tr("before") : tr("after"), formatDateTime(alarm), label, source));
+    }
+    appendPersistentLog(QStringLiteral("wake"),
+                        {{QStringLiteral("verdict"), label},
+                         {QStringLiteral("source"), source},
+                         {QStringLiteral("sources"), attribution.sources.join(QLatin1Char(','))},
+                         {QStringLiteral("irq"), attribution.irq},
+                         {QStringLiteral("alarm"), formatDateTime(alarm)},
+                         {QStringLiteral("resumed"), formatDateTime(resumed)},
+                         {QStringLiteral("offset_s"), QString::number(offsetSeconds, 'f', 1)}});
+    switch (verdict) {
+    case WakeReasonProbe::Verdict::Early:
+        return CycleHistoryStore::EarlyWake;
+    case WakeReasonProbe::Verdict::Late:
+    case WakeReasonProbe::Verdict::Missed:
+        return CycleHistoryStore::LateWake;
+    case WakeReasonProbe::Verdict::OnTime:
+    default:
+        return 0;
+    }
+}
+
+QDateTime RtcWakeDaemon::rtcAlarmFor(const QDateTime &wake) const {
+    if (!wake.isValid()) {
+        return wake;
+    }
+    const QString device = m_controller->device();
+    const qint64 sleepMs = m_clock->now().msecsTo(wake);
+    // rtcwake takes whole seconds; an RTC running fast fires early, so arm it later.
+    const qint64 shiftSecs = std::llround(m_drift.predictGainMs(device, sleepMs) / 1000.0);
+    if (shiftSecs == 0) {
+        return wake;
+    }
+    const auto estimate = m_drift.estimate(device);
+    const double expectedErrorSecs = estimate.stdErrorPpm * 1e-6 * sleepMs / 1000.0;
+    log(tr("Arming %1 %2 s %3 for the wake at %4: drift %5 ppm, expected error ±%6 s")
+            .arg(device)
+            .arg(std::abs(shiftSecs))
+            .arg(shiftSecs > 0 ? tr("later") : tr("earlier"), formatDateTime(wake))
+            .arg(estimate.ppm, 0, 'f', 1)
+            .arg(std::max(0.0, expectedErrorSecs), 0, 'f', 1));
+    return wake.addSecs(shiftSecs);
+}
+
+qint64 RtcWakeDaemon::readyLeadMs(PowerAction action) const {
+    const auto &prefs = m_config.wakeLead;
+    if (!prefs.enabled) {
+        return 0;
+    }
+    return m_resumeStats.leadMs(action, prefs.percentile / 100.0, static_cast<quint32>(prefs.minSamples),
+                                prefs.maxLeadMinutes * 60000LL);
+}
+
+QDateTime RtcWakeDaemon::readyAlarm() const {
+    return m_nextWake.isValid() ? m_nextWake.addMSecs(-m_readyLeadMs) : m_nextWake;
+}
+
+void RtcWakeDaemon::measureBoot(const QDateTime &alarm, const QDateTime &wake) {
+    if (m_bootProbe) {
+        return;
+    }
+    // The plan moves on to the next cycle long before a slow boot finishes; keep this one's times.
+    m_bootProbe = new BootTimingProbe(m_options.procRoot, this);
+    connect(m_bootProbe, &BootTimingProbe::finished, this,
+            [this, alarm, wake](const BootTimingProbe::Timing &timing) { recordBootTiming(alarm, wake, timing); });
+    m_bootProbe->start();
+}
+
+void RtcWakeDaemon::recordBootTiming(const QDateTime &alarm, const QDateTime &wake, const BootTimingProbe::Timing &timing) {
+    const auto seconds = [](const QDateTime &from, const QDateTime &to) {
+        return from.isValid() && to.isValid() ? QString::number(from.msecsTo(to) / 1000.0, 'f', 1) : QStringLiteral("-");
+    };
+    // Boot readiness is the power-off counterpart of the resume latency: alarm to default target.
+    const double readySeconds = alarm.msecsTo(timing.ready) / 1000.0;
+    if (readySeconds >= 0) {
+        m_resumeStats.record(PowerAction::PowerOff, readySeconds);
+        m_resumeStats.save(statePath(QStringLiteral("resume-latency.json")));
+        m_metrics.observe(QStringLiteral("rtcwake_daemon_resume_latency_seconds"), readySeconds,
+                          modeLabel(RtcWakeController::rtcwakeMode(PowerAction::PowerOff)));
+    }
+    const double slackSeconds = timing.ready.msecsTo(wake) / 1000.0;
+    log(tr("Booted by the alarm at %1 and ready %2 s later at %3; slack to the wake at %4: %5 s")
+            .arg(formatDateTime(alarm))
+            .arg(readySeconds, 0, 'f', 1)
+            .arg(formatDateTime(timing.ready), formatDateTime(wake))
+            .arg(slackSeconds, 0, 'f', 1));
+    log(tr("Resume latency %1").arg(m_resumeStats.summary(PowerAction::PowerOff)));
+    appendPersistentLog(QStringLiteral("boot"),
+                        {{QStringLiteral("wake"), formatDateTime(wake)},
+                         {QStringLiteral("alarm"), formatDateTime(alarm)},
+                         {QStringLiteral("ready"), formatDateTime(timing.ready)},
+                         {QStringLiteral("firmware_s"), seconds(timing.poweredOn, timing.kernelStarted)},
+                         {QStringLiteral("kernel_s"), seconds(timing.kernelStarted, timing.userspaceStarted)},
+                         {QStringLiteral("userspace_s"), seconds(timing.userspaceStarted, timing.ready)},
+                         {QStringLiteral("ready_s"), QString::number(readySeconds, 'f', 1)},
+                         {QStringLiteral("slack_s"), QString::number(slackSeconds, 'f', 1)},
+                         {QStringLiteral("p90_s"), QString::number(m_resumeStats.percentile(PowerAction::PowerOff, 0.9), 'f', 1)}});
+}
+
+void RtcWakeDaemon::startDriftProbe(qint64 sleptMs, qint64 resumeWallOffsetMs) {
+    m_driftSleptMs = sleptMs;
+    m_driftResumeOffsetMs = resumeWallOffsetMs;
+    const quint64 probe = m_driftProbe;
+    m_clock->singleShot(kDriftSettleMs, this, [this, probe]() { finishDriftProbe(probe, 1); });
+}
+
+void RtcWakeDaemon::finishDriftProbe(quint64 probe, int attempt) {
+    if (probe != m_driftProbe) {
+        // Another transition started; its resume gets a probe of its own.
+        return;
+    }
+    const QString device = m_controller->device();
+    if (!m_clock->isSynchronized()) {
+        if (attempt < kDriftProbeAttempts) {
+            m_clock->singleShot(kDriftSettleMs, this, [this, probe, attempt]() { finishDriftProbe(probe, attempt + 1); });
+            return;
+        }
+        appendPersistentLog(QStringLiteral("rtc_drift"),
+                            {{QStringLiteral("status"), QStringLiteral("unsynchronized")}, {QStringLiteral("device"), device}});
+        return;
+    }
+
+    // The kernel set the wall clock from the RTC on resume; whatever NTP had to correct
+    // since then is how far the RTC drifted while the machine slept.
+    const QDateTime now = m_clock->now();
+    const qint64 correctionMs = now.toMSecsSinceEpoch() - m_clock->rawMonotonicMs() - m_driftResumeOffsetMs;
+    const qint64 gainMs = -correctionMs;
+    const bool learned = m_drift.addSample(device, m_driftSleptMs, gainMs, now);
+    if (learned) {
+        m_drift.save(statePath(QStringLiteral("rtc-drift.json")));
+    }
+    const auto estimate = m_drift.estimate(device);
+
+    // The RTC against the NTP-disciplined clock right now, for comparison; since_epoch
+    // has whole seconds, so the reading is taken from the middle of its second.
+    const qint64 rtcSecs = m_controller->currentRtcTime();
+    const QString rtcOffset = rtcSecs < 0 ? tr("unknown")
+                                          : QString::number((rtcSecs * 1000 + 500 - now.toMSecsSinceEpoch()) / 1000.0, 'f', 1);
+    log(tr("RTC %1 %2 %3 s over %4 h asleep; drift %5")
+            .arg(device, gainMs >= 0 ? tr("gained") : tr("lost"))
+            .arg(std::abs(gainMs) / 1000.0, 0, 'f', 1)
+            .arg(m_driftSleptMs / 3600000.0, 0, 'f', 1)
+            .arg(learned ? m_drift.summary(device) : tr("sample ignored")));
+    appendPersistentLog(QStringLiteral("rtc_drift"),
+                        {{QStringLiteral("status"), learned ? QStringLiteral("sample") : QStringLiteral("ignored")},
+                         {QStringLiteral("device"), device},
+                         {QStringLiteral("slept_s"), QString::number(m_driftSleptMs / 1000)},
+                         {QStringLiteral("gain_s"), QString::number(gainMs / 1000.0, 'f', 1)},
+                         {QStringLiteral("rtc_offset_s"), rtcOffset},
+                         {QStringLiteral("ppm"), QString::number(estimate.ppm, 'f', 1)},
+                         {QStringLiteral("error_ppm"), QString::number(estimate.stdErrorPpm, 'f', 1)},
+                         {QStringLiteral("samples"), QString::number(estimate.samples)}});
+}
+
 RtcWakeDaemon::WarningOutcome RtcWakeDaemon::invokeWarning(const QDateTime &shutdown, PowerAction action) {
+    TraceScope trace("daemon", "invokeWarning");
     if (!m_config.warning.enabled || m_options.warningApp.isEmpty()) {
         return WarningOutcome::Apply;
     }
 
+    const auto session = userSession();
+    if (!session.graphical()) {
+        log(tr("No session of %1 has a live display; applying without a warning").arg(m_options.targetUser));
+        appendPersistentLog(QStringLiteral("warning"),
+                            {{QStringLiteral("outcome"), QStringLiteral("skipped")},
+                             {QStringLiteral("reason"), QStringLiteral("no_display")}});
+        return WarningOutcome::Apply;
+    }
+
     QString program = QStringLiteral("runuser");
     QStringList args;
     args << QStringLiteral("-u") << m_options.targetUser
          << QStringLiteral("--") << QStringLiteral("env");
 
-    const auto env = buildUserEnvironment();
+    const auto env = buildUserEnvironment(session);
     if (!env.value(QStringLiteral("DISPLAY")).isEmpty()) {
         args << QStringLiteral("DISPLAY=") + env.value(QStringLiteral("DISPLAY"));
     }
@@ -281,11 +1487,31 @@ RtcWakeDaemon::WarningOutcome RtcWakeDaemon::invokeWarning(const QDateTime &shut
     args << QStringLiteral("--action") << RtcWakeController::actionLabel(action);
 
     QProcess process;
+    QElapsedTimer responseTimer;
+    responseTimer.start();
     process.start(program, args);
-    if (!process.waitForStarted() || !process.waitForFinished(-1)) {
+    if (!process.waitForStarted()) {
         log(tr("Failed to start warning dialog"));
         return WarningOutcome::Apply;
     }
+    // The banner applies by itself when the countdown ends; a helper still running well
+    // past that is stuck on a display that went away.
+    const int limitSeconds = std::max(m_config.warning.countdownSeconds, 0) + kWarningGraceSeconds;
+    if (!process.waitForFinished(limitSeconds * 1000)) {
+        // runuser passes SIGTERM on to the helper; SIGKILL would leave the helper behind.
+        process.terminate();
+        if (!process.waitForFinished(2000)) {
+            process.kill();
+            process.waitForFinished(1000);
+        }
+        m_userSession = SessionLocator::Session();
+        log(tr("Warning dialog did not answer within %1 s; applying").arg(limitSeconds));
+        appendPersistentLog(QStringLiteral("warning"),
+                            {{QStringLiteral("outcome"), QStringLiteral("skipped")},
+                             {QStringLiteral("reason"), QStringLiteral("timeout")}});
+        return WarningOutcome::Apply;
+    }
+    m_metrics.observe(QStringLiteral("rtcwake_daemon_warning_response_seconds"), responseTimer.elapsed() / 1000.0);
 
     const QString stdoutText = QString::fromLocal8Bit(process.readAllStandardOutput()).trimmed();
     const QString stderrText = QString::fromLocal8Bit(process.readAllStandardError()).trimmed();
@@ -296,6 +1522,14 @@ RtcWakeDaemon::WarningOutcome RtcWakeDaemon::invokeWarning(const QDateTime &shut
                 .arg(stdoutText.isEmpty() ? QStringLiteral("<empty>") : stdoutText)
                 .arg(stderrText.isEmpty() ? QStringLiteral("<empty>") : stderrText));
     }
+    // runuser reports a helper killed by a signal as 128 + signal, e.g. when its display died.
+    if (process.exitStatus() == QProcess::CrashExit || exitCode >= 128) {
+        m_userSession = SessionLocator::Session();
+        appendPersistentLog(QStringLiteral("warning"),
+                            {{QStringLiteral("outcome"), QStringLiteral("skipped")},
+                             {QStringLiteral("reason"), QStringLiteral("crashed")}});
+        return WarningOutcome::Apply;
+    }
     if (exitCode == 0) {
         return WarningOutcome::Apply;
     }
@@ -305,22 +1539,49 @@ RtcWakeDaemon::WarningOutcome RtcWakeDaemon::invokeWarning(const QDateTime &shut
     return WarningOutcome::Cancel;
 }
 
-QProcessEnvironment RtcWakeDaemon::buildUserEnvironment() const {
+SessionLocator::Session RtcWakeDaemon::userSession() {
+    if (m_userSession.graphical() && m_sessionLocator.alive(m_userSession)) {
+        return m_userSession;
+    }
+    m_userSession = SessionLocator::Session();
+    const qint64 uid = targetUserId();
+    if (uid >= 0) {
+        // logind narrows the scan to open local sessions (the active one first) and reports when that changes.
+        ensureLogindWatcher();
+        const auto sessions = m_sessionLocator.discover(static_cast<uint>(uid), m_logind->graphicalSessions(static_cast<uint>(uid)));
+        if (!sessions.isEmpty()) {
+            m_userSession = sessions.first();
+            const QString display = m_userSession.waylandDisplay.isEmpty() ? m_userSession.display : m_userSession.waylandDisplay;
+            log(tr("Warning goes to session %1 on %2 (from process %3)")
+                    .arg(m_userSession.id.isEmpty() ? tr("<unknown>") : m_userSession.id, display)
+                    .arg(m_userSession.pid));
+            return m_userSession;
+        }
+    }
+    // What the GUI saved at its last start is only good while that display is still up.
+    const auto saved = SessionLocator::fromSessionInfo(m_config.session);
+    if (saved.graphical() && m_sessionLocator.alive(saved)) {
+        m_userSession = saved;
+    }
+    return m_userSession;
+}
+
+QProcessEnvironment RtcWakeDaemon::buildUserEnvironment(const SessionLocator::Session &session) const {
     QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
-    if (!m_config.session.display.isEmpty()) {
-        env.insert(QStringLiteral("DISPLAY"), m_config.session.display);
+    if (!session.display.isEmpty()) {
+        env.insert(QStringLiteral("DISPLAY"), session.display);
     }
-    if (!m_config.session.xdgRuntimeDir.isEmpty()) {
-        env.insert(QStringLiteral("XDG_RUNTIME_DIR"), m_config.session.xdgRuntimeDir);
+    if (!session.xdgRuntimeDir.isEmpty()) {
+        env.insert(QStringLiteral("XDG_RUNTIME_DIR"), session.xdgRuntimeDir);
     }
-    if (!m_config.session.dbusAddress.isEmpty()) {
-        env.insert(QStringLiteral("DBUS_SESSION_BUS_ADDRESS"), m_config.session.dbusAddress);
+    if (!session.dbusAddress.isEmpty()) {
+        env.insert(QStringLiteral("DBUS_SESSION_BUS_ADDRESS"), session.dbusAddress);
     }
-    if (!m_config.session.xauthority.isEmpty()) {
-        env.insert(QStringLiteral("XAUTHORITY"), m_config.session.xauthority);
+    if (!session.xauthority.isEmpty()) {
+        env.insert(QStringLiteral("XAUTHORITY"), session.xauthority);
     }
-    if (!m_config.session.waylandDisplay.isEmpty()) {
-        env.insert(QStringLiteral("WAYLAND_DISPLAY"), m_config.session.waylandDisplay);
+    if (!session.waylandDisplay.isEmpty()) {
+        env.insert(QStringLiteral("WAYLAND_DISPLAY"), session.waylandDisplay);
     }
     return env;
 }
@@ -329,7 +1590,463 @@ void RtcWakeDaemon::log(const QString &message) const {
     qInfo().noquote() << message;
 }
 
+ResumeLatencyStats::Measurement RtcWakeDaemon::recordResumeLatency(PowerAction action, const ResumeLatencyStats::ClockSample &before,
+                                                                   const ResumeLatencyStats::ClockSample &after, const QDateTime &alarm) {
+    // Measured from the alarm, not the wake time: the stats feed the lead that moves the alarm.
+    const auto measurement = ResumeLatencyStats::measure(before, after, alarm);
+    if (measurement.suspendedMs <= 0) {
+        log(tr("rtcwake returned without the system sleeping; no resume latency recorded"));
+        return measurement;
+    }
+
+    // A negative delay means the daemon ran before the planned time (early or foreign wake).
+    // Such a wake says nothing about resume latency and would drag the ready lead toward zero.
+    const double delaySeconds = measurement.wakeDelayMs / 1000.0;
+    if (measurement.wakeDelayMs >= 0) {
+        m_resumeStats.record(action, delaySeconds);
+        m_resumeStats.save(statePath(QStringLiteral("resume-latency.json")));
+        m_metrics.observe(QStringLiteral("rtcwake_daemon_resume_latency_seconds"), delaySeconds,
+                          modeLabel(RtcWakeController::rtcwakeMode(action)));
+    }
+
+    log(tr("Resumed from %1 after %2 s asleep, %3 s after the alarm at %4")
+            .arg(RtcWakeController::actionLabel(action))
+            .arg(measurement.suspendedMs / 1000.0, 0, 'f', 1)
+            .arg(delaySeconds, 0, 'f', 1)
+            .arg(formatDateTime(alarm)));
+    log(tr("Resume latency %1").arg(m_resumeStats.summary(action)));
+    appendPersistentLog(QStringLiteral("resume"),
+                        {{QStringLiteral("action"), RtcWakeController::actionLabel(action)},
+                         {QStringLiteral("planned_wake"), formatDateTime(m_nextWake)},
+                         {QStringLiteral("alarm"), formatDateTime(alarm)},
+                         {QStringLiteral("resumed"), formatDateTime(after.realtime)},
+                         {QStringLiteral("suspended_s"), QString::number(measurement.suspendedMs / 1000.0, 'f', 1)},
+                         {QStringLiteral("wake_delay_s"), QString::number(delaySeconds, 'f', 1)},
+                         {QStringLiteral("p90_s"), QString::number(m_resumeStats.percentile(action, 0.9), 'f', 1)}});
+    return measurement;
+}
+
+void RtcWakeDaemon::appendCycleRecord(CycleHistoryStore::Outcome outcome, const QDateTime &actualShutdown,
+                                      const QDateTime &actualResume, const ResumeLatencyStats::Measurement &measurement,
+                                      qint32 flags) {
+    if (!m_history.isOpen()) {
+        return;
+    }
+    const auto secs = [](const QDateTime &dt) { return dt.isValid() ? dt.toSecsSinceEpoch() : qint64(0); };
+
+    CycleHistoryStore::Record record;
+    record.plannedShutdown = secs(m_cyclePlannedShutdown);
+    record.actualShutdown = secs(actualShutdown);
+    record.plannedWake = secs(m_nextWake);
+    record.actualResume = secs(actualResume);
+    record.wakeLatencyMs = measurement.wakeDelayMs;
+    record.suspendedMs = measurement.suspendedMs;
+    record.action = static_cast<qint32>(m_nextAction);
+    record.outcome = static_cast<qint32>(outcome);
+    record.snoozeCount = m_snoozeCount;
+    record.flags = flags | (m_deferredMs > 0 ? CycleHistoryStore::DeferredForActivity : 0);
+    const CycleEnergy energy = std::exchange(m_cycleEnergy, CycleEnergy());
+    const auto millijoules = [](qint64 uj) { return std::max<qint64>(0, uj) / 1000; };
+    if (energy.asleep.hasRapl) {
+        record.energySources |= CycleHistoryStore::RaplEnergy;
+        record.awakeRaplMj = millijoules(energy.awake.raplUj);
+        record.asleepRaplMj = millijoules(energy.asleep.raplUj);
+        record.transitionRaplMj = millijoules(energy.transition.raplUj);
+    }
+    if (energy.asleep.hasBattery) {
+        // Batteries charge while plugged in, so their share may be negative.
+        record.energySources |= CycleHistoryStore::BatteryEnergy;
+        record.awakeBatteryMj = energy.awake.batteryUj / 1000;
+        record.asleepBatteryMj = energy.asleep.batteryUj / 1000;
+        record.transitionBatteryMj = energy.transition.batteryUj / 1000;
+    }
+    m_history.append(record);
+}
+
+HookRunner::Report RtcWakeDaemon::runHooks(const QString &phase, PowerAction action) {
+    if (m_options.hooksDir.isEmpty()) {
+        return HookRunner::Report();
+    }
+    TraceScope trace("daemon", "runHooks");
+    const QString directory = QDir(m_options.hooksDir)
+                                  .filePath(phase == QStringLiteral("pre") ? QStringLiteral("pre-suspend.d")
+                                                                           : QStringLiteral("post-resume.d"));
+    const QString mode = RtcWakeController::rtcwakeMode(action);
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    env.insert(QStringLiteral("RTCWAKE_ACTION"), RtcWakeController::actionLabel(action));
+    env.insert(QStringLiteral("RTCWAKE_MODE"), mode);
+    if (m_nextWake.isValid()) {
+        env.insert(QStringLiteral("RTCWAKE_WAKE_EPOCH"), QString::number(m_nextWake.toSecsSinceEpoch()));
+    }
+    m_hooks.setEnvironment(env);
+
+    // Same calling convention as systemd-sleep hooks: "pre mem", "post mem".
+    const auto report = m_hooks.run(directory, {phase, mode});
+    if (report.results.isEmpty()) {
+        return report;
+    }
+    for (const auto &result : report.results) {
+        const QString name = QString(result.name).replace(QLatin1Char('"'), QLatin1Char('_'));
+        const QString labels = QStringLiteral("phase=\"%1\",hook=\"%2\"").arg(phase, name);
+        m_metrics.observe(QStringLiteral("rtcwake_daemon_hook_duration_seconds"), result.elapsedMs / 1000.0, labels);
+        if (!result.succeeded()) {
+            m_metrics.increment(QStringLiteral("rtcwake_daemon_hook_failures_total"), labels);
+            log(tr("Hook %1/%2 failed (exit %3%4): %5")
+                    .arg(phase, result.name)
+                    .arg(result.exitCode)
+                    .arg(result.timedOut ? tr(", timed out") : QString())
+                    .arg(result.message.isEmpty() ? tr("<no output>") : result.message));
+        }
+        appendPersistentLog(QStringLiteral("hook"),
+                            {{QStringLiteral("phase"), phase},
+                             {QStringLiteral("name"), result.name},
+                             {QStringLiteral("exit"), QString::number(result.exitCode)},
+                             {QStringLiteral("timed_out"), result.timedOut ? QStringLiteral("true") : QStringLiteral("false")},
+                             {QStringLiteral("elapsed_ms"), QString::number(result.elapsedMs)}});
+    }
+    m_metrics.observe(QStringLiteral("rtcwake_daemon_hook_pipeline_seconds"), report.elapsedMs / 1000.0,
+                      QStringLiteral("phase=\"%1\"").arg(phase));
+    const auto *slowest = report.slowest();
+    log(tr("%1 %2 hooks finished in %3 ms; slowest %4 took %5 ms")
+            .arg(report.results.size())
+            .arg(phase)
+            .arg(report.elapsedMs)
+            .arg(slowest->name)
+            .arg(slowest->elapsedMs));
+    return report;
+}
+
+bool RtcWakeDaemon::deferForActivity() {
+    const auto &limits = m_config.deferral;
+    if (!limits.enabled || m_nextAction == PowerAction::None) {
+        return false;
+    }
+    const QDateTime now = m_clock->now();
+    if (!m_idleProbePending) {
+        // Throughput needs two snapshots; take the first now and decide after the sample window.
+        m_idleBaseline = m_idleProbe.sample(m_clock->monotonicMs(), limits.blockingProcesses);
+        m_idleProbePending = true;
+        scheduleEventTimer(now.addSecs(limits.sampleSeconds), m_nextAction);
+        return true;
+    }
+    m_idleProbePending = false;
+
+    const auto current = m_idleProbe.sample(m_clock->monotonicMs(), limits.blockingProcesses);
+    const QStringList reasons = IdlenessProbe::busyReasons(m_idleBaseline, current, limits, QThread::idealThreadCount());
+    const QString deferredMinutes = QString::number(m_deferredMs / 60000);
+    if (reasons.isEmpty()) {
+        if (m_deferredMs > 0) {
+            log(tr("System idle after deferring %1 minutes").arg(deferredMinutes));
+            appendPersistentLog(QStringLiteral("deferral"),
+                                {{QStringLiteral("status"), QStringLiteral("idle")},
+                                 {QStringLiteral("deferred_min"), deferredMinutes}});
+        }
+        return false;
+    }
+
+    const QString reasonText = reasons.join(QStringLiteral("; "));
+    const qint64 stepMs = limits.stepMinutes * 60000LL;
+    if (m_deferredMs + stepMs > limits.maxDelayMinutes * 60000LL) {
+        log(tr("Still busy (%1) after deferring %2 minutes; applying %3 anyway")
+                .arg(reasonText, deferredMinutes, RtcWakeController::actionLabel(m_nextAction)));
+        appendPersistentLog(QStringLiteral("deferral"),
+                            {{QStringLiteral("status"), QStringLiteral("exhausted")},
+                             {QStringLiteral("reason"), reasonText},
+                             {QStringLiteral("deferred_min"), deferredMinutes}});
+        return false;
+    }
+
+    const QDateTime next = now.addMSecs(stepMs);
+    if (m_nextWake.isValid() && next.secsTo(m_nextWake) < kMinSleepSecs) {
+        log(tr("Busy (%1) and too close to the %2 wake; skipping this cycle")
+                .arg(reasonText, formatDateTime(m_nextWake)));
+        appendPersistentLog(QStringLiteral("deferral"),
+                            {{QStringLiteral("status"), QStringLiteral("skipped")},
+                             {QStringLiteral("reason"), reasonText},
+                             {QStringLiteral("deferred_min"), deferredMinutes}});
+        m_deferredMs += stepMs;
+        appendCycleRecord(CycleHistoryStore::Outcome::Skipped);
+        planNext(tr("Busy until the wake window closed"));
+        return true;
+    }
+
+    m_deferredMs += stepMs;
+    m_metrics.increment(QStringLiteral("rtcwake_daemon_deferrals_total"));
+    log(tr("Deferring %1 by %2 minutes: %3")
+            .arg(RtcWakeController::actionLabel(m_nextAction))
+            .arg(limits.stepMinutes)
+            .arg(reasonText));
+    appendPersistentLog(QStringLiteral("deferral"),
+                        {{QStringLiteral("status"), QStringLiteral("deferred")},
+                         {QStringLiteral("reason"), reasonText},
+                         {QStringLiteral("step_min"), QString::number(limits.stepMinutes)},
+                         {QStringLiteral("deferred_min"), QString::number(m_deferredMs / 60000)},
+                         {QStringLiteral("until"), formatDateTime(next)}});
+    scheduleEventTimer(next, m_nextAction);
+    persistState();
+    return true;
+}
+
+int RtcWakeDaemon::plannedRule() const {
+    if (!m_cyclePlannedShutdown.isValid()) {
+        return -1;
+    }
+    // The rule is not journaled; planning from just before the cycle finds it again.
+    SchedulePlanner::Event event;
+    if (!SchedulePlanner::nextEvent(m_config, m_cyclePlannedShutdown.addMSecs(-1), event)
+        || event.shutdown != m_cyclePlannedShutdown || event.wake != m_nextWake) {
+        return -1;
+    }
+    return event.weeklyIndex;
+}
+
+void RtcWakeDaemon::startMaintenance(int rule, const ResumeLatencyStats::ClockSample &woke) {
+    if (rule < 0 || rule >= m_config.weekly.size() || m_config.weekly.at(rule).jobs.isEmpty()) {
+        return;
+    }
+    const WeeklyEntry &entry = m_config.weekly.at(rule);
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    env.insert(QStringLiteral("RTCWAKE_WAKE_EPOCH"), QString::number(m_nextWake.toSecsSinceEpoch()));
+    m_maintenance.setEnvironment(env);
+    m_maintenance.setMaxParallel(m_config.maintenance.maxParallel);
+    if (!m_maintenance.start(entry.jobs)) {
+        log(tr("Maintenance jobs of an earlier wake are still running"));
+        return;
+    }
+    m_maintenanceResuspend = entry.resuspendAfterJobs;
+    m_maintenanceResuspendUntil = entry.resuspendUntil;
+    m_maintenanceWokeBootMs = woke.bootMs;
+    if (m_maintenanceResuspend && m_config.maintenance.requireSessionIdle) {
+        ensureLogindWatcher();
+    }
+    const QString day = QLocale().dayName(static_cast<int>(entry.day));
+    log(tr("Running %1 maintenance jobs of the %2 rule").arg(entry.jobs.size()).arg(day));
+    appendPersistentLog(QStringLiteral("maintenance"),
+                        {{QStringLiteral("status"), QStringLiteral("started")},
+                         {QStringLiteral("rule"), day},
+                         {QStringLiteral("jobs"), QString::number(entry.jobs.size())}});
+}
+
+void RtcWakeDaemon::handleMaintenanceFinished() {
+    TraceScope trace("daemon", "handleMaintenanceFinished");
+    const auto report = m_maintenance.lastReport();
+    for (const auto &result : report.results) {
+        const QString labels = QStringLiteral("job=\"%1\"").arg(QString(result.name).replace(QLatin1Char('"'), QLatin1Char('_')));
+        if (!result.skipped) {
+            m_metrics.observe(QStringLiteral("rtcwake_daemon_maintenance_job_duration_seconds"), result.elapsedMs / 1000.0, labels);
+        }
+        if (!result.succeeded()) {
+            m_metrics.increment(QStringLiteral("rtcwake_daemon_maintenance_job_failures_total"), labels);
+        }
+        appendPersistentLog(QStringLiteral("maintenance_job"),
+                            {{QStringLiteral("name"), result.name},
+                             {QStringLiteral("exit"), QString::number(result.exitCode)},
+                             {QStringLiteral("timed_out"), result.timedOut ? QStringLiteral("true") : QStringLiteral("false")},
+                             {QStringLiteral("elapsed_ms"), QString::number(result.elapsedMs)},
+                             {QStringLiteral("message"), result.message.isEmpty() ? tr("<no output>") : result.message}});
+    }
+
+    const QDateTime now = m_clock->now();
+    QDateTime until = m_nextWake;
+    if (m_maintenanceResuspendUntil.isValid()) {
+        QDateTime early(now.date(), m_maintenanceResuspendUntil, now.timeZone());
+        if (early <= now) {
+            early = early.addDays(1);
+        }
+        if (!until.isValid() || early < until) {
+            until = early;
+        }
+    }
+
+    QString status = QStringLiteral("resuspend");
+    if (m_transitionActive || report.canceled) {
+        status = QStringLiteral("canceled");
+    } else if (!m_maintenanceResuspend) {
+        status = QStringLiteral("stay_awake");
+    } else if (m_config.maintenance.requireSessionIdle && m_logind && m_logind->isAvailable() && !m_logind->idleHint()) {
+        status = QStringLiteral("session_active");
+    } else if (m_nextAction == PowerAction::None || m_nextAction == PowerAction::FreezeUserSession) {
+        // Freezing the session is no way back to sleep.
+        status = QStringLiteral("no_action");
+    } else if (!until.isValid() || now.secsTo(until) < kMinSleepSecs) {
+        status = QStringLiteral("no_wake");
+    }
+
+    const qint64 awakeMs = std::max<qint64>(0, m_clock->bootMs() - m_maintenanceWokeBootMs);
+    m_metrics.observe(QStringLiteral("rtcwake_daemon_maintenance_awake_seconds"), awakeMs / 1000.0);
+    log(tr("Maintenance finished: %1 jobs, %2 failed, %3 minutes awake (%4)")
+            .arg(report.results.size())
+            .arg(report.failures())
+            .arg(awakeMs / 60000.0, 0, 'f', 1)
+            .arg(status));
+    appendPersistentLog(QStringLiteral("maintenance"),
+                        {{QStringLiteral("status"), status},
+                         {QStringLiteral("jobs"), QString::number(report.results.size())},
+                         {QStringLiteral("failures"), QString::number(report.failures())},
+                         {QStringLiteral("awake_min"), QString::number(awakeMs / 60000.0, 'f', 1)},
+                         {QStringLiteral("until"), status == QStringLiteral("resuspend") ? formatDateTime(until) : tr("<none>")}});
+
+    const bool held = m_maintenanceHeldAction;
+    m_maintenanceHeldAction = false;
+    if (status != QStringLiteral("resuspend")) {
+        if (held && !m_transitionActive) {
+            scheduleEventTimer(m_nextShutdown, m_nextAction);
+        }
+        return;
+    }
+
+    // Arm the wake first, so a failing transition cannot leave the machine without one.
+    if (!alarmArmedFor(until)) {
+        programAlarm(until, m_nextAction);
+    }
+    m_eventTimer->stop();
+    m_snoozeActive = false;
+    if (until != m_nextWake) {
+        // Waking early for the day is not a planned cycle; the plan is rebuilt afterwards.
+        m_cyclePlannedShutdown = QDateTime();
+    }
+    m_nextWake = until;
+    m_nextShutdown = now;
+    executeTransition(CycleHistoryStore::MaintenanceResuspend);
+    finishTransition();
+}
+
+void RtcWakeDaemon::startActivityWatch(PowerAction action) {
+    const auto &prefs = m_config.returnToSleep;
+    if (!prefs.enabled || action == PowerAction::None) {
+        return;
+    }
+    if (prefs.watchSession) {
+        ensureLogindWatcher();
+    }
+    m_returnAction = action;
+    m_activityWokeBootMs = m_clock->bootMs();
+    m_activityMonitor->start(qint64(prefs.graceMinutes) * 60 * 1000, prefs.watchInputDevices);
+    log(tr("Waiting %1 minutes for someone to use the machine").arg(prefs.graceMinutes));
+    appendPersistentLog(QStringLiteral("return_to_sleep"),
+                        {{QStringLiteral("status"), QStringLiteral("watching")},
+                         {QStringLiteral("grace_min"), QString::number(prefs.graceMinutes)},
+                         {QStringLiteral("devices"), QString::number(m_activityMonitor->deviceCount())}});
+}
+
+void RtcWakeDaemon::handleUserActivity(const QString &source) {
+    const qint64 afterMs = std::max<qint64>(0, m_clock->bootMs() - m_activityWokeBootMs);
+    log(tr("Activity on %1 %2 minutes after the wake; staying awake").arg(source).arg(afterMs / 60000.0, 0, 'f', 1));
+    appendPersistentLog(QStringLiteral("return_to_sleep"),
+                        {{QStringLiteral("status"), QStringLiteral("activity")},
+                         {QStringLiteral("source"), source},
+                         {QStringLiteral("after_min"), QString::number(afterMs / 60000.0, 'f', 1)}});
+}
+
+void RtcWakeDaemon::handleNoActivity() {
+    TraceScope trace("daemon", "handleNoActivity");
+    const QDateTime now = m_clock->now();
+    const PowerAction action = m_returnAction;
+    QString skipReason;
+    if (m_transitionActive) {
+        skipReason = QStringLiteral("transition_active");
+    } else if (m_maintenance.isRunning()) {
+        // The jobs decide whether the machine sleeps again once they are done.
+        skipReason = QStringLiteral("maintenance_running");
+    } else if (!m_nextWake.isValid() || now.secsTo(m_nextWake) < kMinSleepSecs) {
+        // Sleeping without a wake would leave the machine down until someone shows up.
+        skipReason = QStringLiteral("no_wake");
+    }
+    if (!skipReason.isEmpty()) {
+        log(tr("Nobody used the machine, but not going back to sleep (%1)").arg(skipReason));
+        appendPersistentLog(QStringLiteral("return_to_sleep"),
+                            {{QStringLiteral("status"), QStringLiteral("skipped")},
+                             {QStringLiteral("reason"), skipReason}});
+        return;
+    }
+
+    const auto outcome = invokeWarning(now, action);
+    if (outcome != WarningOutcome::Apply) {
+        log(tr("Return to sleep declined from the warning dialog"));
+        appendPersistentLog(QStringLiteral("return_to_sleep"),
+                            {{QStringLiteral("status"), QStringLiteral("declined")},
+                             {QStringLiteral("outcome"), outcome == WarningOutcome::Snooze ? QStringLiteral("snooze")
+                                                                                            : QStringLiteral("cancel")}});
+        return;
+    }
+
+    m_eventTimer->stop();
+    m_snoozeActive = false;
+    m_nextShutdown = now;
+    m_nextAction = action;
+    m_metrics.increment(QStringLiteral("rtcwake_daemon_return_to_sleep_total"));
+    log(tr("Nobody used the machine for %1 minutes; %2 until %3")
+            .arg(m_config.returnToSleep.graceMinutes)
+            .arg(RtcWakeController::actionLabel(action), formatDateTime(m_nextWake)));
+    appendPersistentLog(QStringLiteral("return_to_sleep"),
+                        {{QStringLiteral("status"), QStringLiteral("applied")},
+                         {QStringLiteral("action"), RtcWakeController::actionLabel(action)},
+                         {QStringLiteral("grace_min"), QString::number(m_config.returnToSleep.graceMinutes)},
+                         {QStringLiteral("wake"), formatDateTime(m_nextWake)}});
+    executeTransition(CycleHistoryStore::NoActivityResuspend);
+    finishTransition();
+}
+
+void RtcWakeDaemon::startPrefetch() {
+    if (!m_config.prefetch.enabled || m_config.prefetch.paths.isEmpty()) {
+        return;
+    }
+    const QDir home(m_options.targetHome.isEmpty() ? QDir::homePath() : m_options.targetHome);
+    PageCachePrefetcher::Options options;
+    for (const auto &path : m_config.prefetch.paths) {
+        if (path == QStringLiteral("~")) {
+            options.paths << home.path();
+        } else if (path.startsWith(QStringLiteral("~/"))) {
+            options.paths << home.filePath(path.mid(2));
+        } else {
+            options.paths << home.absoluteFilePath(path);
+        }
+    }
+    options.workers = m_config.prefetch.workers;
+    options.budgetMs = m_config.prefetch.budgetSeconds * 1000LL;
+    if (m_prefetcher.start(options)) {
+        log(tr("Prefetching %1 paths into the page cache").arg(options.paths.size()));
+    }
+}
+
+void RtcWakeDaemon::handlePrefetchFinished() {
+    const auto report = m_prefetcher.lastReport();
+    const double mib = report.bytes / (1024.0 * 1024.0);
+    m_metrics.setGauge(QStringLiteral("rtcwake_daemon_prefetch_bytes"), static_cast<double>(report.bytes));
+    m_metrics.observe(QStringLiteral("rtcwake_daemon_prefetch_seconds"), report.elapsedMs / 1000.0);
+    log(tr("Prefetched %1 MiB from %2 files in %3 ms%4")
+            .arg(mib, 0, 'f', 1)
+            .arg(report.files)
+            .arg(report.elapsedMs)
+            .arg(report.canceled ? tr(" (canceled)") : report.budgetExhausted ? tr(" (budget exhausted)") : QString()));
+    for (const auto &root : report.roots) {
+        appendPersistentLog(QStringLiteral("prefetch_path"),
+                            {{QStringLiteral("path"), root.path},
+                             {QStringLiteral("files"), QString::number(root.files)},
+                             {QStringLiteral("bytes"), QString::number(root.bytes)}});
+    }
+    appendPersistentLog(QStringLiteral("prefetch"),
+                        {{QStringLiteral("files"), QString::number(report.files)},
+                         {QStringLiteral("bytes"), QString::number(report.bytes)},
+                         {QStringLiteral("errors"), QString::number(report.errors)},
+                         {QStringLiteral("elapsed_ms"), QString::number(report.elapsedMs)},
+                         {QStringLiteral("budget_exhausted"), report.budgetExhausted ? QStringLiteral("true") : QStringLiteral("false")},
+                         {QStringLiteral("canceled"), report.canceled ? QStringLiteral("true") : QStringLiteral("false")}});
+}
+
+ResumeLatencyStats::ClockSample RtcWakeDaemon::sampleClocks() const {
+    ResumeLatencyStats::ClockSample sample;
+    sample.bootMs = m_clock->bootMs();
+    sample.monotonicMs = m_clock->monotonicMs();
+    sample.realtime = m_clock->now();
+    return sample;
+}
+
 QString RtcWakeDaemon::resolveLogPath() const {
+    return statePath(QStringLiteral("log.txt"));
+}
+
+QString RtcWakeDaemon::statePath(const QString &fileName) const {
     QString base = m_options.targetHome;
     if (base.isEmpty()) {
         base = QDir::homePath();
@@ -338,7 +2055,7 @@ QString RtcWakeDaemon::resolveLogPath() const {
         return QString();
     }
     QDir dir(base);
-    return dir.filePath(QStringLiteral(".local/share/rtcwake-gui/log.txt"));
+    return dir.filePath(QStringLiteral(".local/share/rtcwake-gui/") + fileName);
 }
 
 void RtcWakeDaemon::appendPersistentLog(const QString &category, const QList<QPair<QString, QString>> &fields) const {
@@ -360,7 +2077,7 @@ void RtcWakeDaemon::appendPersistentLog(const QString &category, const QList<QPa
     }
 
     QTextStream stream(&file);
-    const QString stamp = QDateTime::currentDateTime().toString(QStringLiteral("yyyy-MM-dd hh:mm:ss"));
+    const QString stamp = m_clock->now().toString(QStringLiteral("yyyy-MM-dd hh:mm:ss"));
     stream << "[" << stamp << "] category=\"" << sanitizeSingleLine(category) << "\"";
     for (const auto &pair : fields) {
         stream << " " << pair.first << "=\""
@@ -1,67 +1,63 @@
 #include "SchedulePlanner.h"
 
+#include "PlannerCore.h"
+
 #include <QTimeZone>
 
 namespace SchedulePlanner {
 
 namespace {
-void considerCandidate(const QDateTime &shutdown, const QDateTime &wake, PowerAction action,
-                       const QDateTime &now, bool &hasCandidate, Event &best) {
-    if (!shutdown.isValid() || !wake.isValid()) {
-        return;
-    }
-    if (shutdown <= now) {
-        return;
-    }
-    if (!hasCandidate || shutdown < best.shutdown) {
-        best.shutdown = shutdown;
-        best.wake = wake;
-        best.action = action;
-        hasCandidate = true;
-    }
+PlannerCore::CivilDate toCivil(const QDate &date) {
+    return {date.year(), date.month(), date.day()};
 }
 
-QDateTime buildDateTime(const QDate &date, const QTime &time, const QTimeZone &zone) {
-    return QDateTime(date, time, zone);
+PlannerCore::Zone zoneFor(const QTimeZone &zone) {
+    PlannerCore::Zone result;
+    result.toEpoch = [zone](const PlannerCore::CivilDate &date, int msecOfDay, std::int64_t &epochMs) {
+        const QDateTime dt(QDate(date.year, date.month, date.day), QTime::fromMSecsSinceStartOfDay(msecOfDay), zone);
+        if (!dt.isValid()) {
+            return false;
+        }
+        epochMs = dt.toMSecsSinceEpoch();
+        return true;
+    };
+    result.dateOf = [zone](std::int64_t epochMs) {
+        return toCivil(QDateTime::fromMSecsSinceEpoch(epochMs, zone).date());
+    };
+    return result;
 }
 }
 
 bool nextEvent(const AppConfig &config, const QDateTime &now, Event &event) {
-    bool hasCandidate = false;
     const QTimeZone zone = now.timeZone();
-    const PowerAction action = static_cast<PowerAction>(config.actionId);
 
-    const QDateTime singleShutdown = buildDateTime(config.singleShutdownDate, config.singleShutdownTime, zone);
-    const QDateTime singleWake = buildDateTime(config.singleWakeDate, config.singleWakeTime, zone);
-    if (singleShutdown.isValid() && singleWake.isValid() && singleShutdown < singleWake) {
-        considerCandidate(singleShutdown, singleWake, action, now, hasCandidate, event);
+    PlannerCore::Config core;
+    core.action = config.actionId;
+    core.hibernateDelayMs = config.hibernateDelayMinutes * 60LL * 1000;
+    core.hasSingle = config.singleShutdownDate.isValid() && config.singleShutdownTime.isValid()
+        && config.singleWakeDate.isValid() && config.singleWakeTime.isValid();
+    if (core.hasSingle) {
+        core.singleShutdownDate = toCivil(config.singleShutdownDate);
+        core.singleShutdownMsecOfDay = config.singleShutdownTime.msecsSinceStartOfDay();
+        core.singleWakeDate = toCivil(config.singleWakeDate);
+        core.singleWakeMsecOfDay = config.singleWakeTime.msecsSinceStartOfDay();
     }
-
+    core.weekly.reserve(static_cast<size_t>(config.weekly.size()));
     for (const auto &entry : config.weekly) {
-        if (!entry.enabled) {
-            continue;
-        }
-
-        QDate baseDate = now.date();
-        int offset = static_cast<int>(entry.day) - baseDate.dayOfWeek();
-        if (offset < 0) {
-            offset += 7;
-        }
-        QDate shutdownDate = baseDate.addDays(offset);
-        QDateTime shutdown = buildDateTime(shutdownDate, entry.shutdownTime, zone);
-        if (shutdown <= now) {
-            shutdown = shutdown.addDays(7);
-        }
-
-        QDateTime wake = buildDateTime(shutdown.date(), entry.wakeTime, zone);
-        if (wake <= shutdown) {
-            wake = wake.addDays(1);
-        }
-
-        considerCandidate(shutdown, wake, action, now, hasCandidate, event);
+        core.weekly.push_back({static_cast<int>(entry.day), entry.enabled, entry.shutdownTime.msecsSinceStartOfDay(),
+                               entry.wakeTime.msecsSinceStartOfDay()});
     }
 
-    return hasCandidate;
+    PlannerCore::Event next;
+    if (!PlannerCore::nextEvent(core, now.toMSecsSinceEpoch(), zoneFor(zone), next)) {
+        return false;
+    }
+    event.shutdown = QDateTime::fromMSecsSinceEpoch(next.shutdownMs, zone);
+    event.wake = QDateTime::fromMSecsSinceEpoch(next.wakeMs, zone);
+    event.action = static_cast<PowerAction>(next.action);
+    event.weeklyIndex = next.rule;
+    event.hibernateAt = next.hibernateMs > 0 ? QDateTime::fromMSecsSinceEpoch(next.hibernateMs, zone) : QDateTime();
+    return true;
 }
 
 } // namespace SchedulePlanner
@@ -0,0 +1,181 @@
+#include "SessionLocator.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QRegularExpression>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+QByteArray readFile(const QString &path) {
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+/**
+ * A non-blocking connect: a listening server answers right away (a full backlog still means
+ * it is there), while a socket file left behind by a dead server is refused.
+ */
+bool listening(const QByteArray &address) {
+    sockaddr_un addr {};
+    addr.sun_family = AF_UNIX;
+    if (address.isEmpty() || static_cast<std::size_t>(address.size()) >= sizeof(addr.sun_path)) {
+        return false;
+    }
+    std::memcpy(addr.sun_path, address.constData(), static_cast<std::size_t>(address.size()));
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+    const auto length = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + static_cast<std::size_t>(address.size()));
+    const bool accepted = ::connect(fd, reinterpret_cast<const sockaddr *>(&addr), length) == 0
+        || errno == EAGAIN || errno == EINPROGRESS;
+    ::close(fd);
+    return accepted;
+}
+}
+
+SessionLocator::SessionLocator(QString procRoot, QString runRoot, QString x11SocketDir)
+    : m_procRoot(std::move(procRoot)), m_runRoot(std::move(runRoot)), m_x11SocketDir(std::move(x11SocketDir)) {}
+
+QVector<SessionLocator::Session> SessionLocator::discover(uint uid, const QStringList &sessionIds) const {
+    const QString runtimeDir = QStringLiteral("%1/user/%2").arg(m_runRoot).arg(uid);
+    const bool haveRuntimeDir = QFileInfo(runtimeDir).isDir();
+
+    QHash<QString, Session> sessions;
+    QHash<QString, bool> displays;
+    const auto entries = QDir(m_procRoot).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const auto &entry : entries) {
+        bool ok = false;
+        const qint64 pid = entry.toLongLong(&ok);
+        if (!ok) {
+            continue;
+        }
+        Session session = readProcess(pid, uid);
+        if (!session.graphical()) {
+            continue;
+        }
+        // A process from a session logind has closed keeps its old environment; skip it.
+        if (!session.id.isEmpty() && !sessionIds.isEmpty() && !sessionIds.contains(session.id)) {
+            continue;
+        }
+        if (session.xdgRuntimeDir.isEmpty() && haveRuntimeDir) {
+            session.xdgRuntimeDir = runtimeDir;
+        }
+        const QString bus = session.xdgRuntimeDir + QStringLiteral("/bus");
+        if (session.dbusAddress.isEmpty() && !session.xdgRuntimeDir.isEmpty() && QFileInfo::exists(bus)) {
+            session.dbusAddress = QStringLiteral("unix:path=") + bus;
+        }
+
+        const QString display = session.display + QLatin1Char('|') + session.waylandDisplay + QLatin1Char('|') + session.xdgRuntimeDir;
+        auto live = displays.constFind(display);
+        if (live == displays.constEnd()) {
+            live = displays.insert(display, alive(session));
+        }
+        if (!*live) {
+            continue;
+        }
+        // Processes started by the user manager carry no session id; group them by display.
+        const QString key = session.id.isEmpty() ? display : session.id;
+        const auto existing = sessions.constFind(key);
+        if (existing == sessions.constEnd() || existing->pid < pid) {
+            sessions.insert(key, session);
+        }
+    }
+
+    auto result = QVector<Session>::fromList(sessions.values());
+    const auto rank = [&sessionIds](const Session &session) {
+        if (sessionIds.isEmpty()) {
+            return 0;
+        }
+        const int index = sessionIds.indexOf(session.id);
+        return index < 0 ? sessionIds.size() : index;
+    };
+    std::sort(result.begin(), result.end(), [&rank](const Session &a, const Session &b) {
+        const int rankA = rank(a);
+        const int rankB = rank(b);
+        return rankA != rankB ? rankA < rankB : a.pid > b.pid;
+    });
+    return result;
+}
+
+bool SessionLocator::alive(const Session &session) const {
+    if (!session.waylandDisplay.isEmpty()) {
+        const QString socket = session.waylandDisplay.startsWith(QLatin1Char('/'))
+            ? session.waylandDisplay
+            : session.xdgRuntimeDir + QLatin1Char('/') + session.waylandDisplay;
+        if (socket.startsWith(QLatin1Char('/')) && listening(QFile::encodeName(socket))) {
+            return true;
+        }
+    }
+    // Only local X servers count; a forwarded "host:10" display is not the user's screen.
+    static const QRegularExpression localX11(QStringLiteral("^(?:unix)?:(\\d+)(?:\\.\\d+)?$"));
+    const auto match = localX11.match(session.display);
+    if (!match.hasMatch()) {
+        return false;
+    }
+    const QByteArray path = QFile::encodeName(m_x11SocketDir + QStringLiteral("/X") + match.captured(1));
+    // Xorg also listens in the abstract namespace, which still works when /tmp is private.
+    return listening(path) || listening(QByteArray(1, '\0') + path);
+}
+
+SessionLocator::Session SessionLocator::fromSessionInfo(const SessionInfo &info) {
+    Session session;
+    session.display = info.display;
+    session.waylandDisplay = info.waylandDisplay;
+    session.xdgRuntimeDir = info.xdgRuntimeDir;
+    session.dbusAddress = info.dbusAddress;
+    session.xauthority = info.xauthority;
+    return session;
+}
+
+SessionLocator::Session SessionLocator::readProcess(qint64 pid, uint uid) const {
+    Session session;
+    const QString dir = QStringLiteral("%1/%2/").arg(m_procRoot).arg(pid);
+    // "Uid:" lists the real, effective, saved and filesystem ids; the real one owns the process.
+    const auto status = readFile(dir + QStringLiteral("status")).split('\n');
+    const auto uidLine = std::find_if(status.cbegin(), status.cend(), [](const QByteArray &line) { return line.startsWith("Uid:"); });
+    if (uidLine == status.cend()) {
+        return session;
+    }
+    const auto ids = uidLine->mid(4).simplified().split(' ');
+    bool ok = false;
+    if (ids.first().toUInt(&ok) != uid || !ok) {
+        return session;
+    }
+
+    const auto variables = readFile(dir + QStringLiteral("environ")).split('\0');
+    for (const auto &variable : variables) {
+        const int equals = variable.indexOf('=');
+        if (equals <= 0) {
+            continue;
+        }
+        const QByteArray name = variable.left(equals);
+        const QString value = QString::fromLocal8Bit(variable.mid(equals + 1));
+        if (name == "XDG_SESSION_ID") {
+            session.id = value;
+        } else if (name == "DISPLAY") {
+            session.display = value;
+        } else if (name == "WAYLAND_DISPLAY") {
+            session.waylandDisplay = value;
+        } else if (name == "XDG_RUNTIME_DIR") {
+            session.xdgRuntimeDir = value;
+        } else if (name == "DBUS_SESSION_BUS_ADDRESS") {
+            session.dbusAddress = value;
+        } else if (name == "XAUTHORITY") {
+            session.xauthority = value;
+        }
+    }
+    session.pid = pid;
+    return session;
+}
@@ -0,0 +1,195 @@
+#include "SimulatedClock.h"
+
+#include <algorithm>
+
+SimulatedClock::SimulatedClock(const QDateTime &start)
+    : m_now(start) {}
+
+SimulatedClock::~SimulatedClock() {
+    for (auto *timer : m_timers) {
+        timer->m_clock = nullptr;
+    }
+}
+
+QDateTime SimulatedClock::now() const {
+    return m_now;
+}
+
+qint64 SimulatedClock::monotonicMs() const {
+    return m_monotonicMs;
+}
+
+qint64 SimulatedClock::bootMs() const {
+    return m_bootMs;
+}
+
+qint64 SimulatedClock::rawMonotonicMs() const {
+    return m_monotonicMs;
+}
+
+bool SimulatedClock::isSynchronized() const {
+    return m_synchronized;
+}
+
+DaemonTimer *SimulatedClock::createTimer(QObject *parent) {
+    return new SimulatedTimer(this, parent);
+}
+
+ClockChangeWatcher *SimulatedClock::createChangeWatcher(QObject *parent) {
+    auto *watcher = new ClockChangeWatcher(parent);
+    m_watchers.append(watcher);
+    return watcher;
+}
+
+void SimulatedClock::advanceTo(const QDateTime &target) {
+    const auto moveBy = [this](qint64 delta) {
+        if (delta > 0) {
+            m_monotonicMs += delta;
+            m_bootMs += delta;
+            m_now = m_now.addMSecs(delta);
+        }
+    };
+
+    // Callbacks may suspend() or step the clock, so the remaining span is re-derived each round.
+    while (true) {
+        if (deliverClockChange()) {
+            continue;
+        }
+        const qint64 limit = m_monotonicMs + std::max<qint64>(0, m_now.msecsTo(target));
+        SimulatedTimer *timer = nextDue(limit);
+        if (!timer) {
+            break;
+        }
+        moveBy(timer->m_deadlineMs - m_monotonicMs);
+        ++m_fired;
+        timer->fire();
+    }
+    moveBy(m_now.msecsTo(target));
+    deliverClockChange();
+}
+
+void SimulatedClock::advanceBy(qint64 msecs) {
+    advanceTo(m_now.addMSecs(msecs));
+}
+
+void SimulatedClock::suspend(const QDateTime &resume) {
+    const qint64 delta = m_now.msecsTo(resume);
+    if (delta > 0) {
+        m_bootMs += delta;
+        m_now = m_now.addMSecs(delta);
+        m_clockChangePending = true;
+    }
+}
+
+void SimulatedClock::pause(qint64 msecs) {
+    if (msecs > 0) {
+        m_monotonicMs += msecs;
+        m_bootMs += msecs;
+        m_now = m_now.addMSecs(msecs);
+    }
+}
+
+void SimulatedClock::setWallClock(const QDateTime &wall) {
+    m_now = wall.toTimeZone(m_now.timeZone());
+    m_clockChangePending = true;
+}
+
+void SimulatedClock::setSynchronized(bool synchronized) {
+    m_synchronized = synchronized;
+}
+
+bool SimulatedClock::deliverClockChange() {
+    if (!m_clockChangePending) {
+        return false;
+    }
+    m_clockChangePending = false;
+    m_watchers.removeAll(nullptr);
+    const auto watchers = m_watchers;
+    for (const auto &watcher : watchers) {
+        if (watcher) {
+            emit watcher->changed();
+        }
+    }
+    return true;
+}
+
+int SimulatedClock::activeTimers() const {
+    return static_cast<int>(std::count_if(m_timers.cbegin(), m_timers.cend(),
+                                          [](const SimulatedTimer *timer) { return timer->m_active; }));
+}
+
+quint64 SimulatedClock::firedTimers() const {
+    return m_fired;
+}
+
+void SimulatedClock::registerTimer(SimulatedTimer *timer) {
+    m_timers.append(timer);
+}
+
+void SimulatedClock::unregisterTimer(SimulatedTimer *timer) {
+    m_timers.removeAll(timer);
+}
+
+SimulatedTimer *SimulatedClock::nextDue(qint64 limitMonotonicMs) const {
+    SimulatedTimer *best = nullptr;
+    for (auto *timer : m_timers) {
+        if (!timer->m_active || timer->m_deadlineMs > limitMonotonicMs) {
+            continue;
+        }
+        if (!best || timer->m_deadlineMs < best->m_deadlineMs
+            || (timer->m_deadlineMs == best->m_deadlineMs && timer->m_sequence < best->m_sequence)) {
+            best = timer;
+        }
+    }
+    return best;
+}
+
+SimulatedTimer::SimulatedTimer(SimulatedClock *clock, QObject *parent)
+    : DaemonTimer(parent),
+      m_clock(clock) {
+    m_clock->registerTimer(this);
+}
+
+SimulatedTimer::~SimulatedTimer() {
+    if (m_clock) {
+        m_clock->unregisterTimer(this);
+    }
+}
+
+void SimulatedTimer::start(qint64 msecs) {
+    if (!m_clock) {
+        return;
+    }
+    m_deadlineMs = m_clock->m_monotonicMs + std::max<qint64>(0, msecs);
+    m_sequence = ++m_clock->m_sequence;
+    m_active = true;
+}
+
+void SimulatedTimer::stop() {
+    m_active = false;
+}
+
+bool SimulatedTimer::isActive() const {
+    return m_active;
+}
+
+void SimulatedTimer::setSingleShot(bool singleShot) {
+    m_singleShot = singleShot;
+}
+
+void SimulatedTimer::setInterval(qint64 msecs) {
+    m_interval = std::max<qint64>(0, msecs);
+}
+
+qint64 SimulatedTimer::interval() const {
+    return m_interval;
+}
+
+void SimulatedTimer::fire() {
+    if (m_singleShot) {
+        m_active = false;
+    } else {
+        start(m_interval);
+    }
+    emit timeout();
+}
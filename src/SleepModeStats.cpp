@@ -0,0 +1,78 @@
+#include "SleepModeStats.h"
+
+#include "StateFile.h"
+
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+
+double SleepModeStats::Counts::rate() const {
+    return (successes + 1.0) / (attempts + 2.0);
+}
+
+QMap<QString, SleepModeStats::Counts> SleepModeStats::load(const QString &path) {
+    QMap<QString, Counts> result;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return result;
+    }
+    const QJsonObject modes = QJsonDocument::fromJson(file.readAll()).object().value(QStringLiteral("modes")).toObject();
+    for (auto it = modes.begin(); it != modes.end(); ++it) {
+        const QJsonObject obj = it.value().toObject();
+        Counts counts;
+        counts.attempts = obj.value(QStringLiteral("attempts")).toInt();
+        counts.successes = std::clamp(obj.value(QStringLiteral("successes")).toInt(), 0, counts.attempts);
+        counts.lastFailure = QDateTime::fromString(obj.value(QStringLiteral("lastFailure")).toString(), Qt::ISODate);
+        if (counts.attempts > 0) {
+            result.insert(it.key(), counts);
+        }
+    }
+    return result;
+}
+
+bool SleepModeStats::record(const QString &path, const QString &mode, bool success, const QDateTime &when) {
+    QMap<QString, Counts> all = load(path);
+    Counts &counts = all[mode];
+    ++counts.attempts;
+    if (success) {
+        ++counts.successes;
+    } else {
+        counts.lastFailure = when;
+    }
+    if (counts.attempts > kMaxAttempts) {
+        counts.attempts /= 2;
+        counts.successes /= 2;
+    }
+
+    QJsonObject modes;
+    for (auto it = all.cbegin(); it != all.cend(); ++it) {
+        QJsonObject obj;
+        obj.insert(QStringLiteral("attempts"), it->attempts);
+        obj.insert(QStringLiteral("successes"), it->successes);
+        obj.insert(QStringLiteral("rate"), it->rate());
+        if (it->lastFailure.isValid()) {
+            obj.insert(QStringLiteral("lastFailure"), it->lastFailure.toUTC().toString(Qt::ISODate));
+        }
+        modes.insert(it.key(), obj);
+    }
+    QJsonObject root;
+    root.insert(QStringLiteral("modes"), modes);
+
+    return saveJsonState(path, root);
+}
+
+QStringList SleepModeStats::fallbackOrder(const QString &requested, const QStringList &chain,
+                                          const QMap<QString, Counts> &stats) {
+    QStringList result;
+    for (const auto &mode : chain) {
+        if (mode != requested && !result.contains(mode)) {
+            result << mode;
+        }
+    }
+    std::stable_sort(result.begin(), result.end(), [&stats](const QString &a, const QString &b) {
+        return stats.value(a).rate() > stats.value(b).rate();
+    });
+    return result;
+}
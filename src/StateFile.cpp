@@ -0,0 +1,27 @@
+#include "StateFile.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QSaveFile>
+
+bool saveJsonState(const QString &path, const QJsonObject &object) {
+    QDir dir = QFileInfo(path).absoluteDir();
+    if (!dir.exists() && !QDir().mkpath(dir.absolutePath())) {
+        qWarning().noquote() << "Failed to create state directory" << dir.absolutePath();
+        return false;
+    }
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qWarning().noquote() << "Failed to open state file" << path << file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument(object).toJson(QJsonDocument::Compact));
+    file.write("\n");
+    if (!file.commit()) {
+        qWarning().noquote() << "Failed to write state file" << path << file.errorString();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,159 @@
+#include "SystemdTimerBackend.h"
+
+#include "RtcWakeController.h"
+#include "SchedulePlanner.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QTimeZone>
+
+#include <utility>
+
+namespace {
+const QString kHeader = QStringLiteral("# Generated by rtcwake-gui; changes are overwritten on the next save.\n");
+
+/** OnCalendar= expression for @p time, every week on its weekday when @p weekly. */
+QString calendar(const QDateTime &time, bool weekly) {
+    static const char *const days[] = {"Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun"};
+    QString expression = weekly ? QStringLiteral("%1 *-*-* %2")
+                                      .arg(QLatin1String(days[time.date().dayOfWeek() - 1]),
+                                           time.time().toString(QStringLiteral("HH:mm:ss")))
+                                : time.toString(QStringLiteral("yyyy-MM-dd HH:mm:ss"));
+    // Name the zone the planner used; without one systemd reads the expression in its own.
+    const QByteArray zone = time.timeZone().id();
+    if (!zone.isEmpty()) {
+        expression += QLatin1Char(' ') + QString::fromLatin1(zone);
+    }
+    return expression;
+}
+
+/** Orders the single event first and weekly expressions by weekday and time, whatever today is. */
+QString sortKey(const QDateTime &time, bool weekly) {
+    return weekly ? QStringLiteral("1 %1 %2").arg(time.date().dayOfWeek()).arg(time.time().toString(QStringLiteral("HH:mm:ss")))
+                  : QStringLiteral("0 %1").arg(time.toString(Qt::ISODate));
+}
+
+QByteArray timerUnit(const QString &description, const QStringList &calendars, bool wakeSystem) {
+    QString text = kHeader;
+    text += QStringLiteral("[Unit]\nDescription=%1\n\n[Timer]\n").arg(description);
+    for (const auto &expression : calendars) {
+        text += QStringLiteral("OnCalendar=%1\n").arg(expression);
+    }
+    if (wakeSystem) {
+        text += QStringLiteral("WakeSystem=true\n");
+    }
+    // The default of a minute would let the sleep and the wake drift apart.
+    text += QStringLiteral("AccuracySec=1s\n\n[Install]\nWantedBy=timers.target\n");
+    return text.toUtf8();
+}
+
+QByteArray serviceUnit(const QString &description, const QString &command) {
+    return (kHeader
+            + QStringLiteral("[Unit]\nDescription=%1\n\n[Service]\nType=oneshot\nExecStart=%2\n").arg(description, command))
+        .toUtf8();
+}
+}
+
+SystemdTimerBackend::SystemdTimerBackend(QString unitDir)
+    : m_unitDir(std::move(unitDir)) {}
+
+SystemdTimerBackend::Units SystemdTimerBackend::compile(const AppConfig &config, const QDateTime &now) {
+    QMap<QString, QString> sleepCalendars;
+    QMap<QString, QString> wakeCalendars;
+    PowerAction action = PowerAction::None;
+    const QDateTime horizon = now.addDays(kHorizonDays);
+    SchedulePlanner::Event event;
+    QDateTime from = now;
+    while (SchedulePlanner::nextEvent(config, from, event) && event.shutdown <= horizon) {
+        const bool weekly = event.weeklyIndex >= 0;
+        sleepCalendars.insert(sortKey(event.shutdown, weekly), calendar(event.shutdown, weekly));
+        wakeCalendars.insert(sortKey(event.wake, weekly), calendar(event.wake, weekly));
+        action = event.action;
+        from = event.shutdown;
+    }
+
+    Units units;
+    if (wakeCalendars.isEmpty()) {
+        return units;
+    }
+    const QString prefix = QString::fromLatin1(kUnitPrefix);
+    units.insert(prefix + QStringLiteral("wake.timer"),
+                 timerUnit(QStringLiteral("rtcwake-gui: wake the machine"), wakeCalendars.values(), true));
+    units.insert(prefix + QStringLiteral("wake.service"),
+                 serviceUnit(QStringLiteral("rtcwake-gui: scheduled wake"), QStringLiteral("/bin/true")));
+    const QString verb = systemctlVerb(action);
+    if (!verb.isEmpty()) {
+        const QString label = RtcWakeController::actionLabel(action);
+        units.insert(prefix + QStringLiteral("sleep.timer"),
+                     timerUnit(QStringLiteral("rtcwake-gui: %1 at the shutdown time").arg(label), sleepCalendars.values(), false));
+        units.insert(prefix + QStringLiteral("sleep.service"),
+                     serviceUnit(QStringLiteral("rtcwake-gui: %1").arg(label), QStringLiteral("/usr/bin/systemctl %1").arg(verb)));
+    }
+    return units;
+}
+
+QString SystemdTimerBackend::systemctlVerb(PowerAction action) {
+    switch (action) {
+    case PowerAction::SuspendToIdle:
+    case PowerAction::SuspendToRam:
+        // systemd picks the state from SuspendState= in sleep.conf.
+        return QStringLiteral("suspend");
+    case PowerAction::Hibernate:
+        return QStringLiteral("hibernate");
+    case PowerAction::SuspendThenHibernate:
+        return QStringLiteral("suspend-then-hibernate");
+    case PowerAction::PowerOff:
+        // WakeSystem= only resumes a suspended machine; nothing would power it on again.
+    case PowerAction::FreezeUserSession:
+    case PowerAction::None:
+    default:
+        return QString();
+    }
+}
+
+bool SystemdTimerBackend::apply(const Units &units, QStringList *changed) const {
+    QDir dir(m_unitDir);
+    if (!dir.exists() && !QDir().mkpath(m_unitDir)) {
+        qWarning().noquote() << "Failed to create unit directory" << m_unitDir;
+        return false;
+    }
+    bool ok = true;
+    for (auto it = units.cbegin(); it != units.cend(); ++it) {
+        const QString path = dir.filePath(it.key());
+        QFile current(path);
+        if (current.open(QIODevice::ReadOnly) && current.readAll() == it.value()) {
+            continue;
+        }
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly) || file.write(it.value()) != it.value().size() || !file.commit()) {
+            qWarning().noquote() << "Failed to write unit" << path << file.errorString();
+            ok = false;
+            continue;
+        }
+        if (changed) {
+            changed->append(it.key());
+        }
+    }
+    const QString prefix = QString::fromLatin1(kUnitPrefix);
+    const QStringList generated = dir.entryList({prefix + QStringLiteral("*.timer"), prefix + QStringLiteral("*.service")}, QDir::Files);
+    for (const auto &name : generated) {
+        if (units.contains(name)) {
+            continue;
+        }
+        if (!dir.remove(name)) {
+            qWarning().noquote() << "Failed to remove stale unit" << dir.filePath(name);
+            ok = false;
+            continue;
+        }
+        if (changed) {
+            changed->append(name);
+        }
+    }
+    return ok;
+}
+
+QString SystemdTimerBackend::unitDir() const {
+    return m_unitDir;
+}
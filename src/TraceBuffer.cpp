@@ -0,0 +1,158 @@
+#include "TraceBuffer.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+namespace {
+qint64 currentThreadId() {
+    thread_local const qint64 tid = static_cast<qint64>(::syscall(SYS_gettid));
+    return tid;
+}
+}
+
+TraceBuffer::TraceBuffer(int capacity)
+    : m_events(new Event[static_cast<size_t>(std::max(1, capacity))]),
+      m_capacity(std::max(1, capacity)) {}
+
+TraceBuffer &TraceBuffer::instance() {
+    static TraceBuffer buffer;
+    return buffer;
+}
+
+qint64 TraceBuffer::nowUs() {
+    timespec ts {};
+    ::clock_gettime(CLOCK_BOOTTIME, &ts);
+    return static_cast<qint64>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+void TraceBuffer::setEnabled(bool enabled) {
+    m_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool TraceBuffer::isEnabled() const {
+    return m_enabled.load(std::memory_order_relaxed);
+}
+
+void TraceBuffer::complete(const char *category, const char *name, qint64 startUs, qint64 durationUs) {
+    Event event;
+    event.category = category;
+    event.name = name;
+    event.startUs = startUs;
+    event.durationUs = durationUs;
+    event.phase = 'X';
+    record(event);
+}
+
+void TraceBuffer::instant(const char *category, const char *name) {
+    if (!isEnabled()) {
+        return;
+    }
+    Event event;
+    event.category = category;
+    event.name = name;
+    event.startUs = nowUs();
+    event.phase = 'i';
+    record(event);
+}
+
+void TraceBuffer::record(const Event &event) {
+    if (!isEnabled()) {
+        return;
+    }
+    const quint64 slot = m_next.fetch_add(1, std::memory_order_relaxed) % static_cast<quint64>(m_capacity);
+    Event &target = m_events[slot];
+    target = event;
+    target.threadId = currentThreadId();
+}
+
+void TraceBuffer::clear() {
+    std::fill(m_events.get(), m_events.get() + m_capacity, Event {});
+    m_next.store(0, std::memory_order_relaxed);
+}
+
+int TraceBuffer::capacity() const {
+    return m_capacity;
+}
+
+int TraceBuffer::size() const {
+    return static_cast<int>(std::min<quint64>(m_next.load(std::memory_order_relaxed), static_cast<quint64>(m_capacity)));
+}
+
+QByteArray TraceBuffer::toChromeJson() const {
+    const quint64 next = m_next.load(std::memory_order_relaxed);
+    const quint64 count = std::min<quint64>(next, static_cast<quint64>(m_capacity));
+    const quint64 first = next - count;
+    const qint64 pid = QCoreApplication::applicationPid();
+
+    QJsonArray events;
+    for (quint64 i = first; i < next; ++i) {
+        const Event &event = m_events[i % static_cast<quint64>(m_capacity)];
+        if (!event.name) {
+            continue;
+        }
+        QJsonObject obj;
+        obj.insert(QStringLiteral("name"), QString::fromLatin1(event.name));
+        obj.insert(QStringLiteral("cat"), QString::fromLatin1(event.category ? event.category : "default"));
+        obj.insert(QStringLiteral("ph"), QString::fromLatin1(&event.phase, 1));
+        obj.insert(QStringLiteral("ts"), static_cast<double>(event.startUs));
+        if (event.phase == 'X') {
+            obj.insert(QStringLiteral("dur"), static_cast<double>(event.durationUs));
+        } else {
+            obj.insert(QStringLiteral("s"), QStringLiteral("t"));
+        }
+        obj.insert(QStringLiteral("pid"), static_cast<double>(pid));
+        obj.insert(QStringLiteral("tid"), static_cast<double>(event.threadId));
+        events.append(obj);
+    }
+
+    QJsonObject root;
+    root.insert(QStringLiteral("traceEvents"), events);
+    root.insert(QStringLiteral("displayTimeUnit"), QStringLiteral("ms"));
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+bool TraceBuffer::dump(const QString &path) const {
+    if (path.isEmpty()) {
+        return false;
+    }
+    QDir dir = QFileInfo(path).absoluteDir();
+    if (!dir.exists() && !QDir().mkpath(dir.absolutePath())) {
+        qWarning().noquote() << "Failed to create trace directory" << dir.absolutePath();
+        return false;
+    }
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning().noquote() << "Failed to open trace file" << path << file.errorString();
+        return false;
+    }
+    file.write(toChromeJson());
+    file.write("\n");
+    return file.commit();
+}
+
+TraceScope::TraceScope(const char *category, const char *name, TraceBuffer &buffer)
+    : m_buffer(buffer),
+      m_category(category),
+      m_name(name) {
+    if (m_buffer.isEnabled()) {
+        m_startUs = TraceBuffer::nowUs();
+    }
+}
+
+TraceScope::~TraceScope() {
+    if (m_startUs >= 0) {
+        m_buffer.complete(m_category, m_name, m_startUs, TraceBuffer::nowUs() - m_startUs);
+    }
+}
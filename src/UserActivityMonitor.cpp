@@ -0,0 +1,185 @@
+#include "UserActivityMonitor.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QSocketNotifier>
+
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <linux/input.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <utility>
+#include <vector>
+
+namespace {
+constexpr int kBitsPerLong = sizeof(unsigned long) * CHAR_BIT;
+
+bool isUserEvent(const input_event &event) {
+    return event.type == EV_KEY || event.type == EV_REL || event.type == EV_ABS;
+}
+
+/** EVIOCGBIT of @p type on @p fd; the kernel fills an array of longs, so go by long, not by byte. */
+bool readBits(int fd, int type, int count, QBitArray &bits) {
+    std::vector<unsigned long> longs(static_cast<size_t>((count + kBitsPerLong - 1) / kBitsPerLong), 0);
+    if (::ioctl(fd, EVIOCGBIT(type, longs.size() * sizeof(unsigned long)), longs.data()) < 0) {
+        return false;
+    }
+    bits.resize(count);
+    for (int bit = 0; bit < count; ++bit) {
+        bits.setBit(bit, (longs[static_cast<size_t>(bit / kBitsPerLong)] >> (bit % kBitsPerLong)) & 1UL);
+    }
+    return true;
+}
+
+bool readCapabilities(int fd, UserActivityMonitor::Capabilities &capabilities) {
+    return readBits(fd, 0, EV_CNT, capabilities.events) && readBits(fd, EV_KEY, KEY_CNT, capabilities.keys)
+        && readBits(fd, EV_REL, REL_CNT, capabilities.relative) && readBits(fd, EV_ABS, ABS_CNT, capabilities.absolute);
+}
+
+bool has(const QBitArray &bits, int bit) {
+    return bit < bits.size() && bits.testBit(bit);
+}
+}
+
+UserActivityMonitor::UserActivityMonitor(DaemonClock *clock, QString inputDir, QObject *parent)
+    : QObject(parent),
+      m_clock(clock),
+      m_inputDir(std::move(inputDir)),
+      m_timer(m_clock->createTimer(this)),
+      m_capabilityProbe(readCapabilities) {
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::VeryCoarseTimer);
+    connect(m_timer, &DaemonTimer::timeout, this, [this]() {
+        stop();
+        emit graceExpired();
+    });
+}
+
+UserActivityMonitor::~UserActivityMonitor() {
+    closeDevices();
+}
+
+void UserActivityMonitor::start(qint64 graceMs, bool watchInput) {
+    stop();
+    if (watchInput) {
+        openDevices();
+    }
+    m_active = true;
+    m_timer->start(graceMs);
+}
+
+void UserActivityMonitor::stop() {
+    m_active = false;
+    m_timer->stop();
+    closeDevices();
+}
+
+bool UserActivityMonitor::isActive() const {
+    return m_active;
+}
+
+int UserActivityMonitor::deviceCount() const {
+    return m_fds.size();
+}
+
+void UserActivityMonitor::setCapabilityProbe(CapabilityProbe probe) {
+    m_capabilityProbe = std::move(probe);
+}
+
+bool UserActivityMonitor::isUserDevice(const Capabilities &capabilities) {
+    const QBitArray &keys = capabilities.keys;
+    const bool hasKeys = has(capabilities.events, EV_KEY);
+    // Hotkey devices (power button, "Video Bus", vendor WMI keys) have keys but no letters.
+    const bool keyboard = hasKeys && has(keys, KEY_A) && has(keys, KEY_Z) && has(keys, KEY_SPACE);
+    const bool pointer = has(capabilities.events, EV_REL) && has(capabilities.relative, REL_X)
+        && has(capabilities.relative, REL_Y);
+    // Accelerometers report absolute axes too, but have no finger, pen or button to press.
+    const bool touch = has(capabilities.events, EV_ABS) && has(capabilities.absolute, ABS_X)
+        && has(capabilities.absolute, ABS_Y) && hasKeys
+        && (has(keys, BTN_TOUCH) || has(keys, BTN_TOOL_FINGER) || has(keys, BTN_TOOL_PEN) || has(keys, BTN_LEFT));
+    return keyboard || pointer || touch;
+}
+
+void UserActivityMonitor::noteActivity(const QString &source) {
+    if (!m_active) {
+        return;
+    }
+    stop();
+    emit activityDetected(source);
+}
+
+void UserActivityMonitor::setSessionIdle(bool idle) {
+    if (!idle) {
+        noteActivity(QStringLiteral("session"));
+    }
+}
+
+void UserActivityMonitor::openDevices() {
+    const QDir dir(m_inputDir);
+    const auto names = dir.entryList({QStringLiteral("event*")}, QDir::System | QDir::Files, QDir::Name);
+    for (const auto &name : names) {
+        const QByteArray path = QFile::encodeName(dir.filePath(name));
+        const int fd = ::open(path.constData(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) {
+            qWarning().noquote() << "Cannot watch input device" << path << qt_error_string(errno);
+            continue;
+        }
+        Capabilities capabilities;
+        if (!m_capabilityProbe(fd, capabilities) || !isUserDevice(capabilities)) {
+            ::close(fd);
+            continue;
+        }
+        const int index = m_fds.size();
+        auto *notifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+        connect(notifier, &QSocketNotifier::activated, this, [this, index]() { readDevice(index); });
+        m_fds.append(fd);
+        m_names.append(name);
+        m_notifiers.append(notifier);
+    }
+    if (m_fds.isEmpty()) {
+        qWarning().noquote() << "No keyboard, pointer or touch device could be opened below" << m_inputDir
+                             << "; only logind reports activity";
+    }
+}
+
+void UserActivityMonitor::closeDevices() {
+    for (auto *notifier : m_notifiers) {
+        // Activity stops the monitor from inside the notifier's own signal.
+        notifier->setEnabled(false);
+        notifier->deleteLater();
+    }
+    m_notifiers.clear();
+    for (const int fd : m_fds) {
+        ::close(fd);
+    }
+    m_fds.clear();
+    m_names.clear();
+}
+
+void UserActivityMonitor::readDevice(int index) {
+    // Drain everything queued; only the presence of a user event matters.
+    input_event events[16];
+    bool user = false;
+    for (;;) {
+        const ssize_t bytes = ::read(m_fds.at(index), events, sizeof(events));
+        if (bytes <= 0) {
+            if (bytes == 0 || errno != EAGAIN) {
+                // Unplugged (or end of a test FIFO): stop listening to it.
+                m_notifiers.at(index)->setEnabled(false);
+            }
+            break;
+        }
+        for (size_t i = 0; i < static_cast<size_t>(bytes) / sizeof(input_event); ++i) {
+            user = user || isUserEvent(events[i]);
+        }
+    }
+    if (user) {
+        // A copy: noteActivity() stops the monitor, which clears m_names before the signal is emitted.
+        const QString source = m_names.at(index);
+        noteActivity(source);
+    }
+}
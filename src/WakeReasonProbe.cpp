@@ -0,0 +1,206 @@
+#include "WakeReasonProbe.h"
+
+#include "KernelFiles.h"
+#include "StateFile.h"
+
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QVector>
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+bool looksLikeRtc(const QString &name) {
+    static const QRegularExpression rtc(QStringLiteral("rtc|alarmtimer"), QRegularExpression::CaseInsensitiveOption);
+    return rtc.match(name).hasMatch();
+}
+}
+
+QString WakeReasonProbe::Attribution::primary() const {
+    if (!sources.isEmpty()) {
+        return sources.first();
+    }
+    return irq.isEmpty() ? QStringLiteral("unknown") : irq;
+}
+
+WakeReasonProbe::WakeReasonProbe(QString sysRoot, QString procRoot)
+    : m_sysRoot(std::move(sysRoot)),
+      m_procRoot(std::move(procRoot)) {}
+
+WakeReasonProbe::Snapshot WakeReasonProbe::snapshot() const {
+    const Snapshot classWakeup = readClassWakeup();
+    // /sys/class/wakeup appeared in 5.4; older kernels only have the debugfs table.
+    return classWakeup.isEmpty() ? readDebugfs() : classWakeup;
+}
+
+WakeReasonProbe::Snapshot WakeReasonProbe::readClassWakeup() const {
+    Snapshot result;
+    const QDir dir(m_sysRoot + QStringLiteral("/class/wakeup"));
+    for (const auto &entry : dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        const QString path = dir.filePath(entry);
+        const QString name = QString::fromUtf8(KernelFiles::readValue(path + QStringLiteral("/name")));
+        // Several devices may share a name; their counts add up.
+        Counters &counters = result[name.isEmpty() ? entry : name];
+        counters.events += KernelFiles::readValue(path + QStringLiteral("/event_count")).toULongLong();
+        counters.wakeups += KernelFiles::readValue(path + QStringLiteral("/wakeup_count")).toULongLong();
+    }
+    return result;
+}
+
+WakeReasonProbe::Snapshot WakeReasonProbe::readDebugfs() const {
+    Snapshot result;
+    QFile file(m_sysRoot + QStringLiteral("/kernel/debug/wakeup_sources"));
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return result;
+    }
+    // name active_count event_count wakeup_count expire_count ...
+    file.readLine();
+    while (!file.atEnd()) {
+        const QList<QByteArray> fields = file.readLine().simplified().split(' ');
+        if (fields.size() < 4) {
+            continue;
+        }
+        Counters &counters = result[QString::fromUtf8(fields.at(0))];
+        counters.events += fields.at(2).toULongLong();
+        counters.wakeups += fields.at(3).toULongLong();
+    }
+    return result;
+}
+
+QString WakeReasonProbe::wakeupIrq() const {
+    bool ok = false;
+    const int irq = KernelFiles::readValue(m_sysRoot + QStringLiteral("/power/pm_wakeup_irq")).toInt(&ok);
+    return ok ? describeIrq(irq) : QString();
+}
+
+QString WakeReasonProbe::describeIrq(int irq) const {
+    QFile file(m_procRoot + QStringLiteral("/interrupts"));
+    const QByteArray prefix = QByteArray::number(irq) + ':';
+    if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        while (!file.atEnd()) {
+            const QList<QByteArray> fields = file.readLine().simplified().split(' ');
+            if (fields.size() > 1 && fields.first() == prefix) {
+                // The handler name is the last column, after the per-CPU counts and the chip.
+                return QStringLiteral("irq %1 (%2)").arg(irq).arg(QString::fromUtf8(fields.last()));
+            }
+        }
+    }
+    return QStringLiteral("irq %1").arg(irq);
+}
+
+WakeReasonProbe::Attribution WakeReasonProbe::attribute(const Snapshot &before, const Snapshot &after) const {
+    struct Delta {
+        QString name;
+        quint64 events {0};
+        quint64 wakeups {0};
+    };
+    QVector<Delta> deltas;
+    bool anyWakeup = false;
+    for (auto it = after.cbegin(); it != after.cend(); ++it) {
+        const Counters previous = before.value(it.key());
+        Delta delta;
+        delta.name = it.key();
+        delta.events = it->events > previous.events ? it->events - previous.events : 0;
+        delta.wakeups = it->wakeups > previous.wakeups ? it->wakeups - previous.wakeups : 0;
+        anyWakeup = anyWakeup || delta.wakeups > 0;
+        if (delta.events > 0 || delta.wakeups > 0) {
+            deltas.append(delta);
+        }
+    }
+    std::stable_sort(deltas.begin(), deltas.end(), [](const Delta &a, const Delta &b) {
+        return a.wakeups != b.wakeups ? a.wakeups > b.wakeups : a.events > b.events;
+    });
+
+    Attribution attribution;
+    for (const auto &delta : deltas) {
+        // Many drivers only count events; fall back to them when no source claimed a wakeup.
+        if (delta.wakeups > 0 || !anyWakeup) {
+            attribution.sources << delta.name;
+            attribution.rtc = attribution.rtc || looksLikeRtc(delta.name);
+        }
+    }
+    attribution.irq = wakeupIrq();
+    attribution.rtc = attribution.rtc || looksLikeRtc(attribution.irq);
+    return attribution;
+}
+
+WakeReasonProbe::Verdict WakeReasonProbe::classify(const QDateTime &alarm, const QDateTime &resumed,
+                                                   const Attribution &attribution) {
+    if (!alarm.isValid() || !resumed.isValid()) {
+        return Verdict::OnTime;
+    }
+    const qint64 offsetMs = alarm.msecsTo(resumed);
+    if (offsetMs < -kEarlyToleranceMs) {
+        return Verdict::Early;
+    }
+    if (offsetMs > kLateToleranceMs) {
+        const bool otherSource = !attribution.rtc && (!attribution.sources.isEmpty() || !attribution.irq.isEmpty());
+        return otherSource ? Verdict::Missed : Verdict::Late;
+    }
+    return Verdict::OnTime;
+}
+
+QString WakeReasonProbe::verdictLabel(Verdict verdict) {
+    switch (verdict) {
+    case Verdict::Early:
+        return QStringLiteral("early");
+    case Verdict::Late:
+        return QStringLiteral("late");
+    case Verdict::Missed:
+        return QStringLiteral("missed");
+    case Verdict::OnTime:
+    default:
+        return QStringLiteral("on_time");
+    }
+}
+
+QMap<QString, WakeReasonProbe::SourceCounts> WakeReasonProbe::loadCounts(const QString &path) {
+    QMap<QString, SourceCounts> result;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return result;
+    }
+    const QJsonObject sources = QJsonDocument::fromJson(file.readAll()).object().value(QStringLiteral("sources")).toObject();
+    for (auto it = sources.begin(); it != sources.end(); ++it) {
+        const QJsonObject obj = it.value().toObject();
+        SourceCounts counts;
+        counts.wakes = obj.value(QStringLiteral("wakes")).toInt();
+        counts.early = obj.value(QStringLiteral("early")).toInt();
+        counts.late = obj.value(QStringLiteral("late")).toInt();
+        counts.missed = obj.value(QStringLiteral("missed")).toInt();
+        counts.last = QDateTime::fromString(obj.value(QStringLiteral("last")).toString(), Qt::ISODate);
+        if (counts.wakes > 0) {
+            result.insert(it.key(), counts);
+        }
+    }
+    return result;
+}
+
+bool WakeReasonProbe::recordWake(const QString &path, const QString &source, Verdict verdict, const QDateTime &when) {
+    QMap<QString, SourceCounts> all = loadCounts(path);
+    SourceCounts &counts = all[source];
+    ++counts.wakes;
+    counts.early += verdict == Verdict::Early ? 1 : 0;
+    counts.late += verdict == Verdict::Late ? 1 : 0;
+    counts.missed += verdict == Verdict::Missed ? 1 : 0;
+    counts.last = when;
+
+    QJsonObject sources;
+    for (auto it = all.cbegin(); it != all.cend(); ++it) {
+        QJsonObject obj;
+        obj.insert(QStringLiteral("wakes"), it->wakes);
+        obj.insert(QStringLiteral("early"), it->early);
+        obj.insert(QStringLiteral("late"), it->late);
+        obj.insert(QStringLiteral("missed"), it->missed);
+        obj.insert(QStringLiteral("last"), it->last.toUTC().toString(Qt::ISODate));
+        sources.insert(it.key(), obj);
+    }
+    QJsonObject root;
+    root.insert(QStringLiteral("sources"), sources);
+
+    return saveJsonState(path, root);
+}
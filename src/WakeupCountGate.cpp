@@ -0,0 +1,58 @@
+#include "WakeupCountGate.h"
+
+#include <QByteArray>
+#include <QFile>
+
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <utility>
+
+WakeupCountGate::WakeupCountGate(QString sysRoot)
+    : m_sysRoot(std::move(sysRoot)) {}
+
+WakeupCountGate::Result WakeupCountGate::arm(quint64 *count) const {
+    const QByteArray path = QFile::encodeName(m_sysRoot + QStringLiteral("/power/wakeup_count"));
+    const int fd = ::open(path.constData(), O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        return Result::Unavailable;
+    }
+    char buffer[32];
+    // Blocks while wakeup events are being processed; an interrupted read means one is.
+    const ssize_t bytes = ::read(fd, buffer, sizeof(buffer));
+    if (bytes <= 0) {
+        const Result result = bytes < 0 && errno == EINTR ? Result::Pending : Result::Unavailable;
+        ::close(fd);
+        return result;
+    }
+    bool ok = false;
+    const QByteArray value = QByteArray(buffer, static_cast<int>(bytes)).trimmed();
+    const quint64 current = value.toULongLong(&ok);
+    if (!ok) {
+        ::close(fd);
+        return Result::Unavailable;
+    }
+    if (count) {
+        *count = current;
+    }
+    Result result = Result::Armed;
+    if (::lseek(fd, 0, SEEK_SET) < 0 || ::write(fd, value.constData(), static_cast<size_t>(value.size())) != value.size()) {
+        // The kernel refuses a stale count with EINVAL (EBUSY on some kernels).
+        result = errno == EINVAL || errno == EBUSY ? Result::Pending : Result::Unavailable;
+    }
+    ::close(fd);
+    return result;
+}
+
+QString WakeupCountGate::resultLabel(Result result) {
+    switch (result) {
+    case Result::Armed:
+        return QStringLiteral("armed");
+    case Result::Pending:
+        return QStringLiteral("wakeup_pending");
+    case Result::Unavailable:
+    default:
+        return QStringLiteral("unavailable");
+    }
+}
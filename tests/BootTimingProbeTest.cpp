@@ -0,0 +1,58 @@
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include "BootTimingProbe.h"
+#include "TestFiles.h"
+
+class BootTimingProbeTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void anchors_milestones_on_uptime();
+    void leaves_unknown_milestones_invalid();
+    void reads_uptime();
+};
+
+void BootTimingProbeTest::anchors_milestones_on_uptime() {
+    const QDateTime now(QDate(2030, 1, 7), QTime(7, 0, 30), Qt::UTC);
+    BootTimingProbe::Timestamps stamps;
+    stamps.firmwareUs = 6500000;
+    stamps.userspaceUs = 2250000;
+    stamps.finishUs = 21750000;
+
+    const auto timing = BootTimingProbe::compute(now, 25.5, stamps);
+    QCOMPARE(timing.kernelStarted, QDateTime(QDate(2030, 1, 7), QTime(7, 0, 4, 500), Qt::UTC));
+    QCOMPARE(timing.poweredOn, QDateTime(QDate(2030, 1, 7), QTime(6, 59, 58), Qt::UTC));
+    QCOMPARE(timing.userspaceStarted, QDateTime(QDate(2030, 1, 7), QTime(7, 0, 6, 750), Qt::UTC));
+    QCOMPARE(timing.ready, QDateTime(QDate(2030, 1, 7), QTime(7, 0, 26, 250), Qt::UTC));
+}
+
+void BootTimingProbeTest::leaves_unknown_milestones_invalid() {
+    const QDateTime now(QDate(2030, 1, 7), QTime(7, 0), Qt::UTC);
+    BootTimingProbe::Timestamps stamps;
+    // Virtual machines and BIOS boots report no firmware time.
+    stamps.finishUs = 9000000;
+
+    const auto timing = BootTimingProbe::compute(now, 12.0, stamps);
+    QVERIFY(!timing.poweredOn.isValid());
+    QVERIFY(!timing.userspaceStarted.isValid());
+    QCOMPARE(timing.ready, now.addSecs(-3));
+
+    QVERIFY(!BootTimingProbe::compute(now, -1.0, stamps).ready.isValid());
+    QVERIFY(!BootTimingProbe::compute(now, 12.0, BootTimingProbe::Timestamps()).ready.isValid());
+}
+
+void BootTimingProbeTest::reads_uptime() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const BootTimingProbe probe(dir.filePath(QStringLiteral("proc")));
+    QCOMPARE(probe.uptimeSeconds(), -1.0);
+
+    QVERIFY(writeFile(dir.filePath(QStringLiteral("proc/uptime")), "25.51 83.20\n"));
+    QCOMPARE(probe.uptimeSeconds(), 25.51);
+    QVERIFY(!probe.isAvailable());
+}
+
+QTEST_MAIN(BootTimingProbeTest)
+
+#include "BootTimingProbeTest.moc"
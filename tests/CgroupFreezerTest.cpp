@@ -0,0 +1,70 @@
+#include <QtTest>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include "CgroupFreezer.h"
+#include "TestFiles.h"
+
+class CgroupFreezerTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void names_user_slice();
+    void needs_cgroup_v2();
+    void freezes_and_thaws();
+    void reads_frozen_state();
+};
+
+void CgroupFreezerTest::names_user_slice() {
+    QCOMPARE(CgroupFreezer::userSlice(1000), QStringLiteral("user.slice/user-1000.slice"));
+}
+
+void CgroupFreezerTest::needs_cgroup_v2() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const CgroupFreezer freezer(dir.path());
+    QVERIFY(!freezer.supported());
+    QVERIFY(writeFile(dir.filePath(QStringLiteral("user.slice/cgroup.freeze")), "0\n"));
+    QVERIFY(!freezer.supported());
+    QVERIFY(writeFile(dir.filePath(QStringLiteral("cgroup.controllers")), "cpu io memory pids\n"));
+    QVERIFY(freezer.supported());
+}
+
+void CgroupFreezerTest::freezes_and_thaws() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString slice = CgroupFreezer::userSlice(1000);
+    const QString freezeFile = dir.filePath(slice + QStringLiteral("/cgroup.freeze"));
+    QVERIFY(writeFile(freezeFile, "0\n"));
+
+    const CgroupFreezer freezer(dir.path());
+    QVERIFY(freezer.freeze(slice));
+    QCOMPARE(readValue(freezeFile), QByteArray("1"));
+    QVERIFY(freezer.thaw(slice));
+    QCOMPARE(readValue(freezeFile), QByteArray("0"));
+
+    // A user without a slice has nothing to freeze, and no file may appear for it.
+    QVERIFY(QDir().mkpath(dir.filePath(CgroupFreezer::userSlice(1001))));
+    QVERIFY(!freezer.freeze(CgroupFreezer::userSlice(1001)));
+    QVERIFY(!QFile::exists(dir.filePath(CgroupFreezer::userSlice(1001) + QStringLiteral("/cgroup.freeze"))));
+    QVERIFY(!freezer.freeze(CgroupFreezer::userSlice(1002)));
+}
+
+void CgroupFreezerTest::reads_frozen_state() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString slice = CgroupFreezer::userSlice(1000);
+    const QString events = dir.filePath(slice + QStringLiteral("/cgroup.events"));
+    const CgroupFreezer freezer(dir.path());
+    QVERIFY(!freezer.isFrozen(slice));
+
+    QVERIFY(writeFile(events, "populated 1\nfrozen 0\n"));
+    QVERIFY(!freezer.isFrozen(slice));
+    QVERIFY(writeFile(events, "populated 1\nfrozen 1\n"));
+    QVERIFY(freezer.isFrozen(slice));
+}
+
+QTEST_MAIN(CgroupFreezerTest)
+
+#include "CgroupFreezerTest.moc"
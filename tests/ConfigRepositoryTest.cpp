@@ -34,6 +34,7 @@ void ConfigRepositoryTest::saveAndLoad() {
     config.singleWakeDate = QDate(2035, 5, 25);
     config.singleWakeTime = QTime(6, 45);
     config.actionId = static_cast<int>(PowerAction::Hibernate);
+    config.hibernateDelayMinutes = 95;
     config.warning.enabled = true;
     config.warning.message = QStringLiteral("Test message");
     config.warning.countdownSeconds = 42;
@@ -51,12 +52,65 @@ void ConfigRepositoryTest::saveAndLoad() {
     config.session.dbusAddress = QStringLiteral("unix:path=/run/user/999/bus");
     config.session.xauthority = QStringLiteral("/run/user/999/xauth");
     config.session.waylandDisplay = QStringLiteral("wayland-1");
+    config.prefetch.enabled = true;
+    config.prefetch.paths = QStringList({QStringLiteral("~/projects"), QStringLiteral("/opt/toolchain")});
+    config.prefetch.workers = 6;
+    config.prefetch.budgetSeconds = 45;
+    config.deferral.enabled = true;
+    config.deferral.maxLoadPerCpu = 0.75;
+    config.deferral.maxIoPressure = 0;
+    config.deferral.blockingProcesses = QStringList({QStringLiteral("borg"), QStringLiteral("ffmpeg")});
+    config.deferral.stepMinutes = 15;
+    config.deferral.maxDelayMinutes = 90;
+    config.idleSuspend.enabled = true;
+    config.idleSuspend.idleMinutes = 45;
+    config.idleSuspend.windowStart = QTime(21, 30);
+    config.idleSuspend.windowEnd = QTime(5, 0);
+    config.idleSuspend.actionId = static_cast<int>(PowerAction::SuspendToIdle);
+    config.idleSuspend.requireSessionIdle = false;
+    config.maintenance.maxParallel = 3;
+    config.maintenance.requireSessionIdle = false;
+    config.returnToSleep.enabled = true;
+    config.returnToSleep.graceMinutes = 35;
+    config.returnToSleep.watchInputDevices = false;
+    config.returnToSleep.watchSession = false;
+    config.hibernateTuning.enabled = true;
+    config.hibernateTuning.imageSizePercent = 0;
+    config.hibernateTuning.dropCaches = true;
+    config.hibernateTuning.compactMemory = true;
+    config.hibernateTuning.diskMode = QStringLiteral("shutdown");
+    config.hibernateTuning.compressor = QStringLiteral("lz4");
+    config.wakeLead.enabled = true;
+    config.wakeLead.percentile = 75;
+    config.wakeLead.minSamples = 3;
+    config.wakeLead.maxLeadMinutes = 4;
+    config.rtc.device = QStringLiteral("rtc1");
+    config.rtc.maxAlarmHours = 24;
+    config.sleepEntry.maxAttempts = 5;
+    config.sleepEntry.backoffSeconds = 1;
+    config.sleepEntry.maxBackoffSeconds = 8;
+    config.sleepEntry.fallbackModes = {QStringLiteral("freeze"), QStringLiteral("mem")};
+    config.sleepEntry.adaptiveOrder = false;
+    config.energy.enabled = true;
+    config.energy.sampleMinutes = 7;
+    config.timerBackend.enabled = true;
+    config.timerBackend.unitDir = QStringLiteral("/run/systemd/system");
 
     for (auto &entry : config.weekly) {
         entry.enabled = (entry.day == Qt::Monday || entry.day == Qt::Friday);
         entry.shutdownTime = QTime(22, 15);
         entry.wakeTime = QTime(6 + static_cast<int>(entry.day), 30);
     }
+    MaintenanceJob backup;
+    backup.name = QStringLiteral("backup");
+    backup.command = QStringLiteral("borg create ::{now}");
+    backup.nice = 15;
+    backup.ioClass = 2;
+    backup.ioLevel = 6;
+    backup.timeoutSeconds = 5400;
+    config.weekly[0].jobs = {backup};
+    config.weekly[0].resuspendAfterJobs = false;
+    config.weekly[0].resuspendUntil = QTime(7, 45);
 
     QVERIFY(repo.save(config));
 
@@ -66,6 +120,7 @@ void ConfigRepositoryTest::saveAndLoad() {
     QCOMPARE(loaded.singleWakeDate, config.singleWakeDate);
     QCOMPARE(loaded.singleWakeTime, config.singleWakeTime);
     QCOMPARE(loaded.actionId, config.actionId);
+    QCOMPARE(loaded.hibernateDelayMinutes, config.hibernateDelayMinutes);
     QCOMPARE(loaded.warning.enabled, config.warning.enabled);
     QCOMPARE(loaded.warning.message, config.warning.message);
     QCOMPARE(loaded.warning.countdownSeconds, config.warning.countdownSeconds);
@@ -83,13 +138,66 @@ void ConfigRepositoryTest::saveAndLoad() {
     QCOMPARE(loaded.session.dbusAddress, config.session.dbusAddress);
     QCOMPARE(loaded.session.xauthority, config.session.xauthority);
     QCOMPARE(loaded.session.waylandDisplay, config.session.waylandDisplay);
+    QCOMPARE(loaded.prefetch.enabled, config.prefetch.enabled);
+    QCOMPARE(loaded.prefetch.paths, config.prefetch.paths);
+    QCOMPARE(loaded.prefetch.workers, config.prefetch.workers);
+    QCOMPARE(loaded.prefetch.budgetSeconds, config.prefetch.budgetSeconds);
+    QCOMPARE(loaded.deferral.enabled, config.deferral.enabled);
+    QCOMPARE(loaded.deferral.maxLoadPerCpu, config.deferral.maxLoadPerCpu);
+    QCOMPARE(loaded.deferral.maxIoPressure, config.deferral.maxIoPressure);
+    QCOMPARE(loaded.deferral.blockingProcesses, config.deferral.blockingProcesses);
+    QCOMPARE(loaded.deferral.stepMinutes, config.deferral.stepMinutes);
+    QCOMPARE(loaded.deferral.maxDelayMinutes, config.deferral.maxDelayMinutes);
+    QCOMPARE(loaded.idleSuspend.enabled, config.idleSuspend.enabled);
+    QCOMPARE(loaded.idleSuspend.idleMinutes, config.idleSuspend.idleMinutes);
+    QCOMPARE(loaded.idleSuspend.windowStart, config.idleSuspend.windowStart);
+    QCOMPARE(loaded.idleSuspend.windowEnd, config.idleSuspend.windowEnd);
+    QCOMPARE(loaded.idleSuspend.actionId, config.idleSuspend.actionId);
+    QCOMPARE(loaded.idleSuspend.requireSessionIdle, config.idleSuspend.requireSessionIdle);
+    QCOMPARE(loaded.maintenance.maxParallel, config.maintenance.maxParallel);
+    QCOMPARE(loaded.maintenance.requireSessionIdle, config.maintenance.requireSessionIdle);
+    QCOMPARE(loaded.returnToSleep.enabled, config.returnToSleep.enabled);
+    QCOMPARE(loaded.returnToSleep.graceMinutes, config.returnToSleep.graceMinutes);
+    QCOMPARE(loaded.returnToSleep.watchInputDevices, config.returnToSleep.watchInputDevices);
+    QCOMPARE(loaded.returnToSleep.watchSession, config.returnToSleep.watchSession);
+    QCOMPARE(loaded.hibernateTuning.enabled, config.hibernateTuning.enabled);
+    QCOMPARE(loaded.hibernateTuning.imageSizePercent, config.hibernateTuning.imageSizePercent);
+    QCOMPARE(loaded.hibernateTuning.dropCaches, config.hibernateTuning.dropCaches);
+    QCOMPARE(loaded.hibernateTuning.compactMemory, config.hibernateTuning.compactMemory);
+    QCOMPARE(loaded.hibernateTuning.diskMode, config.hibernateTuning.diskMode);
+    QCOMPARE(loaded.hibernateTuning.compressor, config.hibernateTuning.compressor);
+    QCOMPARE(loaded.wakeLead.enabled, config.wakeLead.enabled);
+    QCOMPARE(loaded.wakeLead.percentile, config.wakeLead.percentile);
+    QCOMPARE(loaded.wakeLead.minSamples, config.wakeLead.minSamples);
+    QCOMPARE(loaded.wakeLead.maxLeadMinutes, config.wakeLead.maxLeadMinutes);
+    QCOMPARE(loaded.rtc.device, config.rtc.device);
+    QCOMPARE(loaded.rtc.maxAlarmHours, config.rtc.maxAlarmHours);
+    QCOMPARE(loaded.sleepEntry.maxAttempts, config.sleepEntry.maxAttempts);
+    QCOMPARE(loaded.sleepEntry.backoffSeconds, config.sleepEntry.backoffSeconds);
+    QCOMPARE(loaded.sleepEntry.maxBackoffSeconds, config.sleepEntry.maxBackoffSeconds);
+    QCOMPARE(loaded.sleepEntry.fallbackModes, config.sleepEntry.fallbackModes);
+    QCOMPARE(loaded.sleepEntry.adaptiveOrder, config.sleepEntry.adaptiveOrder);
+    QCOMPARE(loaded.energy.enabled, config.energy.enabled);
+    QCOMPARE(loaded.energy.sampleMinutes, config.energy.sampleMinutes);
+    QCOMPARE(loaded.timerBackend.enabled, config.timerBackend.enabled);
+    QCOMPARE(loaded.timerBackend.unitDir, config.timerBackend.unitDir);
 
     for (int i = 0; i < config.weekly.size(); ++i) {
         QCOMPARE(static_cast<int>(loaded.weekly.at(i).day), static_cast<int>(config.weekly.at(i).day));
         QCOMPARE(loaded.weekly.at(i).enabled, config.weekly.at(i).enabled);
         QCOMPARE(loaded.weekly.at(i).shutdownTime, config.weekly.at(i).shutdownTime);
         QCOMPARE(loaded.weekly.at(i).wakeTime, config.weekly.at(i).wakeTime);
+        QCOMPARE(loaded.weekly.at(i).jobs.size(), config.weekly.at(i).jobs.size());
+        QCOMPARE(loaded.weekly.at(i).resuspendAfterJobs, config.weekly.at(i).resuspendAfterJobs);
+        QCOMPARE(loaded.weekly.at(i).resuspendUntil, config.weekly.at(i).resuspendUntil);
     }
+    const MaintenanceJob &job = loaded.weekly.at(0).jobs.at(0);
+    QCOMPARE(job.name, backup.name);
+    QCOMPARE(job.command, backup.command);
+    QCOMPARE(job.nice, backup.nice);
+    QCOMPARE(job.ioClass, backup.ioClass);
+    QCOMPARE(job.ioLevel, backup.ioLevel);
+    QCOMPARE(job.timeoutSeconds, backup.timeoutSeconds);
 }
 
 QTEST_MAIN(ConfigRepositoryTest)
@@ -0,0 +1,82 @@
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include "CycleHistoryStore.h"
+
+class CycleHistoryStoreTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void appends_and_wraps();
+    void readers_share_the_file();
+    void rejects_foreign_files();
+};
+
+namespace {
+CycleHistoryStore::Record makeRecord(qint64 resume, qint64 sleptMs) {
+    CycleHistoryStore::Record record;
+    record.plannedShutdown = resume - 3600;
+    record.actualShutdown = resume - 3600;
+    record.plannedWake = resume;
+    record.actualResume = resume;
+    record.suspendedMs = sleptMs;
+    record.outcome = static_cast<qint32>(CycleHistoryStore::Outcome::Completed);
+    return record;
+}
+}
+
+void CycleHistoryStoreTest::appends_and_wraps() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    CycleHistoryStore store(dir.filePath(QStringLiteral("history.bin")), 3);
+    QVERIFY(store.open(true));
+
+    for (qint64 i = 1; i <= 5; ++i) {
+        QVERIFY(store.append(makeRecord(1000 * i, 3600 * 1000)));
+    }
+    QCOMPARE(store.totalAppended(), quint64(5));
+
+    const auto records = store.records();
+    QCOMPARE(records.size(), 3);
+    QCOMPARE(records.first().actualResume, qint64(3000));
+    QCOMPARE(records.last().actualResume, qint64(5000));
+    QCOMPARE(CycleHistoryStore::sleptSeconds(records), qint64(3 * 3600));
+    QCOMPARE(store.records(QDateTime::fromSecsSinceEpoch(4500)).size(), 1);
+}
+
+void CycleHistoryStoreTest::readers_share_the_file() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("state/history.bin"));
+
+    CycleHistoryStore writer(path, 8);
+    QVERIFY(writer.open(true));
+    QVERIFY(writer.append(makeRecord(2000, 1000)));
+
+    CycleHistoryStore reader(path, 64);
+    QVERIFY(reader.open(false));
+    QCOMPARE(reader.capacity(), quint32(8));
+    QCOMPARE(reader.records().size(), 1);
+    QVERIFY(!reader.append(makeRecord(3000, 1000)));
+
+    QVERIFY(writer.append(makeRecord(3000, 1000)));
+    QCOMPARE(reader.records().size(), 2);
+}
+
+void CycleHistoryStoreTest::rejects_foreign_files() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("history.bin"));
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(QByteArray(256, 'x'));
+    file.close();
+
+    CycleHistoryStore store(path);
+    QVERIFY(!store.open(true));
+    QVERIFY(!store.isOpen());
+}
+
+QTEST_MAIN(CycleHistoryStoreTest)
+
+#include "CycleHistoryStoreTest.moc"
@@ -0,0 +1,1006 @@
+#include <QtTest>
+#include <QAbstractEventDispatcher>
+#include <QElapsedTimer>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTimeZone>
+
+#include <cmath>
+#include <functional>
+#include <pwd.h>
+#include <unistd.h>
+
+#include "ConfigRepository.h"
+#include "CycleHistoryStore.h"
+#include "RtcDriftModel.h"
+#include "RtcWakeDaemon.h"
+#include "SimulatedClock.h"
+#include "SleepModeStats.h"
+
+namespace {
+/** RTC backend that "sleeps" by jumping the simulated clock to the wake time. */
+class FakeRtc : public RtcWakeController {
+public:
+    struct Transition {
+        QDateTime shutdown;
+        QDateTime wakeUtc;
+        PowerAction action;
+    };
+
+    explicit FakeRtc(SimulatedClock &clock)
+        : m_clock(clock) {}
+
+    CommandResult scheduleWake(const QDateTime &targetUtc, PowerAction action) const override {
+        const QString command = QStringLiteral("fake-rtcwake -m %1").arg(rtcwakeMode(action));
+        if (failingModes.contains(rtcwakeMode(action))) {
+            ++failures;
+            CommandResult result;
+            result.exitCode = 1;
+            result.commandLine = command;
+            result.stdErr = QStringLiteral("write error");
+            return result;
+        }
+        const QDateTime start = m_clock.now();
+        transitions.append({start, targetUtc, action});
+        alarm = 0;
+        m_clock.suspend(targetUtc.addSecs(resumeDelaySecs));
+        if (onSleep) {
+            onSleep();
+        }
+        if (driftPpm != 0.0) {
+            // The wall clock resumed from the drifted RTC; NTP puts it right a minute later.
+            const qint64 gainMs = std::llround(driftPpm * 1e-6 * start.msecsTo(targetUtc));
+            m_clock.singleShot(60 * 1000, const_cast<FakeRtc *>(this),
+                               [this, gainMs]() { m_clock.setWallClock(m_clock.now().addMSecs(-gainMs)); });
+        }
+        return succeed(command);
+    }
+
+    CommandResult programAlarm(const QDateTime &targetUtc) const override {
+        ++programs;
+        alarm = targetUtc.toSecsSinceEpoch();
+        return succeed(QStringLiteral("fake-rtcwake -m no"));
+    }
+
+    qint64 currentAlarm() const override {
+        return alarm;
+    }
+
+    qint64 currentRtcTime() const override {
+        return m_clock.now().toSecsSinceEpoch();
+    }
+
+    qint64 alarmRangeSecs() const override {
+        return rangeSecs;
+    }
+
+    WakeupCountGate::Result armWakeupCount() const override {
+        if (pendingWakeups > 0) {
+            --pendingWakeups;
+            return WakeupCountGate::Result::Pending;
+        }
+        return WakeupCountGate::Result::Armed;
+    }
+
+    mutable QVector<Transition> transitions;
+    mutable int programs {0};
+    mutable qint64 alarm {0};
+    int resumeDelaySecs {4};
+    /** How much faster than real time the RTC runs while the machine sleeps. */
+    double driftPpm {0.0};
+    /** Alarm range the RTC reports; 0 is unlimited. */
+    qint64 rangeSecs {0};
+    /** Handshakes that report a wakeup event racing the suspend. */
+    mutable int pendingWakeups {0};
+    /** rtcwake modes that fail without sleeping. */
+    QStringList failingModes;
+    mutable int failures {0};
+    /** Runs while the machine "sleeps", e.g. to move energy counters. */
+    std::function<void()> onSleep;
+
+private:
+    static CommandResult succeed(const QString &commandLine) {
+        CommandResult result;
+        result.success = true;
+        result.exitCode = 0;
+        result.commandLine = commandLine;
+        return result;
+    }
+
+    SimulatedClock &m_clock;
+};
+
+int countLines(const QString &path, const QString &needle) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return -1;
+    }
+    int count = 0;
+    while (!file.atEnd()) {
+        if (QString::fromUtf8(file.readLine()).contains(needle)) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+AppConfig weeklyConfig(const QVector<int> &days, const QTime &shutdown, const QTime &wake) {
+    AppConfig config;
+    config.singleShutdownDate = QDate(2000, 1, 1);
+    config.singleWakeDate = QDate(2000, 1, 1);
+    config.actionId = static_cast<int>(PowerAction::SuspendToRam);
+    config.warning.enabled = false;
+    for (auto &entry : config.weekly) {
+        entry.enabled = days.contains(entry.day);
+        entry.shutdownTime = shutdown;
+        entry.wakeTime = wake;
+    }
+    return config;
+}
+
+/** Number of times the thread's event dispatcher woke up while the loop ran for @p msecs. */
+int countDispatcherWakeups(int msecs) {
+    int wakeups = 0;
+    auto *dispatcher = QAbstractEventDispatcher::instance();
+    const auto connection = QObject::connect(dispatcher, &QAbstractEventDispatcher::awake, [&wakeups]() { ++wakeups; });
+    QEventLoop loop;
+    QTimer::singleShot(msecs, &loop, &QEventLoop::quit);
+    loop.exec();
+    QObject::disconnect(connection);
+    return wakeups;
+}
+}
+
+class DaemonSimulationTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void simulated_timers_fire_in_order();
+    void runs_weekday_schedule_across_dst();
+    void idles_without_wakeups();
+    void replans_when_wall_clock_steps();
+    void defers_while_busy();
+    void keeps_deferral_steps_across_clock_steps();
+    void suspends_when_idle_in_window();
+    void resuspends_after_maintenance_jobs();
+    void returns_to_sleep_without_activity();
+    void hibernates_at_interim_wake();
+    void compensates_rtc_drift();
+    void wakes_early_by_learned_resume_time();
+    void ignores_early_wakes_in_resume_latency();
+    void chains_alarms_beyond_rtc_range();
+    void retries_and_falls_back_when_sleep_fails();
+    void accounts_energy_per_phase();
+    void freezes_user_session_for_window();
+};
+
+void DaemonSimulationTest::simulated_timers_fire_in_order() {
+    SimulatedClock clock(QDateTime(QDate(2030, 1, 1), QTime(12, 0), Qt::UTC));
+    QObject context;
+    QStringList fired;
+
+    DaemonTimer *repeating = clock.createTimer(&context);
+    repeating->setInterval(60 * 1000);
+    connect(repeating, &DaemonTimer::timeout, &context, [&]() { fired << QStringLiteral("tick"); });
+    repeating->start();
+    clock.singleShot(90 * 1000, &context, [&]() { fired << QStringLiteral("once"); });
+
+    clock.advanceBy(150 * 1000);
+    QCOMPARE(fired, QStringList({QStringLiteral("tick"), QStringLiteral("once"), QStringLiteral("tick")}));
+    QCOMPARE(clock.monotonicMs(), qint64(150 * 1000));
+
+    // Sleeping moves wall and boot time but not monotonic time: no timer catches up,
+    // the change watchers are told instead.
+    int changes = 0;
+    ClockChangeWatcher *watcher = clock.createChangeWatcher(&context);
+    connect(watcher, &ClockChangeWatcher::changed, &context, [&]() { ++changes; });
+    clock.suspend(clock.now().addSecs(3600));
+    QCOMPARE(clock.bootMs() - clock.monotonicMs(), qint64(3600 * 1000));
+    fired.clear();
+    clock.advanceBy(0);
+    QVERIFY(fired.isEmpty());
+    QCOMPARE(changes, 1);
+    QCOMPARE(clock.activeTimers(), 1);
+
+    clock.advanceBy(30 * 1000);
+    QCOMPARE(fired, QStringList({QStringLiteral("tick")}));
+    QCOMPARE(changes, 1);
+}
+
+void DaemonSimulationTest::runs_weekday_schedule_across_dst() {
+    const QTimeZone berlin(QByteArrayLiteral("Europe/Berlin"));
+    if (!berlin.isValid()) {
+        QSKIP("Time zone data for Europe/Berlin is not available");
+    }
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    AppConfig config;
+    config.singleShutdownDate = QDate(2000, 1, 1);
+    config.singleWakeDate = QDate(2000, 1, 1);
+    config.actionId = static_cast<int>(PowerAction::SuspendToRam);
+    config.warning.enabled = false;
+    for (auto &entry : config.weekly) {
+        entry.enabled = entry.day <= Qt::Friday;
+        entry.shutdownTime = QTime(23, 0);
+        entry.wakeTime = QTime(7, 0);
+    }
+    const QString configPath = dir.filePath(QStringLiteral("config.json"));
+    QVERIFY(ConfigRepository(configPath).save(config));
+
+    // Three months spanning the switch to summer time on 2030-03-31.
+    const QDateTime start(QDate(2030, 3, 1), QTime(12, 0), berlin);
+    const QDateTime end(QDate(2030, 5, 31), QTime(12, 0), berlin);
+    SimulatedClock clock(start);
+    FakeRtc rtc(clock);
+
+    RtcWakeDaemon::Options options;
+    options.configPath = configPath;
+    options.targetHome = dir.path();
+    QElapsedTimer elapsed;
+    elapsed.start();
+    {
+        RtcWakeDaemon daemon(options, &clock, &rtc);
+        daemon.start();
+        clock.advanceTo(end);
+    }
+    QVERIFY2(elapsed.elapsed() < 1000, qPrintable(QStringLiteral("simulation took %1 ms").arg(elapsed.elapsed())));
+
+    int expected = 0;
+    for (QDate day = start.date(); day < end.date(); day = day.addDays(1)) {
+        if (day.dayOfWeek() <= Qt::Friday) {
+            ++expected;
+        }
+    }
+    QCOMPARE(rtc.transitions.size(), expected);
+    for (const auto &transition : rtc.transitions) {
+        const QDateTime shutdown = transition.shutdown.toTimeZone(berlin);
+        const QDateTime wake = transition.wakeUtc.toTimeZone(berlin);
+        QCOMPARE(shutdown.time(), QTime(23, 0));
+        QVERIFY(shutdown.date().dayOfWeek() <= Qt::Friday);
+        QCOMPARE(wake.time(), QTime(7, 0));
+        QCOMPARE(wake.date(), shutdown.date().addDays(1));
+        QCOMPARE(transition.action, PowerAction::SuspendToRam);
+    }
+    // One alarm per cycle; the resume notification must not reprogram an alarm that is already armed.
+    QCOMPARE(rtc.programs, expected + 1);
+
+    const QString logPath = dir.filePath(QStringLiteral(".local/share/rtcwake-gui/log.txt"));
+    QCOMPARE(countLines(logPath, QStringLiteral("category=\"resume\"")), expected);
+    QCOMPARE(countLines(logPath, QStringLiteral("success=\"false\"")), 0);
+
+    CycleHistoryStore history(dir.filePath(QStringLiteral(".local/share/rtcwake-gui/history.bin")));
+    QVERIFY(history.open(false));
+    const auto records = history.records();
+    QCOMPARE(records.size(), expected);
+    for (const auto &record : records) {
+        QCOMPARE(record.outcome, static_cast<qint32>(CycleHistoryStore::Outcome::Completed));
+        QCOMPARE(record.wakeLatencyMs, qint64(rtc.resumeDelaySecs * 1000));
+    }
+}
+
+void DaemonSimulationTest::idles_without_wakeups() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(QDir(dir.path()).mkpath(QStringLiteral("config")));
+    QVERIFY(QDir(dir.path()).mkpath(QStringLiteral("sim-home")));
+    QVERIFY(QDir(dir.path()).mkpath(QStringLiteral("home")));
+    const QString configPath = dir.filePath(QStringLiteral("config/config.json"));
+
+    // Simulated: nothing may fire between planning and a deadline four days out.
+    {
+        QVERIFY(ConfigRepository(configPath).save(weeklyConfig({Qt::Friday}, QTime(23, 0), QTime(7, 0))));
+        SimulatedClock clock(QDateTime(QDate(2030, 1, 7), QTime(9, 0), Qt::UTC));
+        FakeRtc rtc(clock);
+        RtcWakeDaemon::Options options;
+        options.configPath = configPath;
+        options.targetHome = dir.filePath(QStringLiteral("sim-home"));
+        RtcWakeDaemon daemon(options, &clock, &rtc);
+        daemon.start();
+        const quint64 firedAtStart = clock.firedTimers();
+        clock.advanceTo(QDateTime(QDate(2030, 1, 11), QTime(22, 59, 59), Qt::UTC));
+        QCOMPARE(clock.firedTimers(), firedAtStart);
+        QCOMPARE(clock.activeTimers(), 1);
+        QCOMPARE(rtc.programs, 1);
+        QVERIFY(rtc.transitions.isEmpty());
+    }
+
+    // Real event loop: an idle daemon must not add dispatcher wakeups of its own.
+    const int day = QDate::currentDate().addDays(3).dayOfWeek();
+    QVERIFY(ConfigRepository(configPath).save(weeklyConfig({day}, QTime(12, 0), QTime(13, 0))));
+    const int baseline = countDispatcherWakeups(1500);
+
+    SimulatedClock unused(QDateTime::currentDateTimeUtc());
+    FakeRtc rtc(unused);
+    RtcWakeDaemon::Options options;
+    options.configPath = configPath;
+    options.targetHome = dir.filePath(QStringLiteral("home"));
+    RtcWakeDaemon daemon(options, nullptr, &rtc);
+    daemon.start();
+    QCOMPARE(rtc.programs, 1);
+    QTest::qWait(100);
+
+    const int wakeups = countDispatcherWakeups(1500);
+    QVERIFY2(wakeups <= baseline, qPrintable(QStringLiteral("%1 wakeups, baseline %2").arg(wakeups).arg(baseline)));
+}
+
+void DaemonSimulationTest::replans_when_wall_clock_steps() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString configPath = dir.filePath(QStringLiteral("config.json"));
+    QVERIFY(ConfigRepository(configPath).save(weeklyConfig({Qt::Monday, Qt::Tuesday}, QTime(23, 0), QTime(7, 0))));
+
+    SimulatedClock clock(QDateTime(QDate(2030, 1, 7), QTime(12, 0), Qt::UTC));
+    FakeRtc rtc(clock);
+    RtcWakeDaemon::Options options;
+    options.configPath = configPath;
+    options.targetHome = dir.path();
+    {
+        RtcWakeDaemon daemon(options, &clock, &rtc);
+        daemon.start();
+
+        // A step inside the sleep window applies the action straight away.
+        clock.setWallClock(QDateTime(QDate(2030, 1, 7), QTime(23, 30), Qt::UTC));
+        clock.advanceBy(0);
+        QCOMPARE(rtc.transitions.size(), 1);
+        QCOMPARE(rtc.transitions.first().wakeUtc, QDateTime(QDate(2030, 1, 8), QTime(7, 0), Qt::UTC));
+
+        // A step over a whole window records it as skipped and plans the next one.
+        clock.advanceTo(QDateTime(QDate(2030, 1, 8), QTime(12, 0), Qt::UTC));
+        clock.setWallClock(QDateTime(QDate(2030, 1, 9), QTime(8, 0), Qt::UTC));
+        clock.advanceBy(0);
+        QCOMPARE(rtc.transitions.size(), 1);
+        QCOMPARE(rtc.alarm, QDateTime(QDate(2030, 1, 15), QTime(7, 0), Qt::UTC).toSecsSinceEpoch());
+    }
+
+    CycleHistoryStore history(dir.filePath(QStringLiteral(".local/share/rtcwake-gui/history.bin")));
+    QVERIFY(history.open(false));
+    const auto records = history.records();
+    QCOMPARE(records.size(), 2);
+    QCOMPARE(records.at(0).outcome, static_cast<qint32>(CycleHistoryStore::Outcome::Completed));
+    QCOMPARE(records.at(1).outcome, static_cast<qint32>(CycleHistoryStore::Outcome::Skipped));
+    QCOMPARE(countLines(dir.filePath(QStringLiteral(".local/share/rtcwake-gui/log.txt")), QStringLiteral("category=\"clock\"")), 3);
+}
+
+void DaemonSimulationTest::defers_while_busy() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    // A load far above any CPU count keeps the machine "busy" for the whole test.
+    QVERIFY(QDir(dir.path()).mkpath(QStringLiteral("proc")));
+    QFile loadavg(dir.filePath(QStringLiteral("proc/loadavg")));
+    QVERIFY(loadavg.open(QIODevice::WriteOnly));
+    loadavg.write("100000.00 100000.00 100000.00 9/300 4242\n");
+    loadavg.close();
+
+    AppConfig config = weeklyConfig({Qt::Monday}, QTime(23, 0), QTime(7, 0));
+    config.deferral.enabled = true;
+    config.deferral.sampleSeconds = 5;
+    config.deferral.stepMinutes = 10;
+    config.deferral.maxDelayMinutes = 30;
+    const QString configPath = dir.filePath(QStringLiteral("config.json"));
+    QVERIFY(ConfigRepository(configPath).save(config));
+
+    SimulatedClock clock(QDateTime(QDate(2030, 1, 7), QTime(12, 0), Qt::UTC));
+    FakeRtc rtc(clock);
+    RtcWakeDaemon::Options options;
+    options.configPath = configPath;
+    options.targetHome = dir.path();
+    options.procRoot = dir.filePath(QStringLiteral("proc"));
+    {
+        RtcWakeDaemon daemon(options, &clock, &rtc);
+        daemon.start();
+        clock.advanceTo(QDateTime(QDate(2030, 1, 8), QTime(8, 0), Qt::UTC));
+    }
+
+    // Three 10-minute steps (each after a 5 s sample), then the 30-minute cap applies the action.
+    QCOMPARE(rtc.transitions.size(), 1);
+    QCOMPARE(rtc.transitions.first().shutdown, QDateTime(QDate(2030, 1, 7), QTime(23, 30, 20), Qt::UTC));
+    const QString logPath = dir.filePath(QStringLiteral(".local/share/rtcwake-gui/log.txt"));
+    QCOMPARE(countLines(logPath, QStringLiteral("category=\"deferral\" status=\"deferred\"")), 3);
+    QCOMPARE(countLines(logPath, QStringLiteral("category=\"deferral\" status=\"exhausted\"")), 1);
+
+    CycleHistoryStore history(dir.filePath(QStringLiteral(".local/share/rtcwake-gui/history.bin")));
+    QVERIFY(history.open(false));
+    const auto records = history.records();
+    QCOMPARE(records.size(), 1);
+    QCOMPARE(records.first().outcome, static_cast<qint32>(CycleHistoryStore::Outcome::Completed));
+    QVERIFY(records.first().flags & CycleHistoryStore::DeferredForActivity);
+    QCOMPARE(records.first().plannedShutdown, QDateTime(QDate(2030, 1, 7), QTime(23, 0), Qt::UTC).toSecsSinceEpoch());
+}
+
+void DaemonSimulationTest::keeps_deferral_steps_across_clock_steps() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(QDir(dir.path()).mkpath(QStringLiteral("proc")));
+    QFile loadavg(dir.filePath(QStringLiteral("proc/loadavg")));
+    QVERIFY(loadavg.open(QIODevice::WriteOnly));
+    loadavg.write("100000.00 100000.00 100000.00 9/300 4242\n");
+    loadavg.close();
+
+    AppConfig config = weeklyConfig({Qt::Monday}, QTime(23, 0), QTime(7, 0));
+    config.deferral.enabled = true;
+    config.deferral.sampleSeconds = 5;
+    config.deferral.stepMinutes = 10;
+    config.deferral.maxDelayMinutes = 30;
+    const QString configPath = dir.filePath(QStringLiteral("config.json"));
+    QVERIFY(ConfigRepository(configPath).save(config));
+    const QString logPath = dir.filePath(QStringLiteral(".local/share/rtcwake-gui/log.txt"));
+    const QString deferred = QStringLiteral("category=\"deferral\" status=\"deferred\"");
+
+    SimulatedClock clock(QDateTime(QDate(2030, 1, 7), QTime(12, 0), Qt::UTC));
+    FakeRtc rtc(clock);
+    RtcWakeDaemon::Options options;
+    options.configPath = configPath;
+    options.targetHome = dir.path();
+    options.procRoot = dir.filePath(QStringLiteral("proc"));
+    {
+        RtcWakeDaemon daemon(options, &clock, &rtc);
+        daemon.start();
+        // Two minutes into the first step, which ends at 23:10:05.
+        clock.advanceTo(QDateTime(QDate(2030, 1, 7), QTime(23, 2, 5), Qt::UTC));
+        QCOMPARE(countLines(logPath, deferred), 1);
+
+        // An NTP step forward past the step's end must not cut the step short.
+        clock.setWallClock(clock.now().addSecs(30 * 60));
+        clock.advanceBy(7 * 60 * 1000);
+        QCOMPARE(countLines(logPath, deferred), 1);
+        QVERIFY(rtc.transitions.isEmpty());
+
+        // Three seconds into the 5 s throughput sample, the clock is set back ten minutes.
+        clock.advanceBy(63 * 1000);
+        clock.setWallClock(clock.now().addSecs(-10 * 60));
+        clock.advanceBy(1000);
+        QCOMPARE(countLines(logPath, deferred), 1);
+        clock.advanceBy(1000);
+        QCOMPARE(countLines(logPath, deferred), 2);
+
+        clock.advanceTo(QDateTime(QDate(2030, 1, 8), QTime(8, 0), Qt::UTC));
+    }
+
+    // The same three steps as without clock changes, shifted by the net 20 minutes.
+    QCOMPARE(rtc.transitions.size(), 1);
+    QCOMPARE(rtc.transitions.first().shutdown, QDateTime(QDate(2030, 1, 7), QTime(23, 50, 20), Qt::UTC));
+    QCOMPARE(countLines(logPath, deferred), 3);
+    QCOMPARE(countLines(logPath, QStringLiteral("category=\"deferral\" status=\"exhausted\"")), 1);
+}
+
+void DaemonSimulationTest::suspends_when_idle_in_window() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    // Regular files take the PSI trigger definitions and never signal pressure.
+    QVERIFY(QDir(dir.path()).mkpath(QStringLiteral("proc/pressure")));
+    for (const char *resource : {"cpu", "io", "memory"}) {
+        QFile file(dir.filePath(QStringLiteral("proc/pressure/") + QLatin1String(resource)));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+    }
+
+    AppConfig config = weeklyConfig({Qt::Monday}, QTime(23, 0), QTime(7, 0));
+    config.idleSuspend.enabled = true;
+    config.idleSuspend.idleMinutes = 30;
+    config.idleSuspend.windowStart = QTime(20, 0);
+    config.idleSuspend.windowEnd = QTime(6, 0);
+    config.idleSuspend.requireSessionIdle = false;
+    const QString configPath = dir.filePath(QStringLiteral("config.json"));
+    QVERIFY(ConfigRepository(configPath).save(config));
+
+    SimulatedClock clock(QDateTime(QDate(2030, 1, 7), QTime(12, 0), Qt::UTC));
+    FakeRtc rtc(clock);
+    RtcWakeDaemon::Options options;
+    options.configPath = configPath;
+    options.targetHome = dir.path();
+    options.procRoot = dir.filePath(QStringLiteral("proc"));
+    {
+        RtcWakeDaemon daemon(options, &clock, &rtc);
+        daemon.start();
+        clock.advanceTo(QDateTime(QDate(2030, 1, 8), QTime(19, 0), Qt::UTC));
+    }
+
+    // Idle from the window start at 20:00: suspended at 20:30 instead of 23:00, same wake.
+    QCOMPARE(rtc.transitions.size(), 1);
+    QCOMPARE(rtc.transitions.first().shutdown, QDateTime(QDate(2030, 1, 7), QTime(20, 30), Qt::UTC));
+    QCOMPARE(rtc.transitions.first().wakeUtc, QDateTime(QDate(2030, 1, 8), QTime(7, 0), Qt::UTC));
+    QCOMPARE(rtc.transitions.first().action, PowerAction::SuspendToRam);
+    const QString logPath = dir.filePath(QStringLiteral(".local/share/rtcwake-gui/log.txt"));
+    QCOMPARE(countLines(logPath, QStringLiteral("category=\"idle_suspend\" status=\"applied\"")), 1);
+
+    CycleHistoryStore history(dir.filePath(QStringLiteral(".local/share/rtcwake-gui/history.bin")));
+    QVERIFY(history.open(false));
+    const auto records = history.records();
+    QCOMPARE(records.size(), 1);
+    QCOMPARE(records.first().outcome, static_cast<qint32>(CycleHistoryStore::Outcome::Completed));
+    QVERIFY(records.first().flags & CycleHistoryStore::IdleSuspend);
+    QCOMPARE(records.first().plannedShutdown, QDateTime(QDate(2030, 1, 7), QTime(23, 0), Qt::UTC).toSecsSinceEpoch());
+}
+
+void DaemonSimulationTest::resuspends_after_maintenance_jobs() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    AppConfig config = weeklyConfig({Qt::Monday}, QTime(23, 0), QTime(3, 0));
+    MaintenanceJob backup;
+    backup.name = QStringLiteral("backup");
+    backup.command = QStringLiteral("echo backed up");
+    MaintenanceJob trim;
+    trim.name = QStringLiteral("fstrim");
+    trim.command = QStringLiteral("true");
+    for (auto &entry : config.weekly) {
+        if (entry.day == Qt::Monday) {
+            entry.jobs = {backup, trim};
+            entry.resuspendUntil = QTime(7, 0);
+        }
+    }
+    config.maintenance.requireSessionIdle = false;
+    const QString configPath = dir.filePath(QStringLiteral("config.json"));
+    QVERIFY(ConfigRepository(configPath).save(config));
+
+    SimulatedClock clock(QDateTime(QDate(2030, 1, 7), QTime(12, 0), Qt::UTC));
+    FakeRtc rtc(clock);
+    RtcWakeDaemon::Options options;
+    options.configPath = configPath;
+    options.targetHome = dir.path();
+    {
+        RtcWakeDaemon daemon(options, &clock, &rtc);
+        daemon.start();
+        clock.advanceTo(QDateTime(QDate(2030, 1, 8), QTime(3, 10), Qt::UTC));
+        QCOMPARE(rtc.transitions.size(), 1);
+
+        // The jobs are real processes; once they finish the machine sleeps until 07:00.
+        QTRY_COMPARE_WITH_TIMEOUT(rtc.transitions.size(), 2, 10000);
+        clock.advanceTo(QDateTime(QDate(2030, 1, 8), QTime(12, 0), Qt::UTC));
+    }
+
+    QCOMPARE(rtc.transitions.at(1).shutdown, QDateTime(QDate(2030, 1, 8), QTime(3, 10), Qt::UTC));
+    QCOMPARE(rtc.transitions.at(1).wakeUtc, QDateTime(QDate(2030, 1, 8), QTime(7, 0), Qt::UTC));
+    // After the early wake the next maintenance wake is armed again.
+    QCOMPARE(rtc.alarm, QDateTime(QDate(2030, 1, 15), QTime(3, 0), Qt::UTC).toSecsSinceEpoch());
+
+    const QString logPath = dir.filePath(QStringLiteral(".local/share/rtcwake-gui/log.txt"));
+    QCOMPARE(countLines(logPath, QStringLiteral("category=\"maintenance_job\" name=\"backup\" exit=\"0\"")), 1);
+    QCOMPARE(countLines(logPath, QStringLiteral("category=\"maintenance_job\"")), 2);
+    QCOMPARE(countLines(logPath, QStringLiteral("category=\"maintenance\" status=\"resuspend\"")), 1);
+    QCOMPARE(countLines(logPath, QStringLiteral("awake_min=\"")), 1);
+
+    CycleHistoryStore history(dir.filePath(QStringLiteral(".local/share/rtcwake-gui/history.bin")));
+    QVERIFY(history.open(false));
+    const auto records = history.records();
+    QCOMPARE(records.size(), 2);
+    QVERIFY(!(records.at(0).flags & CycleHistoryStore::MaintenanceResuspend));
+    QVERIFY(records.at(1).flags & CycleHistoryStore::MaintenanceResuspend);
+    QCOMPARE(records.at(1).outcome, static_cast<qint32>(CycleHistoryStore::Outcome::Completed));
+}
+
+void DaemonSimulationTest::returns_to_sleep_without_activity() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(QDir(dir.path()).mkpath(QStringLiteral("input")));
+
+    AppConfig config = weeklyConfig({Qt::Monday}, QTime(23, 0), QTime(7, 0));
+    config.returnToSleep.enabled = true;
+    config.returnToSleep.graceMinutes = 20;
+    config.returnToSleep.watchSession = false;
+    const QString configPath = dir.filePath(QStringLiteral("config.json"));
+    QVERIFY(ConfigRepository(configPath).save(config));
+
+    SimulatedClock clock(QDateTime(QDate(2030, 1, 7), QTime(12, 0), Qt::UTC));
+    FakeRtc rtc(clock);
+    RtcWakeDaemon::Options options;
+    options.configPath = configPath;
+    options.targetHome = dir.path();
+    options.inputDir = dir.filePath(QStringLiteral("input"));
+    {
+        RtcWakeDaemon daemon(options, &clock, &rtc);
+        daemon.start();
+        // Nobody shows up on Tuesday: back to sleep until next week's wake.
+        clock.advanceTo(QDateTime(QDate(2030, 1, 8), QTime(12, 0), Qt::UTC));
+        QCOMPARE(rtc.transitions.size(), 2);
+
+        // Someone uses the machine after that wake; it stays up.
+        clock.advanceBy(5 * 60 * 1000);
+        daemon.m_activityMonitor->noteActivity(QStringLiteral("event3"));
+        clock.advanceTo(QDateTime(QDate(2030, 1, 15), QTime(12, 0), Qt::UTC));
+    }
+
+    QCOMPARE(rtc.transitions.size(), 2);
+    QCOMPARE(rtc.transitions.at(1).shutdown, QDateTime(QDate(2030, 1, 8), QTime(7, 20, 4), Qt::UTC));
+    QCOMPARE(rtc.transitions.at(1).wakeUtc, QDateTime(QDate(2030, 1, 15), QTime(7, 0), Qt::UTC));
+    QCOMPARE(rtc.transitions.at(1).action, PowerAction::SuspendToRam);
+
+    const QString logPath = dir.filePath(QStringLiteral(".local/share/rtcwake-gui/log.txt"));
+    QCOMPARE(countLines(logPath, QStringLiteral("category=\"return_to_sleep\" status=\"watching\"")), 2);
+    QCOMPARE(countLines(logPath, QStringLiteral("category=\"return_to_sleep\" status=\"applied\"")), 1);
+    QCOMPARE(countLines(logPath, QStringLiteral("status=\"activity\" source=\"event3\"")), 1);
+
+    CycleHistoryStore history(dir.filePath(QStringLiteral(".local/share/rtcwake-gui/history.bin")));
+    QVERIFY(history.open(false));
+    const auto records = history.records();
+    QCOMPARE(records.size(), 2);
+    QVERIFY(!(records.at(0).flags & CycleHistoryStore::NoActivityResuspend));
+    QVERIFY(records.at(1).flags & CycleHistoryStore::NoActivityResuspend);
+    // Slept through the Monday shutdown of that cycle.
+    QCOMPARE(records.at(1).plannedShutdown, QDateTime(QDate(2030, 1, 14), QTime(23, 0), Qt::UTC).toSecsSinceEpoch());
+}
+
+void DaemonSimulationTest::hibernates_at_interim_wake() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    AppConfig config = weeklyConfig({Qt::Monday, Qt::Tuesday}, QTime(23, 0), QTime(7, 0));
+    config.actionId = static_cast<int>(PowerAction::SuspendThenHibernate);
+    config.hibernateDelayMinutes = 180;
+    const QString configPath = dir.filePath(QStringLiteral("config.json"));
+    QVERIFY(ConfigRepository(configPath).save(config));
+
+    SimulatedClock clock(QDateTime(QDate(2030, 1, 7), QTime(12, 0), Qt::UTC));
+    FakeRtc rtc(clock);
+    RtcWakeDaemon::Options options;
+    options.configPath = configPath;
+    options.targetHome = dir.path();
+    {
+        RtcWakeDaemon daemon(options, &clock, &rtc);
+        daemon.start();
+        clock.advanceTo(QDateTime(QDate(2030, 1, 8), QTime(12, 0), Qt::UTC));
+        // Tuesday night someone wakes the machine by hand at 23:30, before the interim alarm.
+        rtc.resumeDelaySecs = -150 * 60;
+        clock.advanceTo(QDateTime(QDate(2030, 1, 9), QTime(12, 0), Qt::UTC));
+    }
+
+    // Monday: RAM until 02:00, then disk until the real wake.
+    QCOMPARE(rtc.transitions.size(), 3);
+    QCOMPARE(rtc.transitions.at(0).shutdown, QDateTime(QDate(2030, 1, 7), QTime(23, 0), Qt::UTC));
+    QCOMPARE(rtc.transitions.at(0).wakeUtc, QDateTime(QDate(2030, 1, 8), QTime(2, 0), Qt::UTC));
+    QCOMPARE(rtc.transitions.at(0).action, PowerAction::SuspendToRam);
+    QCOMPARE(rtc.transitions.at(1).wakeUtc, QDateTime(QDate(2030, 1, 8), QTime(7, 0), Qt::UTC));
+    QCOMPARE(rtc.transitions.at(1).action, PowerAction::Hibernate);
+    // Tuesday: nothing after the early wake.
+    QCOMPARE(rtc.transitions.at(2).wakeUtc, QDateTime(QDate(2030, 1, 9), QTime(2, 0), Qt::UTC));
+
+    const QString logPath = dir.filePath(QStringLiteral(".local/share/rtcwake-gui/log.txt"));
+    QCOMPARE(countLines(logPath, QStringLiteral("category=\"hybrid_sleep\" stage=\"disk\"")), 1);
+    QCOMPARE(countLines(logPath, QStringLiteral("category=\"hybrid_sleep\" stage=\"woken_early\"")), 1);
+    QCOMPARE(countLines(logPath, QStringLiteral("category=\"wake\" verdict=\"on_time\"")), 1);
+    QCOMPARE(countLines(logPath, QStringLiteral("category=\"wake\" verdict=\"early\"")), 1);
+
+    CycleHistoryStore history(dir.filePath(QStringLiteral(".local/share/rtcwake-gui/history.bin")));
+    QVERIFY(history.open(false));
+    const auto records = history.records();
+    QCOMPARE(records.size(), 2);
+    QCOMPARE(records.at(0).action, static_cast<qint32>(PowerAction::SuspendThenHibernate));
+    QCOMPARE(records.at(0).actualResume, QDateTime(QDate(2030, 1, 8), QTime(7, 0, 4), Qt::UTC).toSecsSinceEpoch());
+    QCOMPARE(records.at(0).flags & CycleHistoryStore::EarlyWake, 0);
+    QCOMPARE(records.at(1).flags & CycleHistoryStore::EarlyWake, static_cast<qint32>(CycleHistoryStore::EarlyWake));
+}
+
+void DaemonSimulationTest::compensates_rtc_drift() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString configPath = dir.filePath(QStringLiteral("config.json"));
+    QVERIFY(ConfigRepository(configPath).save(
+        weeklyConfig({Qt::Monday, Qt::Tuesday, Qt::Wednesday, Qt::Thursday}, QTime(23, 0), QTime(7, 0))));
+
+    SimulatedClock clock(QDateTime(QDate(2030, 1, 7), QTime(12, 0), Qt::UTC));
+    FakeRtc rtc(clock);
+    // 500 ppm is 14.4 s over an eight-hour night.
+    rtc.driftPpm = 500.0;
+    RtcWakeDaemon::Options options;
+    options.configPath = configPath;
+    options.targetHome = dir.path();
+    {
+        RtcWakeDaemon daemon(options, &clock, &rtc);
+        daemon.start();
+        clock.advanceTo(QDateTime(QDate(2030, 1, 11), QTime(12, 0), Qt::UTC));
+    }
+
+    // Three nights to learn, then the alarm is armed later by the expected gain.
+    QCOMPARE(rtc.transitions.size(), 4);
+    for (int i = 0; i < 3; ++i) {
+        QCOMPARE(rtc.transitions.at(i).wakeUtc.time(), QTime(7, 0));
+    }
+    QCOMPARE(rtc.transitions.at(3).wakeUtc, QDateTime(QDate(2030, 1, 11), QTime(7, 0, 14), Qt::UTC));
+
+    const QString stateDir = dir.filePath(QStringLiteral(".local/share/rtcwake-gui"));
+    QCOMPARE(countLines(stateDir + QStringLiteral("/log.txt"), QStringLiteral("category=\"rtc_drift\" status=\"sample\"")), 4);
+    RtcDriftModel model;
+    QVERIFY(model.load(stateDir + QStringLiteral("/rtc-drift.json")));
+    const auto estimate = model.estimate(QStringLiteral("rtc0"));
+    QCOMPARE(estimate.samples, 4);
+    QVERIFY2(qAbs(estimate.ppm - 500.0) < 1.0, qPrintable(QString::number(estimate.ppm)));
+}
+
+void DaemonSimulationTest::wakes_early_by_learned_resume_time() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString configPath = dir.filePath(QStringLiteral("config.json"));
+    AppConfig config = weeklyConfig({Qt::Monday, Qt::Tuesday, Qt::Wednesday, Qt::Thursday}, QTime(23, 0), QTime(7, 0));
+    config.wakeLead.enabled = true;
+    config.wakeLead.minSamples = 3;
+    QVERIFY(ConfigRepository(configPath).save(config));
+
+    SimulatedClock clock(QDateTime(QDate(2030, 1, 7), QTime(12, 0), Qt::UTC));
+    FakeRtc rtc(clock);
+    RtcWakeDaemon::Options options;
+    options.configPath = configPath;
+    options.targetHome = dir.path();
+    {
+        RtcWakeDaemon daemon(options, &clock, &rtc);
+        daemon.start();
+        clock.advanceTo(QDateTime(QDate(2030, 1, 11), QTime(12, 0), Qt::UTC));
+    }
+
+    // Three nights of four-second resumes, then the alarm fires that much before 07:00.
+    QCOMPARE(rtc.transitions.size(), 4);
+    for (int i = 0; i < 3; ++i) {
+        QCOMPARE(rtc.transitions.at(i).wakeUtc.time(), QTime(7, 0));
+    }
+    QCOMPARE(rtc.transitions.at(3).wakeUtc, QDateTime(QDate(2030, 1, 11), QTime(6, 59, 56), Qt::UTC));
+
+    // Measured from the alarm, the early night adds the same sample instead of a shorter one.
+    ResumeLatencyStats stats;
+    QVERIFY(stats.load(dir.filePath(QStringLiteral(".local/share/rtcwake-gui/resume-latency.json"))));
+    const auto histogram = stats.histogram(PowerAction::SuspendToRam);
+    QCOMPARE(histogram.count, quint32(4));
+    QCOMPARE(histogram.maxSeconds, 4.0);
+    QCOMPARE(stats.leadMs(PowerAction::SuspendToRam, 0.9, 3, 60 * 1000), qint64(4000));
+    QCOMPARE(stats.leadMs(PowerAction::SuspendToRam, 0.9, 3, 1000), qint64(1000));
+    QCOMPARE(stats.leadMs(PowerAction::SuspendToRam, 0.9, 5, 60 * 1000), qint64(0));
+}
+
+void DaemonSimulationTest::ignores_early_wakes_in_resume_latency() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString configPath = dir.filePath(QStringLiteral("config.json"));
+    AppConfig config = weeklyConfig({Qt::Monday, Qt::Tuesday}, QTime(23, 0), QTime(7, 0));
+    config.wakeLead.enabled = true;
+    config.wakeLead.minSamples = 1;
+    QVERIFY(ConfigRepository(configPath).save(config));
+    const QString statsPath = dir.filePath(QStringLiteral(".local/share/rtcwake-gui/resume-latency.json"));
+
+    SimulatedClock clock(QDateTime(QDate(2030, 1, 7), QTime(12, 0), Qt::UTC));
+    FakeRtc rtc(clock);
+    // Someone presses the power button ten minutes before the alarm.
+    rtc.resumeDelaySecs = -600;
+    RtcWakeDaemon::Options options;
+    options.configPath = configPath;
+    options.targetHome = dir.path();
+    {
+        RtcWakeDaemon daemon(options, &clock, &rtc);
+        daemon.start();
+        clock.advanceTo(QDateTime(QDate(2030, 1, 8), QTime(12, 0), Qt::UTC));
+        QCOMPARE(rtc.transitions.size(), 1);
+        QVERIFY(!QFile::exists(statsPath));
+
+        rtc.resumeDelaySecs = 4;
+        clock.advanceTo(QDateTime(QDate(2030, 1, 9), QTime(12, 0), Qt::UTC));
+    }
+
+    QCOMPARE(rtc.transitions.size(), 2);
+    ResumeLatencyStats stats;
+    QVERIFY(stats.load(statsPath));
+    const auto histogram = stats.histogram(PowerAction::SuspendToRam);
+    QCOMPARE(histogram.count, quint32(1));
+    QCOMPARE(stats.leadMs(PowerAction::SuspendToRam, 0.9, 1, 60 * 1000), qint64(4000));
+}
+
+void DaemonSimulationTest::chains_alarms_beyond_rtc_range() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString configPath = dir.filePath(QStringLiteral("config.json"));
+    // A weekend: Friday 23:00 until Monday 07:00.
+    AppConfig config = weeklyConfig({}, QTime(23, 0), QTime(7, 0));
+    config.singleShutdownDate = QDate(2030, 1, 11);
+    config.singleShutdownTime = QTime(23, 0);
+    config.singleWakeDate = QDate(2030, 1, 14);
+    config.singleWakeTime = QTime(7, 0);
+    QVERIFY(ConfigRepository(configPath).save(config));
+
+    SimulatedClock clock(QDateTime(QDate(2030, 1, 11), QTime(12, 0), Qt::UTC));
+    FakeRtc rtc(clock);
+    // A time-of-day alarm register.
+    rtc.rangeSecs = 24 * 3600;
+    RtcWakeDaemon::Options options;
+    options.configPath = configPath;
+    options.targetHome = dir.path();
+    {
+        RtcWakeDaemon daemon(options, &clock, &rtc);
+        daemon.start();
+        // The safety-net alarm stays inside the range as well.
+        QCOMPARE(rtc.alarm, QDateTime(QDate(2030, 1, 12), QTime(11, 59), Qt::UTC).toSecsSinceEpoch());
+        clock.advanceTo(QDateTime(QDate(2030, 1, 14), QTime(12, 0), Qt::UTC));
+    }
+
+    // Each link stops a minute short of the range and resumes four seconds late.
+    QCOMPARE(rtc.transitions.size(), 3);
+    QCOMPARE(rtc.transitions.at(0).wakeUtc, QDateTime(QDate(2030, 1, 12), QTime(22, 59), Qt::UTC));
+    QCOMPARE(rtc.transitions.at(1).wakeUtc, QDateTime(QDate(2030, 1, 13), QTime(22, 58, 4), Qt::UTC));
+    QCOMPARE(rtc.transitions.at(2).wakeUtc, QDateTime(QDate(2030, 1, 14), QTime(7, 0), Qt::UTC));
+    for (const auto &transition : rtc.transitions) {
+        QCOMPARE(transition.action, PowerAction::SuspendToRam);
+    }
+
+    const QString logPath = dir.filePath(QStringLiteral(".local/share/rtcwake-gui/log.txt"));
+    QCOMPARE(countLines(logPath, QStringLiteral("category=\"rtc_chain\" status=\"relinked\"")), 2);
+    QCOMPARE(countLines(logPath, QStringLiteral("category=\"rtc\" device=")), 1);
+}
+
+void DaemonSimulationTest::retries_and_falls_back_when_sleep_fails() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString configPath = dir.filePath(QStringLiteral("config.json"));
+    AppConfig config = weeklyConfig({}, QTime(23, 0), QTime(7, 0));
+    config.singleShutdownDate = QDate(2030, 1, 7);
+    config.singleShutdownTime = QTime(23, 0);
+    config.singleWakeDate = QDate(2030, 1, 8);
+    config.singleWakeTime = QTime(7, 0);
+    QVERIFY(ConfigRepository(configPath).save(config));
+
+    SimulatedClock clock(QDateTime(QDate(2030, 1, 7), QTime(12, 0), Qt::UTC));
+    FakeRtc rtc(clock);
+    // A wakeup event races the first attempt, then S3 itself turns out to be broken.
+    rtc.pendingWakeups = 1;
+    rtc.failingModes = {QStringLiteral("mem")};
+    RtcWakeDaemon::Options options;
+    options.configPath = configPath;
+    options.targetHome = dir.path();
+    {
+        RtcWakeDaemon daemon(options, &clock, &rtc);
+        daemon.start();
+        clock.advanceTo(QDateTime(QDate(2030, 1, 8), QTime(12, 0), Qt::UTC));
+    }
+
+    QCOMPARE(rtc.failures, 2);
+    QCOMPARE(rtc.transitions.size(), 1);
+    QCOMPARE(rtc.transitions.at(0).action, PowerAction::SuspendToIdle);
+    // Backoffs of two and four seconds went by before the fallback.
+    QCOMPARE(rtc.transitions.at(0).shutdown, QDateTime(QDate(2030, 1, 7), QTime(23, 0, 6), Qt::UTC));
+    QCOMPARE(rtc.transitions.at(0).wakeUtc, QDateTime(QDate(2030, 1, 8), QTime(7, 0), Qt::UTC));
+
+    const QString logPath = dir.filePath(QStringLiteral(".local/share/rtcwake-gui/log.txt"));
+    QCOMPARE(countLines(logPath, QStringLiteral("category=\"sleep_entry\" status=\"wakeup_pending\" mode=\"mem\" attempt=\"1\"")), 1);
+    QCOMPARE(countLines(logPath, QStringLiteral("category=\"sleep_entry\" status=\"failed\" mode=\"mem\"")), 2);
+    QCOMPARE(countLines(logPath, QStringLiteral("category=\"sleep_entry\" status=\"fallback\" mode=\"freeze\" requested=\"mem\"")), 1);
+    QCOMPARE(countLines(logPath, QStringLiteral("category=\"sleep_entry\" status=\"entered\" mode=\"freeze\" attempt=\"1\"")), 1);
+    QCOMPARE(countLines(logPath, QStringLiteral("category=\"rtcwake\" action=")), 1);
+    QCOMPARE(countLines(logPath, QStringLiteral("success=\"true\"")), 1);
+
+    const auto stats = SleepModeStats::load(dir.filePath(QStringLiteral(".local/share/rtcwake-gui/sleep-modes.json")));
+    QCOMPARE(stats.value(QStringLiteral("mem")).attempts, 2);
+    QCOMPARE(stats.value(QStringLiteral("mem")).successes, 0);
+    QCOMPARE(stats.value(QStringLiteral("freeze")).successes, 1);
+}
+
+void DaemonSimulationTest::accounts_energy_per_phase() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString configPath = dir.filePath(QStringLiteral("config.json"));
+    AppConfig config = weeklyConfig({}, QTime(23, 0), QTime(7, 0));
+    config.singleShutdownDate = QDate(2030, 1, 7);
+    config.singleShutdownTime = QTime(23, 0);
+    config.singleWakeDate = QDate(2030, 1, 8);
+    config.singleWakeTime = QTime(7, 0);
+    config.energy.enabled = true;
+    QVERIFY(ConfigRepository(configPath).save(config));
+
+    // A fake sysfs with one RAPL package close to its wrap and one battery.
+    const QString sysRoot = dir.filePath(QStringLiteral("sys"));
+    const auto write = [&sysRoot](const QString &path, const QByteArray &value) {
+        QDir().mkpath(QFileInfo(sysRoot + path).path());
+        QFile file(sysRoot + path);
+        return file.open(QIODevice::WriteOnly) && file.write(value) == value.size();
+    };
+    QVERIFY(write(QStringLiteral("/class/powercap/intel-rapl:0/name"), "package-0\n"));
+    QVERIFY(write(QStringLiteral("/class/powercap/intel-rapl:0/max_energy_range_uj"), "262143328850\n"));
+    QVERIFY(write(QStringLiteral("/class/powercap/intel-rapl:0/energy_uj"), "262000000000\n"));
+    QVERIFY(write(QStringLiteral("/class/power_supply/BAT0/type"), "Battery\n"));
+    QVERIFY(write(QStringLiteral("/class/power_supply/BAT0/energy_now"), "50000000\n"));
+
+    SimulatedClock clock(QDateTime(QDate(2030, 1, 7), QTime(12, 0), Qt::UTC));
+    FakeRtc rtc(clock);
+    rtc.onSleep = [&write]() {
+        write(QStringLiteral("/class/powercap/intel-rapl:0/energy_uj"), "100000\n");
+        write(QStringLiteral("/class/power_supply/BAT0/energy_now"), "48500000\n");
+    };
+    RtcWakeDaemon::Options options;
+    options.configPath = configPath;
+    options.targetHome = dir.path();
+    options.sysRoot = sysRoot;
+    {
+        RtcWakeDaemon daemon(options, &clock, &rtc);
+        daemon.start();
+        clock.advanceTo(QDateTime(QDate(2030, 1, 7), QTime(22, 0), Qt::UTC));
+        // The evening: the counter wraps, which the periodic samples catch, and 1 Wh drains.
+        QVERIFY(write(QStringLiteral("/class/powercap/intel-rapl:0/energy_uj"), "500000000\n"));
+        QVERIFY(write(QStringLiteral("/class/power_supply/BAT0/energy_now"), "49000000\n"));
+        clock.advanceTo(QDateTime(QDate(2030, 1, 8), QTime(12, 0), Qt::UTC));
+    }
+
+    QCOMPARE(rtc.transitions.size(), 1);
+    CycleHistoryStore history(dir.filePath(QStringLiteral(".local/share/rtcwake-gui/history.bin")));
+    QVERIFY(history.open(false));
+    const auto records = history.records();
+    QCOMPARE(records.size(), 1);
+    const auto &record = records.first();
+    QCOMPARE(record.energySources, quint32(CycleHistoryStore::RaplEnergy | CycleHistoryStore::BatteryEnergy));
+    QCOMPARE(record.awakeRaplMj, qint64(643328));
+    // The package counter restarted during the sleep.
+    QCOMPARE(record.asleepRaplMj, qint64(100));
+    QCOMPARE(record.transitionRaplMj, qint64(0));
+    QCOMPARE(record.awakeBatteryMj, qint64(3600000));
+    QCOMPARE(record.asleepBatteryMj, qint64(1800000));
+    QCOMPARE(record.transitionBatteryMj, qint64(0));
+
+    const QString logPath = dir.filePath(QStringLiteral(".local/share/rtcwake-gui/log.txt"));
+    QCOMPARE(countLines(logPath, QStringLiteral("category=\"energy\" source=\"rapl\" awake_j=\"643.329\" asleep_j=\"0.100\"")), 1);
+    QCOMPARE(countLines(logPath, QStringLiteral("category=\"energy\" source=\"battery\" awake_j=\"3600.000\" asleep_j=\"1800.000\" transition_j=\"0.000\"")), 1);
+}
+
+void DaemonSimulationTest::freezes_user_session_for_window() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString configPath = dir.filePath(QStringLiteral("config.json"));
+    AppConfig config = weeklyConfig({Qt::Monday}, QTime(23, 0), QTime(7, 0));
+    config.actionId = static_cast<int>(PowerAction::FreezeUserSession);
+    QVERIFY(ConfigRepository(configPath).save(config));
+
+    // A fake cgroup v2 hierarchy with the slice of the user running the test.
+    const struct passwd *user = ::getpwuid(::getuid());
+    QVERIFY(user);
+    const QString cgroupRoot = dir.filePath(QStringLiteral("cgroup"));
+    const QString freezeFile = QStringLiteral("%1/user.slice/user-%2.slice/cgroup.freeze").arg(cgroupRoot).arg(user->pw_uid);
+    QVERIFY(QDir().mkpath(QFileInfo(freezeFile).path()));
+    const auto freezeState = [&freezeFile]() {
+        QFile file(freezeFile);
+        return file.open(QIODevice::ReadOnly) ? file.readAll().trimmed() : QByteArray();
+    };
+    {
+        QFile file(freezeFile);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("0\n");
+    }
+
+    SimulatedClock clock(QDateTime(QDate(2030, 1, 7), QTime(12, 0), Qt::UTC));
+    FakeRtc rtc(clock);
+    RtcWakeDaemon::Options options;
+    options.configPath = configPath;
+    options.targetUser = QString::fromLocal8Bit(user->pw_name);
+    options.targetHome = dir.path();
+    options.cgroupRoot = cgroupRoot;
+    {
+        RtcWakeDaemon daemon(options, &clock, &rtc);
+        daemon.start();
+        clock.advanceTo(QDateTime(QDate(2030, 1, 8), QTime(1, 0), Qt::UTC));
+        QCOMPARE(freezeState(), QByteArray("1"));
+
+        // The thaw follows the wall clock across a step.
+        clock.setWallClock(QDateTime(QDate(2030, 1, 8), QTime(3, 0), Qt::UTC));
+        clock.advanceBy(3 * 60 * 60 * 1000);
+        QCOMPARE(freezeState(), QByteArray("1"));
+        clock.advanceTo(QDateTime(QDate(2030, 1, 8), QTime(7, 0), Qt::UTC));
+        QCOMPARE(freezeState(), QByteArray("0"));
+
+        // Stopping the daemon inside the next window must not leave the session frozen.
+        clock.advanceTo(QDateTime(QDate(2030, 1, 14), QTime(23, 30), Qt::UTC));
+        QCOMPARE(freezeState(), QByteArray("1"));
+    }
+    QCOMPARE(freezeState(), QByteArray("0"));
+    // The system never slept.
+    QCOMPARE(rtc.transitions.size(), 0);
+
+    CycleHistoryStore history(dir.filePath(QStringLiteral(".local/share/rtcwake-gui/history.bin")));
+    QVERIFY(history.open(false));
+    const auto records = history.records();
+    QCOMPARE(records.size(), 1);
+    QCOMPARE(records.first().action, static_cast<qint32>(PowerAction::FreezeUserSession));
+    QCOMPARE(records.first().outcome, static_cast<qint32>(CycleHistoryStore::Outcome::Completed));
+    QCOMPARE(records.first().actualShutdown, QDateTime(QDate(2030, 1, 7), QTime(23, 0), Qt::UTC).toSecsSinceEpoch());
+    QCOMPARE(records.first().actualResume, QDateTime(QDate(2030, 1, 8), QTime(7, 0), Qt::UTC).toSecsSinceEpoch());
+
+    const QString logPath = dir.filePath(QStringLiteral(".local/share/rtcwake-gui/log.txt"));
+    QCOMPARE(countLines(logPath, QStringLiteral("category=\"session_freeze\" status=\"frozen\"")), 2);
+    QCOMPARE(countLines(logPath, QStringLiteral("category=\"session_freeze\" status=\"thawed\"")), 1);
+    QCOMPARE(countLines(logPath, QStringLiteral("category=\"session_freeze\" status=\"thawed_on_exit\"")), 1);
+}
+
+QTEST_MAIN(DaemonSimulationTest)
+
+#include "DaemonSimulationTest.moc"
@@ -0,0 +1,75 @@
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include "DaemonStateJournal.h"
+
+class DaemonStateJournalTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void round_trips_state();
+    void rejects_tampered_payload();
+};
+
+void DaemonStateJournalTest::round_trips_state() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    DaemonStateJournal journal(dir.filePath(QStringLiteral("state/daemon-state.journal")));
+
+    DaemonStateJournal::State state;
+    state.nextShutdown = QDateTime(QDate(2030, 3, 30), QTime(23, 5, 30));
+    state.nextWake = QDateTime(QDate(2030, 3, 31), QTime(7, 30));
+    state.cyclePlannedShutdown = QDateTime(QDate(2030, 3, 30), QTime(23, 0));
+    state.armedAlarm = state.nextWake;
+    state.action = PowerAction::Hibernate;
+    state.readyLeadMs = 45000;
+    state.snoozeActive = true;
+    state.snoozeCount = 1;
+    state.configFingerprint = QByteArrayLiteral("abc123");
+    state.pid = 4242;
+    QVERIFY(journal.save(state));
+
+    DaemonStateJournal::State loaded;
+    QVERIFY(journal.load(loaded));
+    QCOMPARE(loaded.nextShutdown, state.nextShutdown);
+    QCOMPARE(loaded.nextWake, state.nextWake);
+    QCOMPARE(loaded.cyclePlannedShutdown, state.cyclePlannedShutdown);
+    QCOMPARE(loaded.armedAlarm, state.armedAlarm);
+    QVERIFY(!loaded.transitionStarted.isValid());
+    QCOMPARE(loaded.action, PowerAction::Hibernate);
+    QCOMPARE(loaded.readyLeadMs, qint64(45000));
+    QCOMPARE(loaded.snoozeActive, true);
+    QCOMPARE(loaded.snoozeCount, 1);
+    QCOMPARE(loaded.configFingerprint, state.configFingerprint);
+    QCOMPARE(loaded.pid, qint64(4242));
+}
+
+void DaemonStateJournalTest::rejects_tampered_payload() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("daemon-state.journal"));
+    DaemonStateJournal journal(path);
+
+    DaemonStateJournal::State state;
+    state.nextShutdown = QDateTime(QDate(2030, 3, 30), QTime(23, 0));
+    state.snoozeActive = false;
+    QVERIFY(journal.save(state));
+
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadOnly | QIODevice::Text));
+    QByteArray contents = file.readAll();
+    file.close();
+    contents.replace("\"snoozeActive\":false", "\"snoozeActive\":true");
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text));
+    file.write(contents);
+    file.close();
+
+    DaemonStateJournal::State loaded;
+    QVERIFY(!journal.load(loaded));
+    QVERIFY(journal.clear());
+    QVERIFY(!journal.load(loaded));
+}
+
+QTEST_MAIN(DaemonStateJournalTest)
+
+#include "DaemonStateJournalTest.moc"
@@ -0,0 +1,139 @@
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include "EnergyMeter.h"
+#include "TestFiles.h"
+
+namespace {
+bool writeZone(const QString &root, const QString &zone, const QByteArray &name, qint64 energyUj) {
+    const QString path = root + QStringLiteral("/class/powercap/") + zone;
+    return writeFile(path + QStringLiteral("/name"), name + '\n')
+        && writeFile(path + QStringLiteral("/energy_uj"), QByteArray::number(energyUj) + '\n')
+        && writeFile(path + QStringLiteral("/max_energy_range_uj"), "262143328850\n");
+}
+}
+
+class EnergyMeterTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void sums_packages_across_wraps();
+    void prefers_platform_zone();
+    void reads_batteries();
+    void keeps_charge_in_battery_total();
+    void reports_missing_counters();
+};
+
+void EnergyMeterTest::sums_packages_across_wraps() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(writeZone(dir.path(), QStringLiteral("intel-rapl:0"), "package-0", 262000000000));
+    QVERIFY(writeZone(dir.path(), QStringLiteral("intel-rapl:1"), "package-1", 1000000));
+    // Sub-zones are already part of their package.
+    QVERIFY(writeZone(dir.path(), QStringLiteral("intel-rapl:0:0"), "core", 5000000));
+
+    EnergyMeter meter(dir.path());
+    const auto first = meter.sample();
+    QCOMPARE(first.raplUj, qint64(0));
+    QVERIFY(first.hasRapl);
+    QVERIFY(!first.hasBattery);
+    // Half the time 250 W needs to wrap the counter.
+    QCOMPARE(meter.wrapSafeIntervalMs(), qint64(524286));
+
+    QVERIFY(writeZone(dir.path(), QStringLiteral("intel-rapl:0"), "package-0", 500000000));
+    QVERIFY(writeZone(dir.path(), QStringLiteral("intel-rapl:1"), "package-1", 3000000));
+    QVERIFY(writeZone(dir.path(), QStringLiteral("intel-rapl:0:0"), "core", 9000000));
+    const auto second = meter.sample();
+    QCOMPARE(second.raplUj, qint64(643328850 + 2000000));
+
+    // After a sleep a counter that went backwards was reset.
+    QVERIFY(writeZone(dir.path(), QStringLiteral("intel-rapl:0"), "package-0", 100000));
+    const auto third = meter.sample(true);
+    QCOMPARE(EnergyMeter::since(second, third).raplUj, qint64(100000));
+    QCOMPARE(meter.totals().raplUj, third.raplUj);
+}
+
+void EnergyMeterTest::prefers_platform_zone() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(writeZone(dir.path(), QStringLiteral("intel-rapl:0"), "package-0", 1000));
+    QVERIFY(writeZone(dir.path(), QStringLiteral("intel-rapl:1"), "psys", 1000));
+
+    EnergyMeter meter(dir.path());
+    meter.sample();
+    QVERIFY(writeZone(dir.path(), QStringLiteral("intel-rapl:0"), "package-0", 5000));
+    QVERIFY(writeZone(dir.path(), QStringLiteral("intel-rapl:1"), "psys", 9000));
+    QCOMPARE(meter.sample().raplUj, qint64(8000));
+}
+
+void EnergyMeterTest::reads_batteries() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString supplies = dir.filePath(QStringLiteral("class/power_supply/"));
+    QVERIFY(writeFile(supplies + QStringLiteral("BAT0/type"), "Battery\n"));
+    QVERIFY(writeFile(supplies + QStringLiteral("BAT0/energy_now"), "50000000\n"));
+    QVERIFY(writeFile(supplies + QStringLiteral("BAT1/type"), "Battery\n"));
+    QVERIFY(writeFile(supplies + QStringLiteral("BAT1/charge_now"), "4000000\n"));
+    QVERIFY(writeFile(supplies + QStringLiteral("BAT1/voltage_now"), "12000000\n"));
+    QVERIFY(writeFile(supplies + QStringLiteral("AC/type"), "Mains\n"));
+
+    EnergyMeter meter(dir.path());
+    QCOMPARE(meter.sample().batteryUj, qint64(0));
+    QCOMPARE(meter.wrapSafeIntervalMs(), qint64(0));
+
+    // 1 Wh from BAT0; 100 mAh at 12 V is another 1.2 Wh from BAT1.
+    QVERIFY(writeFile(supplies + QStringLiteral("BAT0/energy_now"), "49000000\n"));
+    QVERIFY(writeFile(supplies + QStringLiteral("BAT1/charge_now"), "3900000\n"));
+    QCOMPARE(meter.sample().batteryUj, qint64(2200000) * 3600);
+
+    // Charging counts against the drain.
+    QVERIFY(writeFile(supplies + QStringLiteral("BAT0/energy_now"), "51000000\n"));
+    QCOMPARE(meter.sample().batteryUj, qint64(200000) * 3600);
+}
+
+void EnergyMeterTest::keeps_charge_in_battery_total() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString battery = dir.filePath(QStringLiteral("class/power_supply/BAT0/"));
+    QVERIFY(writeFile(battery + QStringLiteral("type"), "Battery\n"));
+    QVERIFY(writeFile(battery + QStringLiteral("energy_now"), "50000000\n"));
+
+    EnergyMeter meter(dir.path());
+    const auto start = meter.sample();
+    QVERIFY(start.hasBattery);
+
+    // Plugged in: 2 Wh charged, so the total drain goes negative and stays there.
+    QVERIFY(writeFile(battery + QStringLiteral("energy_now"), "52000000\n"));
+    const auto charged = meter.sample();
+    QCOMPARE(charged.batteryUj, qint64(-2000000) * 3600);
+
+    // Unplugged: 1 Wh drained is 1 Wh, not the 3 Wh a reset total would report.
+    QVERIFY(writeFile(battery + QStringLiteral("energy_now"), "51000000\n"));
+    const auto drained = meter.sample();
+    QCOMPARE(drained.batteryUj, qint64(-1000000) * 3600);
+    QCOMPARE(EnergyMeter::since(charged, drained).batteryUj, qint64(1000000) * 3600);
+    QCOMPARE(EnergyMeter::since(start, drained).batteryUj, qint64(-1000000) * 3600);
+}
+
+void EnergyMeterTest::reports_missing_counters() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    EnergyMeter meter(dir.path());
+    const auto totals = meter.sample();
+    QVERIFY(!totals.hasRapl);
+    QVERIFY(!totals.hasBattery);
+
+    EnergyMeter::Energy later;
+    later.raplUj = 5;
+    later.batteryUj = -1;
+    later.hasRapl = true;
+    later.hasBattery = true;
+    QVERIFY(!EnergyMeter::since(totals, later).hasRapl);
+    const auto none = EnergyMeter::since(later, later);
+    QVERIFY(none.hasBattery);
+    QCOMPARE(none.batteryUj, qint64(0));
+}
+
+QTEST_MAIN(EnergyMeterTest)
+
+#include "EnergyMeterTest.moc"
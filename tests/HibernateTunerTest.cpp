@@ -0,0 +1,141 @@
+#include <QtTest>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include "HibernateTuner.h"
+#include "TestFiles.h"
+
+namespace {
+bool writeTree(const QString &root) {
+    return writeFile(root + QStringLiteral("/proc/meminfo"), "MemTotal:       16777216 kB\nMemFree:         8000000 kB\n")
+        && writeFile(root + QStringLiteral("/proc/sys/vm/drop_caches"), "0\n")
+        && writeFile(root + QStringLiteral("/proc/sys/vm/compact_memory"), "0\n")
+        && writeFile(root + QStringLiteral("/sys/power/image_size"), "6871947264\n")
+        && writeFile(root + QStringLiteral("/sys/power/disk"), "[platform] shutdown reboot suspend test_resume\n")
+        && writeFile(root + QStringLiteral("/sys/module/hibernate/parameters/compressor"), "lzo\n");
+}
+
+HibernateTuner tuner(const QTemporaryDir &dir) {
+    return HibernateTuner(dir.filePath(QStringLiteral("sys")), dir.filePath(QStringLiteral("proc")),
+                          dir.filePath(QStringLiteral("kmsg")));
+}
+}
+
+class HibernateTunerTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void applies_policy();
+    void reports_unavailable_choices();
+    void reads_image_timings_after_sequence();
+    void keeps_stats_per_setting();
+};
+
+void HibernateTunerTest::applies_policy() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(writeTree(dir.path()));
+
+    HibernateTuningPreferences prefs;
+    prefs.enabled = true;
+    prefs.imageSizePercent = 25;
+    prefs.dropCaches = true;
+    prefs.compactMemory = true;
+    prefs.diskMode = QStringLiteral("shutdown");
+    prefs.compressor = QStringLiteral("lz4");
+
+    const auto applied = tuner(dir).apply(prefs);
+    QVERIFY2(applied.errors.isEmpty(), qPrintable(applied.errors.join(QLatin1Char('\n'))));
+    QCOMPARE(applied.key, QStringLiteral("image=25%,disk=shutdown,compressor=lz4,drop_caches,compact"));
+    QCOMPARE(applied.imageBytes, qint64(4294967296));
+    QCOMPARE(readValue(dir.filePath(QStringLiteral("sys/power/image_size"))), QByteArray("4294967296"));
+    QCOMPARE(readValue(dir.filePath(QStringLiteral("sys/power/disk"))), QByteArray("shutdown"));
+    QCOMPARE(readValue(dir.filePath(QStringLiteral("sys/module/hibernate/parameters/compressor"))), QByteArray("lz4"));
+    QCOMPARE(readValue(dir.filePath(QStringLiteral("proc/sys/vm/drop_caches"))), QByteArray("1"));
+    QCOMPARE(readValue(dir.filePath(QStringLiteral("proc/sys/vm/compact_memory"))), QByteArray("1"));
+}
+
+void HibernateTunerTest::reports_unavailable_choices() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(writeTree(dir.path()));
+    QVERIFY(QFile::remove(dir.filePath(QStringLiteral("sys/module/hibernate/parameters/compressor"))));
+
+    HibernateTuningPreferences prefs;
+    prefs.enabled = true;
+    prefs.diskMode = QStringLiteral("firmware");
+    prefs.compressor = QStringLiteral("lz4");
+
+    const auto applied = tuner(dir).apply(prefs);
+    QCOMPARE(applied.errors.size(), 2);
+    QCOMPARE(applied.key, QStringLiteral("image=kernel,disk=firmware,compressor=lz4"));
+    // The kernel's own size is reported when the policy leaves it alone.
+    QCOMPARE(applied.imageBytes, qint64(6871947264));
+    QCOMPARE(readValue(dir.filePath(QStringLiteral("sys/power/disk"))),
+             QByteArray("[platform] shutdown reboot suspend test_resume"));
+    QVERIFY(!QFile::exists(dir.filePath(QStringLiteral("sys/module/hibernate/parameters/compressor"))));
+}
+
+void HibernateTunerTest::reads_image_timings_after_sequence() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(writeFile(dir.filePath(QStringLiteral("kmsg")),
+                      "6,100,5000000,-;PM: hibernation: Wrote 1000 kbytes in 9.00 seconds (0.11 MB/s)\n"
+                      "6,150,6000000,-;PM: hibernation: Read 1000 kbytes in 8.00 seconds (0.12 MB/s)\n"
+                      "6,205,9000000,-;PM: hibernation: Wrote 2048000 kbytes in 4.10 seconds (499.51 MB/s)\n"
+                      " SUBSYSTEM=platform\n"
+                      "6,206,9100000,-;PM: hibernation: Read 2048000 kbytes in 2.05 seconds (999.02 MB/s)\n"
+                      "4,207,9200000,-;usb 1-1: reset high-speed USB device number 2\n"));
+
+    const auto reader = tuner(dir);
+    QCOMPARE(reader.kmsgSequence(), quint64(207));
+
+    const auto stats = reader.imageStats(150);
+    QCOMPARE(stats.writtenKiB, qint64(2048000));
+    QCOMPARE(stats.writeSeconds, 4.10);
+    QCOMPARE(stats.readKiB, qint64(2048000));
+    QCOMPARE(stats.readSeconds, 2.05);
+
+    const auto nothing = reader.imageStats(207);
+    QCOMPARE(nothing.writeSeconds, -1.0);
+    QCOMPARE(nothing.readSeconds, -1.0);
+}
+
+void HibernateTunerTest::keeps_stats_per_setting() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("state/hibernate-tuning.json"));
+    const QString kernel = QStringLiteral("image=kernel,disk=kernel,compressor=kernel");
+    const QString small = QStringLiteral("image=min,disk=shutdown,compressor=lz4,drop_caches");
+
+    HibernateTuner::ImageStats slow;
+    slow.writeSeconds = 40.0;
+    slow.readSeconds = 30.0;
+    HibernateTuner::ImageStats fast;
+    fast.writeSeconds = 6.0;
+    fast.readSeconds = 4.0;
+    for (int i = 0; i < 3; ++i) {
+        QVERIFY(HibernateTuner::recordSample(path, kernel, 6871947264, slow, 45.0));
+    }
+    QVERIFY(HibernateTuner::recordSample(path, small, 0, fast, 12.0));
+    QVERIFY(HibernateTuner::recordSample(path, small, 0, HibernateTuner::ImageStats(), 14.0));
+
+    auto stats = HibernateTuner::loadStats(path);
+    QCOMPARE(stats.size(), 2);
+    QCOMPARE(stats.value(kernel).count, 3);
+    QCOMPARE(stats.value(kernel).meanWriteSeconds(), 40.0);
+    QCOMPARE(stats.value(small).count, 2);
+    QCOMPARE(stats.value(small).writeCount, 1);
+    QCOMPARE(stats.value(small).meanResumeSeconds(), 13.0);
+    QCOMPARE(stats.value(small).costSeconds(), 19.0);
+    QCOMPARE(stats.value(small).lastImageBytes, qint64(0));
+
+    // Two samples are not enough to call the faster setting the winner yet.
+    QCOMPARE(HibernateTuner::bestSetting(stats), kernel);
+    QVERIFY(HibernateTuner::recordSample(path, small, 0, fast, 10.0));
+    QCOMPARE(HibernateTuner::bestSetting(HibernateTuner::loadStats(path)), small);
+}
+
+QTEST_MAIN(HibernateTunerTest)
+
+#include "HibernateTunerTest.moc"
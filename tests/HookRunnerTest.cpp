@@ -0,0 +1,160 @@
+#include <QtTest>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include "HookRunner.h"
+#include "TestFiles.h"
+
+namespace {
+bool writeHook(const QString &path, const QByteArray &body, bool executable = true) {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    file.write("#!/bin/sh\n" + body);
+    file.close();
+    const auto mode = QFileDevice::ReadOwner | QFileDevice::WriteOwner;
+    return file.setPermissions(executable ? mode | QFileDevice::ExeOwner : mode);
+}
+
+QStringList readLines(const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return {};
+    }
+    return QString::fromUtf8(file.readAll()).split(QLatin1Char('\n'), Qt::SkipEmptyParts);
+}
+
+const HookRunner::Result *findResult(const HookRunner::Report &report, const QString &name) {
+    for (const auto &result : report.results) {
+        if (result.name == name) {
+            return &result;
+        }
+    }
+    return nullptr;
+}
+}
+
+class HookRunnerTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void discovers_headers_and_skips_backups();
+    void runs_in_parallel_respecting_order();
+    void kills_hooks_after_timeout();
+    void kills_hook_children_after_timeout();
+    void breaks_dependency_cycles();
+};
+
+void HookRunnerTest::discovers_headers_and_skips_backups() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(writeHook(dir.filePath(QStringLiteral("20-nfs")), "# rtcwake-after: 10-backup, 05-missing\n"
+                                                              "# rtcwake-timeout: 2.5\n"
+                                                              "exit 0\n"));
+    QVERIFY(writeHook(dir.filePath(QStringLiteral("10-backup")), "exit 0\n# rtcwake-timeout: 9\n"));
+    QVERIFY(writeHook(dir.filePath(QStringLiteral("10-backup~")), "exit 0\n"));
+    QVERIFY(writeHook(dir.filePath(QStringLiteral("README")), "not a hook\n", false));
+
+    const auto hooks = HookRunner::discover(dir.path(), 1000);
+    QCOMPARE(hooks.size(), 2);
+    QCOMPARE(hooks.at(0).name, QStringLiteral("10-backup"));
+    QCOMPARE(hooks.at(0).timeoutMs, 1000);
+    QVERIFY(hooks.at(0).after.isEmpty());
+    QCOMPARE(hooks.at(1).name, QStringLiteral("20-nfs"));
+    QCOMPARE(hooks.at(1).timeoutMs, 2500);
+    QCOMPARE(hooks.at(1).after, QStringList({QStringLiteral("10-backup"), QStringLiteral("05-missing")}));
+
+    QVERIFY(HookRunner::discover(dir.filePath(QStringLiteral("absent"))).isEmpty());
+}
+
+void HookRunnerTest::runs_in_parallel_respecting_order() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString order = dir.filePath(QStringLiteral("order.txt"));
+    const QByteArray append = "echo \"$(basename \"$0\") $1 $2\" >> '" + order.toUtf8() + "'\n";
+    QVERIFY(QDir(dir.path()).mkpath(QStringLiteral("hooks")));
+    const QDir hooks(dir.filePath(QStringLiteral("hooks")));
+    QVERIFY(writeHook(hooks.filePath(QStringLiteral("a-unmount")), "sleep 0.5\n" + append));
+    QVERIFY(writeHook(hooks.filePath(QStringLiteral("b-backup")), "sleep 0.5\n" + append + "echo stopped\n"));
+    QVERIFY(writeHook(hooks.filePath(QStringLiteral("c-network")), "# rtcwake-after: a-unmount\n" + append + "exit 3\n"));
+
+    HookRunner runner;
+    const auto report = runner.run(hooks.path(), {QStringLiteral("pre"), QStringLiteral("mem")});
+    QVERIFY(!runner.isRunning());
+    QCOMPARE(report.results.size(), 3);
+    QVERIFY2(report.elapsedMs < 900, qPrintable(QStringLiteral("pipeline took %1 ms").arg(report.elapsedMs)));
+
+    const QStringList lines = readLines(order);
+    QCOMPARE(lines.size(), 3);
+    QVERIFY(lines.indexOf(QStringLiteral("c-network pre mem")) > lines.indexOf(QStringLiteral("a-unmount pre mem")));
+
+    const auto *backup = findResult(report, QStringLiteral("b-backup"));
+    QVERIFY(backup);
+    QVERIFY(backup->succeeded());
+    QCOMPARE(backup->message, QStringLiteral("stopped"));
+    QVERIFY(backup->elapsedMs >= 400);
+    const auto *network = findResult(report, QStringLiteral("c-network"));
+    QVERIFY(network);
+    QCOMPARE(network->exitCode, 3);
+    QVERIFY(!report.succeeded());
+    QVERIFY(report.slowest()->name != QStringLiteral("c-network"));
+
+    // With a single slot the same pipeline serializes.
+    runner.setMaxParallel(1);
+    const auto serial = runner.run(hooks.path(), {QStringLiteral("pre"), QStringLiteral("mem")});
+    QVERIFY(serial.elapsedMs >= 1000);
+}
+
+void HookRunnerTest::kills_hooks_after_timeout() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(writeHook(dir.filePath(QStringLiteral("hang")), "# rtcwake-timeout: 0.2\nexec sleep 30\n"));
+    QVERIFY(writeHook(dir.filePath(QStringLiteral("quick")), "exit 0\n"));
+
+    HookRunner runner;
+    const auto report = runner.run(dir.path(), {QStringLiteral("post"), QStringLiteral("mem")});
+    QVERIFY2(report.elapsedMs < 2000, qPrintable(QStringLiteral("pipeline took %1 ms").arg(report.elapsedMs)));
+    const auto *hang = findResult(report, QStringLiteral("hang"));
+    QVERIFY(hang);
+    QVERIFY(hang->timedOut);
+    QVERIFY(!hang->succeeded());
+    QVERIFY(findResult(report, QStringLiteral("quick"))->succeeded());
+}
+
+void HookRunnerTest::kills_hook_children_after_timeout() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString pidFile = dir.filePath(QStringLiteral("child.pid"));
+    QVERIFY(writeHook(dir.filePath(QStringLiteral("hang")),
+                      "# rtcwake-timeout: 0.2\nsleep 30 &\necho $! > '" + pidFile.toUtf8() + "'\nwait\n"));
+
+    HookRunner runner;
+    const auto report = runner.run(dir.path(), {QStringLiteral("pre"), QStringLiteral("mem")});
+    QVERIFY(findResult(report, QStringLiteral("hang"))->timedOut);
+
+    // The shell's background child went down with it.
+    const qint64 child = readValue(pidFile).toLongLong();
+    QVERIFY(child > 0);
+    QTRY_VERIFY_WITH_TIMEOUT(processGone(child), 2000);
+}
+
+void HookRunnerTest::breaks_dependency_cycles() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(writeHook(dir.filePath(QStringLiteral("x")), "# rtcwake-after: y\nexit 0\n"));
+    QVERIFY(writeHook(dir.filePath(QStringLiteral("y")), "# rtcwake-after: x\nexit 0\n"));
+    QVERIFY(writeHook(dir.filePath(QStringLiteral("z")), "# rtcwake-after: x y\nexit 0\n"));
+
+    HookRunner runner;
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression(QStringLiteral("rtcwake-after cycle")));
+    const auto report = runner.run(dir.path(), {QStringLiteral("pre"), QStringLiteral("mem")});
+    QCOMPARE(report.results.size(), 3);
+    QVERIFY(!findResult(report, QStringLiteral("x"))->succeeded());
+    QVERIFY(findResult(report, QStringLiteral("y"))->succeeded());
+    QVERIFY(findResult(report, QStringLiteral("z"))->succeeded());
+}
+
+QTEST_MAIN(HookRunnerTest)
+
+#include "HookRunnerTest.moc"
@@ -0,0 +1,139 @@
+#include <QtTest>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include "IdleSuspendMonitor.h"
+#include "SimulatedClock.h"
+
+namespace {
+constexpr qint64 kMinute = 60 * 1000;
+
+/** Regular files accept the trigger definition but never report POLLPRI. */
+bool createPressureFiles(const QString &procRoot) {
+    if (!QDir(procRoot).mkpath(QStringLiteral("pressure"))) {
+        return false;
+    }
+    for (const char *resource : {"cpu", "io", "memory"}) {
+        QFile file(procRoot + QStringLiteral("/pressure/") + QLatin1String(resource));
+        if (!file.open(QIODevice::WriteOnly)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+IdleSuspendMonitor::Settings thirtyMinutes() {
+    IdleSuspendMonitor::Settings settings;
+    settings.idleMs = 30 * kMinute;
+    settings.pressurePercent = 5;
+    return settings;
+}
+}
+
+class IdleSuspendMonitorTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void emits_idle_after_quiet_period();
+    void backs_off_after_activity();
+    void waits_for_session_idle();
+    void stays_off_without_psi();
+};
+
+void IdleSuspendMonitorTest::emits_idle_after_quiet_period() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(createPressureFiles(dir.path()));
+
+    SimulatedClock clock(QDateTime(QDate(2030, 1, 7), QTime(22, 0), Qt::UTC));
+    IdleSuspendMonitor monitor(&clock, dir.path());
+    QSignalSpy spy(&monitor, &IdleSuspendMonitor::idle);
+    monitor.start(thirtyMinutes());
+    QCOMPARE(monitor.triggerCount(), 3);
+    QVERIFY(monitor.isActive());
+
+    // 5% of the 10 s window, NUL-terminated as the kernel documentation does it.
+    QFile cpu(dir.filePath(QStringLiteral("pressure/cpu")));
+    QVERIFY(cpu.open(QIODevice::ReadOnly));
+    QCOMPARE(cpu.readAll(), QByteArray("some 500000 10000000", 21));
+
+    clock.advanceBy(29 * kMinute);
+    QCOMPARE(spy.count(), 0);
+    clock.advanceBy(kMinute);
+    QCOMPARE(spy.count(), 1);
+    QVERIFY(!monitor.isActive());
+    QCOMPARE(clock.activeTimers(), 0);
+
+    // Nothing more until the owner starts another period.
+    clock.advanceBy(120 * kMinute);
+    QCOMPARE(spy.count(), 1);
+}
+
+void IdleSuspendMonitorTest::backs_off_after_activity() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(createPressureFiles(dir.path()));
+
+    SimulatedClock clock(QDateTime(QDate(2030, 1, 7), QTime(22, 0), Qt::UTC));
+    IdleSuspendMonitor monitor(&clock, dir.path());
+    QSignalSpy spy(&monitor, &IdleSuspendMonitor::idle);
+    monitor.start(thirtyMinutes());
+    clock.advanceBy(10 * kMinute);
+
+    // A burst of pressure events costs one timer, not one wakeup per event.
+    const quint64 firedBefore = clock.firedTimers();
+    for (int i = 0; i < 100; ++i) {
+        monitor.noteActivity();
+    }
+    QCOMPARE(clock.activeTimers(), 1);
+
+    // Back-off ends at +40 min, the next quiet period at +70 min.
+    clock.advanceBy(59 * kMinute);
+    QCOMPARE(spy.count(), 0);
+    clock.advanceBy(kMinute);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(clock.firedTimers() - firedBefore, quint64(2));
+}
+
+void IdleSuspendMonitorTest::waits_for_session_idle() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(createPressureFiles(dir.path()));
+
+    SimulatedClock clock(QDateTime(QDate(2030, 1, 7), QTime(22, 0), Qt::UTC));
+    IdleSuspendMonitor monitor(&clock, dir.path());
+    QSignalSpy spy(&monitor, &IdleSuspendMonitor::idle);
+    monitor.start(thirtyMinutes());
+    clock.advanceBy(20 * kMinute);
+
+    monitor.setSessionIdle(false);
+    QCOMPARE(clock.activeTimers(), 0);
+    clock.advanceBy(120 * kMinute);
+    QCOMPARE(spy.count(), 0);
+
+    // The quiet period starts over once the session goes idle.
+    monitor.setSessionIdle(true);
+    clock.advanceBy(29 * kMinute);
+    QCOMPARE(spy.count(), 0);
+    clock.advanceBy(kMinute);
+    QCOMPARE(spy.count(), 1);
+}
+
+void IdleSuspendMonitorTest::stays_off_without_psi() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    SimulatedClock clock(QDateTime(QDate(2030, 1, 7), QTime(22, 0), Qt::UTC));
+    IdleSuspendMonitor monitor(&clock, dir.path());
+    QSignalSpy spy(&monitor, &IdleSuspendMonitor::idle);
+    monitor.start(thirtyMinutes());
+    QCOMPARE(monitor.triggerCount(), 0);
+    QVERIFY(!monitor.isActive());
+    clock.advanceBy(120 * kMinute);
+    QCOMPARE(spy.count(), 0);
+}
+
+QTEST_MAIN(IdleSuspendMonitorTest)
+
+#include "IdleSuspendMonitorTest.moc"
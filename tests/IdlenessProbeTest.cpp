@@ -0,0 +1,123 @@
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include "IdlenessProbe.h"
+#include "TestFiles.h"
+
+namespace {
+QByteArray diskstats(quint64 sectorsRead, quint64 sectorsWritten) {
+    const QByteArray whole = QByteArray::number(sectorsRead) + " 0 0 0 " + QByteArray::number(sectorsWritten);
+    // Partitions and loop devices repeat the same I/O and must not be counted.
+    return "   7       0 loop0 5 0 9999 0 0 0 9999 0 0 0 0 0 0 0 0 0 0\n"
+           " 259       0 nvme0n1 10 0 " + whole + " 0 0 0 0 0 0 0 0 0 0\n"
+           " 259       1 nvme0n1p1 10 0 " + whole + " 0 0 0 0 0 0 0 0 0 0\n"
+           "   8       0 sda 1 0 0 0 1 0 0 0 0 0 0 0 0 0 0 0 0\n";
+}
+
+QByteArray netdev(quint64 rx, quint64 tx) {
+    return "Inter-|   Receive                                                |  Transmit\n"
+           " face |bytes    packets errs drop fifo frame compressed multicast|bytes    packets errs drop fifo colls carrier compressed\n"
+           "    lo: 999999999 10 0 0 0 0 0 0 999999999 10 0 0 0 0 0 0\n"
+           "  eth0: " + QByteArray::number(rx) + " 10 0 0 0 0 0 0 " + QByteArray::number(tx) + " 10 0 0 0 0 0 0\n";
+}
+}
+
+class IdlenessProbeTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void reads_proc_counters();
+    void reports_busy_reasons();
+    void idle_system_has_no_reasons();
+};
+
+void IdlenessProbeTest::reads_proc_counters() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(writeFile(dir.filePath(QStringLiteral("loadavg")), "3.50 2.00 1.00 2/300 4242\n"));
+    QVERIFY(writeFile(dir.filePath(QStringLiteral("pressure/cpu")),
+                      "some avg10=12.50 avg60=3.00 avg300=1.00 total=100\nfull avg10=0.00 avg60=0.00 avg300=0.00 total=0\n"));
+    QVERIFY(writeFile(dir.filePath(QStringLiteral("pressure/io")),
+                      "some avg10=0.75 avg60=0.00 avg300=0.00 total=5\nfull avg10=0.50 avg60=0.00 avg300=0.00 total=3\n"));
+    QVERIFY(writeFile(dir.filePath(QStringLiteral("diskstats")), diskstats(100, 300)));
+    QVERIFY(writeFile(dir.filePath(QStringLiteral("net/dev")), netdev(1000, 24)));
+    QVERIFY(writeFile(dir.filePath(QStringLiteral("101/comm")), "borg\n"));
+    QVERIFY(writeFile(dir.filePath(QStringLiteral("102/comm")), "bash\n"));
+    QVERIFY(writeFile(dir.filePath(QStringLiteral("self/comm")), "ffmpeg\n"));
+    // comm keeps 15 characters of "unattended-upgrades".
+    QVERIFY(writeFile(dir.filePath(QStringLiteral("103/comm")), "unattended-upgr\n"));
+
+    const IdlenessProbe probe(dir.path());
+    const auto snapshot = probe.sample(1000, {QStringLiteral("ffmpeg"), QStringLiteral("borg"),
+                                              QStringLiteral("unattended-upgrades"), QStringLiteral("unattended")});
+    QVERIFY(snapshot.valid);
+    QCOMPARE(snapshot.monotonicMs, qint64(1000));
+    QCOMPARE(snapshot.load1, 3.5);
+    QCOMPARE(snapshot.cpuPressure, 12.5);
+    QCOMPARE(snapshot.ioPressure, 0.75);
+    QCOMPARE(snapshot.memoryPressure, -1.0);
+    QCOMPARE(snapshot.diskBytes, quint64((100 + 300) * 512));
+    QCOMPARE(snapshot.netBytes, quint64(1024));
+    QCOMPARE(snapshot.blockingProcesses, QStringList({QStringLiteral("borg"), QStringLiteral("unattended-upgrades")}));
+
+    QVERIFY(!IdlenessProbe(dir.filePath(QStringLiteral("missing"))).sample(0, {}).valid);
+}
+
+void IdlenessProbeTest::reports_busy_reasons() {
+    IdlenessProbe::Snapshot before;
+    before.valid = true;
+    before.monotonicMs = 0;
+    before.diskBytes = 0;
+    before.netBytes = 0;
+
+    IdlenessProbe::Snapshot after = before;
+    after.monotonicMs = 5000;
+    after.load1 = 6.0;
+    after.cpuPressure = 1.0;
+    after.ioPressure = 40.0;
+    after.memoryPressure = -1.0;
+    after.diskBytes = 5000ULL * 4096;
+    after.netBytes = 5000ULL * 100;
+    after.blockingProcesses = QStringList({QStringLiteral("make")});
+
+    DeferralPreferences limits;
+    limits.maxLoadPerCpu = 0.5;
+    limits.maxIoPressure = 10.0;
+    limits.maxDiskKiBps = 2048;
+    limits.maxNetKiBps = 512;
+    const QStringList reasons = IdlenessProbe::busyReasons(before, after, limits, 4);
+    QCOMPARE(reasons.size(), 4);
+    QCOMPARE(reasons.at(0), QStringLiteral("load 1.50 per cpu > 0.50"));
+    QCOMPARE(reasons.at(1), QStringLiteral("io pressure 40.00% > 10.00%"));
+    QCOMPARE(reasons.at(2), QStringLiteral("disk 4000 KiB/s > 2048 KiB/s"));
+    QCOMPARE(reasons.at(3), QStringLiteral("running make"));
+
+    // Disabled limits are not checked.
+    limits.maxLoadPerCpu = 0;
+    limits.maxIoPressure = 0;
+    limits.maxDiskKiBps = 0;
+    QCOMPARE(IdlenessProbe::busyReasons(before, after, limits, 4), QStringList({QStringLiteral("running make")}));
+}
+
+void IdlenessProbeTest::idle_system_has_no_reasons() {
+    IdlenessProbe::Snapshot before;
+    before.valid = true;
+    before.diskBytes = 1000;
+    before.netBytes = 1000;
+    IdlenessProbe::Snapshot after = before;
+    after.monotonicMs = 5000;
+    after.load1 = 0.2;
+    after.cpuPressure = 0.0;
+    after.ioPressure = 0.0;
+    after.memoryPressure = 0.0;
+    after.diskBytes = 2000;
+    QVERIFY(IdlenessProbe::busyReasons(before, after, DeferralPreferences(), 2).isEmpty());
+
+    // Counters that go backwards (e.g. a hot-unplugged NIC) do not count as traffic.
+    after.netBytes = 0;
+    QVERIFY(IdlenessProbe::busyReasons(before, after, DeferralPreferences(), 2).isEmpty());
+}
+
+QTEST_MAIN(IdlenessProbeTest)
+
+#include "IdlenessProbeTest.moc"
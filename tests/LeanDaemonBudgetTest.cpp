@@ -0,0 +1,152 @@
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QProcess>
+#include <QRegularExpression>
+#include <QTemporaryDir>
+
+#include "ConfigRepository.h"
+#include "LeanConfigReader.h"
+#include "SchedulePlanner.h"
+
+namespace {
+AppConfig weekdayConfig(const QTime &shutdown, const QTime &wake) {
+    AppConfig config;
+    config.singleShutdownDate = QDate(2000, 1, 1);
+    config.singleWakeDate = QDate(2000, 1, 1);
+    config.actionId = static_cast<int>(PowerAction::SuspendToRam);
+    config.warning.enabled = false;
+    for (auto &entry : config.weekly) {
+        entry.enabled = entry.day <= Qt::Friday;
+        entry.shutdownTime = shutdown;
+        entry.wakeTime = wake;
+    }
+    return config;
+}
+
+qint64 residentKb(qint64 pid) {
+    QFile status(QStringLiteral("/proc/%1/status").arg(pid));
+    if (!status.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return -1;
+    }
+    const QString text = QString::fromLatin1(status.readAll());
+    const auto match = QRegularExpression(QStringLiteral("VmRSS:\\s+(\\d+) kB")).match(text);
+    return match.hasMatch() ? match.captured(1).toLongLong() : -1;
+}
+
+/** Read daemon output until a schedule line appears; returns its shutdown/wake epochs. */
+bool waitForPlan(QProcess &process, QString &output, const QString &reason, qint64 &shutdown, qint64 &wake) {
+    const QRegularExpression pattern(QStringLiteral("category=\"schedule\" status=\"planned\" reason=\"%1\".*"
+                                                    "shutdown_epoch=\"(\\d+)\" wake_epoch=\"(\\d+)\"")
+                                         .arg(QRegularExpression::escape(reason)));
+    QElapsedTimer timeout;
+    timeout.start();
+    while (timeout.elapsed() < 5000) {
+        const auto match = pattern.match(output);
+        if (match.hasMatch()) {
+            shutdown = match.captured(1).toLongLong();
+            wake = match.captured(2).toLongLong();
+            output.remove(0, match.capturedEnd());
+            return true;
+        }
+        if (!process.waitForReadyRead(100) && process.state() != QProcess::Running) {
+            return false;
+        }
+        output += QString::fromUtf8(process.readAll());
+    }
+    return false;
+}
+}
+
+class LeanDaemonBudgetTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void reader_matches_config_repository();
+    void stays_within_budgets();
+};
+
+void LeanDaemonBudgetTest::reader_matches_config_repository() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("config.json"));
+
+    AppConfig config = weekdayConfig(QTime(23, 15), QTime(6, 45));
+    config.weekly[2].enabled = false;
+    config.singleShutdownDate = QDate(2031, 6, 1);
+    config.singleShutdownTime = QTime(12, 0, 30);
+    config.singleWakeDate = QDate(2031, 6, 1);
+    config.singleWakeTime = QTime(13, 0);
+    config.warning.message = QStringLiteral("Speichern \"jetzt\" – bitte");
+    QVERIFY(ConfigRepository(path).save(config));
+
+    LeanConfigReader::Config lean;
+    std::string error;
+    QVERIFY2(LeanConfigReader::load(path.toStdString(), lean, &error), error.c_str());
+    QCOMPARE(QString::fromStdString(lean.warning.message), config.warning.message);
+    QCOMPARE(lean.warning.enabled, false);
+
+    // Both planners must agree at a range of instants, including across the single event.
+    const QDateTime base(QDate(2031, 5, 25), QTime(8, 0));
+    for (int hours = 0; hours < 24 * 14; hours += 7) {
+        const QDateTime now = base.addSecs(hours * 3600);
+        SchedulePlanner::Event expected;
+        PlannerCore::Event actual;
+        const bool hasExpected = SchedulePlanner::nextEvent(ConfigRepository(path).load(), now, expected);
+        const bool hasActual = PlannerCore::nextEvent(lean.plan, now.toMSecsSinceEpoch(), PlannerCore::systemZone(), actual);
+        QCOMPARE(hasActual, hasExpected);
+        QCOMPARE(actual.shutdownMs, expected.shutdown.toMSecsSinceEpoch());
+        QCOMPARE(actual.wakeMs, expected.wake.toMSecsSinceEpoch());
+        QCOMPARE(actual.action, static_cast<int>(expected.action));
+    }
+
+    QVERIFY(!LeanConfigReader::parse("{\"weekly\": [", lean, &error));
+    QVERIFY(!error.empty());
+}
+
+void LeanDaemonBudgetTest::stays_within_budgets() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString configPath = dir.filePath(QStringLiteral("config.json"));
+    QVERIFY(ConfigRepository(configPath).save(weekdayConfig(QTime(23, 0), QTime(7, 0))));
+
+    QProcess process;
+    process.setProcessChannelMode(QProcess::MergedChannels);
+    QElapsedTimer startup;
+    startup.start();
+    process.start(QStringLiteral(LEAN_DAEMON_PATH),
+                  {QStringLiteral("--config"), configPath, QStringLiteral("--home"), dir.path(), QStringLiteral("--dry-run")});
+    QVERIFY(process.waitForStarted());
+
+    QString output;
+    qint64 shutdown = 0;
+    qint64 wake = 0;
+    QVERIFY2(waitForPlan(process, output, QStringLiteral("Daemon started"), shutdown, wake), qPrintable(output));
+    const qint64 startupMs = startup.elapsed();
+    QVERIFY2(startupMs <= LEAN_DAEMON_STARTUP_BUDGET_MS,
+             qPrintable(QStringLiteral("first plan after %1 ms").arg(startupMs)));
+
+    SchedulePlanner::Event expected;
+    QVERIFY(SchedulePlanner::nextEvent(weekdayConfig(QTime(23, 0), QTime(7, 0)), QDateTime::currentDateTime(), expected));
+    QCOMPARE(shutdown, expected.shutdown.toSecsSinceEpoch());
+    QCOMPARE(wake, expected.wake.toSecsSinceEpoch());
+
+    const qint64 rss = residentKb(process.processId());
+    QVERIFY2(rss > 0 && rss <= LEAN_DAEMON_RSS_BUDGET_KB, qPrintable(QStringLiteral("RSS %1 kB").arg(rss)));
+
+    // inotify picks up the rewrite without any polling.
+    QVERIFY(ConfigRepository(configPath).save(weekdayConfig(QTime(22, 30), QTime(6, 30))));
+    QVERIFY2(waitForPlan(process, output, QStringLiteral("Config reloaded"), shutdown, wake), qPrintable(output));
+    QVERIFY(SchedulePlanner::nextEvent(weekdayConfig(QTime(22, 30), QTime(6, 30)), QDateTime::currentDateTime(), expected));
+    QCOMPARE(shutdown, expected.shutdown.toSecsSinceEpoch());
+
+    process.terminate();
+    QVERIFY(process.waitForFinished(2000));
+    QCOMPARE(process.exitStatus(), QProcess::NormalExit);
+    QCOMPARE(process.exitCode(), 0);
+    QVERIFY(QFile::exists(dir.filePath(QStringLiteral(".local/share/rtcwake-gui/next-wake.json"))));
+}
+
+QTEST_MAIN(LeanDaemonBudgetTest)
+
+#include "LeanDaemonBudgetTest.moc"
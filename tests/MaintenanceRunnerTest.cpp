@@ -0,0 +1,96 @@
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+
+#include "MaintenanceRunner.h"
+#include "TestFiles.h"
+
+namespace {
+MaintenanceJob job(const QString &name, const QString &command, int timeoutSeconds = 30) {
+    MaintenanceJob result;
+    result.name = name;
+    result.command = command;
+    result.timeoutSeconds = timeoutSeconds;
+    return result;
+}
+}
+
+class MaintenanceRunnerTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void runs_jobs_in_parallel_with_priorities();
+    void kills_job_group_after_timeout();
+    void cancel_skips_pending_jobs();
+};
+
+void MaintenanceRunnerTest::runs_jobs_in_parallel_with_priorities() {
+    MaintenanceRunner runner;
+    runner.setMaxParallel(2);
+    QSignalSpy spy(&runner, &MaintenanceRunner::finished);
+
+    MaintenanceJob niceness = job(QStringLiteral("niceness"), QStringLiteral("sleep 0.5; echo \"$RTCWAKE_JOB $(nice)\""));
+    niceness.nice = 12;
+    QElapsedTimer elapsed;
+    elapsed.start();
+    QVERIFY(runner.start({niceness, job(QStringLiteral("b"), QStringLiteral("sleep 0.5")),
+                          job(QStringLiteral("c"), QStringLiteral("sleep 0.5")),
+                          job(QStringLiteral("d"), QStringLiteral("sleep 0.5; exit 3"))}));
+    QVERIFY(runner.isRunning());
+    QVERIFY(!runner.start({job(QStringLiteral("again"), QStringLiteral("true"))}));
+    QTRY_COMPARE_WITH_TIMEOUT(spy.count(), 1, 10000);
+
+    // Two rounds of two jobs, not one round of four and not four rounds of one.
+    QVERIFY2(elapsed.elapsed() >= 1000, qPrintable(QString::number(elapsed.elapsed())));
+    QVERIFY2(elapsed.elapsed() < 1900, qPrintable(QString::number(elapsed.elapsed())));
+
+    const auto report = runner.lastReport();
+    QVERIFY(!runner.isRunning());
+    QCOMPARE(report.results.size(), 4);
+    QCOMPARE(report.results.at(0).message, QStringLiteral("niceness 12"));
+    QVERIFY(report.results.at(0).succeeded());
+    QCOMPARE(report.results.at(3).exitCode, 3);
+    QCOMPARE(report.failures(), 1);
+    QVERIFY(report.results.at(1).elapsedMs >= 500);
+}
+
+void MaintenanceRunnerTest::kills_job_group_after_timeout() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString pidFile = dir.filePath(QStringLiteral("child.pid"));
+
+    MaintenanceRunner runner;
+    QSignalSpy spy(&runner, &MaintenanceRunner::finished);
+    QVERIFY(runner.start({job(QStringLiteral("stuck"), QStringLiteral("sleep 60 & echo $! > '%1'; wait").arg(pidFile), 1)}));
+    QTRY_COMPARE_WITH_TIMEOUT(spy.count(), 1, 10000);
+
+    const auto result = runner.lastReport().results.first();
+    QVERIFY(result.timedOut);
+    QVERIFY(!result.succeeded());
+    QCOMPARE(result.message, QStringLiteral("killed after 1 s"));
+
+    // The shell's background child went down with it.
+    const qint64 child = readValue(pidFile).toLongLong();
+    QVERIFY(child > 0);
+    QTRY_VERIFY_WITH_TIMEOUT(processGone(child), 2000);
+}
+
+void MaintenanceRunnerTest::cancel_skips_pending_jobs() {
+    MaintenanceRunner runner;
+    runner.setMaxParallel(1);
+    QSignalSpy spy(&runner, &MaintenanceRunner::finished);
+    QVERIFY(runner.start({job(QStringLiteral("long"), QStringLiteral("sleep 60")), job(QStringLiteral("later"), QStringLiteral("true"))}));
+    QTest::qWait(100);
+    runner.cancel();
+    QTRY_COMPARE_WITH_TIMEOUT(spy.count(), 1, 5000);
+
+    const auto report = runner.lastReport();
+    QVERIFY(report.canceled);
+    QVERIFY(!report.results.at(0).succeeded());
+    QVERIFY(report.results.at(1).skipped);
+    QCOMPARE(report.failures(), 2);
+}
+
+QTEST_MAIN(MaintenanceRunnerTest)
+
+#include "MaintenanceRunnerTest.moc"
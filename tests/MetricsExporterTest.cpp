@@ -0,0 +1,71 @@
+#include <QtTest>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include "MetricsExporter.h"
+
+class MetricsExporterTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void renders_text_format();
+    void flush_replaces_file();
+    void disabled_without_path();
+};
+
+void MetricsExporterTest::renders_text_format() {
+    MetricsExporter exporter(QStringLiteral("/nonexistent/metrics.prom"));
+    exporter.defineCounter(QStringLiteral("demo_total"), QStringLiteral("Demo counter."));
+    exporter.defineGauge(QStringLiteral("demo_gauge"), QStringLiteral("Demo gauge."));
+    exporter.defineHistogram(QStringLiteral("demo_seconds"), QStringLiteral("Demo histogram."), {1, 0.5});
+
+    exporter.increment(QStringLiteral("demo_total"));
+    exporter.increment(QStringLiteral("demo_total"), QStringLiteral("mode=\"mem\""), 2);
+    exporter.setGauge(QStringLiteral("demo_gauge"), 1700000000);
+    exporter.observe(QStringLiteral("demo_seconds"), 0.25);
+    exporter.observe(QStringLiteral("demo_seconds"), 0.75);
+    exporter.observe(QStringLiteral("demo_seconds"), 3);
+
+    const QString text = QString::fromUtf8(exporter.render());
+    QVERIFY(text.contains(QStringLiteral("# TYPE demo_total counter\n")));
+    QVERIFY(text.contains(QStringLiteral("\ndemo_total 1\n")));
+    QVERIFY(text.contains(QStringLiteral("demo_total{mode=\"mem\"} 2\n")));
+    QVERIFY(text.contains(QStringLiteral("demo_gauge 1700000000\n")));
+    QVERIFY(text.contains(QStringLiteral("demo_seconds_bucket{le=\"0.5\"} 1\n")));
+    QVERIFY(text.contains(QStringLiteral("demo_seconds_bucket{le=\"1\"} 2\n")));
+    QVERIFY(text.contains(QStringLiteral("demo_seconds_bucket{le=\"+Inf\"} 3\n")));
+    QVERIFY(text.contains(QStringLiteral("demo_seconds_sum 4\n")));
+    QVERIFY(text.contains(QStringLiteral("demo_seconds_count 3\n")));
+}
+
+void MetricsExporterTest::flush_replaces_file() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("textfile/rtcwake.prom"));
+
+    MetricsExporter exporter(path);
+    exporter.defineCounter(QStringLiteral("demo_total"), QStringLiteral("Demo counter."));
+    exporter.increment(QStringLiteral("demo_total"));
+    QVERIFY(!QFile::exists(path));
+    QVERIFY(exporter.flush());
+
+    exporter.increment(QStringLiteral("demo_total"));
+    QVERIFY(exporter.flush());
+
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadOnly | QIODevice::Text));
+    QVERIFY(QString::fromUtf8(file.readAll()).contains(QStringLiteral("demo_total 2\n")));
+}
+
+void MetricsExporterTest::disabled_without_path() {
+    MetricsExporter exporter(QString());
+    exporter.defineCounter(QStringLiteral("demo_total"), QStringLiteral("Demo counter."));
+    exporter.increment(QStringLiteral("demo_total"));
+    QVERIFY(!exporter.isEnabled());
+    QVERIFY(exporter.render().isEmpty());
+    QVERIFY(!exporter.flush());
+}
+
+QTEST_MAIN(MetricsExporterTest)
+
+#include "MetricsExporterTest.moc"
@@ -0,0 +1,96 @@
+#include <QtTest>
+#include <QDir>
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+
+#include "PageCachePrefetcher.h"
+
+namespace {
+bool writeFile(const QString &path, qint64 size) {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    return file.write(QByteArray(static_cast<int>(size), 'x')) == size;
+}
+}
+
+class PageCachePrefetcherTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void prefetches_files_and_trees();
+    void stops_at_budget();
+    void runs_in_background();
+};
+
+void PageCachePrefetcherTest::prefetches_files_and_trees() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(QDir(dir.path()).mkpath(QStringLiteral("home/.config/app")));
+    QVERIFY(writeFile(dir.filePath(QStringLiteral("home/notes.txt")), 4096));
+    QVERIFY(writeFile(dir.filePath(QStringLiteral("home/.config/app/state")), 10000));
+    QVERIFY(writeFile(dir.filePath(QStringLiteral("vm.img")), 3 * 1024 * 1024 + 17));
+    // Symlinks are not followed, so the image is only counted under its own root.
+    QVERIFY(QFile::link(dir.filePath(QStringLiteral("vm.img")), dir.filePath(QStringLiteral("home/vm-link"))));
+
+    PageCachePrefetcher::Options options;
+    options.paths = QStringList({dir.filePath(QStringLiteral("home")), dir.filePath(QStringLiteral("vm.img")),
+                                 dir.filePath(QStringLiteral("missing"))});
+    options.workers = 2;
+    options.budgetMs = 10000;
+    const auto report = PageCachePrefetcher::run(options);
+
+    QCOMPARE(report.roots.size(), 3);
+    QCOMPARE(report.roots.at(0).files, qint64(2));
+    QCOMPARE(report.roots.at(0).bytes, qint64(4096 + 10000));
+    QCOMPARE(report.roots.at(1).files, qint64(1));
+    QCOMPARE(report.roots.at(1).bytes, qint64(3 * 1024 * 1024 + 17));
+    QCOMPARE(report.roots.at(2).files, qint64(0));
+    QCOMPARE(report.files, qint64(3));
+    QCOMPARE(report.bytes, qint64(4096 + 10000 + 3 * 1024 * 1024 + 17));
+    QCOMPARE(report.errors, qint64(1));
+    QVERIFY(!report.budgetExhausted);
+    QVERIFY(!report.canceled);
+}
+
+void PageCachePrefetcherTest::stops_at_budget() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(writeFile(dir.filePath(QStringLiteral("data")), 1024));
+
+    PageCachePrefetcher::Options options;
+    options.paths = QStringList({dir.path()});
+    options.budgetMs = 0;
+    const auto report = PageCachePrefetcher::run(options);
+    QVERIFY(report.budgetExhausted);
+    QCOMPARE(report.bytes, qint64(0));
+}
+
+void PageCachePrefetcherTest::runs_in_background() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(writeFile(dir.filePath(QStringLiteral("data")), 8192));
+
+    PageCachePrefetcher prefetcher;
+    QSignalSpy finished(&prefetcher, &PageCachePrefetcher::finished);
+    PageCachePrefetcher::Options options;
+    options.paths = QStringList({dir.path()});
+    QVERIFY(prefetcher.start(options));
+    QVERIFY(!prefetcher.start(options));
+    QVERIFY(finished.wait(5000));
+    QVERIFY(!prefetcher.isRunning());
+    QCOMPARE(prefetcher.lastReport().bytes, qint64(8192));
+
+    // Canceling reports synchronously and the queued completion is dropped.
+    QVERIFY(prefetcher.start(options));
+    prefetcher.cancel();
+    QCOMPARE(finished.count(), 2);
+    QTest::qWait(50);
+    QCOMPARE(finished.count(), 2);
+}
+
+QTEST_MAIN(PageCachePrefetcherTest)
+
+#include "PageCachePrefetcherTest.moc"
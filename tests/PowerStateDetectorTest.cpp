@@ -0,0 +1,100 @@
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include "PowerStateDetector.h"
+#include "TestFiles.h"
+
+namespace {
+bool writeTree(const QString &root, const QByteArray &resume, const QByteArray &swapKiB) {
+    return writeFile(root + QStringLiteral("/sys/power/state"), "freeze mem disk\n")
+        && writeFile(root + QStringLiteral("/sys/power/resume"), resume + '\n')
+        && writeFile(root + QStringLiteral("/sys/power/image_size"), "3355443200\n")
+        && writeFile(root + QStringLiteral("/proc/swaps"),
+                     "Filename\t\t\t\tType\t\tSize\t\tUsed\t\tPriority\n"
+                     "/dev/nvme0n1p3                          partition\t" + swapKiB + "\t\t0\t\t-2\n");
+}
+
+PowerStateDetector::Option option(const QVector<PowerStateDetector::Option> &options, PowerAction action) {
+    for (const auto &candidate : options) {
+        if (candidate.action == action) {
+            return candidate;
+        }
+    }
+    return {PowerAction::None, QString(), QString(), false};
+}
+}
+
+class PowerStateDetectorTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void offers_hybrid_with_swap_and_resume();
+    void needs_resume_device();
+    void needs_enough_swap();
+    void offers_session_freeze_on_cgroup_v2();
+};
+
+void PowerStateDetectorTest::offers_hybrid_with_swap_and_resume() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(writeTree(dir.path(), "259:3", "8388604"));
+
+    const PowerStateDetector detector(dir.filePath(QStringLiteral("sys")), dir.filePath(QStringLiteral("proc")));
+    const auto support = detector.hibernation();
+    QVERIFY(support.usable());
+    QCOMPARE(support.swapBytes, qint64(8388604) * 1024);
+    QCOMPARE(support.imageBytes, qint64(3355443200));
+
+    const auto options = detector.detect();
+    QVERIFY(option(options, PowerAction::Hibernate).available);
+    const auto hybrid = option(options, PowerAction::SuspendThenHibernate);
+    QVERIFY(hybrid.available);
+    QCOMPARE(hybrid.label, QStringLiteral("Suspend, then hibernate"));
+}
+
+void PowerStateDetectorTest::needs_resume_device() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(writeTree(dir.path(), "0:0", "8388604"));
+
+    const PowerStateDetector detector(dir.filePath(QStringLiteral("sys")), dir.filePath(QStringLiteral("proc")));
+    QCOMPARE(detector.hibernation().problem(), QStringLiteral("No resume device is configured"));
+    const auto options = detector.detect();
+    QVERIFY(!option(options, PowerAction::Hibernate).available);
+    QVERIFY(!option(options, PowerAction::SuspendThenHibernate).available);
+    QVERIFY(option(options, PowerAction::SuspendToRam).available);
+}
+
+void PowerStateDetectorTest::needs_enough_swap() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(writeTree(dir.path(), "259:3", "1048572"));
+
+    const PowerStateDetector detector(dir.filePath(QStringLiteral("sys")), dir.filePath(QStringLiteral("proc")));
+    QVERIFY(!detector.hibernation().usable());
+    const auto hybrid = option(detector.detect(), PowerAction::SuspendThenHibernate);
+    QVERIFY(!hybrid.available);
+    QVERIFY2(hybrid.description.contains(QStringLiteral("Swap (1023 MiB)")), qPrintable(hybrid.description));
+}
+
+void PowerStateDetectorTest::offers_session_freeze_on_cgroup_v2() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(writeTree(dir.path(), "259:3", "8388604"));
+    const QString cgroupRoot = dir.filePath(QStringLiteral("cgroup"));
+    QVERIFY(writeFile(cgroupRoot + QStringLiteral("/user.slice/cgroup.freeze"), "0\n"));
+
+    // Without cgroup.controllers this is a v1 hierarchy, which has no cgroup.freeze.
+    const PowerStateDetector v1(dir.filePath(QStringLiteral("sys")), dir.filePath(QStringLiteral("proc")), cgroupRoot);
+    QVERIFY(!option(v1.detect(), PowerAction::FreezeUserSession).available);
+
+    QVERIFY(writeFile(cgroupRoot + QStringLiteral("/cgroup.controllers"), "cpuset cpu io memory pids\n"));
+    const PowerStateDetector v2(dir.filePath(QStringLiteral("sys")), dir.filePath(QStringLiteral("proc")), cgroupRoot);
+    const auto freeze = option(v2.detect(), PowerAction::FreezeUserSession);
+    QVERIFY(freeze.available);
+    QCOMPARE(freeze.label, QStringLiteral("Freeze user session"));
+}
+
+QTEST_MAIN(PowerStateDetectorTest)
+
+#include "PowerStateDetectorTest.moc"
@@ -0,0 +1,67 @@
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include "ResumeLatencyStats.h"
+
+class ResumeLatencyStatsTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void measures_sleep_and_delay();
+    void percentiles_follow_buckets();
+    void round_trips_state_file();
+};
+
+void ResumeLatencyStatsTest::measures_sleep_and_delay() {
+    ResumeLatencyStats::ClockSample before;
+    before.bootMs = 10000;
+    before.monotonicMs = 10000;
+    before.realtime = QDateTime(QDate(2030, 1, 1), QTime(23, 0));
+
+    ResumeLatencyStats::ClockSample after;
+    after.bootMs = 10000 + 8 * 3600 * 1000 + 12000;
+    after.monotonicMs = 10000 + 5000;
+    after.realtime = QDateTime(QDate(2030, 1, 2), QTime(7, 0, 7));
+
+    const auto result = ResumeLatencyStats::measure(before, after, QDateTime(QDate(2030, 1, 2), QTime(7, 0)));
+    QCOMPARE(result.suspendedMs, qint64(8 * 3600 * 1000 + 7000));
+    QCOMPARE(result.wakeDelayMs, qint64(7000));
+}
+
+void ResumeLatencyStatsTest::percentiles_follow_buckets() {
+    ResumeLatencyStats stats;
+    QCOMPARE(stats.percentile(PowerAction::SuspendToRam, 0.5), -1.0);
+    for (int i = 0; i < 9; ++i) {
+        stats.record(PowerAction::SuspendToRam, 3.0);
+    }
+    stats.record(PowerAction::SuspendToRam, 45.0);
+
+    QCOMPARE(stats.histogram(PowerAction::SuspendToRam).count, quint32(10));
+    QCOMPARE(stats.percentile(PowerAction::SuspendToRam, 0.5), 5.0);
+    QCOMPARE(stats.percentile(PowerAction::SuspendToRam, 0.9), 5.0);
+    QCOMPARE(stats.percentile(PowerAction::SuspendToRam, 1.0), 45.0);
+    QCOMPARE(stats.actions(), QList<PowerAction>{PowerAction::SuspendToRam});
+}
+
+void ResumeLatencyStatsTest::round_trips_state_file() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("state/resume-latency.json"));
+
+    ResumeLatencyStats stats;
+    stats.record(PowerAction::Hibernate, 42.0);
+    stats.record(PowerAction::Hibernate, 900.0);
+    QVERIFY(stats.save(path));
+
+    ResumeLatencyStats loaded;
+    QVERIFY(loaded.load(path));
+    const auto histogram = loaded.histogram(PowerAction::Hibernate);
+    QCOMPARE(histogram.count, quint32(2));
+    QCOMPARE(histogram.maxSeconds, 900.0);
+    QCOMPARE(histogram.sumSeconds, 942.0);
+    QCOMPARE(loaded.percentile(PowerAction::Hibernate, 0.5), 60.0);
+}
+
+QTEST_MAIN(ResumeLatencyStatsTest)
+
+#include "ResumeLatencyStatsTest.moc"
@@ -0,0 +1,79 @@
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include "RtcDeviceProbe.h"
+#include "TestFiles.h"
+
+namespace {
+/** rtc0: SoC RTC without wake support, rtc1: PMIC RTC that can wake, rtc2: no alarm at all. */
+bool writeTree(const QString &sysRoot) {
+    const QString rtc = sysRoot + QStringLiteral("/class/rtc/");
+    return writeFile(rtc + QStringLiteral("rtc0/name"), "snvs_rtc\n")
+        && writeFile(rtc + QStringLiteral("rtc0/hctosys"), "1\n")
+        && writeFile(rtc + QStringLiteral("rtc0/wakealarm"), "\n")
+        && writeFile(rtc + QStringLiteral("rtc0/device/power/wakeup"), "disabled\n")
+        && writeFile(rtc + QStringLiteral("rtc1/name"), "rtc-pcf85063\n")
+        && writeFile(rtc + QStringLiteral("rtc1/hctosys"), "0\n")
+        && writeFile(rtc + QStringLiteral("rtc1/wakealarm"), "1893481200\n")
+        && writeFile(rtc + QStringLiteral("rtc2/name"), "rtc-efi\n")
+        && writeFile(rtc + QStringLiteral("rtc10/name"), "rtc-test\n")
+        && writeFile(rtc + QStringLiteral("rtc10/wakealarm"), "\n");
+}
+}
+
+class RtcDeviceProbeTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void lists_devices_and_capabilities();
+    void selects_a_device_that_can_wake();
+    void probes_range_and_clears_alarm();
+};
+
+void RtcDeviceProbeTest::lists_devices_and_capabilities() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(writeTree(dir.path()));
+
+    const auto devices = RtcDeviceProbe(dir.path()).devices();
+    QCOMPARE(devices.size(), 4);
+    QCOMPARE(devices.at(0).name, QStringLiteral("rtc0"));
+    QCOMPARE(devices.at(0).driver, QStringLiteral("snvs_rtc"));
+    QVERIFY(devices.at(0).hctosys);
+    QVERIFY(devices.at(0).hasWakeAlarm);
+    QVERIFY(!devices.at(0).canWake);
+    QCOMPARE(devices.at(1).name, QStringLiteral("rtc1"));
+    QVERIFY(devices.at(1).canWake);
+    QVERIFY(!devices.at(2).hasWakeAlarm);
+    QCOMPARE(devices.at(3).name, QStringLiteral("rtc10"));
+}
+
+void RtcDeviceProbeTest::selects_a_device_that_can_wake() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(writeTree(dir.path()));
+
+    const RtcDeviceProbe probe(dir.path());
+    QCOMPARE(probe.select(QString()), QStringLiteral("rtc1"));
+    QCOMPARE(probe.select(QStringLiteral("rtc10")), QStringLiteral("rtc10"));
+    // Neither can wake the system, so the choice falls back to one that can.
+    QCOMPARE(probe.select(QStringLiteral("rtc0")), QStringLiteral("rtc1"));
+    QCOMPARE(probe.select(QStringLiteral("rtc2")), QStringLiteral("rtc1"));
+    QCOMPARE(RtcDeviceProbe(dir.filePath(QStringLiteral("missing"))).select(QString()), QString());
+}
+
+void RtcDeviceProbeTest::probes_range_and_clears_alarm() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(writeTree(dir.path()));
+
+    const RtcDeviceProbe probe(dir.path());
+    // A plain file accepts everything, so the longest candidate wins.
+    QCOMPARE(probe.probeAlarmRange(QStringLiteral("rtc1")), RtcDeviceProbe::rangeCandidates().first());
+    QCOMPARE(readValue(dir.filePath(QStringLiteral("class/rtc/rtc1/wakealarm"))), QByteArray("0"));
+    QCOMPARE(probe.probeAlarmRange(QStringLiteral("rtc7")), qint64(0));
+}
+
+QTEST_MAIN(RtcDeviceProbeTest)
+
+#include "RtcDeviceProbeTest.moc"
@@ -0,0 +1,98 @@
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include "RtcDriftModel.h"
+
+#include <cmath>
+
+namespace {
+constexpr qint64 kHour = 60 * 60 * 1000;
+
+QDateTime at(int day) {
+    return QDateTime(QDate(2030, 1, day), QTime(7, 15), Qt::UTC);
+}
+}
+
+class RtcDriftModelTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void fits_rate_through_origin();
+    void ignores_short_and_implausible_sleeps();
+    void keeps_newest_samples();
+    void round_trips_through_json();
+};
+
+void RtcDriftModelTest::fits_rate_through_origin() {
+    RtcDriftModel model;
+    const QString device = QStringLiteral("rtc0");
+    // Roughly -250 ppm (the RTC loses time), with one-second rounding noise.
+    QVERIFY(model.addSample(device, 8 * kHour, -7000, at(8)));
+    QVERIFY(model.addSample(device, 2 * kHour, -2000, at(9)));
+    QCOMPARE(model.predictGainMs(device, 8 * kHour), qint64(0));
+
+    QVERIFY(model.addSample(device, 10 * kHour, -9000, at(10)));
+    const auto estimate = model.estimate(device);
+    QVERIFY(estimate.usable());
+    QCOMPARE(estimate.samples, 3);
+    // sum(g*d) / sum(d^2) = -(56 + 4 + 90) / (64 + 4 + 100) ms per hour-ms.
+    QVERIFY2(qAbs(estimate.ppm - (-150.0 / 168.0 / 3600.0 * 1e6)) < 0.01, qPrintable(QString::number(estimate.ppm)));
+    QVERIFY(estimate.stdErrorPpm > 0.0);
+    QVERIFY(estimate.stdErrorPpm < 20.0);
+    QCOMPARE(model.predictGainMs(device, 8 * kHour), qint64(std::llround(estimate.ppm * 1e-6 * 8 * kHour)));
+    QCOMPARE(model.predictGainMs(QStringLiteral("rtc1"), 8 * kHour), qint64(0));
+}
+
+void RtcDriftModelTest::ignores_short_and_implausible_sleeps() {
+    RtcDriftModel model;
+    const QString device = QStringLiteral("rtc0");
+    QVERIFY(!model.addSample(device, 30 * 60 * 1000, 1000, at(8)));
+    // A minute over an hour is a clock change, not drift.
+    QVERIFY(!model.addSample(device, kHour, 60 * 1000, at(8)));
+    QCOMPARE(model.estimate(device).samples, 0);
+    QCOMPARE(model.summary(device), QStringLiteral("rtc0: no drift samples"));
+}
+
+void RtcDriftModelTest::keeps_newest_samples() {
+    RtcDriftModel model;
+    const QString device = QStringLiteral("rtc0");
+    for (int i = 0; i < RtcDriftModel::kMaxSamples; ++i) {
+        QVERIFY(model.addSample(device, 8 * kHour, 14400, at(1)));
+    }
+    // The RTC was replaced: newer samples push the old rate out.
+    for (int i = 0; i < RtcDriftModel::kMaxSamples; ++i) {
+        QVERIFY(model.addSample(device, 8 * kHour, -2880, at(2)));
+    }
+    const auto samples = model.samples(device);
+    QCOMPARE(samples.size(), RtcDriftModel::kMaxSamples);
+    QCOMPARE(samples.first().recorded, at(2));
+    QVERIFY(qAbs(model.estimate(device).ppm - (-100.0)) < 0.001);
+    QVERIFY(model.estimate(device).stdErrorPpm < 1e-6);
+}
+
+void RtcDriftModelTest::round_trips_through_json() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("state/rtc-drift.json"));
+
+    RtcDriftModel model;
+    QVERIFY(model.addSample(QStringLiteral("rtc0"), 8 * kHour, 14000, at(8)));
+    QVERIFY(model.addSample(QStringLiteral("rtc0"), 9 * kHour, 16500, at(9)));
+    QVERIFY(model.addSample(QStringLiteral("rtc1"), 8 * kHour, -500, at(8)));
+    QVERIFY(model.save(path));
+
+    RtcDriftModel loaded;
+    QVERIFY(loaded.load(path));
+    QCOMPARE(loaded.devices(), QStringList({QStringLiteral("rtc0"), QStringLiteral("rtc1")}));
+    const auto samples = loaded.samples(QStringLiteral("rtc0"));
+    QCOMPARE(samples.size(), 2);
+    QCOMPARE(samples.at(1).sleptMs, 9 * kHour);
+    QCOMPARE(samples.at(1).gainMs, qint64(16500));
+    QCOMPARE(samples.at(1).recorded, at(9));
+    QCOMPARE(loaded.estimate(QStringLiteral("rtc0")).ppm, model.estimate(QStringLiteral("rtc0")).ppm);
+    QVERIFY(loaded.summary(QStringLiteral("rtc1")).endsWith(QStringLiteral(", not compensating yet")));
+}
+
+QTEST_MAIN(RtcDriftModelTest)
+
+#include "RtcDriftModelTest.moc"
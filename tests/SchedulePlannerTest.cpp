@@ -10,6 +10,7 @@ private slots:
     void picks_single_future();
     void falls_back_to_weekly();
     void skips_disabled();
+    void plans_hibernate_stage();
 };
 
 void SchedulePlannerTest::picks_single_future() {
@@ -29,6 +30,7 @@ void SchedulePlannerTest::picks_single_future() {
     QCOMPARE(event.action, PowerAction::PowerOff);
     QCOMPARE(event.shutdown, QDateTime(QDate(2030, 1, 1), QTime(22, 0), QTimeZone::systemTimeZone()));
     QCOMPARE(event.wake, QDateTime(QDate(2030, 1, 2), QTime(6, 0), QTimeZone::systemTimeZone()));
+    QCOMPARE(event.weeklyIndex, -1);
 }
 
 void SchedulePlannerTest::falls_back_to_weekly() {
@@ -71,6 +73,37 @@ void SchedulePlannerTest::skips_disabled() {
     QVERIFY(SchedulePlanner::nextEvent(config, now, event));
     QCOMPARE(event.shutdown.date().dayOfWeek(), static_cast<int>(Qt::Monday));
     QCOMPARE(event.action, PowerAction::Hibernate);
+    QCOMPARE(event.weeklyIndex, 0);
+}
+
+void SchedulePlannerTest::plans_hibernate_stage() {
+    AppConfig config;
+    config.singleShutdownDate = QDate(2030, 1, 1);
+    config.singleShutdownTime = QTime(22, 0);
+    config.singleWakeDate = QDate(2030, 1, 2);
+    config.singleWakeTime = QTime(6, 0);
+    config.actionId = static_cast<int>(PowerAction::SuspendThenHibernate);
+    config.hibernateDelayMinutes = 120;
+    for (auto &entry : config.weekly) {
+        entry.enabled = false;
+    }
+
+    const QTimeZone zone = QTimeZone::systemTimeZone();
+    QDateTime now(QDate(2030, 1, 1), QTime(20, 0), zone);
+    SchedulePlanner::Event event;
+    QVERIFY(SchedulePlanner::nextEvent(config, now, event));
+    QCOMPARE(event.action, PowerAction::SuspendThenHibernate);
+    QCOMPARE(event.hibernateAt, QDateTime(QDate(2030, 1, 2), QTime(0, 0), zone));
+
+    // Less than half an hour on disk is not worth the image; stay in RAM.
+    config.hibernateDelayMinutes = 7 * 60 + 40;
+    QVERIFY(SchedulePlanner::nextEvent(config, now, event));
+    QVERIFY(!event.hibernateAt.isValid());
+
+    config.actionId = static_cast<int>(PowerAction::SuspendToRam);
+    config.hibernateDelayMinutes = 120;
+    QVERIFY(SchedulePlanner::nextEvent(config, now, event));
+    QVERIFY(!event.hibernateAt.isValid());
 }
 
 QTEST_MAIN(SchedulePlannerTest)
@@ -0,0 +1,160 @@
+#include <QtTest>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include "SessionLocator.h"
+#include "TestFiles.h"
+
+#include <cstring>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+constexpr uint kUid = 1000;
+
+/** A process of @p uid whose environment holds @p variables. */
+bool writeProcess(const QTemporaryDir &dir, int pid, uint uid, const QList<QByteArray> &variables) {
+    const QString process = dir.filePath(QStringLiteral("proc/%1/").arg(pid));
+    QByteArray environ;
+    for (const auto &variable : variables) {
+        environ += variable + '\0';
+    }
+    return writeFile(process + QStringLiteral("status"),
+                     QStringLiteral("Name:\tapp\nUid:\t%1\t%1\t%1\t%1\nGid:\t%1\t%1\t%1\t%1\n").arg(uid).toLatin1())
+        && writeFile(process + QStringLiteral("environ"), environ);
+}
+
+/** A unix socket at @p path; it keeps listening unless @p listening is false, leaving a stale file. */
+int bindSocket(const QString &path, bool listening = true) {
+    if (!QDir().mkpath(QFileInfo(path).path())) {
+        return -1;
+    }
+    const QByteArray name = QFile::encodeName(path);
+    sockaddr_un addr {};
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, name.constData(), static_cast<std::size_t>(name.size()));
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || ::bind(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0) {
+        return -1;
+    }
+    if (!listening) {
+        ::close(fd);
+        return 0;
+    }
+    return ::listen(fd, 4) == 0 ? fd : -1;
+}
+
+SessionLocator locator(const QTemporaryDir &dir) {
+    return SessionLocator(dir.filePath(QStringLiteral("proc")), dir.filePath(QStringLiteral("run")),
+                          dir.filePath(QStringLiteral("x11")));
+}
+}
+
+class SessionLocatorTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void reads_session_from_process_environment();
+    void skips_dead_and_remote_displays();
+    void follows_logind_sessions();
+    void cleanup();
+
+private:
+    QList<int> m_sockets;
+};
+
+void SessionLocatorTest::cleanup() {
+    for (const int fd : m_sockets) {
+        ::close(fd);
+    }
+    m_sockets.clear();
+}
+
+void SessionLocatorTest::reads_session_from_process_environment() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString runtimeDir = dir.filePath(QStringLiteral("run/user/1000"));
+    m_sockets << bindSocket(runtimeDir + QStringLiteral("/wayland-0"));
+    QVERIFY(m_sockets.last() > 0);
+    QVERIFY(writeFile(runtimeDir + QStringLiteral("/bus"), QByteArray()));
+
+    // The session leader started before the compositor and has no display yet.
+    QVERIFY(writeProcess(dir, 90, kUid, {"XDG_SESSION_ID=3", "HOME=/home/user"}));
+    QVERIFY(writeProcess(dir, 100, kUid, {"XDG_SESSION_ID=3", "WAYLAND_DISPLAY=wayland-0"}));
+    QVERIFY(writeProcess(dir, 120, kUid, {"XDG_SESSION_ID=3", "WAYLAND_DISPLAY=wayland-0", "DISPLAY=:1",
+                                          "XAUTHORITY=/run/user/1000/.mutter-Xwaylandauth.ABC"}));
+    QVERIFY(writeProcess(dir, 130, 1001, {"XDG_SESSION_ID=4", "WAYLAND_DISPLAY=wayland-0"}));
+    QVERIFY(writeFile(dir.filePath(QStringLiteral("proc/self/status")), "Uid:\t1000\t1000\t1000\t1000\n"));
+
+    const auto sessions = locator(dir).discover(kUid);
+    QCOMPARE(sessions.size(), 1);
+    const auto session = sessions.first();
+    QCOMPARE(session.id, QStringLiteral("3"));
+    QCOMPARE(session.pid, qint64(120));
+    QCOMPARE(session.waylandDisplay, QStringLiteral("wayland-0"));
+    QCOMPARE(session.display, QStringLiteral(":1"));
+    QCOMPARE(session.xauthority, QStringLiteral("/run/user/1000/.mutter-Xwaylandauth.ABC"));
+    QCOMPARE(session.xdgRuntimeDir, runtimeDir);
+    QCOMPARE(session.dbusAddress, QStringLiteral("unix:path=") + runtimeDir + QStringLiteral("/bus"));
+    QVERIFY(locator(dir).alive(session));
+}
+
+void SessionLocatorTest::skips_dead_and_remote_displays() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    // X0 belonged to a server that exited without removing its socket.
+    QCOMPARE(bindSocket(dir.filePath(QStringLiteral("x11/X0")), false), 0);
+    m_sockets << bindSocket(dir.filePath(QStringLiteral("x11/X2")));
+    QVERIFY(m_sockets.last() > 0);
+
+    QVERIFY(writeProcess(dir, 200, kUid, {"XDG_SESSION_ID=1", "DISPLAY=:0"}));
+    QVERIFY(writeProcess(dir, 210, kUid, {"XDG_SESSION_ID=2", "DISPLAY=localhost:10.0"}));
+    QVERIFY(writeProcess(dir, 220, kUid, {"XDG_SESSION_ID=5", "DISPLAY=:2.0"}));
+
+    const auto sessions = locator(dir).discover(kUid);
+    QCOMPARE(sessions.size(), 1);
+    QCOMPARE(sessions.first().id, QStringLiteral("5"));
+    QVERIFY(sessions.first().xdgRuntimeDir.isEmpty());
+
+    SessionInfo saved;
+    saved.display = QStringLiteral(":0");
+    QVERIFY(!locator(dir).alive(SessionLocator::fromSessionInfo(saved)));
+    saved.display = QStringLiteral(":2");
+    QVERIFY(locator(dir).alive(SessionLocator::fromSessionInfo(saved)));
+}
+
+void SessionLocatorTest::follows_logind_sessions() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    m_sockets << bindSocket(dir.filePath(QStringLiteral("x11/X0")));
+    m_sockets << bindSocket(dir.filePath(QStringLiteral("x11/X1")));
+    QVERIFY(m_sockets.at(0) > 0 && m_sockets.at(1) > 0);
+
+    QVERIFY(writeProcess(dir, 300, kUid, {"XDG_SESSION_ID=2", "DISPLAY=:0"}));
+    QVERIFY(writeProcess(dir, 310, kUid, {"XDG_SESSION_ID=6", "DISPLAY=:1"}));
+    // A tmux server kept the environment of a session that has since been closed.
+    QVERIFY(writeProcess(dir, 320, kUid, {"XDG_SESSION_ID=1", "DISPLAY=:0"}));
+
+    const auto all = locator(dir).discover(kUid);
+    QCOMPARE(all.size(), 3);
+    QCOMPARE(all.first().pid, qint64(320));
+
+    const auto open = locator(dir).discover(kUid, {QStringLiteral("6"), QStringLiteral("2")});
+    QCOMPARE(open.size(), 2);
+    QCOMPARE(open.at(0).id, QStringLiteral("6"));
+    QCOMPARE(open.at(1).id, QStringLiteral("2"));
+
+    // Apps started by the user manager carry no session id and come after logind's sessions.
+    QVERIFY(writeProcess(dir, 400, kUid, {"DISPLAY=:1"}));
+    const auto withManager = locator(dir).discover(kUid, {QStringLiteral("2")});
+    QCOMPARE(withManager.size(), 2);
+    QCOMPARE(withManager.at(0).id, QStringLiteral("2"));
+    QCOMPARE(withManager.at(1).pid, qint64(400));
+}
+
+QTEST_MAIN(SessionLocatorTest)
+
+#include "SessionLocatorTest.moc"
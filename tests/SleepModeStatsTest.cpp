@@ -0,0 +1,72 @@
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include "SleepModeStats.h"
+
+class SleepModeStatsTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void counts_attempts_per_mode();
+    void halves_old_history();
+    void orders_fallbacks_by_success_rate();
+};
+
+void SleepModeStatsTest::counts_attempts_per_mode() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("state/sleep-modes.json"));
+    const QDateTime when(QDate(2030, 1, 7), QTime(23, 0), Qt::UTC);
+
+    QVERIFY(SleepModeStats::load(path).isEmpty());
+    QVERIFY(SleepModeStats::record(path, QStringLiteral("mem"), false, when));
+    QVERIFY(SleepModeStats::record(path, QStringLiteral("mem"), true, when.addDays(1)));
+    QVERIFY(SleepModeStats::record(path, QStringLiteral("freeze"), true, when));
+
+    const auto stats = SleepModeStats::load(path);
+    QCOMPARE(stats.size(), 2);
+    QCOMPARE(stats.value(QStringLiteral("mem")).attempts, 2);
+    QCOMPARE(stats.value(QStringLiteral("mem")).successes, 1);
+    QCOMPARE(stats.value(QStringLiteral("mem")).lastFailure, when);
+    QCOMPARE(stats.value(QStringLiteral("mem")).rate(), 0.5);
+    QVERIFY(!stats.value(QStringLiteral("freeze")).lastFailure.isValid());
+    QCOMPARE(stats.value(QStringLiteral("freeze")).rate(), 2.0 / 3.0);
+}
+
+void SleepModeStatsTest::halves_old_history() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("sleep-modes.json"));
+    const QDateTime when(QDate(2030, 1, 7), QTime(23, 0), Qt::UTC);
+    for (int i = 0; i < SleepModeStats::kMaxAttempts; ++i) {
+        QVERIFY(SleepModeStats::record(path, QStringLiteral("mem"), true, when));
+    }
+    QVERIFY(SleepModeStats::record(path, QStringLiteral("mem"), false, when));
+
+    const auto counts = SleepModeStats::load(path).value(QStringLiteral("mem"));
+    QCOMPARE(counts.attempts, (SleepModeStats::kMaxAttempts + 1) / 2);
+    QCOMPARE(counts.successes, SleepModeStats::kMaxAttempts / 2);
+}
+
+void SleepModeStatsTest::orders_fallbacks_by_success_rate() {
+    const QStringList chain {QStringLiteral("mem"), QStringLiteral("freeze"), QStringLiteral("disk")};
+    QMap<QString, SleepModeStats::Counts> stats;
+
+    // Untried modes keep the configured order, without the requested one.
+    QCOMPARE(SleepModeStats::fallbackOrder(QStringLiteral("mem"), chain, stats),
+             QStringList({QStringLiteral("freeze"), QStringLiteral("disk")}));
+    QCOMPARE(SleepModeStats::fallbackOrder(QStringLiteral("disk"), chain, stats),
+             QStringList({QStringLiteral("mem"), QStringLiteral("freeze")}));
+
+    // s2idle keeps failing on this machine; hibernation has always worked.
+    stats[QStringLiteral("freeze")].attempts = 4;
+    stats[QStringLiteral("disk")].attempts = 3;
+    stats[QStringLiteral("disk")].successes = 3;
+    QCOMPARE(SleepModeStats::fallbackOrder(QStringLiteral("mem"), chain, stats),
+             QStringList({QStringLiteral("disk"), QStringLiteral("freeze")}));
+    QVERIFY(SleepModeStats::fallbackOrder(QStringLiteral("mem"), QStringList(), stats).isEmpty());
+}
+
+QTEST_MAIN(SleepModeStatsTest)
+
+#include "SleepModeStatsTest.moc"
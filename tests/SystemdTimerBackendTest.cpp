@@ -0,0 +1,156 @@
+#include <QtTest>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include "SystemdTimerBackend.h"
+#include "TestFiles.h"
+
+namespace {
+// A Wednesday; 2030-01-07 is a Monday.
+const QDateTime kNow(QDate(2030, 1, 9), QTime(12, 0), Qt::UTC);
+
+AppConfig weeklyConfig(const QVector<int> &days, const QTime &shutdown, const QTime &wake) {
+    AppConfig config;
+    config.singleShutdownDate = QDate(2000, 1, 1);
+    config.singleWakeDate = QDate(2000, 1, 1);
+    config.actionId = static_cast<int>(PowerAction::SuspendToRam);
+    for (auto &entry : config.weekly) {
+        entry.enabled = days.contains(entry.day);
+        entry.shutdownTime = shutdown;
+        entry.wakeTime = wake;
+    }
+    return config;
+}
+}
+
+class SystemdTimerBackendTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void compiles_weekly_rules();
+    void compiles_single_event();
+    void only_wakes_for_unsupported_actions();
+    void rewrites_only_changed_units();
+};
+
+void SystemdTimerBackendTest::compiles_weekly_rules() {
+    const auto units = SystemdTimerBackend::compile(weeklyConfig({Qt::Friday, Qt::Monday}, QTime(23, 0), QTime(7, 0)), kNow);
+    QCOMPARE(units.keys(), QStringList({QStringLiteral("rtcwake-gui-sleep.service"), QStringLiteral("rtcwake-gui-sleep.timer"),
+                                        QStringLiteral("rtcwake-gui-wake.service"), QStringLiteral("rtcwake-gui-wake.timer")}));
+    // Monday first, although Friday comes first from a Wednesday.
+    QCOMPARE(units.value(QStringLiteral("rtcwake-gui-sleep.timer")),
+             QByteArray("# Generated by rtcwake-gui; changes are overwritten on the next save.\n"
+                        "[Unit]\n"
+                        "Description=rtcwake-gui: Suspend to RAM at the shutdown time\n"
+                        "\n"
+                        "[Timer]\n"
+                        "OnCalendar=Mon *-*-* 23:00:00 UTC\n"
+                        "OnCalendar=Fri *-*-* 23:00:00 UTC\n"
+                        "AccuracySec=1s\n"
+                        "\n"
+                        "[Install]\n"
+                        "WantedBy=timers.target\n"));
+    QCOMPARE(units.value(QStringLiteral("rtcwake-gui-sleep.service")),
+             QByteArray("# Generated by rtcwake-gui; changes are overwritten on the next save.\n"
+                        "[Unit]\n"
+                        "Description=rtcwake-gui: Suspend to RAM\n"
+                        "\n"
+                        "[Service]\n"
+                        "Type=oneshot\n"
+                        "ExecStart=/usr/bin/systemctl suspend\n"));
+    // The wakes fall on the following days.
+    QCOMPARE(units.value(QStringLiteral("rtcwake-gui-wake.timer")),
+             QByteArray("# Generated by rtcwake-gui; changes are overwritten on the next save.\n"
+                        "[Unit]\n"
+                        "Description=rtcwake-gui: wake the machine\n"
+                        "\n"
+                        "[Timer]\n"
+                        "OnCalendar=Tue *-*-* 07:00:00 UTC\n"
+                        "OnCalendar=Sat *-*-* 07:00:00 UTC\n"
+                        "WakeSystem=true\n"
+                        "AccuracySec=1s\n"
+                        "\n"
+                        "[Install]\n"
+                        "WantedBy=timers.target\n"));
+
+    // The same plan compiled on another day gives the same units.
+    QCOMPARE(SystemdTimerBackend::compile(weeklyConfig({Qt::Friday, Qt::Monday}, QTime(23, 0), QTime(7, 0)), kNow.addDays(3)),
+             units);
+}
+
+void SystemdTimerBackendTest::compiles_single_event() {
+    AppConfig config = weeklyConfig({Qt::Monday}, QTime(23, 0), QTime(7, 0));
+    config.actionId = static_cast<int>(PowerAction::Hibernate);
+    config.singleShutdownDate = QDate(2030, 1, 10);
+    config.singleShutdownTime = QTime(22, 30);
+    config.singleWakeDate = QDate(2030, 1, 11);
+    config.singleWakeTime = QTime(6, 15);
+
+    const auto units = SystemdTimerBackend::compile(config, kNow);
+    const QString sleepTimer = QString::fromUtf8(units.value(QStringLiteral("rtcwake-gui-sleep.timer")));
+    QVERIFY2(sleepTimer.contains(QStringLiteral("[Timer]\nOnCalendar=2030-01-10 22:30:00 UTC\nOnCalendar=Mon *-*-* 23:00:00 UTC\n")),
+             qPrintable(sleepTimer));
+    const QString wakeTimer = QString::fromUtf8(units.value(QStringLiteral("rtcwake-gui-wake.timer")));
+    QVERIFY2(wakeTimer.contains(QStringLiteral("[Timer]\nOnCalendar=2030-01-11 06:15:00 UTC\nOnCalendar=Tue *-*-* 07:00:00 UTC\n")),
+             qPrintable(wakeTimer));
+    QVERIFY(units.value(QStringLiteral("rtcwake-gui-sleep.service")).contains("ExecStart=/usr/bin/systemctl hibernate\n"));
+
+    // Once the single event has passed only the weekly rule is left.
+    const auto later = SystemdTimerBackend::compile(config, QDateTime(QDate(2030, 1, 11), QTime(12, 0), Qt::UTC));
+    QVERIFY(!later.value(QStringLiteral("rtcwake-gui-sleep.timer")).contains("2030-01-10"));
+}
+
+void SystemdTimerBackendTest::only_wakes_for_unsupported_actions() {
+    AppConfig config = weeklyConfig({Qt::Monday}, QTime(23, 0), QTime(7, 0));
+    for (const auto action : {PowerAction::None, PowerAction::PowerOff, PowerAction::FreezeUserSession}) {
+        config.actionId = static_cast<int>(action);
+        const auto units = SystemdTimerBackend::compile(config, kNow);
+        QCOMPARE(units.keys(), QStringList({QStringLiteral("rtcwake-gui-wake.service"), QStringLiteral("rtcwake-gui-wake.timer")}));
+    }
+    QVERIFY(SystemdTimerBackend::compile(weeklyConfig({}, QTime(23, 0), QTime(7, 0)), kNow).isEmpty());
+}
+
+void SystemdTimerBackendTest::rewrites_only_changed_units() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString unitDir = dir.filePath(QStringLiteral("system"));
+    const SystemdTimerBackend backend(unitDir);
+    QVERIFY(QDir().mkpath(unitDir));
+    {
+        QFile own(QDir(unitDir).filePath(QStringLiteral("rtcwake-daemon.service")));
+        QVERIFY(own.open(QIODevice::WriteOnly));
+        own.write("[Service]\n");
+    }
+
+    AppConfig config = weeklyConfig({Qt::Monday}, QTime(23, 0), QTime(7, 0));
+    QStringList changed;
+    QVERIFY(backend.apply(SystemdTimerBackend::compile(config, kNow), &changed));
+    QCOMPARE(changed.size(), 4);
+
+    changed.clear();
+    QVERIFY(backend.apply(SystemdTimerBackend::compile(config, kNow.addDays(1)), &changed));
+    QVERIFY2(changed.isEmpty(), qPrintable(changed.join(QLatin1Char(','))));
+
+    config.weekly[0].wakeTime = QTime(6, 45);
+    QVERIFY(backend.apply(SystemdTimerBackend::compile(config, kNow), &changed));
+    QCOMPARE(changed, QStringList({QStringLiteral("rtcwake-gui-wake.timer")}));
+    QVERIFY(readFile(QDir(unitDir).filePath(QStringLiteral("rtcwake-gui-wake.timer"))).contains("OnCalendar=Tue *-*-* 06:45:00 UTC\n"));
+
+    // Stale units go, the admin's own stay.
+    changed.clear();
+    config.actionId = static_cast<int>(PowerAction::PowerOff);
+    QVERIFY(backend.apply(SystemdTimerBackend::compile(config, kNow), &changed));
+    QCOMPARE(changed, QStringList({QStringLiteral("rtcwake-gui-sleep.service"), QStringLiteral("rtcwake-gui-sleep.timer")}));
+    QVERIFY(!QFile::exists(QDir(unitDir).filePath(QStringLiteral("rtcwake-gui-sleep.timer"))));
+    QVERIFY(QFile::exists(QDir(unitDir).filePath(QStringLiteral("rtcwake-daemon.service"))));
+
+    changed.clear();
+    QVERIFY(backend.apply({}, &changed));
+    QCOMPARE(changed.size(), 2);
+    QCOMPARE(QDir(unitDir).entryList(QDir::Files), QStringList({QStringLiteral("rtcwake-daemon.service")}));
+}
+
+QTEST_MAIN(SystemdTimerBackendTest)
+
+#include "SystemdTimerBackendTest.moc"
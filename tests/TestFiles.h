@@ -0,0 +1,38 @@
+#pragma once
+
+#include <QByteArray>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QString>
+
+/** Write @p content to @p path, creating missing parent directories (fake /sys, /proc and state trees). */
+inline bool writeFile(const QString &path, const QByteArray &content) {
+    if (!QDir().mkpath(QFileInfo(path).path())) {
+        return false;
+    }
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(content) == content.size();
+}
+
+/** Contents of @p path, empty when it cannot be read. */
+inline QByteArray readFile(const QString &path) {
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+/** A sysfs-style value: the contents of @p path without the trailing newline. */
+inline QByteArray readValue(const QString &path) {
+    return readFile(path).trimmed();
+}
+
+/** True once @p pid is gone or only a zombie nobody reaped yet. */
+inline bool processGone(qint64 pid) {
+    QFile stat(QStringLiteral("/proc/%1/stat").arg(pid));
+    if (!stat.open(QIODevice::ReadOnly)) {
+        return true;
+    }
+    const QByteArray text = stat.readAll();
+    const int paren = text.lastIndexOf(')');
+    return paren >= 0 && text.mid(paren + 2, 1) == "Z";
+}
@@ -0,0 +1,81 @@
+#include <QtTest>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+
+#include "TraceBuffer.h"
+
+class TraceBufferTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void records_scopes();
+    void wraps_keeping_newest();
+    void disabled_records_nothing();
+    void dumps_chrome_json();
+};
+
+void TraceBufferTest::records_scopes() {
+    TraceBuffer buffer(8);
+    {
+        TraceScope scope("test", "outer", buffer);
+        buffer.instant("test", "marker");
+    }
+    QCOMPARE(buffer.size(), 2);
+
+    const auto doc = QJsonDocument::fromJson(buffer.toChromeJson());
+    const QJsonArray events = doc.object().value(QStringLiteral("traceEvents")).toArray();
+    QCOMPARE(events.size(), 2);
+    QCOMPARE(events.at(0).toObject().value(QStringLiteral("name")).toString(), QStringLiteral("marker"));
+    QCOMPARE(events.at(0).toObject().value(QStringLiteral("ph")).toString(), QStringLiteral("i"));
+    QCOMPARE(events.at(1).toObject().value(QStringLiteral("name")).toString(), QStringLiteral("outer"));
+    QCOMPARE(events.at(1).toObject().value(QStringLiteral("ph")).toString(), QStringLiteral("X"));
+    QVERIFY(events.at(1).toObject().value(QStringLiteral("dur")).toDouble() >= 0);
+}
+
+void TraceBufferTest::wraps_keeping_newest() {
+    TraceBuffer buffer(4);
+    const char *names[] = {"e0", "e1", "e2", "e3", "e4", "e5"};
+    for (const char *name : names) {
+        buffer.complete("test", name, TraceBuffer::nowUs(), 1);
+    }
+    QCOMPARE(buffer.size(), 4);
+
+    const auto doc = QJsonDocument::fromJson(buffer.toChromeJson());
+    const QJsonArray events = doc.object().value(QStringLiteral("traceEvents")).toArray();
+    QCOMPARE(events.size(), 4);
+    QCOMPARE(events.first().toObject().value(QStringLiteral("name")).toString(), QStringLiteral("e2"));
+    QCOMPARE(events.last().toObject().value(QStringLiteral("name")).toString(), QStringLiteral("e5"));
+}
+
+void TraceBufferTest::disabled_records_nothing() {
+    TraceBuffer buffer(4);
+    buffer.setEnabled(false);
+    {
+        TraceScope scope("test", "ignored", buffer);
+    }
+    buffer.instant("test", "ignored");
+    QCOMPARE(buffer.size(), 0);
+}
+
+void TraceBufferTest::dumps_chrome_json() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    TraceBuffer buffer(4);
+    buffer.instant("test", "marker");
+
+    const QString path = dir.filePath(QStringLiteral("nested/trace.json"));
+    QVERIFY(buffer.dump(path));
+
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QJsonParseError error;
+    const auto doc = QJsonDocument::fromJson(file.readAll(), &error);
+    QCOMPARE(error.error, QJsonParseError::NoError);
+    QVERIFY(doc.object().value(QStringLiteral("traceEvents")).isArray());
+}
+
+QTEST_MAIN(TraceBufferTest)
+
+#include "TraceBufferTest.moc"
@@ -0,0 +1,190 @@
+#include <QtTest>
+#include <QDir>
+#include <QTemporaryDir>
+
+#include "SimulatedClock.h"
+#include "UserActivityMonitor.h"
+
+#include <fcntl.h>
+#include <linux/input.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+constexpr qint64 kMinute = 60 * 1000;
+
+bool writeEvent(int fd, quint16 type, quint16 code, qint32 value) {
+    input_event event {};
+    event.type = type;
+    event.code = code;
+    event.value = value;
+    return ::write(fd, &event, sizeof(event)) == static_cast<ssize_t>(sizeof(event));
+}
+
+QBitArray bits(int count, std::initializer_list<int> set) {
+    QBitArray result(count);
+    for (const int bit : set) {
+        result.setBit(bit);
+    }
+    return result;
+}
+
+UserActivityMonitor::Capabilities capabilities(std::initializer_list<int> events, std::initializer_list<int> keys,
+                                               std::initializer_list<int> relative = {}, std::initializer_list<int> absolute = {}) {
+    UserActivityMonitor::Capabilities result;
+    result.events = bits(EV_CNT, events);
+    result.keys = bits(KEY_CNT, keys);
+    result.relative = bits(REL_CNT, relative);
+    result.absolute = bits(ABS_CNT, absolute);
+    return result;
+}
+
+UserActivityMonitor::CapabilityProbe reporting(const UserActivityMonitor::Capabilities &device) {
+    return [device](int, UserActivityMonitor::Capabilities &capabilities) {
+        capabilities = device;
+        return true;
+    };
+}
+
+const UserActivityMonitor::Capabilities kKeyboard = capabilities({EV_KEY, EV_MSC}, {KEY_A, KEY_Z, KEY_SPACE, KEY_ENTER});
+const UserActivityMonitor::Capabilities kAccelerometer = capabilities({EV_ABS}, {}, {}, {ABS_X, ABS_Y, ABS_Z});
+}
+
+class UserActivityMonitorTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void expires_without_activity();
+    void input_event_cancels_grace();
+    void opens_only_user_devices();
+    void classifies_devices();
+    void session_activity_cancels_grace();
+};
+
+void UserActivityMonitorTest::expires_without_activity() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    SimulatedClock clock(QDateTime(QDate(2030, 1, 8), QTime(7, 0), Qt::UTC));
+    UserActivityMonitor monitor(&clock, dir.path());
+    QSignalSpy expired(&monitor, &UserActivityMonitor::graceExpired);
+    QSignalSpy activity(&monitor, &UserActivityMonitor::activityDetected);
+
+    // Activity before a grace period started means nothing.
+    monitor.noteActivity(QStringLiteral("event0"));
+    monitor.start(20 * kMinute, true);
+    QCOMPARE(monitor.deviceCount(), 0);
+    QCOMPARE(clock.activeTimers(), 1);
+
+    clock.advanceBy(19 * kMinute);
+    QCOMPARE(expired.count(), 0);
+    clock.advanceBy(kMinute);
+    QCOMPARE(expired.count(), 1);
+    QCOMPARE(activity.count(), 0);
+    QVERIFY(!monitor.isActive());
+    QCOMPARE(clock.activeTimers(), 0);
+}
+
+void UserActivityMonitorTest::input_event_cancels_grace() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    // A FIFO stands in for the evdev node: readable only once something is written.
+    const QByteArray device = QFile::encodeName(dir.filePath(QStringLiteral("event3")));
+    QVERIFY(::mkfifo(device.constData(), 0600) == 0);
+
+    SimulatedClock clock(QDateTime(QDate(2030, 1, 8), QTime(7, 0), Qt::UTC));
+    UserActivityMonitor monitor(&clock, dir.path());
+    monitor.setCapabilityProbe(reporting(kKeyboard));
+    QSignalSpy expired(&monitor, &UserActivityMonitor::graceExpired);
+    QSignalSpy activity(&monitor, &UserActivityMonitor::activityDetected);
+    monitor.start(20 * kMinute, true);
+    QCOMPARE(monitor.deviceCount(), 1);
+
+    const int writer = ::open(device.constData(), O_WRONLY | O_NONBLOCK);
+    QVERIFY(writer >= 0);
+
+    // A switch event (lid, dock) is not a person.
+    QVERIFY(writeEvent(writer, EV_SW, SW_LID, 0));
+    QVERIFY(writeEvent(writer, EV_SYN, SYN_REPORT, 0));
+    QTest::qWait(100);
+    QCOMPARE(activity.count(), 0);
+    QVERIFY(monitor.isActive());
+
+    QVERIFY(writeEvent(writer, EV_KEY, KEY_SPACE, 1));
+    QVERIFY(writeEvent(writer, EV_SYN, SYN_REPORT, 0));
+    QTRY_COMPARE(activity.count(), 1);
+    QCOMPARE(activity.first().first().toString(), QStringLiteral("event3"));
+    QVERIFY(!monitor.isActive());
+    QCOMPARE(monitor.deviceCount(), 0);
+    ::close(writer);
+
+    clock.advanceBy(60 * kMinute);
+    QCOMPARE(expired.count(), 0);
+}
+
+void UserActivityMonitorTest::opens_only_user_devices() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QByteArray device = QFile::encodeName(dir.filePath(QStringLiteral("event5")));
+    QVERIFY(::mkfifo(device.constData(), 0600) == 0);
+
+    SimulatedClock clock(QDateTime(QDate(2030, 1, 8), QTime(7, 0), Qt::UTC));
+    UserActivityMonitor monitor(&clock, dir.path());
+    // A FIFO is no evdev node, so the real probe turns it down as well.
+    monitor.start(20 * kMinute, true);
+    QCOMPARE(monitor.deviceCount(), 0);
+
+    // A laptop lying on a desk still jitters its accelerometer.
+    monitor.setCapabilityProbe(reporting(kAccelerometer));
+    monitor.start(20 * kMinute, true);
+    QCOMPARE(monitor.deviceCount(), 0);
+
+    monitor.setCapabilityProbe(reporting(kKeyboard));
+    monitor.start(20 * kMinute, true);
+    QCOMPARE(monitor.deviceCount(), 1);
+    monitor.stop();
+}
+
+void UserActivityMonitorTest::classifies_devices() {
+    QVERIFY(UserActivityMonitor::isUserDevice(kKeyboard));
+    const auto mouse = capabilities({EV_KEY, EV_REL}, {BTN_LEFT, BTN_RIGHT}, {REL_X, REL_Y, REL_WHEEL});
+    QVERIFY(UserActivityMonitor::isUserDevice(mouse));
+    const auto touchpad = capabilities({EV_KEY, EV_ABS}, {BTN_LEFT, BTN_TOOL_FINGER, BTN_TOUCH}, {},
+                                       {ABS_X, ABS_Y, ABS_MT_POSITION_X, ABS_MT_POSITION_Y});
+    QVERIFY(UserActivityMonitor::isUserDevice(touchpad));
+    const auto touchscreen = capabilities({EV_KEY, EV_ABS}, {BTN_TOUCH}, {}, {ABS_X, ABS_Y});
+    QVERIFY(UserActivityMonitor::isUserDevice(touchscreen));
+
+    QVERIFY(!UserActivityMonitor::isUserDevice(kAccelerometer));
+    const auto powerButton = capabilities({EV_KEY}, {KEY_POWER});
+    QVERIFY(!UserActivityMonitor::isUserDevice(powerButton));
+    const auto videoBus = capabilities({EV_KEY}, {KEY_BRIGHTNESSDOWN, KEY_BRIGHTNESSUP, KEY_SWITCHVIDEOMODE});
+    QVERIFY(!UserActivityMonitor::isUserDevice(videoBus));
+    const auto lid = capabilities({EV_SW}, {});
+    QVERIFY(!UserActivityMonitor::isUserDevice(lid));
+}
+
+void UserActivityMonitorTest::session_activity_cancels_grace() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    SimulatedClock clock(QDateTime(QDate(2030, 1, 8), QTime(7, 0), Qt::UTC));
+    UserActivityMonitor monitor(&clock, dir.path());
+    QSignalSpy expired(&monitor, &UserActivityMonitor::graceExpired);
+    QSignalSpy activity(&monitor, &UserActivityMonitor::activityDetected);
+    monitor.start(20 * kMinute, false);
+
+    monitor.setSessionIdle(true);
+    clock.advanceBy(10 * kMinute);
+    QCOMPARE(activity.count(), 0);
+
+    monitor.setSessionIdle(false);
+    QCOMPARE(activity.count(), 1);
+    QCOMPARE(activity.first().first().toString(), QStringLiteral("session"));
+    clock.advanceBy(60 * kMinute);
+    QCOMPARE(expired.count(), 0);
+}
+
+QTEST_MAIN(UserActivityMonitorTest)
+
+#include "UserActivityMonitorTest.moc"
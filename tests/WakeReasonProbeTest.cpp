@@ -0,0 +1,123 @@
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include "WakeReasonProbe.h"
+#include "TestFiles.h"
+
+namespace {
+bool writeSource(const QString &sysRoot, const QString &entry, const QByteArray &name, int events, int wakeups) {
+    const QString dir = sysRoot + QStringLiteral("/class/wakeup/") + entry;
+    return writeFile(dir + QStringLiteral("/name"), name + '\n')
+        && writeFile(dir + QStringLiteral("/event_count"), QByteArray::number(events) + '\n')
+        && writeFile(dir + QStringLiteral("/wakeup_count"), QByteArray::number(wakeups) + '\n');
+}
+
+QDateTime at(const QTime &time) {
+    return QDateTime(QDate(2030, 1, 8), time, Qt::UTC);
+}
+}
+
+class WakeReasonProbeTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void attributes_wakeup_count_deltas();
+    void falls_back_to_debugfs_and_events();
+    void classifies_against_alarm();
+    void counts_wakes_per_source();
+};
+
+void WakeReasonProbeTest::attributes_wakeup_count_deltas() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString sys = dir.filePath(QStringLiteral("sys"));
+    QVERIFY(writeSource(sys, QStringLiteral("wakeup0"), "alarmtimer.0.auto", 10, 3));
+    QVERIFY(writeSource(sys, QStringLiteral("wakeup1"), "1-2", 200, 0));
+    QVERIFY(writeSource(sys, QStringLiteral("wakeup2"), "PNP0C0D:00", 4, 1));
+
+    const WakeReasonProbe probe(sys, dir.filePath(QStringLiteral("proc")));
+    const auto before = probe.snapshot();
+    QCOMPARE(before.size(), 3);
+    QCOMPARE(before.value(QStringLiteral("1-2")).events, quint64(200));
+
+    // The USB mouse moved and woke the machine; the alarm timer stayed put.
+    QVERIFY(writeSource(sys, QStringLiteral("wakeup1"), "1-2", 260, 1));
+    QVERIFY(writeSource(sys, QStringLiteral("wakeup2"), "PNP0C0D:00", 6, 1));
+    QVERIFY(writeFile(sys + QStringLiteral("/power/pm_wakeup_irq"), "17\n"));
+    QVERIFY(writeFile(dir.filePath(QStringLiteral("proc/interrupts")),
+                      "           CPU0       CPU1\n"
+                      "   8:          0          1   IR-IO-APIC    8-edge      rtc0\n"
+                      "  17:         25          3   IR-IO-APIC   17-fasteoi   xhci_hcd\n"));
+
+    const auto attribution = probe.attribute(before, probe.snapshot());
+    QCOMPARE(attribution.sources, QStringList({QStringLiteral("1-2")}));
+    QCOMPARE(attribution.primary(), QStringLiteral("1-2"));
+    QCOMPARE(attribution.irq, QStringLiteral("irq 17 (xhci_hcd)"));
+    QVERIFY(!attribution.rtc);
+}
+
+void WakeReasonProbeTest::falls_back_to_debugfs_and_events() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString table = dir.filePath(QStringLiteral("sys/kernel/debug/wakeup_sources"));
+    QVERIFY(writeFile(table, "name\t\tactive_count\tevent_count\twakeup_count\texpire_count\tactive_since\n"
+                             "rtc0\t\t2\t2\t0\t0\t0\n"
+                             "eth0\t\t7\t7\t0\t0\t0\n"));
+    const WakeReasonProbe probe(dir.filePath(QStringLiteral("sys")), dir.filePath(QStringLiteral("proc")));
+    const auto before = probe.snapshot();
+    QCOMPARE(before.size(), 2);
+
+    // No source counted a wakeup, so the event counts decide.
+    QVERIFY(writeFile(table, "name\t\tactive_count\tevent_count\twakeup_count\texpire_count\tactive_since\n"
+                             "rtc0\t\t3\t3\t0\t0\t0\n"
+                             "eth0\t\t7\t7\t0\t0\t0\n"));
+    const auto attribution = probe.attribute(before, probe.snapshot());
+    QCOMPARE(attribution.sources, QStringList({QStringLiteral("rtc0")}));
+    QVERIFY(attribution.rtc);
+    QVERIFY(attribution.irq.isEmpty());
+
+    QCOMPARE(probe.attribute(before, before).primary(), QStringLiteral("unknown"));
+}
+
+void WakeReasonProbeTest::classifies_against_alarm() {
+    using Verdict = WakeReasonProbe::Verdict;
+    WakeReasonProbe::Attribution rtc;
+    rtc.sources << QStringLiteral("alarmtimer.0.auto");
+    rtc.rtc = true;
+    WakeReasonProbe::Attribution lan;
+    lan.sources << QStringLiteral("0000:00:1f.6");
+    const WakeReasonProbe::Attribution nothing;
+
+    const QDateTime alarm = at(QTime(7, 0));
+    QCOMPARE(WakeReasonProbe::classify(alarm, at(QTime(7, 0, 4)), rtc), Verdict::OnTime);
+    QCOMPARE(WakeReasonProbe::classify(alarm, at(QTime(6, 59, 30)), lan), Verdict::OnTime);
+    QCOMPARE(WakeReasonProbe::classify(alarm, at(QTime(3, 12)), lan), Verdict::Early);
+    QCOMPARE(WakeReasonProbe::classify(alarm, at(QTime(7, 20)), rtc), Verdict::Late);
+    QCOMPARE(WakeReasonProbe::classify(alarm, at(QTime(7, 20)), nothing), Verdict::Late);
+    // The RTC never fired; the user pressed a key twenty minutes later.
+    QCOMPARE(WakeReasonProbe::classify(alarm, at(QTime(7, 20)), lan), Verdict::Missed);
+    QCOMPARE(WakeReasonProbe::verdictLabel(Verdict::Missed), QStringLiteral("missed"));
+}
+
+void WakeReasonProbeTest::counts_wakes_per_source() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("state/wake-sources.json"));
+    QVERIFY(WakeReasonProbe::recordWake(path, QStringLiteral("rtc0"), WakeReasonProbe::Verdict::OnTime, at(QTime(7, 0))));
+    QVERIFY(WakeReasonProbe::recordWake(path, QStringLiteral("1-2"), WakeReasonProbe::Verdict::Early, at(QTime(2, 0))));
+    QVERIFY(WakeReasonProbe::recordWake(path, QStringLiteral("1-2"), WakeReasonProbe::Verdict::Early, at(QTime(3, 0))));
+    QVERIFY(WakeReasonProbe::recordWake(path, QStringLiteral("rtc0"), WakeReasonProbe::Verdict::Late, at(QTime(7, 9))));
+
+    const auto counts = WakeReasonProbe::loadCounts(path);
+    QCOMPARE(counts.size(), 2);
+    QCOMPARE(counts.value(QStringLiteral("1-2")).wakes, 2);
+    QCOMPARE(counts.value(QStringLiteral("1-2")).early, 2);
+    QCOMPARE(counts.value(QStringLiteral("1-2")).last, at(QTime(3, 0)));
+    QCOMPARE(counts.value(QStringLiteral("rtc0")).wakes, 2);
+    QCOMPARE(counts.value(QStringLiteral("rtc0")).late, 1);
+    QCOMPARE(counts.value(QStringLiteral("rtc0")).missed, 0);
+}
+
+QTEST_MAIN(WakeReasonProbeTest)
+
+#include "WakeReasonProbeTest.moc"
@@ -0,0 +1,45 @@
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include "WakeupCountGate.h"
+#include "TestFiles.h"
+
+class WakeupCountGateTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void writes_count_back();
+    void skips_missing_or_garbled_count();
+};
+
+void WakeupCountGateTest::writes_count_back() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("power/wakeup_count"));
+    QVERIFY(writeFile(path, "1234\n"));
+
+    quint64 count = 0;
+    QCOMPARE(WakeupCountGate(dir.path()).arm(&count), WakeupCountGate::Result::Armed);
+    QCOMPARE(count, quint64(1234));
+    // Writing the value back leaves a plain file as it was.
+    QCOMPARE(readFile(path), QByteArray("1234\n"));
+    QVERIFY(writeFile(path, "77"));
+    QCOMPARE(WakeupCountGate(dir.path()).arm(), WakeupCountGate::Result::Armed);
+    QCOMPARE(readFile(path), QByteArray("77"));
+}
+
+void WakeupCountGateTest::skips_missing_or_garbled_count() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QCOMPARE(WakeupCountGate(dir.path()).arm(), WakeupCountGate::Result::Unavailable);
+
+    QVERIFY(writeFile(dir.filePath(QStringLiteral("power/wakeup_count")), "busy\n"));
+    quint64 count = 42;
+    QCOMPARE(WakeupCountGate(dir.path()).arm(&count), WakeupCountGate::Result::Unavailable);
+    QCOMPARE(count, quint64(42));
+    QCOMPARE(WakeupCountGate::resultLabel(WakeupCountGate::Result::Pending), QStringLiteral("wakeup_pending"));
+}
+
+QTEST_MAIN(WakeupCountGateTest)
+
+#include "WakeupCountGateTest.moc"